@@ -289,8 +289,13 @@ void App::cleanup()
 	m_heapAlloc.deleteInstance(m_coreTracer);
 #endif
 
+	m_displayStats = {};
+	m_heapAlloc.deleteInstance(m_config);
+
 	m_settingsDir.destroy(m_heapAlloc);
 	m_cacheDir.destroy(m_heapAlloc);
+
+	LoggerSingleton::get().setAsync(false);
 }
 
 Error App::init(const ConfigSet& config, AllocAlignedCallback allocCb, void* allocCbUserData)
@@ -307,14 +312,17 @@ Error App::init(const ConfigSet& config, AllocAlignedCallback allocCb, void* all
 
 Error App::initInternal(const ConfigSet& config_, AllocAlignedCallback allocCb, void* allocCbUserData)
 {
-	ConfigSet config = config_;
-	m_displayStats = config.getNumberU32("core_displayStats");
-
-	initMemoryCallbacks(allocCb, allocCbUserData);
+	initMemoryCallbacks(config_.getBool("core_displayStats"), allocCb, allocCbUserData);
 	m_heapAlloc = HeapAllocator<U8>(m_allocCb, m_allocCbData);
 
+	m_config = m_heapAlloc.newInstance<ConfigSet>(config_);
+	ConfigSet& config = *m_config;
+	m_displayStats = config.getOption<Bool>("core_displayStats");
+
 	ANKI_CHECK(initDirs(config));
 
+	LoggerSingleton::get().setAsync(config.getBool("core_asyncLogging"));
+
 	// Print a message
 	const char* buildType =
 #if ANKI_OPTIMIZE
@@ -342,6 +350,12 @@ Error App::initInternal(const ConfigSet& config_, AllocAlignedCallback allocCb,
 				   ANKI_VERSION_MAJOR, ANKI_VERSION_MINOR, buildType, ANKI_COMPILER_STR, __DATE__, ANKI_REVISION);
 
 	m_timerTick = 1.0 / F32(config.getNumberU32("core_targetFps")); // in sec. 1.0 / period
+	config.addChangeCallback("core_targetFps",
+							 [](void* userData, CString option) {
+								 App& self = *static_cast<App*>(userData);
+								 self.m_timerTick = 1.0 / F32(self.m_config->getNumberU32(option));
+							 },
+							 this);
 
 // Check SIMD support
 #if ANKI_SIMD_SSE && ANKI_COMPILER_GCC_COMPATIBLE
@@ -360,6 +374,8 @@ Error App::initInternal(const ConfigSet& config_, AllocAlignedCallback allocCb,
 #if ANKI_ENABLE_TRACE
 	m_coreTracer = m_heapAlloc.newInstance<CoreTracer>();
 	ANKI_CHECK(m_coreTracer->init(m_heapAlloc, m_settingsDir));
+	m_coreTracer->setRingMode(config.getNumberU32("core_tracerRingFrameCount"),
+							  config.getNumberF64("core_tracerDumpFrameTime") / 1000.0);
 #endif
 
 	//
@@ -474,7 +490,7 @@ Error App::initInternal(const ConfigSet& config_, AllocAlignedCallback allocCb,
 	// Misc
 	//
 	ANKI_CHECK(m_ui->newInstance<StatsUi>(m_statsUi));
-	ANKI_CHECK(m_ui->newInstance<DeveloperConsole>(m_console, m_allocCb, m_allocCbData, m_script));
+	ANKI_CHECK(m_ui->newInstance<DeveloperConsole>(m_console, m_allocCb, m_allocCbData, m_script, m_config));
 
 	ANKI_CORE_LOGI("Application initialized");
 
@@ -575,7 +591,7 @@ Error App::mainLoop()
 
 			// Render
 			TexturePtr presentableTex = m_gr->acquireNextPresentableTexture();
-			m_renderer->setStatsEnabled(m_displayStats
+			m_renderer->setStatsEnabled(m_displayStats.get()
 #if ANKI_ENABLE_TRACE
 										|| TracerSingleton::get().getEnabled()
 #endif
@@ -606,7 +622,7 @@ Error App::mainLoop()
 			}
 
 			// Stats
-			if(m_displayStats)
+			if(m_displayStats.get())
 			{
 				StatsUi& statsUi = static_cast<StatsUi&>(*m_statsUi);
 				statsUi.m_frameTime.set(frameTime);
@@ -651,9 +667,10 @@ Error App::mainLoop()
 void App::injectUiElements(DynamicArrayAuto<UiQueueElement>& newUiElementArr, RenderQueue& rqueue)
 {
 	const U32 originalCount = rqueue.m_uis.getSize();
-	if(m_displayStats || m_consoleEnabled)
+	const Bool displayStats = m_displayStats.get();
+	if(displayStats || m_consoleEnabled)
 	{
-		const U32 extraElements = (m_displayStats != 0) + (m_consoleEnabled != 0);
+		const U32 extraElements = (displayStats != 0) + (m_consoleEnabled != 0);
 		newUiElementArr.create(originalCount + extraElements);
 
 		if(originalCount > 0)
@@ -665,7 +682,7 @@ void App::injectUiElements(DynamicArrayAuto<UiQueueElement>& newUiElementArr, Re
 	}
 
 	U32 count = originalCount;
-	if(m_displayStats)
+	if(displayStats)
 	{
 		newUiElementArr[count].m_userData = m_statsUi.get();
 		newUiElementArr[count].m_drawCallback = [](CanvasPtr& canvas, void* userData) -> void {
@@ -684,9 +701,9 @@ void App::injectUiElements(DynamicArrayAuto<UiQueueElement>& newUiElementArr, Re
 	}
 }
 
-void App::initMemoryCallbacks(AllocAlignedCallback allocCb, void* allocCbUserData)
+void App::initMemoryCallbacks(Bool trackMemory, AllocAlignedCallback allocCb, void* allocCbUserData)
 {
-	if(m_displayStats)
+	if(trackMemory)
 	{
 		m_memStats.m_originalAllocCallback = allocCb;
 		m_memStats.m_originalUserData = allocCbUserData;
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <AnKi/Core/Common.h>
+#include <AnKi/Core/ConfigSet.h>
 #include <AnKi/Util/Allocator.h>
 #include <AnKi/Util/String.h>
 #include <AnKi/Util/Ptr.h>
@@ -23,7 +24,6 @@ extern android_app* gAndroidApp;
 
 // Forward
 class CoreTracer;
-class ConfigSet;
 class ThreadHive;
 class NativeWindow;
 class Input;
@@ -58,6 +58,12 @@ public:
 		m_timerTick = x;
 	}
 
+	/// The options the App got initialized with. Changing them will affect the options that are read every frame.
+	ConfigSet& getConfig()
+	{
+		return *m_config;
+	}
+
 	const String& getSettingsDirectory() const
 	{
 		return m_settingsDir;
@@ -140,12 +146,12 @@ public:
 
 	void setDisplayStats(Bool enable)
 	{
-		m_displayStats = enable;
+		m_config->set("core_displayStats", enable);
 	}
 
 	Bool getDisplayStats() const
 	{
-		return m_displayStats;
+		return m_displayStats.get();
 	}
 
 	void setDisplayDeveloperConsole(Bool display)
@@ -167,6 +173,7 @@ private:
 	HeapAllocator<U8> m_heapAlloc;
 
 	// Sybsystems
+	ConfigSet* m_config = nullptr;
 #if ANKI_ENABLE_TRACE
 	CoreTracer* m_coreTracer = nullptr;
 #endif
@@ -184,7 +191,7 @@ private:
 
 	// Misc
 	UiImmediateModeBuilderPtr m_statsUi;
-	Bool m_displayStats = false;
+	ConfigOption<Bool> m_displayStats;
 	UiImmediateModeBuilderPtr m_console;
 	Bool m_consoleEnabled = false;
 	Timestamp m_globalTimestamp = 1;
@@ -207,7 +214,7 @@ private:
 		static void* allocCallback(void* userData, void* ptr, PtrSize size, PtrSize alignment);
 	} m_memStats;
 
-	void initMemoryCallbacks(AllocAlignedCallback allocCb, void* allocCbUserData);
+	void initMemoryCallbacks(Bool trackMemory, AllocAlignedCallback allocCb, void* allocCbUserData);
 
 	ANKI_USE_RESULT Error initInternal(const ConfigSet& config, AllocAlignedCallback allocCb, void* allocCbUserData);
 
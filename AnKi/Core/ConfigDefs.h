@@ -15,4 +15,8 @@ ANKI_CONFIG_OPTION(core_targetFps, 60u, 30u, MAX_U32, "Target FPS")
 ANKI_CONFIG_OPTION(core_mainThreadCount, max(2u, getCpuCoresCount() / 2u), 2u, 1024u)
 ANKI_CONFIG_OPTION(core_displayStats, 0, 0, 1)
 ANKI_CONFIG_OPTION(core_clearCaches, 0, 0, 1)
+ANKI_CONFIG_OPTION(core_tracerRingFrameCount, 0, 0, 1024, "Make the tracer keep only the last frames. 0 disables it")
+ANKI_CONFIG_OPTION(core_tracerDumpFrameTime, 50.0, 0.0, 10000.0,
+				   "In ms. Dump the tracer's frames if a frame takes longer than that. 0 disables it")
+ANKI_CONFIG_OPTION(core_asyncLogging, 0, 0, 1, "Pass the log messages to the handlers from a background thread")
 ANKI_CONFIG_OPTION(window_fullscreen, 0, 0, 1)
@@ -27,6 +27,7 @@ public:
 	};
 
 	String m_name;
+	StringId m_nameId;
 	String m_helpMsg;
 
 	String m_str;
@@ -39,10 +40,20 @@ public:
 
 	Type m_type = NONE;
 
+	class ChangeCallback
+	{
+	public:
+		ConfigChangeCallback m_callback;
+		void* m_userData;
+	};
+
+	DynamicArray<ChangeCallback> m_changeCallbacks;
+
 	Option() = default;
 
 	Option(Option&& b)
 		: m_name(std::move(b.m_name))
+		, m_nameId(b.m_nameId)
 		, m_helpMsg(std::move(b.m_helpMsg))
 		, m_str(std::move(b.m_str))
 		, m_float(b.m_float)
@@ -52,6 +63,7 @@ public:
 		, m_minUnsigned(b.m_minUnsigned)
 		, m_maxUnsigned(b.m_maxUnsigned)
 		, m_type(b.m_type)
+		, m_changeCallbacks(std::move(b.m_changeCallbacks))
 	{
 	}
 
@@ -80,6 +92,7 @@ ConfigSet::~ConfigSet()
 		o.m_name.destroy(m_alloc);
 		o.m_str.destroy(m_alloc);
 		o.m_helpMsg.destroy(m_alloc);
+		o.m_changeCallbacks.destroy(m_alloc);
 	}
 
 	m_options.destroy(m_alloc);
@@ -93,6 +106,7 @@ ConfigSet& ConfigSet::operator=(const ConfigSet& b)
 	{
 		Option newO;
 		newO.m_name.create(m_alloc, o.m_name.toCString());
+		newO.m_nameId = o.m_nameId;
 		if(o.m_type == Option::STRING)
 		{
 			newO.m_str.create(m_alloc, o.m_str.toCString());
@@ -111,11 +125,11 @@ ConfigSet& ConfigSet::operator=(const ConfigSet& b)
 	return *this;
 }
 
-ConfigSet::Option* ConfigSet::tryFind(CString optionName)
+ConfigSet::Option* ConfigSet::tryFind(StringId optionName)
 {
 	for(List<Option>::Iterator it = m_options.getBegin(); it != m_options.getEnd(); ++it)
 	{
-		if((*it).m_name == optionName)
+		if((*it).m_nameId == optionName)
 		{
 			return &(*it);
 		}
@@ -124,11 +138,11 @@ ConfigSet::Option* ConfigSet::tryFind(CString optionName)
 	return nullptr;
 }
 
-const ConfigSet::Option* ConfigSet::tryFind(CString optionName) const
+const ConfigSet::Option* ConfigSet::tryFind(StringId optionName) const
 {
 	for(List<Option>::ConstIterator it = m_options.getBegin(); it != m_options.getEnd(); ++it)
 	{
-		if((*it).m_name == optionName)
+		if((*it).m_nameId == optionName)
 		{
 			return &(*it);
 		}
@@ -143,6 +157,7 @@ void ConfigSet::newOption(CString optionName, CString value, CString helpMsg)
 
 	Option o;
 	o.m_name.create(m_alloc, optionName);
+	o.m_nameId = StringIdRegistry::registerString(optionName);
 	o.m_str.create(m_alloc, value);
 	o.m_type = Option::STRING;
 	if(!helpMsg.isEmpty())
@@ -160,6 +175,7 @@ void ConfigSet::newOptionInternal(CString optionName, F64 value, F64 minValue, F
 
 	Option o;
 	o.m_name.create(m_alloc, optionName);
+	o.m_nameId = StringIdRegistry::registerString(optionName);
 	o.m_float = value;
 	o.m_minFloat = minValue;
 	o.m_maxFloat = maxValue;
@@ -179,6 +195,7 @@ void ConfigSet::newOptionInternal(CString optionName, U64 value, U64 minValue, U
 
 	Option o;
 	o.m_name.create(m_alloc, optionName);
+	o.m_nameId = StringIdRegistry::registerString(optionName);
 	o.m_unsigned = value;
 	o.m_minUnsigned = minValue;
 	o.m_maxUnsigned = maxValue;
@@ -193,90 +210,134 @@ void ConfigSet::newOptionInternal(CString optionName, U64 value, U64 minValue, U
 
 void ConfigSet::set(CString optionName, CString value)
 {
-	Option& o = find(optionName);
+	Option& o = find(StringId(optionName));
 	ANKI_ASSERT(o.m_type == Option::STRING);
 	o.m_str.destroy(m_alloc);
 	o.m_str.create(m_alloc, value);
+	notifyChange(o);
 }
 
 void ConfigSet::setInternal(CString optionName, F64 value)
 {
-	Option& o = find(optionName);
+	Option& o = find(StringId(optionName));
 	ANKI_ASSERT(o.m_type == Option::FLOAT);
 	ANKI_ASSERT(value >= o.m_minFloat);
 	ANKI_ASSERT(value <= o.m_maxFloat);
 	o.m_float = value;
+	notifyChange(o);
 }
 
 void ConfigSet::setInternal(CString optionName, U64 value)
 {
-	Option& o = find(optionName);
+	Option& o = find(StringId(optionName));
 	ANKI_ASSERT(o.m_type == Option::UNSIGNED);
 	ANKI_ASSERT(value >= o.m_minUnsigned);
 	ANKI_ASSERT(value <= o.m_maxUnsigned);
 	o.m_unsigned = value;
+	notifyChange(o);
 }
 
 F64 ConfigSet::getNumberF64(CString optionName) const
+{
+	return getNumberF64(StringId(optionName));
+}
+
+F32 ConfigSet::getNumberF32(CString optionName) const
+{
+	return getNumberF32(StringId(optionName));
+}
+
+U64 ConfigSet::getNumberU64(CString optionName) const
+{
+	return getNumberU64(StringId(optionName));
+}
+
+U32 ConfigSet::getNumberU32(CString optionName) const
+{
+	return getNumberU32(StringId(optionName));
+}
+
+U16 ConfigSet::getNumberU16(CString optionName) const
+{
+	return getNumberU16(StringId(optionName));
+}
+
+U8 ConfigSet::getNumberU8(CString optionName) const
+{
+	return getNumberU8(StringId(optionName));
+}
+
+Bool ConfigSet::getBool(CString optionName) const
+{
+	return getBool(StringId(optionName));
+}
+
+CString ConfigSet::getString(CString optionName) const
+{
+	return getString(StringId(optionName));
+}
+
+F64 ConfigSet::getNumberF64(StringId optionName) const
 {
 	const Option& option = find(optionName);
 	ANKI_ASSERT(option.m_type == Option::FLOAT);
 	return option.m_float;
 }
 
-F32 ConfigSet::getNumberF32(CString optionName) const
+F32 ConfigSet::getNumberF32(StringId optionName) const
 {
 	return F32(getNumberF64(optionName));
 }
 
-U64 ConfigSet::getNumberU64(CString optionName) const
+U64 ConfigSet::getNumberU64(StringId optionName) const
 {
 	const Option& option = find(optionName);
 	ANKI_ASSERT(option.m_type == Option::UNSIGNED);
 	return option.m_unsigned;
 }
 
-U32 ConfigSet::getNumberU32(CString optionName) const
+U32 ConfigSet::getNumberU32(StringId optionName) const
 {
 	const U64 out = getNumberU64(optionName);
 	if(out > MAX_U32)
 	{
-		ANKI_CORE_LOGW("Option is out of U32 range: %s", optionName.cstr());
+		ANKI_CORE_LOGW("Option is out of U32 range: %s", StringIdRegistry::find(optionName).cstr());
 	}
 	return U32(out);
 }
 
-U16 ConfigSet::getNumberU16(CString optionName) const
+U16 ConfigSet::getNumberU16(StringId optionName) const
 {
 	const U64 out = getNumberU64(optionName);
 	if(out > MAX_U16)
 	{
-		ANKI_CORE_LOGW("Option is out of U16 range: %s", optionName.cstr());
+		ANKI_CORE_LOGW("Option is out of U16 range: %s", StringIdRegistry::find(optionName).cstr());
 	}
 	return U16(out);
 }
 
-U8 ConfigSet::getNumberU8(CString optionName) const
+U8 ConfigSet::getNumberU8(StringId optionName) const
 {
 	const U64 out = getNumberU64(optionName);
 	if(out > MAX_U8)
 	{
-		ANKI_CORE_LOGW("Option is out of U8 range: %s", optionName.cstr());
+		ANKI_CORE_LOGW("Option is out of U8 range: %s", StringIdRegistry::find(optionName).cstr());
 	}
 	return U8(out);
 }
 
-Bool ConfigSet::getBool(CString optionName) const
+Bool ConfigSet::getBool(StringId optionName) const
 {
 	const U64 val = getNumberU64(optionName);
 	if((val & ~U64(1)) != 0)
 	{
-		ANKI_CORE_LOGW("Expecting 0 or 1 for the config option \"%s\". Will mask out extra bits", optionName.cstr());
+		ANKI_CORE_LOGW("Expecting 0 or 1 for the config option \"%s\". Will mask out extra bits",
+					   StringIdRegistry::find(optionName).cstr());
 	}
 	return val & 1;
 }
 
-CString ConfigSet::getString(CString optionName) const
+CString ConfigSet::getString(StringId optionName) const
 {
 	const Option& o = find(optionName);
 	ANKI_ASSERT(o.m_type == Option::STRING);
@@ -401,25 +462,111 @@ Error ConfigSet::setFromCommandLineArguments(U32 cmdLineArgsCount, char* cmdLine
 
 		arg = cmdLineArgs[i];
 		ANKI_ASSERT(arg);
-		if(option->m_type == Option::STRING)
+		ANKI_CHECK(setFromStringInternal(*option, arg));
+	}
+
+	return Error::NONE;
+}
+
+Error ConfigSet::setFromString(CString optionName, CString value)
+{
+	Option* option = tryFind(optionName);
+	if(option == nullptr)
+	{
+		ANKI_CORE_LOGE("Can't find config option: %s", optionName.cstr());
+		return Error::USER_DATA;
+	}
+
+	return setFromStringInternal(*option, value);
+}
+
+Error ConfigSet::setFromStringInternal(Option& option, CString value)
+{
+	if(option.m_type == Option::STRING)
+	{
+		option.m_str.destroy(m_alloc);
+		option.m_str.create(m_alloc, value);
+	}
+	else if(option.m_type == Option::FLOAT)
+	{
+		F64 val;
+		ANKI_CHECK(value.toNumber(val));
+		if(val < option.m_minFloat || val > option.m_maxFloat)
 		{
-			option->m_str.destroy(m_alloc);
-			option->m_str.create(m_alloc, arg);
+			ANKI_CORE_LOGE("Value %f is out of range for option %s", val, option.m_name.cstr());
+			return Error::USER_DATA;
 		}
-		else if(option->m_type == Option::FLOAT)
+		option.m_float = val;
+	}
+	else
+	{
+		ANKI_ASSERT(option.m_type == Option::UNSIGNED);
+		U64 val;
+		ANKI_CHECK(value.toNumber(val));
+		if(val < option.m_minUnsigned || val > option.m_maxUnsigned)
 		{
-			CString val(arg);
-			ANKI_CHECK(val.toNumber(option->m_float));
+			ANKI_CORE_LOGE("Value %" PRIu64 " is out of range for option %s", val, option.m_name.cstr());
+			return Error::USER_DATA;
 		}
-		else
+		option.m_unsigned = val;
+	}
+
+	notifyChange(option);
+	return Error::NONE;
+}
+
+void ConfigSet::getOptionValue(StringId optionName, const F64*& value) const
+{
+	const Option& o = find(optionName);
+	ANKI_ASSERT(o.m_type == Option::FLOAT);
+	value = &o.m_float;
+}
+
+void ConfigSet::getOptionValue(StringId optionName, const U64*& value) const
+{
+	const Option& o = find(optionName);
+	ANKI_ASSERT(o.m_type == Option::UNSIGNED);
+	value = &o.m_unsigned;
+}
+
+void ConfigSet::getOptionValue(StringId optionName, const String*& value) const
+{
+	const Option& o = find(optionName);
+	ANKI_ASSERT(o.m_type == Option::STRING);
+	value = &o.m_str;
+}
+
+void ConfigSet::addChangeCallback(CString optionName, ConfigChangeCallback callback, void* userData)
+{
+	ANKI_ASSERT(callback);
+	Option& o = find(StringId(optionName));
+	Option::ChangeCallback& cb = *o.m_changeCallbacks.emplaceBack(m_alloc);
+	cb.m_callback = callback;
+	cb.m_userData = userData;
+}
+
+void ConfigSet::removeChangeCallback(CString optionName, ConfigChangeCallback callback, void* userData)
+{
+	Option& o = find(StringId(optionName));
+	for(U32 i = 0; i < o.m_changeCallbacks.getSize(); ++i)
+	{
+		if(o.m_changeCallbacks[i].m_callback == callback && o.m_changeCallbacks[i].m_userData == userData)
 		{
-			ANKI_ASSERT(option->m_type == Option::UNSIGNED);
-			CString val(arg);
-			ANKI_CHECK(val.toNumber(option->m_unsigned));
+			o.m_changeCallbacks[i] = o.m_changeCallbacks.getBack();
+			o.m_changeCallbacks.popBack(m_alloc);
+			return;
 		}
 	}
 
-	return Error::NONE;
+	ANKI_ASSERT(!"Callback not found");
+}
+
+void ConfigSet::notifyChange(const Option& option)
+{
+	for(const Option::ChangeCallback& cb : option.m_changeCallbacks)
+	{
+		cb.m_callback(cb.m_userData, option.m_name.toCString());
+	}
 }
 
 } // end namespace anki
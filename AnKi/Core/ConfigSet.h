@@ -8,6 +8,7 @@
 #include <AnKi/Core/Common.h>
 #include <AnKi/Util/List.h>
 #include <AnKi/Util/String.h>
+#include <AnKi/Util/StringId.h>
 
 namespace anki
 {
@@ -15,7 +16,50 @@ namespace anki
 /// @addtogroup core
 /// @{
 
+/// Callback that is called when the value of an option changes.
+/// @memberof ConfigSet
+using ConfigChangeCallback = void (*)(void* userData, CString option);
+
+/// A handle to an option of a ConfigSet. Reading it doesn't involve any lookup. It's valid for as long as the ConfigSet
+/// that created it is alive.
+/// @tparam T The type of the value. Can be a number, Bool or CString.
+template<typename T>
+class ConfigOption
+{
+	friend class ConfigSet;
+
+public:
+	ConfigOption() = default;
+
+	Bool isValid() const
+	{
+		return m_value != nullptr;
+	}
+
+	template<typename Y = T, ANKI_ENABLE(!std::is_same<Y, CString>::value)>
+	T get() const
+	{
+		ANKI_ASSERT(m_value);
+		return T(*m_value);
+	}
+
+	template<typename Y = T, ANKI_ENABLE(std::is_same<Y, CString>::value)>
+	T get() const
+	{
+		ANKI_ASSERT(m_value);
+		return m_value->toCString();
+	}
+
+private:
+	using Storage = typename std::conditional<
+		std::is_floating_point<T>::value, F64,
+		typename std::conditional<std::is_same<T, CString>::value, String, U64>::type>::type;
+
+	const Storage* m_value = nullptr;
+};
+
 /// A storage of configuration variables.
+/// @note It's not thread-safe.
 class ConfigSet
 {
 public:
@@ -61,6 +105,43 @@ public:
 	CString getString(CString option) const;
 	/// @}
 
+	/// @name Find an option using a precomputed ID and return its value. See ANKI_STRING_ID.
+	/// @{
+	F64 getNumberF64(StringId option) const;
+	F32 getNumberF32(StringId option) const;
+	U64 getNumberU64(StringId option) const;
+	U32 getNumberU32(StringId option) const;
+	U16 getNumberU16(StringId option) const;
+	U8 getNumberU8(StringId option) const;
+	Bool getBool(StringId option) const;
+	CString getString(StringId option) const;
+	/// @}
+
+	/// Get a handle to an option. Resolve it once and then use the handle to read the value.
+	template<typename T>
+	ConfigOption<T> getOption(StringId option) const
+	{
+		ConfigOption<T> out;
+		getOptionValue(option, out.m_value);
+		return out;
+	}
+
+	/// Get a handle to an option. Resolve it once and then use the handle to read the value.
+	template<typename T>
+	ConfigOption<T> getOption(CString option) const
+	{
+		return getOption<T>(StringId(option));
+	}
+
+	/// Register a callback that will be called every time the option changes.
+	void addChangeCallback(CString option, ConfigChangeCallback callback, void* userData);
+
+	/// Unregister a callback that was added with addChangeCallback.
+	void removeChangeCallback(CString option, ConfigChangeCallback callback, void* userData);
+
+	/// Set the value of an option by parsing a string. It's what the command line and the developer console use.
+	ANKI_USE_RESULT Error setFromString(CString option, CString value);
+
 	/// @name Create new options.
 	/// @{
 	void newOption(CString optionName, CString value, CString helpMsg);
@@ -90,23 +171,41 @@ private:
 	HeapAllocator<U8> m_alloc;
 	List<Option> m_options;
 
-	Option* tryFind(CString name);
-	const Option* tryFind(CString name) const;
+	Option* tryFind(StringId name);
+	const Option* tryFind(StringId name) const;
 
-	Option& find(CString name)
+	Option* tryFind(CString name)
+	{
+		return tryFind(StringId(name));
+	}
+
+	const Option* tryFind(CString name) const
+	{
+		return tryFind(StringId(name));
+	}
+
+	Option& find(StringId name)
 	{
 		Option* o = tryFind(name);
 		ANKI_ASSERT(o && "Couldn't find config option");
 		return *o;
 	}
 
-	const Option& find(CString name) const
+	const Option& find(StringId name) const
 	{
 		const Option* o = tryFind(name);
 		ANKI_ASSERT(o && "Couldn't find config option");
 		return *o;
 	}
 
+	void getOptionValue(StringId option, const F64*& value) const;
+	void getOptionValue(StringId option, const U64*& value) const;
+	void getOptionValue(StringId option, const String*& value) const;
+
+	ANKI_USE_RESULT Error setFromStringInternal(Option& option, CString value);
+
+	void notifyChange(const Option& option);
+
 	void setInternal(CString option, F64 value);
 	void setInternal(CString option, U64 value);
 
@@ -6,10 +6,10 @@
 #pragma once
 
 #include <AnKi/Core/Common.h>
+#include <AnKi/Core/TraceBinary.h>
 #include <AnKi/Util/Thread.h>
 #include <AnKi/Util/Allocator.h>
-#include <AnKi/Util/List.h>
-#include <AnKi/Util/File.h>
+#include <AnKi/Util/LockFreeQueue.h>
 
 namespace anki
 {
@@ -17,7 +17,8 @@ namespace anki
 /// @addtogroup core
 /// @{
 
-/// A system that sits on top of the tracer and processes the counters and events.
+/// A system that sits on top of the tracer and processes the counters and events. They are streamed to a binary trace
+/// file (see TraceBinaryWriter) that can be converted to Chrome JSON and CSV with the TraceConverter tool.
 class CoreTracer
 {
 public:
@@ -25,35 +26,43 @@ public:
 
 	~CoreTracer();
 
-	/// @param directory The directory to store the trace and counters.
+	/// @param directory The directory to store the trace.
 	ANKI_USE_RESULT Error init(GenericMemoryPoolAllocator<U8> alloc, CString directory);
 
-	/// It will flush everything.
+	/// Keep only the last frames in memory and write them to the trace when there is a frame time spike or when
+	/// Tracer::requestDump() is called.
+	/// @param frameCount     The number of frames to keep. Zero disables the ring mode.
+	/// @param dumpFrameTime  Dump if a frame takes more than that. Zero disables it.
+	void setRingMode(U32 frameCount, Second dumpFrameTime);
+
+	/// It will flush everything. In ring mode it will flush only if a dump is needed.
 	void flushFrame(U64 frame);
 
 private:
 	class ThreadWorkItem;
-	class PerFrameCounters;
 
 	GenericMemoryPoolAllocator<U8> m_alloc;
 
 	Thread m_thread;
-	ConditionVariable m_cvar;
+	ConditionVariable m_cvar; ///< Used to wake up the thread. The work items don't need the lock.
 	Mutex m_mtx;
 
-	DynamicArray<String> m_counterNames;
-	IntrusiveList<PerFrameCounters> m_frameCounters;
-
-	IntrusiveList<ThreadWorkItem> m_workItems; ///< Items for the thread to process.
-	File m_traceJsonFile;
-	File m_countersCsvFile;
+	MpmcQueue<ThreadWorkItem*> m_workItems; ///< Items for the thread to process.
+	TraceBinaryWriter m_traceWriter; ///< Only the thread touches it.
 	Bool m_quit = false;
 
+	Second m_dumpFrameTime = 0.0;
+	Second m_prevFlushTime = 0.0;
+
+	static constexpr U32 WORK_ITEM_QUEUE_SIZE = 256;
+
 	Error threadWorker();
 
-	Error writeEvents(ThreadWorkItem& item);
-	void gatherCounters(ThreadWorkItem& item);
-	Error writeCountersForReal();
+	void wakeUpThread();
+
+	void flushInternal();
+
+	Error writeWorkItem(ThreadWorkItem& item);
 };
 /// @}
 
@@ -4,6 +4,8 @@
 // http://www.anki3d.org/LICENSE
 
 #include <AnKi/Core/DeveloperConsole.h>
+#include <AnKi/Core/ConfigSet.h>
+#include <AnKi/Util/StringList.h>
 
 namespace anki
 {
@@ -21,9 +23,11 @@ DeveloperConsole::~DeveloperConsole()
 	}
 }
 
-Error DeveloperConsole::init(AllocAlignedCallback allocCb, void* allocCbUserData, ScriptManager* scriptManager)
+Error DeveloperConsole::init(AllocAlignedCallback allocCb, void* allocCbUserData, ScriptManager* scriptManager,
+							 ConfigSet* config)
 {
 	m_alloc = HeapAllocator<U8>(allocCb, allocCbUserData);
+	m_config = config;
 	zeroMemory(m_inputText);
 
 	ANKI_CHECK(m_manager->newInstance(m_font, "EngineAssets/UbuntuMonoRegular.ttf", std::initializer_list<U32>{16}));
@@ -97,10 +101,22 @@ void DeveloperConsole::build(CanvasPtr ctx)
 	if(ImGui::InputText("", &m_inputText[0], m_inputText.getSizeInBytes(), ImGuiInputTextFlags_EnterReturnsTrue,
 						nullptr, nullptr))
 	{
-		const Error err = m_scriptEnv.evalString(&m_inputText[0]);
-		if(!err)
+		const CString input(&m_inputText[0]);
+		if(m_config && input.find("set ") == 0)
 		{
-			ANKI_CORE_LOGI("Script ran without errors");
+			const Error err = setConfigOption(input);
+			if(!err)
+			{
+				ANKI_CORE_LOGI("Config option changed");
+			}
+		}
+		else
+		{
+			const Error err = m_scriptEnv.evalString(input);
+			if(!err)
+			{
+				ANKI_CORE_LOGI("Script ran without errors");
+			}
 		}
 		m_inputText[0] = '\0';
 	}
@@ -149,4 +165,21 @@ void DeveloperConsole::newLogItem(const LoggerMessageInfo& inf)
 	m_logItemsTimestamp.fetchAdd(1);
 }
 
+Error DeveloperConsole::setConfigOption(CString command)
+{
+	StringListAuto tokens(m_alloc);
+	tokens.splitString(command, ' ');
+	if(tokens.getSize() != 3)
+	{
+		ANKI_CORE_LOGE("Expecting: set <option> <value>");
+		return Error::USER_DATA;
+	}
+
+	auto it = tokens.getBegin();
+	++it;
+	const CString option = it->toCString();
+	++it;
+	return m_config->setFromString(option, it->toCString());
+}
+
 } // end namespace anki
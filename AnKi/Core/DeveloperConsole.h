@@ -13,6 +13,9 @@
 namespace anki
 {
 
+// Forward
+class ConfigSet;
+
 /// @addtogroup core
 /// @{
 
@@ -27,7 +30,9 @@ public:
 
 	~DeveloperConsole();
 
-	ANKI_USE_RESULT Error init(AllocAlignedCallback allocCb, void* allocCbUserData, ScriptManager* scriptManager);
+	/// @param config The options that the "set <option> <value>" command will change. Can be nullptr.
+	ANKI_USE_RESULT Error init(AllocAlignedCallback allocCb, void* allocCbUserData, ScriptManager* scriptManager,
+							   ConfigSet* config = nullptr);
 
 	void build(CanvasPtr ctx) override;
 
@@ -55,9 +60,13 @@ private:
 	U32 m_logItemsTimestampConsumed = 0;
 
 	ScriptEnvironment m_scriptEnv;
+	ConfigSet* m_config = nullptr;
 
 	void newLogItem(const LoggerMessageInfo& inf);
 
+	/// Run a "set <option> <value>" command.
+	ANKI_USE_RESULT Error setConfigOption(CString command);
+
 	static void loggerCallback(void* userData, const LoggerMessageInfo& info)
 	{
 		static_cast<DeveloperConsole*>(userData)->newLogItem(info);
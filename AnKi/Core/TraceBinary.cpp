@@ -0,0 +1,377 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Core/TraceBinary.h>
+#include <limits>
+
+namespace anki
+{
+
+static U64 secondsToNanoseconds(Second s)
+{
+	return U64(s * 1000000000.0);
+}
+
+TraceBinaryWriter::~TraceBinaryWriter()
+{
+	if(m_file.isOpen())
+	{
+		const Error err = flush();
+		(void)err;
+	}
+
+	m_buffer.destroy(m_alloc);
+	m_nameIds.destroy(m_alloc);
+	for(String& name : m_names)
+	{
+		name.destroy(m_alloc);
+	}
+	m_names.destroy(m_alloc);
+}
+
+Error TraceBinaryWriter::open(GenericMemoryPoolAllocator<U8> alloc, CString filename)
+{
+	m_alloc = alloc;
+	ANKI_CHECK(m_file.open(filename, FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+
+	TraceBinaryHeader header;
+	memcpy(&header.m_magic[0], TraceBinaryHeader::MAGIC, sizeof(header.m_magic));
+	header.m_version = TraceBinaryHeader::VERSION;
+	header.m_padding = 0;
+	ANKI_CHECK(m_file.write(&header, sizeof(header)));
+
+	m_buffer.create(m_alloc, FLUSH_THRESHOLD * 2);
+	return Error::NONE;
+}
+
+Error TraceBinaryWriter::writeEvents(ThreadId tid, U64 frame, ConstWeakArray<TracerEvent> events)
+{
+	if(events.getSize() == 0)
+	{
+		return Error::NONE;
+	}
+
+	// Write the new names before the block that uses them
+	U32* nameIds = static_cast<U32*>(m_alloc.getMemoryPool().allocate(events.getSize() * sizeof(U32), alignof(U32)));
+	for(U32 i = 0; i < events.getSize(); ++i)
+	{
+		nameIds[i] = internName(events[i].m_name);
+	}
+
+	const U32 sizeOffset = beginBlock(TraceBinaryBlockType::EVENTS);
+	writeVarint(tid);
+	writeVarint(frame);
+	writeVarint(events.getSize());
+
+	U64 prevStart = 0;
+	for(U32 i = 0; i < events.getSize(); ++i)
+	{
+		const U64 start = secondsToNanoseconds(events[i].m_start);
+		ANKI_ASSERT(start >= prevStart && "Events should be sorted");
+		writeVarint(nameIds[i]);
+		writeVarint(start - prevStart);
+		writeVarint(secondsToNanoseconds(events[i].m_duration));
+		prevStart = start;
+	}
+
+	endBlock(sizeOffset);
+	m_alloc.getMemoryPool().free(nameIds);
+
+	return flushIfNeeded();
+}
+
+Error TraceBinaryWriter::writeCounters(ThreadId tid, U64 frame, ConstWeakArray<TracerCounter> counters)
+{
+	if(counters.getSize() == 0)
+	{
+		return Error::NONE;
+	}
+
+	U32* nameIds =
+		static_cast<U32*>(m_alloc.getMemoryPool().allocate(counters.getSize() * sizeof(U32), alignof(U32)));
+	for(U32 i = 0; i < counters.getSize(); ++i)
+	{
+		nameIds[i] = internName(counters[i].m_name, counters[i].m_nameId);
+	}
+
+	const U32 sizeOffset = beginBlock(TraceBinaryBlockType::COUNTERS);
+	writeVarint(tid);
+	writeVarint(frame);
+	writeVarint(counters.getSize());
+
+	for(U32 i = 0; i < counters.getSize(); ++i)
+	{
+		writeVarint(nameIds[i]);
+		writeVarint(counters[i].m_value);
+	}
+
+	endBlock(sizeOffset);
+	m_alloc.getMemoryPool().free(nameIds);
+
+	return flushIfNeeded();
+}
+
+Error TraceBinaryWriter::flush()
+{
+	if(m_bufferSize > 0)
+	{
+		ANKI_CHECK(m_file.write(&m_buffer[0], m_bufferSize));
+		m_bufferSize = 0;
+	}
+
+	return Error::NONE;
+}
+
+U32 TraceBinaryWriter::internName(CString name, StringId nameId)
+{
+	if(!nameId.isValid())
+	{
+		nameId = StringId(name);
+	}
+
+	auto it = m_nameIds.find(nameId);
+	if(it != m_nameIds.getEnd())
+	{
+		if(ANKI_LIKELY(m_names[*it].toCString() == name))
+		{
+			return *it;
+		}
+
+		// Collision. The map keeps the first name so search the rest the slow way
+		for(U32 i = 0; i < m_names.getSize(); ++i)
+		{
+			if(m_names[i].toCString() == name)
+			{
+				return i;
+			}
+		}
+	}
+
+	const U32 id = m_names.getSize();
+	m_names.emplaceBack(m_alloc);
+	m_names.getBack().create(m_alloc, name);
+	if(it == m_nameIds.getEnd())
+	{
+		m_nameIds.emplace(m_alloc, nameId, id);
+	}
+
+	const U32 length = min<U32>(U32(name.getLength()), U32(TraceBinaryHeader::MAX_NAME_LENGTH));
+	const U32 sizeOffset = beginBlock(TraceBinaryBlockType::NAME);
+	writeVarint(id);
+	writeVarint(length);
+	writeBytes(name.cstr(), length);
+	endBlock(sizeOffset);
+
+	return id;
+}
+
+U32 TraceBinaryWriter::beginBlock(TraceBinaryBlockType type)
+{
+	const U8 typeu8 = U8(type);
+	writeBytes(&typeu8, sizeof(typeu8));
+
+	// Reserve the size. It will be written in endBlock
+	const U32 sizeOffset = m_bufferSize;
+	const U32 size = 0;
+	writeBytes(&size, sizeof(size));
+
+	return sizeOffset;
+}
+
+void TraceBinaryWriter::endBlock(U32 sizeOffset)
+{
+	const U32 size = U32(m_bufferSize - sizeOffset - sizeof(U32));
+	memcpy(&m_buffer[sizeOffset], &size, sizeof(size));
+}
+
+void TraceBinaryWriter::writeVarint(U64 val)
+{
+	Array<U8, 10> bytes;
+	U32 count = 0;
+	do
+	{
+		const U8 low = U8(val & 0x7F);
+		val >>= 7;
+		bytes[count++] = (val) ? (low | 0x80) : low;
+	} while(val);
+
+	writeBytes(&bytes[0], count);
+}
+
+void TraceBinaryWriter::writeBytes(const void* data, U32 size)
+{
+	if(m_bufferSize + size > m_buffer.getSize())
+	{
+		// Can't flush here since there might be a block in progress. Grow instead
+		m_buffer.resize(m_alloc, max<U32>(m_buffer.getSize() * 2, m_bufferSize + size));
+	}
+
+	memcpy(&m_buffer[m_bufferSize], data, size);
+	m_bufferSize += size;
+}
+
+namespace
+{
+
+/// Reads the primitives of the binary trace from memory.
+class TraceBinaryParser
+{
+public:
+	const U8* m_begin;
+	const U8* m_end;
+
+	Bool readVarint(U64& val)
+	{
+		val = 0;
+		for(U32 shift = 0; shift < 64 && m_begin < m_end; shift += 7)
+		{
+			const U8 byte = *m_begin++;
+			val |= U64(byte & 0x7F) << shift;
+			if((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	template<typename T>
+	Bool readVarint(T& val)
+	{
+		U64 val64;
+		if(!readVarint(val64) || val64 > U64(std::numeric_limits<T>::max()))
+		{
+			return false;
+		}
+
+		val = T(val64);
+		return true;
+	}
+
+	Bool readBytes(void* data, PtrSize size)
+	{
+		if(PtrSize(m_end - m_begin) < size)
+		{
+			return false;
+		}
+
+		memcpy(data, m_begin, size);
+		m_begin += size;
+		return true;
+	}
+};
+
+} // end anonymous namespace
+
+Error parseTraceBinary(ConstWeakArray<U8, PtrSize> data, TraceBinaryVisitor& visitor)
+{
+	TraceBinaryParser parser;
+	parser.m_begin = data.getBegin();
+	parser.m_end = data.getEnd();
+
+	TraceBinaryHeader header;
+	if(!parser.readBytes(&header, sizeof(header))
+	   || memcmp(&header.m_magic[0], TraceBinaryHeader::MAGIC, sizeof(header.m_magic)) != 0)
+	{
+		ANKI_CORE_LOGE("Not a binary trace");
+		return Error::USER_DATA;
+	}
+
+	if(header.m_version != TraceBinaryHeader::VERSION)
+	{
+		ANKI_CORE_LOGE("Wrong binary trace version: %u", header.m_version);
+		return Error::USER_DATA;
+	}
+
+	Array<char, TraceBinaryHeader::MAX_NAME_LENGTH + 1> nameBuffer;
+	while(parser.m_begin < parser.m_end)
+	{
+		U8 type;
+		U32 size;
+		if(!parser.readBytes(&type, sizeof(type)) || !parser.readBytes(&size, sizeof(size))
+		   || PtrSize(parser.m_end - parser.m_begin) < size)
+		{
+			ANKI_CORE_LOGE("Truncated binary trace");
+			return Error::USER_DATA;
+		}
+
+		TraceBinaryParser block;
+		block.m_begin = parser.m_begin;
+		block.m_end = parser.m_begin + size;
+		parser.m_begin = block.m_end;
+
+		Bool ok = true;
+		switch(TraceBinaryBlockType(type))
+		{
+		case TraceBinaryBlockType::NAME:
+		{
+			U32 nameId;
+			U32 length;
+			ok = block.readVarint(nameId) && block.readVarint(length) && length <= TraceBinaryHeader::MAX_NAME_LENGTH
+				 && block.readBytes(&nameBuffer[0], length);
+			if(ok)
+			{
+				nameBuffer[length] = '\0';
+				visitor.visitName(nameId, &nameBuffer[0]);
+			}
+			break;
+		}
+		case TraceBinaryBlockType::EVENTS:
+		{
+			ThreadId tid;
+			U64 frame;
+			U32 count;
+			ok = block.readVarint(tid) && block.readVarint(frame) && block.readVarint(count);
+
+			U64 start = 0;
+			for(U32 i = 0; i < count && ok; ++i)
+			{
+				U32 nameId;
+				U64 startDelta, duration;
+				ok = block.readVarint(nameId) && block.readVarint(startDelta) && block.readVarint(duration);
+				if(ok)
+				{
+					start += startDelta;
+					visitor.visitEvent(tid, frame, nameId, start, duration);
+				}
+			}
+			break;
+		}
+		case TraceBinaryBlockType::COUNTERS:
+		{
+			ThreadId tid;
+			U64 frame;
+			U32 count;
+			ok = block.readVarint(tid) && block.readVarint(frame) && block.readVarint(count);
+
+			for(U32 i = 0; i < count && ok; ++i)
+			{
+				U32 nameId;
+				U64 value;
+				ok = block.readVarint(nameId) && block.readVarint(value);
+				if(ok)
+				{
+					visitor.visitCounter(tid, frame, nameId, value);
+				}
+			}
+			break;
+		}
+		default:
+			// Unknown block, skip it
+			break;
+		}
+
+		if(!ok)
+		{
+			ANKI_CORE_LOGE("Corrupted block in binary trace");
+			return Error::USER_DATA;
+		}
+	}
+
+	return Error::NONE;
+}
+
+} // end namespace anki
@@ -0,0 +1,119 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Core/Common.h>
+#include <AnKi/Util/Tracer.h>
+#include <AnKi/Util/File.h>
+#include <AnKi/Util/HashMap.h>
+
+namespace anki
+{
+
+/// @addtogroup core
+/// @{
+
+/// The binary trace file starts with a TraceBinaryHeader and then it's a series of blocks. Every block starts with a
+/// TraceBinaryBlockType (U8) and the size of the payload (U32). The integers of the payload are LEB128 varints.
+/// - NAME: The name ID and then the size and the characters of the name. Every name is written once before its first
+///   use.
+/// - EVENTS: The thread ID, the frame, the event count and then per event the name ID, the start (delta from the
+///   previous event's start) and the duration. Times are in nanoseconds.
+/// - COUNTERS: The thread ID, the frame, the counter count and then per counter the name ID and the value.
+enum class TraceBinaryBlockType : U8
+{
+	NAME,
+	EVENTS,
+	COUNTERS,
+
+	COUNT
+};
+
+/// The header of the binary trace file.
+class TraceBinaryHeader
+{
+public:
+	static constexpr const char* MAGIC = "ANKITRC1";
+	static constexpr U32 VERSION = 1;
+	static constexpr U32 MAX_NAME_LENGTH = 255; ///< Longer names are truncated.
+
+	Array<char, 8> m_magic;
+	U32 m_version;
+	U32 m_padding;
+};
+static_assert(sizeof(TraceBinaryHeader) == 16, "Wrong size");
+
+/// Streams the events and counters of CoreTracer to a binary file. The blocks are gathered into a buffer that is
+/// written to the file when it gets big enough.
+/// @note It's not thread-safe.
+class TraceBinaryWriter
+{
+public:
+	TraceBinaryWriter() = default;
+
+	~TraceBinaryWriter();
+
+	ANKI_USE_RESULT Error open(GenericMemoryPoolAllocator<U8> alloc, CString filename);
+
+	/// Write the events of a thread. They should be sorted by their start time.
+	ANKI_USE_RESULT Error writeEvents(ThreadId tid, U64 frame, ConstWeakArray<TracerEvent> events);
+
+	/// Write the counters of a thread.
+	ANKI_USE_RESULT Error writeCounters(ThreadId tid, U64 frame, ConstWeakArray<TracerCounter> counters);
+
+	/// Write the buffered blocks to the file.
+	ANKI_USE_RESULT Error flush();
+
+private:
+	static constexpr U32 FLUSH_THRESHOLD = 64_KB;
+
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	File m_file;
+	DynamicArray<U8> m_buffer;
+	U32 m_bufferSize = 0;
+	HashMap<StringId, U32> m_nameIds;
+	DynamicArray<String> m_names; ///< Indexed by the name ID. Used to detect StringId collisions.
+
+	/// Get the ID of a name. If it's the first time the name is seen a NAME block will be written. Names whose StringId
+	/// collides with the StringId of a different name still get their own ID.
+	/// @param name   The name.
+	/// @param nameId The StringId of the name. If it's invalid it will be computed.
+	U32 internName(CString name, StringId nameId = StringId());
+
+	/// @return The offset of the size of the block. Needs to be passed to endBlock.
+	U32 beginBlock(TraceBinaryBlockType type);
+
+	void endBlock(U32 sizeOffset);
+
+	void writeVarint(U64 val);
+
+	void writeBytes(const void* data, U32 size);
+
+	ANKI_USE_RESULT Error flushIfNeeded()
+	{
+		return (m_bufferSize >= FLUSH_THRESHOLD) ? flush() : Error::NONE;
+	}
+};
+
+/// The interface that receives the contents of a binary trace.
+class TraceBinaryVisitor
+{
+public:
+	virtual ~TraceBinaryVisitor() = default;
+
+	/// @param name It's valid until parseTraceBinary returns.
+	virtual void visitName(U32 nameId, CString name) = 0;
+
+	virtual void visitEvent(ThreadId tid, U64 frame, U32 nameId, U64 startNs, U64 durationNs) = 0;
+
+	virtual void visitCounter(ThreadId tid, U64 frame, U32 nameId, U64 value) = 0;
+};
+
+/// Parse a binary trace that is in memory. The names will be visited before any event or counter that uses them.
+ANKI_USE_RESULT Error parseTraceBinary(ConstWeakArray<U8, PtrSize> data, TraceBinaryVisitor& visitor);
+/// @}
+
+} // end namespace anki
@@ -161,6 +161,8 @@ Error GltfImporter::init(const GltfImporterInitInfo& initInfo)
 	m_rpath.create(initInfo.m_rpath);
 	m_texrpath.create(initInfo.m_texrpath);
 	m_optimizeMeshes = initInfo.m_optimizeMeshes;
+	m_compressMeshes = initInfo.m_compressMeshes;
+	m_printMeshStats = initInfo.m_printMeshStats;
 	m_comment.create(initInfo.m_comment);
 
 	m_lightIntensityScale = max(initInfo.m_lightIntensityScale, EPSILON);
@@ -226,7 +228,7 @@ Error GltfImporter::writeAll()
 	{
 		for(cgltf_node* const* node = scene->nodes; node < scene->nodes + scene->nodes_count && !err; ++node)
 		{
-			err = visitNode(*(*node), Transform::getIdentity(), HashMapAuto<CString, StringAuto>(m_alloc));
+			err = visitNode(*(*node), Transform::getIdentity(), HashMapAuto<StringAuto, StringAuto>(m_alloc));
 		}
 	}
 
@@ -252,7 +254,7 @@ Error GltfImporter::writeAll()
 	return err;
 }
 
-Error GltfImporter::getExtras(const cgltf_extras& extras, HashMapAuto<CString, StringAuto>& out)
+Error GltfImporter::getExtras(const cgltf_extras& extras, HashMapAuto<StringAuto, StringAuto>& out)
 {
 	cgltf_size extrasSize;
 	cgltf_copy_extras_json(m_gltf, &extras, nullptr, &extrasSize);
@@ -315,7 +317,7 @@ Error GltfImporter::getExtras(const cgltf_extras& extras, HashMapAuto<CString, S
 		auto it2 = it;
 		++it2;
 
-		out.emplace(it->toCString(), StringAuto(m_alloc, it2->toCString()));
+		out.emplace(StringAuto(m_alloc, it->toCString()), StringAuto(m_alloc, it2->toCString()));
 		++it;
 		++it;
 	}
@@ -396,7 +398,7 @@ Error GltfImporter::parseArrayOfNumbers(CString str, DynamicArrayAuto<F64>& out,
 }
 
 Error GltfImporter::visitNode(const cgltf_node& node, const Transform& parentTrf,
-							  const HashMapAuto<CString, StringAuto>& parentExtras)
+							  const HashMapAuto<StringAuto, StringAuto>& parentExtras)
 {
 	// Check error from a thread
 	const Error threadErr = m_errorInThread.load();
@@ -406,7 +408,7 @@ Error GltfImporter::visitNode(const cgltf_node& node, const Transform& parentTrf
 		return threadErr;
 	}
 
-	HashMapAuto<CString, StringAuto> outExtras(m_alloc);
+	HashMapAuto<StringAuto, StringAuto> outExtras(m_alloc);
 	if(node.light)
 	{
 		ANKI_CHECK(writeLight(node, parentExtras));
@@ -428,11 +430,11 @@ Error GltfImporter::visitNode(const cgltf_node& node, const Transform& parentTrf
 	else if(node.mesh)
 	{
 		// Handle special nodes
-		HashMapAuto<CString, StringAuto> extras(parentExtras);
+		HashMapAuto<StringAuto, StringAuto> extras(parentExtras);
 		ANKI_CHECK(getExtras(node.mesh->extras, extras));
 		ANKI_CHECK(getExtras(node.extras, extras));
 
-		HashMapAuto<CString, StringAuto>::Iterator it;
+		HashMapAuto<StringAuto, StringAuto>::Iterator it;
 
 		const Bool skipRt = (it = extras.find("no_rt")) != extras.getEnd() && (*it == "true" || *it == "1");
 
@@ -609,7 +611,7 @@ Error GltfImporter::visitNode(const cgltf_node& node, const Transform& parentTrf
 			ctx->m_skin = node.skin;
 			ctx->m_rayTypes = (skipRt) ? RayTypeBit::NONE : RayTypeBit::ALL;
 
-			HashMapAuto<CString, StringAuto>::Iterator it2;
+			HashMapAuto<StringAuto, StringAuto>::Iterator it2;
 			const Bool selfCollision = (it2 = extras.find("collision_mesh")) != extras.getEnd() && *it2 == "self";
 
 			U32 maxLod = 0;
@@ -759,7 +761,7 @@ Error GltfImporter::writeModel(const cgltf_mesh& mesh)
 		return Error::USER_DATA;
 	}
 
-	HashMapAuto<CString, StringAuto> extras(m_alloc);
+	HashMapAuto<StringAuto, StringAuto> extras(m_alloc);
 	ANKI_CHECK(getExtras(mesh.extras, extras));
 
 	File file;
@@ -786,7 +788,7 @@ Error GltfImporter::writeModel(const cgltf_mesh& mesh)
 		ANKI_CHECK(file.writeText("\t\t\t<mesh2>%s%s.ankimesh</mesh2>\n", m_rpath.cstr(), name.cstr()));
 	}
 
-	HashMapAuto<CString, StringAuto> materialExtras(m_alloc);
+	HashMapAuto<StringAuto, StringAuto> materialExtras(m_alloc);
 	ANKI_CHECK(getExtras(mesh.primitives[0].material->extras, materialExtras));
 	auto mtlOverride = materialExtras.find("material_override");
 	if(mtlOverride != materialExtras.getEnd())
@@ -892,7 +894,7 @@ Error GltfImporter::writeAnimation(const cgltf_animation& anim)
 	ANKI_GLTF_LOGI("Importing animation %s", fname.cstr());
 
 	// Gather the channels
-	HashMapAuto<CString, Array<const cgltf_animation_channel*, 3>> channelMap(m_alloc);
+	HashMapAuto<StringAuto, Array<const cgltf_animation_channel*, 3>> channelMap(m_alloc);
 	U32 channelCount = 0;
 	for(U i = 0; i < anim.channels_count; ++i)
 	{
@@ -925,7 +927,7 @@ Error GltfImporter::writeAnimation(const cgltf_animation& anim)
 		{
 			Array<const cgltf_animation_channel*, 3> arr = {};
 			arr[idx] = &channel;
-			channelMap.emplace(channelName.toCString(), arr);
+			channelMap.emplace(channelName, arr);
 			++channelCount;
 		}
 	}
@@ -1165,13 +1167,13 @@ Error GltfImporter::writeSkeleton(const cgltf_skin& skin)
 	return Error::NONE;
 }
 
-Error GltfImporter::writeLight(const cgltf_node& node, const HashMapAuto<CString, StringAuto>& parentExtras)
+Error GltfImporter::writeLight(const cgltf_node& node, const HashMapAuto<StringAuto, StringAuto>& parentExtras)
 {
 	const cgltf_light& light = *node.light;
 	StringAuto nodeName = getNodeName(node);
 	ANKI_GLTF_LOGI("Importing light %s", nodeName.cstr());
 
-	HashMapAuto<CString, StringAuto> extras(parentExtras);
+	HashMapAuto<StringAuto, StringAuto> extras(parentExtras);
 	ANKI_CHECK(getExtras(light.extras, extras));
 
 	CString lightTypeStr;
@@ -1307,7 +1309,7 @@ Error GltfImporter::writeLight(const cgltf_node& node, const HashMapAuto<CString
 	return Error::NONE;
 }
 
-Error GltfImporter::writeCamera(const cgltf_node& node, const HashMapAuto<CString, StringAuto>& parentExtras)
+Error GltfImporter::writeCamera(const cgltf_node& node, const HashMapAuto<StringAuto, StringAuto>& parentExtras)
 {
 	if(node.camera->type != cgltf_camera_type_perspective)
 	{
@@ -1330,11 +1332,11 @@ Error GltfImporter::writeCamera(const cgltf_node& node, const HashMapAuto<CStrin
 	return Error::NONE;
 }
 
-Error GltfImporter::writeModelNode(const cgltf_node& node, const HashMapAuto<CString, StringAuto>& parentExtras)
+Error GltfImporter::writeModelNode(const cgltf_node& node, const HashMapAuto<StringAuto, StringAuto>& parentExtras)
 {
 	ANKI_GLTF_LOGI("Importing model node %s", getNodeName(node).cstr());
 
-	HashMapAuto<CString, StringAuto> extras(parentExtras);
+	HashMapAuto<StringAuto, StringAuto> extras(parentExtras);
 	ANKI_CHECK(getExtras(node.extras, extras));
 
 	StringAuto modelFname(m_alloc);
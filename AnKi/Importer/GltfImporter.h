@@ -31,6 +31,8 @@ public:
 	CString m_rpath;
 	CString m_texrpath;
 	Bool m_optimizeMeshes = true;
+	Bool m_compressMeshes = true; ///< Quantize the vertex attributes and encode the buffers with meshoptimizer.
+	Bool m_printMeshStats = false; ///< Log the size and the decode throughput of every mesh.
 	F32 m_lodFactor = 1.0f;
 	U32 m_lodCount = 1;
 	F32 m_lightIntensityScale = 1.0f;
@@ -86,13 +88,15 @@ private:
 	U32 m_lodCount = 1;
 	F32 m_lightIntensityScale = 1.0f;
 	Bool m_optimizeMeshes = false;
+	Bool m_compressMeshes = false;
+	Bool m_printMeshStats = false;
 	StringAuto m_comment{m_alloc};
 
 	/// Don't generate LODs for meshes with less vertices than this number.
 	U32 m_skipLodVertexCountThreshold = 256;
 
 	// Misc
-	ANKI_USE_RESULT Error getExtras(const cgltf_extras& extras, HashMapAuto<CString, StringAuto>& out);
+	ANKI_USE_RESULT Error getExtras(const cgltf_extras& extras, HashMapAuto<StringAuto, StringAuto>& out);
 	ANKI_USE_RESULT Error parseArrayOfNumbers(CString str, DynamicArrayAuto<F64>& out,
 											  const U32* expectedArraySize = nullptr);
 	void populateNodePtrToIdx();
@@ -139,10 +143,11 @@ private:
 	// Scene
 	ANKI_USE_RESULT Error writeTransform(const Transform& trf);
 	ANKI_USE_RESULT Error visitNode(const cgltf_node& node, const Transform& parentTrf,
-									const HashMapAuto<CString, StringAuto>& parentExtras);
-	ANKI_USE_RESULT Error writeLight(const cgltf_node& node, const HashMapAuto<CString, StringAuto>& parentExtras);
-	ANKI_USE_RESULT Error writeCamera(const cgltf_node& node, const HashMapAuto<CString, StringAuto>& parentExtras);
-	ANKI_USE_RESULT Error writeModelNode(const cgltf_node& node, const HashMapAuto<CString, StringAuto>& parentExtras);
+									const HashMapAuto<StringAuto, StringAuto>& parentExtras);
+	ANKI_USE_RESULT Error writeLight(const cgltf_node& node, const HashMapAuto<StringAuto, StringAuto>& parentExtras);
+	ANKI_USE_RESULT Error writeCamera(const cgltf_node& node, const HashMapAuto<StringAuto, StringAuto>& parentExtras);
+	ANKI_USE_RESULT Error writeModelNode(const cgltf_node& node,
+										 const HashMapAuto<StringAuto, StringAuto>& parentExtras);
 };
 /// @}
 
@@ -109,7 +109,7 @@ Error GltfImporter::writeMaterial(const cgltf_material& mtl, RayTypeBit usedRayT
 		return Error::USER_DATA;
 	}
 
-	HashMapAuto<CString, StringAuto> extras(m_alloc);
+	HashMapAuto<StringAuto, StringAuto> extras(m_alloc);
 	ANKI_CHECK(getExtras(mtl.extras, extras));
 
 	StringAuto xml(m_alloc);
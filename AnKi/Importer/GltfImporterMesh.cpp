@@ -5,6 +5,8 @@
 
 #include <AnKi/Importer/GltfImporter.h>
 #include <AnKi/Util/StringList.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/WeakArray.h>
 #include <AnKi/Collision/Plane.h>
 #include <AnKi/Collision/Functions.h>
 #include <AnKi/Resource/MeshBinary.h>
@@ -106,6 +108,68 @@ static Error alignBufferInFile(PtrSize bufferSize, File& file)
 	return Error::NONE;
 }
 
+/// Write a buffer and align the file after it.
+static Error writeBufferToFile(const void* data, PtrSize size, File& file)
+{
+	ANKI_CHECK(file.write(data, size));
+	return alignBufferInFile(size, file);
+}
+
+/// The layout of the 2nd vertex buffer of a compressed mesh.
+class QuantizedMainVertex
+{
+public:
+	U32 m_normal;
+	U32 m_tangent;
+	U16Vec2 m_uv;
+};
+static_assert(sizeof(QuantizedMainVertex) == MESH_BINARY_COMPRESSED_MAIN_VERTEX_STRIDE, "See file");
+static_assert(sizeof(U16Vec4) == MESH_BINARY_COMPRESSED_POSITION_STRIDE, "See file");
+static_assert(sizeof(BoneInfoVertex) == MESH_BINARY_COMPRESSED_BONE_INFO_STRIDE, "See file");
+
+static U16 quantizeUnorm16(F32 value, F32 min, F32 max)
+{
+	ANKI_ASSERT(max > min);
+	const F32 f = clamp((value - min) / (max - min), 0.0f, 1.0f);
+	return U16(f * F32(MAX_U16) + 0.5f);
+}
+
+static Error encodeIndexBuffer(ConstWeakArray<U16> indices, U32 vertexCount, DynamicArrayAuto<U8>& out)
+{
+	// The encoder wants 32bit indices
+	DynamicArrayAuto<U32> indices32(out.getAllocator());
+	indices32.create(indices.getSize());
+	for(U32 i = 0; i < indices.getSize(); ++i)
+	{
+		indices32[i] = indices[i];
+	}
+
+	out.create(U32(meshopt_encodeIndexBufferBound(indices.getSize(), vertexCount)));
+	const PtrSize size = meshopt_encodeIndexBuffer(&out[0], out.getSize(), &indices32[0], indices32.getSize());
+	if(size == 0)
+	{
+		ANKI_GLTF_LOGE("Failed to encode the index buffer");
+		return Error::FUNCTION_FAILED;
+	}
+
+	out.resize(U32(size));
+	return Error::NONE;
+}
+
+static Error encodeVertexBuffer(const void* vertices, U32 vertexCount, U32 vertexSize, DynamicArrayAuto<U8>& out)
+{
+	out.create(U32(meshopt_encodeVertexBufferBound(vertexCount, vertexSize)));
+	const PtrSize size = meshopt_encodeVertexBuffer(&out[0], out.getSize(), vertices, vertexCount, vertexSize);
+	if(size == 0)
+	{
+		ANKI_GLTF_LOGE("Failed to encode a vertex buffer");
+		return Error::FUNCTION_FAILED;
+	}
+
+	out.resize(U32(size));
+	return Error::NONE;
+}
+
 class TempVertex
 {
 public:
@@ -694,6 +758,10 @@ Error GltfImporter::writeMesh(const cgltf_mesh& mesh, CString nameOverride, F32
 		{
 			header.m_flags |= MeshBinaryFlag::CONVEX;
 		}
+		if(m_compressMeshes)
+		{
+			header.m_flags |= MeshBinaryFlag::COMPRESSED;
+		}
 		header.m_indexType = IndexType::U16;
 		header.m_totalIndexCount = totalIndexCount;
 		header.m_totalVertexCount = totalVertexCount;
@@ -702,32 +770,25 @@ Error GltfImporter::writeMesh(const cgltf_mesh& mesh, CString nameOverride, F32
 		header.m_aabbMax = aabbMax;
 	}
 
-	// Open file
-	File file;
-	ANKI_CHECK(file.open(fname.toCString(), FileOpenFlag::WRITE | FileOpenFlag::BINARY));
-
-	// Write header
-	ANKI_CHECK(file.write(&header, sizeof(header)));
-
-	// Write sub meshes
-	for(const SubMesh& in : submeshes)
+	// Gather the buffers of all submeshes
+	DynamicArrayAuto<U16> indices(m_alloc);
+	indices.create(totalIndexCount);
+	DynamicArrayAuto<Vec3> positions(m_alloc);
+	positions.create(totalVertexCount);
+	DynamicArrayAuto<MainVertex> mainVerts(m_alloc);
+	mainVerts.create(totalVertexCount);
+	DynamicArrayAuto<BoneInfoVertex> boneInfoVerts(m_alloc);
+	if(hasBoneWeights)
 	{
-		MeshBinarySubMesh out;
-		out.m_firstIndex = in.m_firstIdx;
-		out.m_indexCount = in.m_idxCount;
-		out.m_aabbMin = in.m_aabbMin;
-		out.m_aabbMax = in.m_aabbMax;
-
-		ANKI_CHECK(file.write(&out, sizeof(out)));
+		boneInfoVerts.create(totalVertexCount);
 	}
 
-	// Write indices
+	Vec2 uvMin(MAX_F32);
+	Vec2 uvMax(MIN_F32);
+	U32 vertCount = 0;
 	for(const SubMesh& submesh : submeshes)
 	{
-		DynamicArrayAuto<U16> indices(m_alloc);
-		indices.create(submesh.m_indices.getSize());
-		U32 vertCount = 0;
-		for(U32 i = 0; i < indices.getSize(); ++i)
+		for(U32 i = 0; i < submesh.m_indices.getSize(); ++i)
 		{
 			const U32 idx = submesh.m_indices[i] + vertCount;
 			if(idx > MAX_U16)
@@ -736,84 +797,211 @@ Error GltfImporter::writeMesh(const cgltf_mesh& mesh, CString nameOverride, F32
 				return Error::USER_DATA;
 			}
 
-			indices[i] = U16(idx);
+			indices[submesh.m_firstIdx + i] = U16(idx);
+		}
+
+		for(U32 v = 0; v < submesh.m_verts.getSize(); ++v)
+		{
+			const TempVertex& in = submesh.m_verts[v];
+			const U32 outIdx = vertCount + v;
+
+			positions[outIdx] = in.m_position;
+
+			MainVertex& mainVert = mainVerts[outIdx];
+			mainVert.m_normal = packColorToR10G10B10A2SNorm(in.m_normal.x(), in.m_normal.y(), in.m_normal.z(), 0.0f);
+			mainVert.m_tangent =
+				packColorToR10G10B10A2SNorm(in.m_tangent.x(), in.m_tangent.y(), in.m_tangent.z(), in.m_tangent.w());
+			mainVert.m_uvs[UV_CHANNEL_0] = in.m_uv;
+
+			uvMin = uvMin.min(in.m_uv);
+			uvMax = uvMax.max(in.m_uv);
+
+			if(hasBoneWeights)
+			{
+				BoneInfoVertex& boneInfoVert = boneInfoVerts[outIdx];
+				for(U32 c = 0; c < 4; ++c)
+				{
+					if(in.m_boneIds[c] > 0XFF)
+					{
+						ANKI_GLTF_LOGE("Only 256 bones are supported");
+						return Error::USER_DATA;
+					}
+
+					boneInfoVert.m_boneIndices[c] = U8(in.m_boneIds[c]);
+					boneInfoVert.m_boneWeights[c] = U8(in.m_boneWeights[c] * F32(MAX_U8));
+				}
+			}
 		}
 
-		ANKI_CHECK(file.write(&indices[0], indices.getSizeInBytes()));
 		vertCount += submesh.m_verts.getSize();
 	}
 
-	ANKI_CHECK(alignBufferInFile(header.m_totalIndexCount * sizeof(U16), file));
-
-	// Write position vert buffer
-	for(const SubMesh& submesh : submeshes)
+	// Quantize and encode the buffers
+	MeshBinaryCompression compression;
+	memset(&compression, 0, sizeof(compression));
+	DynamicArrayAuto<U8> encodedIndices(m_alloc);
+	DynamicArrayAuto<U8> encodedPositions(m_alloc);
+	DynamicArrayAuto<U8> encodedMainVerts(m_alloc);
+	DynamicArrayAuto<U8> encodedBoneInfoVerts(m_alloc);
+	if(m_compressMeshes)
 	{
-		DynamicArrayAuto<Vec3> positions(m_alloc);
-		positions.create(submesh.m_verts.getSize());
-		for(U32 v = 0; v < submesh.m_verts.getSize(); ++v)
+		ANKI_CHECK(encodeIndexBuffer(indices, totalVertexCount, encodedIndices));
+		compression.m_indexBufferSize = encodedIndices.getSize();
+
+		// Positions relative to the AABB
+		DynamicArrayAuto<U16Vec4> quantizedPositions(m_alloc);
+		quantizedPositions.create(totalVertexCount);
+		for(U32 v = 0; v < totalVertexCount; ++v)
 		{
-			positions[v] = submesh.m_verts[v].m_position;
+			for(U32 d = 0; d < 3; ++d)
+			{
+				quantizedPositions[v][d] = quantizeUnorm16(positions[v][d], aabbMin[d], aabbMax[d]);
+			}
+			quantizedPositions[v].w() = 0;
 		}
-		ANKI_CHECK(file.write(&positions[0], positions.getSizeInBytes()));
-	}
 
-	ANKI_CHECK(alignBufferInFile(header.m_totalVertexCount * sizeof(Vec3), file));
+		ANKI_CHECK(encodeVertexBuffer(&quantizedPositions[0], totalVertexCount, MESH_BINARY_COMPRESSED_POSITION_STRIDE,
+									  encodedPositions));
+		compression.m_vertexBufferSizes[0] = encodedPositions.getSize();
 
-	// Write the 2nd vert buffer
-	for(const SubMesh& submesh : submeshes)
-	{
-		DynamicArrayAuto<MainVertex> verts(m_alloc);
-		verts.create(submesh.m_verts.getSize());
+		// Normals and tangents are already quantized. UVs relative to their range
+		for(U32 d = 0; d < 2; ++d)
+		{
+			if(uvMax[d] - uvMin[d] < EPSILON)
+			{
+				uvMax[d] = uvMin[d] + 1.0f;
+			}
+		}
+		compression.m_uvMin = uvMin;
+		compression.m_uvMax = uvMax;
 
-		for(U32 i = 0; i < verts.getSize(); ++i)
+		DynamicArrayAuto<QuantizedMainVertex> quantizedMainVerts(m_alloc);
+		quantizedMainVerts.create(totalVertexCount);
+		for(U32 v = 0; v < totalVertexCount; ++v)
 		{
-			const Vec3& normal = submesh.m_verts[i].m_normal;
-			const Vec4& tangent = submesh.m_verts[i].m_tangent;
-			const Vec2& uv = submesh.m_verts[i].m_uv;
+			quantizedMainVerts[v].m_normal = mainVerts[v].m_normal;
+			quantizedMainVerts[v].m_tangent = mainVerts[v].m_tangent;
 
-			verts[i].m_normal = packColorToR10G10B10A2SNorm(normal.x(), normal.y(), normal.z(), 0.0f);
-			verts[i].m_tangent = packColorToR10G10B10A2SNorm(tangent.x(), tangent.y(), tangent.z(), tangent.w());
-			verts[i].m_uvs[UV_CHANNEL_0] = uv;
+			const Vec2& uv = mainVerts[v].m_uvs[UV_CHANNEL_0];
+			quantizedMainVerts[v].m_uv =
+				U16Vec2(quantizeUnorm16(uv.x(), uvMin.x(), uvMax.x()), quantizeUnorm16(uv.y(), uvMin.y(), uvMax.y()));
 		}
 
-		ANKI_CHECK(file.write(&verts[0], verts.getSizeInBytes()));
+		ANKI_CHECK(encodeVertexBuffer(&quantizedMainVerts[0], totalVertexCount,
+									  MESH_BINARY_COMPRESSED_MAIN_VERTEX_STRIDE, encodedMainVerts));
+		compression.m_vertexBufferSizes[1] = encodedMainVerts.getSize();
+
+		// Bone info is already quantized
+		if(hasBoneWeights)
+		{
+			ANKI_CHECK(encodeVertexBuffer(&boneInfoVerts[0], totalVertexCount, MESH_BINARY_COMPRESSED_BONE_INFO_STRIDE,
+										  encodedBoneInfoVerts));
+			compression.m_vertexBufferSizes[2] = encodedBoneInfoVerts.getSize();
+		}
 	}
 
-	ANKI_CHECK(alignBufferInFile(header.m_totalVertexCount * sizeof(MainVertex), file));
+	// Open file
+	File file;
+	ANKI_CHECK(file.open(fname.toCString(), FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+
+	// Write header
+	ANKI_CHECK(file.write(&header, sizeof(header)));
 
-	// Write 3rd vert buffer
-	if(hasBoneWeights)
+	// Write sub meshes
+	for(const SubMesh& in : submeshes)
 	{
-		for(const SubMesh& submesh : submeshes)
+		MeshBinarySubMesh out;
+		out.m_firstIndex = in.m_firstIdx;
+		out.m_indexCount = in.m_idxCount;
+		out.m_aabbMin = in.m_aabbMin;
+		out.m_aabbMax = in.m_aabbMax;
+
+		ANKI_CHECK(file.write(&out, sizeof(out)));
+	}
+
+	// Write the buffers
+	if(m_compressMeshes)
+	{
+		ANKI_CHECK(file.write(&compression, sizeof(compression)));
+
+		ANKI_CHECK(writeBufferToFile(&encodedIndices[0], encodedIndices.getSizeInBytes(), file));
+		ANKI_CHECK(writeBufferToFile(&encodedPositions[0], encodedPositions.getSizeInBytes(), file));
+		ANKI_CHECK(writeBufferToFile(&encodedMainVerts[0], encodedMainVerts.getSizeInBytes(), file));
+		if(hasBoneWeights)
+		{
+			ANKI_CHECK(writeBufferToFile(&encodedBoneInfoVerts[0], encodedBoneInfoVerts.getSizeInBytes(), file));
+		}
+	}
+	else
+	{
+		ANKI_CHECK(writeBufferToFile(&indices[0], indices.getSizeInBytes(), file));
+		ANKI_CHECK(writeBufferToFile(&positions[0], positions.getSizeInBytes(), file));
+		ANKI_CHECK(writeBufferToFile(&mainVerts[0], mainVerts.getSizeInBytes(), file));
+		if(hasBoneWeights)
 		{
-			DynamicArrayAuto<BoneInfoVertex> verts(m_alloc);
-			verts.create(submesh.m_verts.getSize());
+			ANKI_CHECK(writeBufferToFile(&boneInfoVerts[0], boneInfoVerts.getSizeInBytes(), file));
+		}
+	}
 
-			for(U32 i = 0; i < verts.getSize(); ++i)
-			{
-				BoneInfoVertex vert;
+	// Print the stats
+	if(m_printMeshStats)
+	{
+		const PtrSize size = indices.getSizeInBytes() + positions.getSizeInBytes() + mainVerts.getSizeInBytes()
+							 + boneInfoVerts.getSizeInBytes();
 
-				for(U32 c = 0; c < 4; ++c)
+		if(!m_compressMeshes)
+		{
+			ANKI_GLTF_LOGI("Mesh stats %s: %u bytes, not compressed", fname.cstr(), U32(size));
+		}
+		else
+		{
+			const PtrSize compressedSize = encodedIndices.getSizeInBytes() + encodedPositions.getSizeInBytes()
+										   + encodedMainVerts.getSizeInBytes()
+										   + encodedBoneInfoVerts.getSizeInBytes();
+
+			// Decode the buffers the same way the loader does. Do it a few times to get a more stable number
+			const U32 boneInfoStride = (hasBoneWeights) ? MESH_BINARY_COMPRESSED_BONE_INFO_STRIDE : 0;
+			DynamicArrayAuto<U8> decoded(m_alloc);
+			decoded.create(max(totalIndexCount * U32(sizeof(U16)),
+							   totalVertexCount * MESH_BINARY_COMPRESSED_MAIN_VERTEX_STRIDE));
+
+			constexpr U32 ITERATIONS = 16;
+			const Second begin = HighRezTimer::getCurrentTime();
+			for(U32 i = 0; i < ITERATIONS; ++i)
+			{
+				int err = meshopt_decodeIndexBuffer(&decoded[0], totalIndexCount, sizeof(U16), &encodedIndices[0],
+													encodedIndices.getSize());
+				err |= meshopt_decodeVertexBuffer(&decoded[0], totalVertexCount, MESH_BINARY_COMPRESSED_POSITION_STRIDE,
+												  &encodedPositions[0], encodedPositions.getSize());
+				err |= meshopt_decodeVertexBuffer(&decoded[0], totalVertexCount,
+												  MESH_BINARY_COMPRESSED_MAIN_VERTEX_STRIDE, &encodedMainVerts[0],
+												  encodedMainVerts.getSize());
+				if(hasBoneWeights)
 				{
-					if(submesh.m_verts[i].m_boneIds[c] > 0XFF)
-					{
-						ANKI_GLTF_LOGE("Only 256 bones are supported");
-						return Error::USER_DATA;
-					}
-
-					vert.m_boneIndices[c] = U8(submesh.m_verts[i].m_boneIds[c]);
-					vert.m_boneWeights[c] = U8(submesh.m_verts[i].m_boneWeights[c] * F32(MAX_U8));
+					err |= meshopt_decodeVertexBuffer(&decoded[0], totalVertexCount, boneInfoStride,
+													  &encodedBoneInfoVerts[0], encodedBoneInfoVerts.getSize());
 				}
 
-				verts[i] = vert;
+				if(err)
+				{
+					ANKI_GLTF_LOGE("Failed to decode the mesh: %s", fname.cstr());
+					return Error::FUNCTION_FAILED;
+				}
 			}
-
-			ANKI_CHECK(file.write(&verts[0], verts.getSizeInBytes()));
+			const Second decodeTime = (HighRezTimer::getCurrentTime() - begin) / Second(ITERATIONS);
+
+			const PtrSize decodedSize =
+				totalIndexCount * sizeof(U16)
+				+ PtrSize(totalVertexCount)
+					  * (MESH_BINARY_COMPRESSED_POSITION_STRIDE + MESH_BINARY_COMPRESSED_MAIN_VERTEX_STRIDE
+						 + boneInfoStride);
+
+			ANKI_GLTF_LOGI("Mesh stats %s: %u bytes uncompressed, %u bytes compressed (%.1f%%), decode %.3fms "
+						   "(%.1fMB/s)",
+						   fname.cstr(), U32(size), U32(compressedSize), F64(compressedSize) / F64(size) * 100.0,
+						   decodeTime * 1000.0, F64(decodedSize) / decodeTime / (1024.0 * 1024.0));
 		}
-
-		ANKI_CHECK(alignBufferInFile(header.m_totalVertexCount * sizeof(BoneInfoVertex), file));
 	}
-
 	return Error::NONE;
 }
 
@@ -32,6 +32,11 @@ public:
 	{
 		return anki::computeHash(this, sizeof(*this), 693);
 	}
+
+	Bool operator==(const HashMapKey& b) const
+	{
+		return m_lightUuid == b.m_lightUuid && m_face == b.m_face;
+	}
 };
 
 TileAllocator::~TileAllocator()
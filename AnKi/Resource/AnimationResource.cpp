@@ -203,15 +203,55 @@ Error AnimationResource::load(const ResourceFilename& filename, Bool async)
 	return Error::NONE;
 }
 
-void AnimationResource::interpolate(U32 channelIndex, Second time, Vec3& pos, Quat& rot, F32& scale) const
+template<typename T>
+U32 AnimationResource::findKeyframe(ConstWeakArray<AnimationKeyframe<T>> keys, Second time, U32 hint)
 {
-	pos = Vec3(0.0f);
-	rot = Quat::getIdentity();
-	scale = 1.0f;
+	const U32 count = keys.getSize();
+	ANKI_ASSERT(count > 1);
+
+	// Try the hint and the pair after it first. That's where the time will be most of the time on forward playback
+	for(U32 i = hint; i < min(hint + 2, count - 1); ++i)
+	{
+		if(time >= keys[i].getTime() && time <= keys[i + 1].getTime())
+		{
+			return i;
+		}
+	}
+
+	if(time < keys[0].getTime() || time > keys[count - 1].getTime())
+	{
+		return MAX_U32;
+	}
+
+	// Binary search the first keyframe that is after the time
+	U32 first = 0;
+	U32 len = count;
+	while(len > 0)
+	{
+		const U32 half = len / 2;
+		if(keys[first + half].getTime() <= time)
+		{
+			first += half + 1;
+			len -= half + 1;
+		}
+		else
+		{
+			len = half;
+		}
+	}
+
+	return min(first, count - 1) - 1;
+}
+
+template U32 AnimationResource::findKeyframe(ConstWeakArray<AnimationKeyframe<Vec3>> keys, Second time, U32 hint);
+template U32 AnimationResource::findKeyframe(ConstWeakArray<AnimationKeyframe<Quat>> keys, Second time, U32 hint);
+template U32 AnimationResource::findKeyframe(ConstWeakArray<AnimationKeyframe<F32>> keys, Second time, U32 hint);
 
+Bool AnimationResource::adjustTime(Second& time) const
+{
 	if(ANKI_UNLIKELY(time < m_startTime))
 	{
-		return;
+		return false;
 	}
 
 	// Audjust time
@@ -221,57 +261,74 @@ void AnimationResource::interpolate(U32 channelIndex, Second time, Vec3& pos, Qu
 	}
 
 	ANKI_ASSERT(time >= m_startTime && time <= m_startTime + m_duration);
-	ANKI_ASSERT(channelIndex < m_channels.getSize());
+	return true;
+}
 
-	const AnimationChannel& channel = m_channels[channelIndex];
+void AnimationResource::interpolateChannel(const AnimationChannel& channel, Second time, Vec3& pos, Quat& rot,
+										   F32& scale, AnimationChannelCursor& cursor)
+{
+	pos = Vec3(0.0f);
+	rot = Quat::getIdentity();
+	scale = 1.0f;
 
 	// Position
 	if(channel.m_positions.getSize() > 1)
 	{
-		for(U32 i = 0; i < channel.m_positions.getSize() - 1; ++i)
+		const U32 i = findKeyframe<Vec3>(channel.m_positions, time, cursor.m_position);
+		if(i != MAX_U32)
 		{
 			const AnimationKeyframe<Vec3>& left = channel.m_positions[i];
 			const AnimationKeyframe<Vec3>& right = channel.m_positions[i + 1];
-			if(time >= left.m_time && time <= right.m_time)
-			{
-				const Second u = (time - left.m_time) / (right.m_time - left.m_time);
-				pos = linearInterpolate(left.m_value, right.m_value, F32(u));
-				break;
-			}
+			const Second u = (time - left.m_time) / (right.m_time - left.m_time);
+			pos = linearInterpolate(left.m_value, right.m_value, F32(u));
+			cursor.m_position = i;
 		}
 	}
 
 	// Rotation
 	if(channel.m_rotations.getSize() > 1)
 	{
-		for(U32 i = 0; i < channel.m_rotations.getSize() - 1; ++i)
+		const U32 i = findKeyframe<Quat>(channel.m_rotations, time, cursor.m_rotation);
+		if(i != MAX_U32)
 		{
 			const AnimationKeyframe<Quat>& left = channel.m_rotations[i];
 			const AnimationKeyframe<Quat>& right = channel.m_rotations[i + 1];
-			if(time >= left.m_time && time <= right.m_time)
-			{
-				const Second u = (time - left.m_time) / (right.m_time - left.m_time);
-				rot = left.m_value.slerp(right.m_value, F32(u));
-				break;
-			}
+			const Second u = (time - left.m_time) / (right.m_time - left.m_time);
+			rot = left.m_value.slerp(right.m_value, F32(u));
+			cursor.m_rotation = i;
 		}
 	}
 
 	// Scale
 	if(channel.m_scales.getSize() > 1)
 	{
-		for(U32 i = 0; i < channel.m_scales.getSize() - 1; ++i)
+		const U32 i = findKeyframe<F32>(channel.m_scales, time, cursor.m_scale);
+		if(i != MAX_U32)
 		{
 			const AnimationKeyframe<F32>& left = channel.m_scales[i];
 			const AnimationKeyframe<F32>& right = channel.m_scales[i + 1];
-			if(time >= left.m_time && time <= right.m_time)
-			{
-				const Second u = (time - left.m_time) / (right.m_time - left.m_time);
-				scale = linearInterpolate(left.m_value, right.m_value, F32(u));
-				break;
-			}
+			const Second u = (time - left.m_time) / (right.m_time - left.m_time);
+			scale = linearInterpolate(left.m_value, right.m_value, F32(u));
+			cursor.m_scale = i;
 		}
 	}
 }
 
+void AnimationResource::interpolate(U32 channelIndex, Second time, Vec3& pos, Quat& rot, F32& scale,
+									AnimationChannelCursor* cursor) const
+{
+	ANKI_ASSERT(channelIndex < m_channels.getSize());
+
+	if(!adjustTime(time))
+	{
+		pos = Vec3(0.0f);
+		rot = Quat::getIdentity();
+		scale = 1.0f;
+		return;
+	}
+
+	AnimationChannelCursor localCursor;
+	interpolateChannel(m_channels[channelIndex], time, pos, rot, scale, (cursor) ? *cursor : localCursor);
+}
+
 } // end namespace anki
@@ -8,6 +8,7 @@
 #include <AnKi/Resource/ResourceObject.h>
 #include <AnKi/Math.h>
 #include <AnKi/Util/String.h>
+#include <AnKi/Util/WeakArray.h>
 
 namespace anki
 {
@@ -25,6 +26,14 @@ class AnimationKeyframe
 	friend class AnimationResource;
 
 public:
+	AnimationKeyframe() = default;
+
+	AnimationKeyframe(Second time, const T& value)
+		: m_time(time)
+		, m_value(value)
+	{
+	}
+
 	Second getTime() const
 	{
 		return m_time;
@@ -63,6 +72,16 @@ public:
 	}
 };
 
+/// Remembers the keyframes AnimationResource::interpolate() found the last time it sampled a channel. Sampling at a
+/// close time (forward playback) will start the search from there.
+class AnimationChannelCursor
+{
+public:
+	U32 m_position = 0;
+	U32 m_rotation = 0;
+	U32 m_scale = 0;
+};
+
 /// Animation consists of keyframe data.
 class AnimationResource : public ResourceObject
 {
@@ -92,12 +111,30 @@ public:
 	}
 
 	/// Get the interpolated data
-	void interpolate(U32 channelIndex, Second time, Vec3& position, Quat& rotation, F32& scale) const;
+	/// @param[in,out] cursor Optional. Speeds up the keyframe search when the time advances a little on every call.
+	void interpolate(U32 channelIndex, Second time, Vec3& position, Quat& rotation, F32& scale,
+					 AnimationChannelCursor* cursor = nullptr) const;
+
+	// Internals:
+
+	/// Find the keyframe pair that contains a point in time.
+	/// @param hint The pair found the previous time. Will be checked first.
+	/// @return The index of the left keyframe or MAX_U32 if the time is outside the keyframes.
+	template<typename T>
+	ANKI_INTERNAL static U32 findKeyframe(ConstWeakArray<AnimationKeyframe<T>> keys, Second time, U32 hint);
+
+	/// Interpolate a channel. The time should be already inside the clip.
+	ANKI_INTERNAL static void interpolateChannel(const AnimationChannel& channel, Second time, Vec3& position,
+												 Quat& rotation, F32& scale, AnimationChannelCursor& cursor);
 
 private:
 	DynamicArray<AnimationChannel> m_channels;
 	Second m_duration;
 	Second m_startTime;
+
+	/// Bring the time inside the clip.
+	/// @return False if the animation hasn't started yet.
+	Bool adjustTime(Second& time) const;
 };
 /// @}
 
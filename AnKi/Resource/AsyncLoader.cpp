@@ -6,12 +6,51 @@
 #include <AnKi/Resource/AsyncLoader.h>
 #include <AnKi/Util/Logger.h>
 #include <AnKi/Util/Tracer.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <algorithm>
 
 namespace anki
 {
 
+static const Array<const char*, AsyncLoader::STAGE_COUNT> STAGE_THREAD_NAMES = {
+	{"anki_asyio", "anki_asydecode", "anki_asytransf"}};
+
+/// Run the task and trace the time it spent in the queue and the time it runs.
+static Error runTask(AsyncLoaderTask& task, AsyncLoaderTaskContext& ctx, Second queueLatency)
+{
+	const U64 latencyUs = U64(queueLatency * 1000000.0);
+	(void)latencyUs;
+
+	switch(ctx.m_stage)
+	{
+	case AsyncLoaderStage::IO:
+	{
+		ANKI_TRACE_INC_COUNTER(RSRC_ASYNC_IO_TASKS, 1);
+		ANKI_TRACE_INC_COUNTER(RSRC_ASYNC_IO_LATENCY_US, latencyUs);
+		ANKI_TRACE_SCOPED_EVENT(RSRC_ASYNC_IO);
+		return task(ctx);
+	}
+	case AsyncLoaderStage::DECODE:
+	{
+		ANKI_TRACE_INC_COUNTER(RSRC_ASYNC_DECODE_TASKS, 1);
+		ANKI_TRACE_INC_COUNTER(RSRC_ASYNC_DECODE_LATENCY_US, latencyUs);
+		ANKI_TRACE_SCOPED_EVENT(RSRC_ASYNC_DECODE);
+		return task(ctx);
+	}
+	case AsyncLoaderStage::TRANSFER:
+	{
+		ANKI_TRACE_INC_COUNTER(RSRC_ASYNC_TRANSFER_TASKS, 1);
+		ANKI_TRACE_INC_COUNTER(RSRC_ASYNC_TRANSFER_LATENCY_US, latencyUs);
+		ANKI_TRACE_SCOPED_EVENT(RSRC_ASYNC_TRANSFER);
+		return task(ctx);
+	}
+	default:
+		ANKI_ASSERT(0);
+		return Error::NONE;
+	}
+}
+
 AsyncLoader::AsyncLoader()
-	: m_thread("anki_asyload")
 {
 }
 
@@ -19,23 +58,42 @@ AsyncLoader::~AsyncLoader()
 {
 	stop();
 
-	if(!m_taskQueue.isEmpty())
+	Bool hasWork = false;
+	for(Stage& stage : m_stages)
 	{
-		ANKI_RESOURCE_LOGW("Stoping loading thread while there is work to do");
-
-		while(!m_taskQueue.isEmpty())
+		for(AsyncLoaderTask* task : stage.m_taskQueue)
 		{
-			AsyncLoaderTask* task = &m_taskQueue.getFront();
-			m_taskQueue.popFront();
+			hasWork = true;
 			m_alloc.deleteInstance(task);
 		}
+
+		stage.m_taskQueue.destroy(m_alloc);
+	}
+
+	if(hasWork)
+	{
+		ANKI_RESOURCE_LOGW("Stoping loading thread while there is work to do");
 	}
 }
 
-void AsyncLoader::init(const HeapAllocator<U8>& alloc)
+void AsyncLoader::init(const HeapAllocator<U8>& alloc, const Array<U32, STAGE_COUNT>& threadCounts)
 {
 	m_alloc = alloc;
-	m_thread.start(this, threadCallback);
+
+	for(AsyncLoaderStage s = AsyncLoaderStage::FIRST; s < AsyncLoaderStage::COUNT; ++s)
+	{
+		Stage& stage = m_stages[s];
+		stage.m_loader = this;
+		stage.m_stage = s;
+
+		ANKI_ASSERT(threadCounts[s] > 0);
+		stage.m_threads.create(m_alloc, threadCounts[s]);
+		for(Thread*& thread : stage.m_threads)
+		{
+			thread = m_alloc.newInstance<Thread>(STAGE_THREAD_NAMES[s]);
+			thread->start(&stage, threadCallback);
+		}
+	}
 }
 
 void AsyncLoader::stop()
@@ -43,137 +101,207 @@ void AsyncLoader::stop()
 	{
 		LockGuard<Mutex> lock(m_mtx);
 		m_quit = true;
-		m_condVar.notifyOne();
+		notifyAllStages();
 	}
 
-	Error err = m_thread.join();
-	(void)err;
+	for(Stage& stage : m_stages)
+	{
+		for(Thread* thread : stage.m_threads)
+		{
+			Error err = thread->join();
+			(void)err;
+			m_alloc.deleteInstance(thread);
+		}
+
+		stage.m_threads.destroy(m_alloc);
+	}
 }
 
 void AsyncLoader::pause()
 {
+	LockGuard<Mutex> lock(m_mtx);
+	m_paused = true;
+
+	// Wait for the running tasks of all stages to finish
+	while(m_runningTaskCount > 0)
 	{
-		LockGuard<Mutex> lock(m_mtx);
-		m_paused = true;
-		m_sync = true;
-		m_condVar.notifyOne();
+		m_idleCondVar.wait(m_mtx);
 	}
-
-	m_barrier.wait();
 }
 
 void AsyncLoader::resume()
 {
 	LockGuard<Mutex> lock(m_mtx);
 	m_paused = false;
-	m_condVar.notifyOne();
+	notifyAllStages();
+}
+
+void AsyncLoader::notifyAllStages()
+{
+	for(Stage& stage : m_stages)
+	{
+		stage.m_condVar.notifyAll();
+	}
 }
 
 Error AsyncLoader::threadCallback(ThreadCallbackInfo& info)
 {
-	AsyncLoader& self = *reinterpret_cast<AsyncLoader*>(info.m_userData);
-	return self.threadWorker();
+	Stage& stage = *reinterpret_cast<Stage*>(info.m_userData);
+	return stage.m_loader->threadWorker(stage);
 }
 
-Error AsyncLoader::threadWorker()
+Error AsyncLoader::threadWorker(Stage& stage)
 {
 	Error err = Error::NONE;
 
 	while(!err)
 	{
 		AsyncLoaderTask* task = nullptr;
-		Bool quit = false;
-		Bool sync = false;
 
 		{
 			// Wait for something
 			LockGuard<Mutex> lock(m_mtx);
-			while((m_taskQueue.isEmpty() || m_paused) && !m_quit && !m_sync)
+			while((stage.m_taskQueue.getSize() == 0 || m_paused) && !m_quit)
 			{
-				m_condVar.wait(m_mtx);
+				stage.m_condVar.wait(m_mtx);
 			}
 
-			// Do some work
 			if(m_quit)
 			{
-				quit = true;
+				break;
 			}
-			else if(m_sync)
-			{
-				sync = true;
-				m_sync = false;
-			}
-			else
-			{
-				task = &m_taskQueue.getFront();
-				m_taskQueue.popFront();
-			}
-		}
 
-		if(quit)
-		{
-			break;
+			task = popTask(stage);
+			++m_runningTaskCount;
 		}
-		else if(sync)
+
+		ANKI_ASSERT(task);
+		AsyncLoaderTaskContext ctx;
+		ctx.m_stage = stage.m_stage;
+
+		if(task->isCancelled())
 		{
-			m_barrier.wait();
+			// Drop it without running it
+			m_cancelledTaskCount.fetchAdd(1);
 		}
 		else
 		{
 			// Exec the task
-			ANKI_ASSERT(task);
-			AsyncLoaderTaskContext ctx;
+			err = runTask(*task, ctx, HighRezTimer::getCurrentTime() - task->m_queueTime);
 
+			if(err)
 			{
-				ANKI_TRACE_SCOPED_EVENT(RSRC_ASYNC_TASK);
-				err = (*task)(ctx);
+				ANKI_RESOURCE_LOGE("Async loader task failed");
 			}
-
-			if(!err)
+			else if(ctx.m_nextStage == AsyncLoaderStage::COUNT && !ctx.m_resubmitTask)
 			{
 				m_completedTaskCount.fetchAdd(1);
 			}
-			else
-			{
-				ANKI_RESOURCE_LOGE("Async loader task failed");
-			}
+		}
 
-			// Do other stuff
-			if(ctx.m_resubmitTask)
+		// Do other stuff
+		ANKI_ASSERT(!(ctx.m_resubmitTask && ctx.m_nextStage != AsyncLoaderStage::COUNT)
+					&& "Can't resubmit and move to another stage at the same time");
+		const Bool requeue =
+			!err && !task->isCancelled() && (ctx.m_resubmitTask || ctx.m_nextStage != AsyncLoaderStage::COUNT);
+		if(requeue)
+		{
+			if(ctx.m_nextStage != AsyncLoaderStage::COUNT)
 			{
-				LockGuard<Mutex> lock(m_mtx);
-				m_taskQueue.pushBack(task);
+				task->m_stage = ctx.m_nextStage;
 			}
-			else
+		}
+		else
+		{
+			// Delete the task
+			m_alloc.deleteInstance(task);
+		}
+
+		{
+			LockGuard<Mutex> lock(m_mtx);
+
+			if(requeue)
 			{
-				// Delete the task
-				m_alloc.deleteInstance(task);
+				pushTask(task);
 			}
 
 			if(ctx.m_pause)
 			{
-				LockGuard<Mutex> lock(m_mtx);
 				m_paused = true;
 			}
+
+			ANKI_ASSERT(m_runningTaskCount > 0);
+			--m_runningTaskCount;
+			if(m_runningTaskCount == 0)
+			{
+				m_idleCondVar.notifyAll();
+			}
 		}
 	}
 
 	return err;
 }
 
-void AsyncLoader::submitTask(AsyncLoaderTask* task)
+void AsyncLoader::submitTask(AsyncLoaderTask* task, U32 priority, AsyncLoaderTaskTokenPtr token)
 {
 	ANKI_ASSERT(task);
+	task->m_priority = priority;
+	task->m_token = std::move(token);
+	task->m_stage = AsyncLoaderStage::IO;
 
-	// Append task to the list
 	LockGuard<Mutex> lock(m_mtx);
-	m_taskQueue.pushBack(task);
+	pushTask(task);
+}
+
+void AsyncLoader::setTaskPriority(const AsyncLoaderTaskTokenPtr& token, U32 priority)
+{
+	ANKI_ASSERT(token.isCreated());
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	for(Stage& stage : m_stages)
+	{
+		Bool changed = false;
+		for(AsyncLoaderTask* task : stage.m_taskQueue)
+		{
+			if(task->m_token == token && task->m_priority != priority)
+			{
+				task->m_priority = priority;
+				changed = true;
+			}
+		}
+
+		if(changed)
+		{
+			// Priority updates are far more rare than pushes and pops so rebuilding the heap is fine
+			std::make_heap(stage.m_taskQueue.getBegin(), stage.m_taskQueue.getEnd(), taskLess);
+		}
+	}
+}
+
+void AsyncLoader::pushTask(AsyncLoaderTask* task)
+{
+	Stage& stage = m_stages[task->m_stage];
+
+	task->m_submitIndex = m_submitCount++;
+	task->m_queueTime = HighRezTimer::getCurrentTime();
+	stage.m_taskQueue.emplaceBack(m_alloc, task);
+	std::push_heap(stage.m_taskQueue.getBegin(), stage.m_taskQueue.getEnd(), taskLess);
 
 	if(!m_paused)
 	{
-		// Wake up the thread if it's not paused
-		m_condVar.notifyOne();
+		// Wake up a thread if it's not paused
+		stage.m_condVar.notifyOne();
 	}
 }
 
+AsyncLoaderTask* AsyncLoader::popTask(Stage& stage)
+{
+	ANKI_ASSERT(stage.m_taskQueue.getSize());
+	std::pop_heap(stage.m_taskQueue.getBegin(), stage.m_taskQueue.getEnd(), taskLess);
+	AsyncLoaderTask* task = stage.m_taskQueue.getBack();
+	stage.m_taskQueue.popBack(m_alloc);
+	return task;
+}
+
 } // end namespace anki
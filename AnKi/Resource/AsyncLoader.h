@@ -7,7 +7,8 @@
 
 #include <AnKi/Resource/Common.h>
 #include <AnKi/Util/Thread.h>
-#include <AnKi/Util/List.h>
+#include <AnKi/Util/DynamicArray.h>
+#include <AnKi/Util/Ptr.h>
 
 namespace anki
 {
@@ -18,39 +19,149 @@ class AsyncLoader;
 /// @addtogroup resource
 /// @{
 
+/// The stages of the AsyncLoader pipeline. Every stage has its own queue and threads so the work of one stage overlaps
+/// with the work of the others.
+enum class AsyncLoaderStage : U8
+{
+	IO, ///< Read files from the disk.
+	DECODE, ///< CPU work like decompression and parsing.
+	TRANSFER, ///< Copy to transfer memory and submit GPU work.
+
+	COUNT,
+	FIRST = 0
+};
+ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(AsyncLoaderStage)
+
 class AsyncLoaderTaskContext
 {
 public:
+	/// The stage the task is running in.
+	AsyncLoaderStage m_stage = AsyncLoaderStage::IO;
+
 	/// Pause the async loader.
 	Bool m_pause = false;
 
-	/// Resubmit the same task at the end of the queue.
+	/// Resubmit the same task at the end of the queue of the same stage.
 	Bool m_resubmitTask = false;
+
+	/// Continue the task in another stage. The task keeps its priority. If it's COUNT the task is done.
+	AsyncLoaderStage m_nextStage = AsyncLoaderStage::COUNT;
 };
 
+/// A token that identifies one or more submitted tasks. It can be used to cancel them or change their priority.
+class AsyncLoaderTaskToken
+{
+	friend class AsyncLoader;
+
+public:
+	AsyncLoaderTaskToken(HeapAllocator<U8> alloc)
+		: m_alloc(alloc)
+	{
+	}
+
+	/// Cancel the tasks. The tasks that haven't started will never run. The ones that are running will finish but
+	/// they will not be resubmitted. Long tasks can poll isCancelled() and bail out early.
+	void cancel()
+	{
+		m_cancelled.store(1);
+	}
+
+	Bool isCancelled() const
+	{
+		return m_cancelled.load() != 0;
+	}
+
+	Atomic<I32>& getRefcount()
+	{
+		return m_refcount;
+	}
+
+	HeapAllocator<U8> getAllocator() const
+	{
+		return m_alloc;
+	}
+
+private:
+	HeapAllocator<U8> m_alloc;
+	Atomic<I32> m_refcount = {0};
+	Atomic<U32> m_cancelled = {0};
+};
+
+/// Token smart pointer.
+using AsyncLoaderTaskTokenPtr = IntrusivePtr<AsyncLoaderTaskToken>;
+
 /// Interface for tasks for the AsyncLoader.
-class AsyncLoaderTask : public IntrusiveListEnabled<AsyncLoaderTask>
+class AsyncLoaderTask
 {
+	friend class AsyncLoader;
+
 public:
 	virtual ~AsyncLoaderTask()
 	{
 	}
 
 	virtual ANKI_USE_RESULT Error operator()(AsyncLoaderTaskContext& ctx) = 0;
+
+	/// Check if the token the task was submitted with got cancelled.
+	Bool isCancelled() const
+	{
+		return m_token.isCreated() && m_token->isCancelled();
+	}
+
+private:
+	AsyncLoaderTaskTokenPtr m_token;
+	U64 m_submitIndex = 0; ///< Keeps the tasks of the same priority in submission order.
+	Second m_queueTime = 0.0; ///< When it entered the queue of its stage.
+	U32 m_priority = 0;
+	AsyncLoaderStage m_stage = AsyncLoaderStage::IO;
 };
 
-/// Asynchronous resource loader.
+/// Asynchronous resource loader. It's a pipeline of stages (see AsyncLoaderStage) and every stage runs its tasks in one
+/// or more threads. Tasks start in the IO stage and move to other stages using AsyncLoaderTaskContext::m_nextStage. In
+/// every stage tasks with higher priority run first and tasks with the same priority run in submission order.
 class AsyncLoader
 {
 public:
+	/// The default priority of the tasks.
+	static constexpr U32 DEFAULT_PRIORITY = 0;
+
+	static constexpr U32 STAGE_COUNT = U32(AsyncLoaderStage::COUNT);
+
 	AsyncLoader();
 
 	~AsyncLoader();
 
-	void init(const HeapAllocator<U8>& alloc);
+	/// @param alloc The allocator.
+	/// @param threadCounts The number of the threads of each stage. If a stage has more than one the tasks may run
+	///                     concurrently and tasks with the same priority may finish in any order.
+	void init(const HeapAllocator<U8>& alloc, const Array<U32, STAGE_COUNT>& threadCounts);
+
+	/// Same as the above with the same number of threads for all stages.
+	void init(const HeapAllocator<U8>& alloc, U32 threadCount = 1)
+	{
+		Array<U32, STAGE_COUNT> threadCounts;
+		for(U32& count : threadCounts)
+		{
+			count = threadCount;
+		}
+		init(alloc, threadCounts);
+	}
+
+	/// Submit a task. It will run in the IO stage first.
+	/// @param task The task.
+	/// @param priority The priority of the task. Higher runs first.
+	/// @param token An optional token to cancel the task or update its priority.
+	void submitTask(AsyncLoaderTask* task, U32 priority = DEFAULT_PRIORITY,
+					AsyncLoaderTaskTokenPtr token = AsyncLoaderTaskTokenPtr());
 
-	/// Submit a task.
-	void submitTask(AsyncLoaderTask* task);
+	/// Create a new token that can be passed to submitTask().
+	AsyncLoaderTaskTokenPtr newTaskToken()
+	{
+		return AsyncLoaderTaskTokenPtr(m_alloc.newInstance<AsyncLoaderTaskToken>(m_alloc));
+	}
+
+	/// Change the priority of the tasks that were submitted with a token and are waiting in a queue.
+	void setTaskPriority(const AsyncLoaderTaskTokenPtr& token, U32 priority);
 
 	/// Create a new asynchronous loading task.
 	template<typename TTask, typename... TArgs>
@@ -66,7 +177,7 @@ public:
 		submitTask(newTask<TTask>(std::forward<TArgs>(args)...));
 	}
 
-	/// Pause the loader. This method will block the caller for the current async task to finish. The rest of the
+	/// Pause the loader. This method will block the caller for the current async tasks to finish. The rest of the
 	/// tasks in the queue will not be executed until resume is called.
 	void pause();
 
@@ -78,32 +189,64 @@ public:
 		return m_alloc;
 	}
 
-	/// Get the total number of completed tasks.
+	/// Get the total number of tasks that completed all their stages.
 	U64 getCompletedTaskCount() const
 	{
 		return m_completedTaskCount.load();
 	}
 
+	/// Get the total number of tasks that were dropped because they got cancelled.
+	U64 getCancelledTaskCount() const
+	{
+		return m_cancelledTaskCount.load();
+	}
+
 private:
+	/// The queue and the threads of a stage.
+	class Stage
+	{
+	public:
+		AsyncLoader* m_loader = nullptr;
+		AsyncLoaderStage m_stage = AsyncLoaderStage::COUNT;
+		DynamicArray<Thread*> m_threads;
+		ConditionVariable m_condVar;
+		DynamicArray<AsyncLoaderTask*> m_taskQueue; ///< A binary heap.
+	};
+
 	HeapAllocator<U8> m_alloc;
-	Thread m_thread;
-	Barrier m_barrier = {2};
+	Array<Stage, STAGE_COUNT> m_stages;
 
-	Mutex m_mtx;
-	ConditionVariable m_condVar;
-	IntrusiveList<AsyncLoaderTask> m_taskQueue;
+	Mutex m_mtx; ///< Protects the state of all stages.
+	ConditionVariable m_idleCondVar; ///< Wakes up pause() when there are no running tasks.
+	U64 m_submitCount = 0;
+	U32 m_runningTaskCount = 0;
 	Bool m_quit = false;
 	Bool m_paused = false;
-	Bool m_sync = false;
 
 	Atomic<U64> m_completedTaskCount = {0};
+	Atomic<U64> m_cancelledTaskCount = {0};
 
 	/// Thread callback
 	static ANKI_USE_RESULT Error threadCallback(ThreadCallbackInfo& info);
 
-	Error threadWorker();
+	Error threadWorker(Stage& stage);
 
 	void stop();
+
+	/// Push to the heap of the task's stage and wake up one of its threads. Needs to be called with the lock held.
+	void pushTask(AsyncLoaderTask* task);
+
+	/// Pop the task with the highest priority. Needs to be called with the lock held.
+	AsyncLoaderTask* popTask(Stage& stage);
+
+	/// Wake up all threads of all stages. Needs to be called with the lock held.
+	void notifyAllStages();
+
+	/// The ordering of the heap.
+	static Bool taskLess(const AsyncLoaderTask* a, const AsyncLoaderTask* b)
+	{
+		return (a->m_priority != b->m_priority) ? a->m_priority < b->m_priority : a->m_submitIndex > b->m_submitIndex;
+	}
 };
 /// @}
 
@@ -10,3 +10,9 @@ ANKI_CONFIG_OPTION(
 	"The engine loads assets only in from these paths. Separate them with : (it's smart enough to identify drive "
 	"letters in Windows)")
 ANKI_CONFIG_OPTION(rsrc_transferScratchMemorySize, 256_MB, 1_MB, 4_GB)
+ANKI_CONFIG_OPTION(rsrc_asyncLoaderIoThreadCount, 1, 1, 16, "The number of threads that read resource files")
+ANKI_CONFIG_OPTION(rsrc_asyncLoaderDecodeThreadCount, 2, 1, 16, "The number of threads that decode resources")
+ANKI_CONFIG_OPTION(rsrc_asyncLoaderTransferThreadCount, 1, 1, 16,
+				   "The number of threads that copy resources to transfer memory")
+ANKI_CONFIG_OPTION(rsrc_shaderVariantManifest, 1, 0, 1,
+				   "Record the shader variants that get used and create them while loading in the next runs")
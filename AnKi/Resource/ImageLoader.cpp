@@ -159,6 +159,13 @@ public:
 		ANKI_ASSERT(!"Not Implemented");
 		return MAX_PTR_SIZE;
 	}
+
+	/// Get a view of the whole file. The data will be empty if the file doesn't support it.
+	virtual ANKI_USE_RESULT Error map(ConstWeakArray<U8, PtrSize>& data)
+	{
+		data = ConstWeakArray<U8, PtrSize>();
+		return Error::NONE;
+	}
 };
 
 class ImageLoader::RsrcFile : public FileInterface
@@ -180,6 +187,11 @@ public:
 	{
 		return m_rfile->getSize();
 	}
+
+	ANKI_USE_RESULT Error map(ConstWeakArray<U8, PtrSize>& data) final
+	{
+		return m_rfile->map(data);
+	}
 };
 
 class ImageLoader::SystemFile : public FileInterface
@@ -454,6 +466,39 @@ Error ImageLoader::loadAnkiTexture(FileInterface& file, U32 maxTextureSize,
 	// Move file pointer
 	//
 
+	// If the file can be mapped the surfaces will point to the mapping. Otherwise read them in new memory
+	ConstWeakArray<U8, PtrSize> fileData;
+	ANKI_CHECK(file.map(fileData));
+	const Bool mapped = fileData.getSize() > 0;
+	PtrSize offset = sizeof(AnkiTextureHeader);
+
+	auto skip = [&](PtrSize size) -> Error {
+		offset += size;
+		return (mapped) ? Error::NONE : file.seek(size, FileSeekOrigin::CURRENT);
+	};
+
+	auto readData = [&](PtrSize size, DynamicArray<U8>& storage, ConstWeakArray<U8, PtrSize>& data) -> Error {
+		if(mapped)
+		{
+			if(offset + size > fileData.getSize())
+			{
+				ANKI_RESOURCE_LOGE("Trying to read past the end of the file. The file is probably truncated");
+				return Error::USER_DATA;
+			}
+
+			data = ConstWeakArray<U8, PtrSize>(&fileData[offset], size);
+		}
+		else
+		{
+			storage.create(alloc, U32(size));
+			ANKI_CHECK(file.read(&storage[0], size));
+			data = ConstWeakArray<U8, PtrSize>(&storage[0], size);
+		}
+
+		offset += size;
+		return Error::NONE;
+	};
+
 	if(preferredCompression == ImageLoaderDataCompression::RAW)
 	{
 		// Do nothing
@@ -463,7 +508,7 @@ Error ImageLoader::loadAnkiTexture(FileInterface& file, U32 maxTextureSize,
 		if((header.m_compressionFormats & ImageLoaderDataCompression::RAW) != ImageLoaderDataCompression::NONE)
 		{
 			// If raw compression is present then skip it
-			ANKI_CHECK(file.seek(calcSizeOfSegment(header, ImageLoaderDataCompression::RAW), FileSeekOrigin::CURRENT));
+			ANKI_CHECK(skip(calcSizeOfSegment(header, ImageLoaderDataCompression::RAW)));
 		}
 	}
 	else if(preferredCompression == ImageLoaderDataCompression::ETC)
@@ -471,13 +516,13 @@ Error ImageLoader::loadAnkiTexture(FileInterface& file, U32 maxTextureSize,
 		if((header.m_compressionFormats & ImageLoaderDataCompression::RAW) != ImageLoaderDataCompression::NONE)
 		{
 			// If raw compression is present then skip it
-			ANKI_CHECK(file.seek(calcSizeOfSegment(header, ImageLoaderDataCompression::RAW), FileSeekOrigin::CURRENT));
+			ANKI_CHECK(skip(calcSizeOfSegment(header, ImageLoaderDataCompression::RAW)));
 		}
 
 		if((header.m_compressionFormats & ImageLoaderDataCompression::S3TC) != ImageLoaderDataCompression::NONE)
 		{
 			// If s3tc compression is present then skip it
-			ANKI_CHECK(file.seek(calcSizeOfSegment(header, ImageLoaderDataCompression::S3TC), FileSeekOrigin::CURRENT));
+			ANKI_CHECK(skip(calcSizeOfSegment(header, ImageLoaderDataCompression::S3TC)));
 		}
 	}
 
@@ -508,14 +553,13 @@ Error ImageLoader::loadAnkiTexture(FileInterface& file, U32 maxTextureSize,
 						surf.m_width = mipWidth;
 						surf.m_height = mipHeight;
 
-						surf.m_data.create(alloc, dataSize);
-						ANKI_CHECK(file.read(&surf.m_data[0], dataSize));
+						ANKI_CHECK(readData(dataSize, surf.m_storage, surf.m_data));
 
 						mipCount = max(header.m_mipCount - mip, mipCount);
 					}
 					else
 					{
-						ANKI_CHECK(file.seek(dataSize, FileSeekOrigin::CURRENT));
+						ANKI_CHECK(skip(dataSize));
 					}
 				}
 			}
@@ -546,14 +590,13 @@ Error ImageLoader::loadAnkiTexture(FileInterface& file, U32 maxTextureSize,
 				vol.m_height = mipHeight;
 				vol.m_depth = mipDepth;
 
-				vol.m_data.create(alloc, dataSize);
-				ANKI_CHECK(file.read(&vol.m_data[0], dataSize));
+				ANKI_CHECK(readData(dataSize, vol.m_storage, vol.m_data));
 
 				mipCount = max(header.m_mipCount - mip, mipCount);
 			}
 			else
 			{
-				ANKI_CHECK(file.seek(dataSize, FileSeekOrigin::CURRENT));
+				ANKI_CHECK(skip(dataSize));
 			}
 
 			mipWidth /= 2;
@@ -569,18 +612,34 @@ Error ImageLoader::loadAnkiTexture(FileInterface& file, U32 maxTextureSize,
 	return Error::NONE;
 }
 
+Error ImageLoader::getFileContents(FileInterface& fs, DynamicArrayAuto<U8>& storage,
+								  ConstWeakArray<U8, PtrSize>& contents)
+{
+	ANKI_CHECK(fs.map(contents));
+
+	if(contents.getSize() == 0)
+	{
+		const PtrSize fileSize = fs.getSize();
+		storage.create(U32(fileSize));
+		ANKI_CHECK(fs.read(&storage[0], fileSize));
+		contents = ConstWeakArray<U8, PtrSize>(&storage[0], fileSize);
+	}
+
+	return Error::NONE;
+}
+
 Error ImageLoader::loadStb(FileInterface& fs, U32& width, U32& height, DynamicArray<U8>& data,
 						   GenericMemoryPoolAllocator<U8>& alloc)
 {
 	// Read the file
-	DynamicArrayAuto<U8> fileData = {alloc};
-	const PtrSize fileSize = fs.getSize();
-	fileData.create(U32(fileSize));
-	ANKI_CHECK(fs.read(&fileData[0], fileSize));
+	DynamicArrayAuto<U8> storage = {alloc};
+	ConstWeakArray<U8, PtrSize> fileData;
+	ANKI_CHECK(getFileContents(fs, storage, fileData));
 
 	// Use STB to read the image
 	int stbw, stbh, comp;
-	U8* stbdata = reinterpret_cast<U8*>(stbi_load_from_memory(&fileData[0], I32(fileSize), &stbw, &stbh, &comp, 4));
+	U8* stbdata = reinterpret_cast<U8*>(
+		stbi_load_from_memory(&fileData[0], I32(fileData.getSize()), &stbw, &stbh, &comp, 4));
 	if(!stbdata)
 	{
 		ANKI_RESOURCE_LOGE("STB failed to read image");
@@ -599,10 +658,31 @@ Error ImageLoader::loadStb(FileInterface& fs, U32& width, U32& height, DynamicAr
 	return Error::NONE;
 }
 
-Error ImageLoader::load(ResourceFilePtr rfile, const CString& filename, U32 maxTextureSize)
+Error ImageLoader::loadStbHeader(FileInterface& fs, U32& width, U32& height, GenericMemoryPoolAllocator<U8>& alloc)
+{
+	DynamicArrayAuto<U8> storage = {alloc};
+	ConstWeakArray<U8, PtrSize> fileData;
+	ANKI_CHECK(getFileContents(fs, storage, fileData));
+
+	int stbw, stbh, comp;
+	if(!stbi_info_from_memory(&fileData[0], I32(fileData.getSize()), &stbw, &stbh, &comp))
+	{
+		ANKI_RESOURCE_LOGE("STB failed to read the image header");
+		return Error::FUNCTION_FAILED;
+	}
+
+	width = U32(stbw);
+	height = U32(stbh);
+
+	return Error::NONE;
+}
+
+Error ImageLoader::load(ResourceFilePtr rfile, const CString& filename, U32 maxTextureSize, Bool deferDecoding)
 {
 	RsrcFile file;
 	file.m_rfile = rfile;
+	m_file = rfile;
+	m_deferDecoding = deferDecoding;
 
 	const Error err = loadInternal(file, filename, maxTextureSize);
 	if(err)
@@ -651,7 +731,9 @@ Error ImageLoader::loadInternal(FileInterface& file, const CString& filename, U3
 		m_depth = 1;
 		m_layerCount = 1;
 		U32 bpp = 0;
-		ANKI_CHECK(loadTga(file, m_surfaces[0].m_width, m_surfaces[0].m_height, bpp, m_surfaces[0].m_data, m_alloc));
+		ANKI_CHECK(
+			loadTga(file, m_surfaces[0].m_width, m_surfaces[0].m_height, bpp, m_surfaces[0].m_storage, m_alloc));
+		m_surfaces[0].m_data = m_surfaces[0].m_storage;
 
 		m_width = m_surfaces[0].m_width;
 		m_height = m_surfaces[0].m_height;
@@ -689,7 +771,17 @@ Error ImageLoader::loadInternal(FileInterface& file, const CString& filename, U3
 		m_layerCount = 1;
 		m_colorFormat = ImageLoaderColorFormat::RGBA8;
 
-		ANKI_CHECK(loadStb(file, m_surfaces[0].m_width, m_surfaces[0].m_height, m_surfaces[0].m_data, m_alloc));
+		if(m_deferDecoding)
+		{
+			ANKI_CHECK(loadStbHeader(file, m_surfaces[0].m_width, m_surfaces[0].m_height, m_alloc));
+			m_decodingDeferred = true;
+		}
+		else
+		{
+			ANKI_CHECK(
+				loadStb(file, m_surfaces[0].m_width, m_surfaces[0].m_height, m_surfaces[0].m_storage, m_alloc));
+			m_surfaces[0].m_data = m_surfaces[0].m_storage;
+		}
 
 		m_width = m_surfaces[0].m_width;
 		m_height = m_surfaces[0].m_height;
@@ -703,6 +795,44 @@ Error ImageLoader::loadInternal(FileInterface& file, const CString& filename, U3
 	return Error::NONE;
 }
 
+Error ImageLoader::prefetch()
+{
+	if(m_file.isCreated())
+	{
+		ConstWeakArray<U8, PtrSize> data;
+		ANKI_CHECK(m_file->mapAndPrefetch(data));
+	}
+
+	return Error::NONE;
+}
+
+Error ImageLoader::decode()
+{
+	if(!m_decodingDeferred)
+	{
+		return Error::NONE;
+	}
+
+	// Only png is deferred ATM
+	ANKI_ASSERT(m_file.isCreated() && m_surfaces.getSize() == 1);
+	RsrcFile file;
+	file.m_rfile = m_file;
+
+	ImageLoaderSurface& surf = m_surfaces[0];
+	U32 width, height;
+	ANKI_CHECK(loadStb(file, width, height, surf.m_storage, m_alloc));
+	if(width != surf.m_width || height != surf.m_height)
+	{
+		ANKI_RESOURCE_LOGE("The size of the decoded image is not the size of the header");
+		return Error::USER_DATA;
+	}
+
+	surf.m_data = surf.m_storage;
+	m_decodingDeferred = false;
+
+	return Error::NONE;
+}
+
 const ImageLoaderSurface& ImageLoader::getSurface(U32 level, U32 face, U32 layer) const
 {
 	ANKI_ASSERT(level < m_mipCount);
@@ -741,17 +871,20 @@ void ImageLoader::destroy()
 {
 	for(ImageLoaderSurface& surf : m_surfaces)
 	{
-		surf.m_data.destroy(m_alloc);
+		surf.m_storage.destroy(m_alloc);
 	}
 
 	m_surfaces.destroy(m_alloc);
 
 	for(ImageLoaderVolume& v : m_volumes)
 	{
-		v.m_data.destroy(m_alloc);
+		v.m_storage.destroy(m_alloc);
 	}
 
 	m_volumes.destroy(m_alloc);
+
+	m_file.reset(nullptr);
+	m_decodingDeferred = false;
 }
 
 } // end namespace anki
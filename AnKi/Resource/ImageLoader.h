@@ -49,7 +49,8 @@ class ImageLoaderSurface
 public:
 	U32 m_width;
 	U32 m_height;
-	DynamicArray<U8> m_data;
+	ConstWeakArray<U8, PtrSize> m_data; ///< Points to m_storage or to the mapped file.
+	DynamicArray<U8> m_storage;
 };
 
 /// An image volume
@@ -60,7 +61,8 @@ public:
 	U32 m_width;
 	U32 m_height;
 	U32 m_depth;
-	DynamicArray<U8> m_data;
+	ConstWeakArray<U8, PtrSize> m_data; ///< Points to m_storage or to the mapped file.
+	DynamicArray<U8> m_storage;
 };
 
 /// Loads bitmaps from regular system files or resource files. Supported formats are .tga and .ankitex.
@@ -127,12 +129,31 @@ public:
 
 	const ImageLoaderVolume& getVolume(U32 level) const;
 
-	/// Load a resource image file.
-	ANKI_USE_RESULT Error load(ResourceFilePtr file, const CString& filename, U32 maxTextureSize = MAX_U32);
+	/// Load a resource image file. If the file can be mapped the surfaces will point to the mapping and the loader will
+	/// keep the file alive.
+	/// @param file The file.
+	/// @param filename The filename. Its extension is used to identify the format.
+	/// @param maxTextureSize Skip the mips that are bigger than that.
+	/// @param deferDecoding If true the formats that need CPU decoding (png) will only read their header. The pixels
+	///                      will be available after decode() is called, possibly in another thread.
+	ANKI_USE_RESULT Error load(ResourceFilePtr file, const CString& filename, U32 maxTextureSize = MAX_U32,
+							   Bool deferDecoding = false);
 
 	/// Load a system image file.
 	ANKI_USE_RESULT Error load(const CString& filename, U32 maxTextureSize = MAX_U32);
 
+	/// Map the resource file and read it from the disk so the surfaces that point to the mapping are in memory.
+	ANKI_USE_RESULT Error prefetch();
+
+	/// Decode the pixels if the decoding was deferred in load().
+	ANKI_USE_RESULT Error decode();
+
+	/// Check if the pixels are ready or decode() needs to be called.
+	Bool isDecoded() const
+	{
+		return !m_decodingDeferred;
+	}
+
 private:
 	class FileInterface;
 	class RsrcFile;
@@ -140,6 +161,8 @@ private:
 
 	GenericMemoryPoolAllocator<U8> m_alloc;
 
+	ResourceFilePtr m_file; ///< Keep it alive because the surfaces might point to its mapping.
+
 	/// [mip][depth or face or layer]. Loader doesn't support cube arrays ATM so face and layer won't be used at the
 	/// same time.
 	DynamicArray<ImageLoaderSurface> m_surfaces;
@@ -154,6 +177,8 @@ private:
 	ImageLoaderDataCompression m_compression = ImageLoaderDataCompression::NONE;
 	ImageLoaderColorFormat m_colorFormat = ImageLoaderColorFormat::NONE;
 	ImageLoaderTextureType m_textureType = ImageLoaderTextureType::NONE;
+	Bool m_deferDecoding = false;
+	Bool m_decodingDeferred = false;
 
 	void destroy();
 
@@ -169,6 +194,13 @@ private:
 	static ANKI_USE_RESULT Error loadStb(FileInterface& fs, U32& width, U32& height, DynamicArray<U8>& data,
 										 GenericMemoryPoolAllocator<U8>& alloc);
 
+	static ANKI_USE_RESULT Error loadStbHeader(FileInterface& fs, U32& width, U32& height,
+											   GenericMemoryPoolAllocator<U8>& alloc);
+
+	/// Map the file or read it if it can't be mapped.
+	static ANKI_USE_RESULT Error getFileContents(FileInterface& fs, DynamicArrayAuto<U8>& storage,
+												 ConstWeakArray<U8, PtrSize>& contents);
+
 	static ANKI_USE_RESULT Error
 	loadAnkiTexture(FileInterface& file, U32 maxTextureSize, ImageLoaderDataCompression& preferredCompression,
 					DynamicArray<ImageLoaderSurface>& surfaces, DynamicArray<ImageLoaderVolume>& volumes,
@@ -6,6 +6,8 @@
 #include <AnKi/Resource/MaterialResource.h>
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Resource/TextureResource.h>
+#include <AnKi/Resource/ShaderVariantManifest.h>
+#include <AnKi/Resource/AsyncLoader.h>
 #include <AnKi/Util/Xml.h>
 
 namespace anki
@@ -14,6 +16,10 @@ namespace anki
 static const Array<CString, U32(BuiltinMutatorId::COUNT)> BUILTIN_MUTATOR_NAMES = {
 	{"NONE", "ANKI_INSTANCED", "ANKI_PASS", "ANKI_LOD", "ANKI_BONES", "ANKI_VELOCITY"}};
 
+static const Array<StringId, U32(BuiltinMutatorId::COUNT)> BUILTIN_MUTATOR_IDS = {
+	{ANKI_STRING_ID("NONE"), ANKI_STRING_ID("ANKI_INSTANCED"), ANKI_STRING_ID("ANKI_PASS"), ANKI_STRING_ID("ANKI_LOD"),
+	 ANKI_STRING_ID("ANKI_BONES"), ANKI_STRING_ID("ANKI_VELOCITY")}};
+
 class BuiltinVarInfo
 {
 public:
@@ -163,6 +169,39 @@ MaterialVariable::~MaterialVariable()
 {
 }
 
+/// Creates the variants that the ShaderVariantManifest remembers.
+class MaterialResource::PrewarmTask : public AsyncLoaderTask
+{
+public:
+	MaterialResourcePtr m_material;
+	DynamicArrayAuto<U8> m_variants;
+	U32 m_variantSize = 0;
+
+	PrewarmTask(const MaterialResourcePtr& material)
+		: m_material(material)
+		, m_variants(material->getManager().getAsyncLoader().getAllocator())
+	{
+	}
+
+	Error operator()(AsyncLoaderTaskContext& ctx) final
+	{
+		if(ctx.m_stage == AsyncLoaderStage::IO)
+		{
+			// Nothing to read. Creating shaders is CPU work
+			ctx.m_nextStage = AsyncLoaderStage::DECODE;
+			return Error::NONE;
+		}
+
+		m_material->prewarmVariants(m_variants, m_variantSize);
+		return Error::NONE;
+	}
+
+	GenericMemoryPoolAllocator<U8> getAllocator() const
+	{
+		return m_material->getManager().getAsyncLoader().getAllocator();
+	}
+};
+
 MaterialResource::MaterialResource(ResourceManager* manager)
 	: ResourceObject(manager)
 {
@@ -252,6 +291,29 @@ Error MaterialResource::load(const ResourceFilename& filename, Bool async)
 		ANKI_CHECK(parseRtMaterial(rtMaterialEl));
 	}
 
+	// Create the variants of the previous runs in the background
+	ShaderVariantManifest* manifest = getManager().getShaderVariantManifest();
+	if(manifest)
+	{
+		UniquePtr<PrewarmTask> task(getManager().getAsyncLoader().newTask<PrewarmTask>(MaterialResourcePtr(this)));
+		manifest->getVariants(filename, task->m_variants, task->m_variantSize);
+
+		if(task->m_variantSize == 0)
+		{
+			// Nothing to create, the task will be deleted
+		}
+		else if(async)
+		{
+			getManager().getAsyncLoader().submitTask(task.get());
+			PrewarmTask* pTask;
+			task.moveAndReset(pTask);
+		}
+		else
+		{
+			prewarmVariants(task->m_variants, task->m_variantSize);
+		}
+	}
+
 	return Error::NONE;
 }
 
@@ -337,7 +399,7 @@ Error MaterialResource::findBuiltinMutators()
 	U builtinMutatorCount = 0;
 
 	m_builtinMutators[BuiltinMutatorId::INSTANCED] =
-		m_prog->tryFindMutator(BUILTIN_MUTATOR_NAMES[BuiltinMutatorId::INSTANCED]);
+		m_prog->tryFindMutator(BUILTIN_MUTATOR_IDS[BuiltinMutatorId::INSTANCED]);
 	if(m_builtinMutators[BuiltinMutatorId::INSTANCED])
 	{
 		if(m_builtinMutators[BuiltinMutatorId::INSTANCED]->m_values.getSize() != 2)
@@ -368,7 +430,7 @@ Error MaterialResource::findBuiltinMutators()
 	}
 
 	// PASS
-	m_builtinMutators[BuiltinMutatorId::PASS] = m_prog->tryFindMutator(BUILTIN_MUTATOR_NAMES[BuiltinMutatorId::PASS]);
+	m_builtinMutators[BuiltinMutatorId::PASS] = m_prog->tryFindMutator(BUILTIN_MUTATOR_IDS[BuiltinMutatorId::PASS]);
 	if(m_builtinMutators[BuiltinMutatorId::PASS] && m_forwardShading)
 	{
 		ANKI_RESOURCE_LOGE("Mutator is not required for forward shading: %s",
@@ -417,7 +479,7 @@ Error MaterialResource::findBuiltinMutators()
 	}
 
 	// LOD
-	m_builtinMutators[BuiltinMutatorId::LOD] = m_prog->tryFindMutator(BUILTIN_MUTATOR_NAMES[BuiltinMutatorId::LOD]);
+	m_builtinMutators[BuiltinMutatorId::LOD] = m_prog->tryFindMutator(BUILTIN_MUTATOR_IDS[BuiltinMutatorId::LOD]);
 	if(m_builtinMutators[BuiltinMutatorId::LOD])
 	{
 		if(m_builtinMutators[BuiltinMutatorId::LOD]->m_values.getSize() > MAX_LOD_COUNT)
@@ -442,7 +504,7 @@ Error MaterialResource::findBuiltinMutators()
 	}
 
 	// BONES
-	m_builtinMutators[BuiltinMutatorId::BONES] = m_prog->tryFindMutator(BUILTIN_MUTATOR_NAMES[BuiltinMutatorId::BONES]);
+	m_builtinMutators[BuiltinMutatorId::BONES] = m_prog->tryFindMutator(BUILTIN_MUTATOR_IDS[BuiltinMutatorId::BONES]);
 	if(m_builtinMutators[BuiltinMutatorId::BONES])
 	{
 		if(m_builtinMutators[BuiltinMutatorId::BONES]->m_values.getSize() != 2)
@@ -501,7 +563,7 @@ Error MaterialResource::findBuiltinMutators()
 
 	// VELOCITY
 	m_builtinMutators[BuiltinMutatorId::VELOCITY] =
-		m_prog->tryFindMutator(BUILTIN_MUTATOR_NAMES[BuiltinMutatorId::VELOCITY]);
+		m_prog->tryFindMutator(BUILTIN_MUTATOR_IDS[BuiltinMutatorId::VELOCITY]);
 	if(m_builtinMutators[BuiltinMutatorId::VELOCITY])
 	{
 		if(m_builtinMutators[BuiltinMutatorId::VELOCITY]->m_values.getSize() != 2)
@@ -871,20 +933,17 @@ const MaterialVariant& MaterialResource::getOrCreateVariant(const RenderingKey&
 	MaterialVariant& variant =
 		m_variantMatrix[key.getPass()][key.getLod()][instanced][key.isSkinned()][key.hasVelocity()];
 
-	// Check if it's initialized
+	// Check if it's initialized. Initialized variants never change so there is no need to lock
+	if(variant.m_initialized.load(AtomicMemoryOrder::ACQUIRE))
 	{
-		RLockGuard<RWMutex> lock(m_variantMatrixMtx);
-		if(variant.m_prog.isCreated())
-		{
-			return variant;
-		}
+		return variant;
 	}
 
 	// Not initialized, init it
-	WLockGuard<RWMutex> lock(m_variantMatrixMtx);
+	LockGuard<Mutex> lock(m_variantMatrixMtx);
 
 	// Check again
-	if(variant.m_prog.isCreated())
+	if(variant.m_initialized.load())
 	{
 		return variant;
 	}
@@ -952,10 +1011,47 @@ const MaterialVariant& MaterialResource::getOrCreateVariant(const RenderingKey&
 
 	// Init the variant
 	initVariant(*progVariant, variant, instanced);
+	variant.m_initialized.store(1, AtomicMemoryOrder::RELEASE);
+
+	// Remember it for the next runs
+	ShaderVariantManifest* manifest = getManager().getShaderVariantManifest();
+	if(manifest)
+	{
+		const Array<U8, 5> manifestVariant = {U8(key.getPass()), U8(key.getLod()), U8(instanced), U8(key.isSkinned()),
+											  U8(key.hasVelocity())};
+		manifest->recordVariant(getFilename(), manifestVariant);
+	}
 
 	return variant;
 }
 
+void MaterialResource::prewarmVariants(ConstWeakArray<U8> variants, U32 variantSize) const
+{
+	if(variantSize != 5)
+	{
+		return;
+	}
+
+	for(U32 offset = 0; offset < variants.getSize(); offset += variantSize)
+	{
+		const Pass pass = Pass(variants[offset]);
+		const U32 lod = variants[offset + 1];
+		const Bool instanced = variants[offset + 2] != 0;
+		const Bool skinned = variants[offset + 3] != 0;
+		const Bool velocity = variants[offset + 4] != 0;
+
+		// The material might have changed since the variant was recorded
+		if(pass >= Pass::COUNT || lod >= m_lodCount || (instanced && !isInstanced())
+		   || (skinned && !m_builtinMutators[BuiltinMutatorId::BONES])
+		   || (velocity && !m_builtinMutators[BuiltinMutatorId::VELOCITY]))
+		{
+			continue;
+		}
+
+		getOrCreateVariant(RenderingKey(pass, lod, (instanced) ? MAX_INSTANCE_COUNT : 1, skinned, velocity));
+	}
+}
+
 void MaterialResource::initVariant(const ShaderProgramResourceVariant& progVariant, MaterialVariant& variant,
 								   Bool instanced) const
 {
@@ -270,6 +270,7 @@ private:
 	BitSet<128, U32> m_activeVars = {false};
 	U32 m_perDrawUboSize = 0;
 	U32 m_perInstanceUboSizeSingleInstance = 0;
+	Atomic<U32> m_initialized = {0}; ///< When it's set the variant doesn't change.
 };
 
 /// Material resource.
@@ -377,6 +378,8 @@ public:
 		return m_perInstanceUboBinding;
 	}
 
+	/// Get or create a variant. The variants that exist already are found without locking.
+	/// @note It's thread-safe.
 	const MaterialVariant& getOrCreateVariant(const RenderingKey& key) const;
 
 	U32 getShaderGroupHandleIndex(RayType type) const
@@ -426,9 +429,11 @@ private:
 	U32 m_boneTrfsBinding = MAX_U32;
 	U32 m_prevFrameBoneTrfsBinding = MAX_U32;
 
-	/// Matrix of variants.
+	class PrewarmTask;
+
+	/// Matrix of variants. The initialized variants are read without locking.
 	mutable Array5d<MaterialVariant, U(Pass::COUNT), MAX_LOD_COUNT, 2, 2, 2> m_variantMatrix;
-	mutable RWMutex m_variantMatrixMtx;
+	mutable Mutex m_variantMatrixMtx;
 
 	DynamicArray<MaterialVariable> m_vars;
 
@@ -457,6 +462,9 @@ private:
 
 	void initVariant(const ShaderProgramResourceVariant& progVariant, MaterialVariant& variant, Bool instanced) const;
 
+	/// Create the variants that the ShaderVariantManifest has.
+	void prewarmVariants(ConstWeakArray<U8> variants, U32 variantSize) const;
+
 	const MaterialVariable* tryFindVariableInternal(CString name) const
 	{
 		for(const MaterialVariable& v : m_vars)
@@ -25,11 +25,25 @@ enum class MeshBinaryFlag : U32
 	NONE = 0,
 	QUAD = 1 << 0,
 	CONVEX = 1 << 1,
+	COMPRESSED = 1 << 2, ///< The buffers are quantized and encoded with meshoptimizer. See MeshBinaryCompression.
 
-	ALL = QUAD | CONVEX,
+	ALL = QUAD | CONVEX | COMPRESSED,
 };
 ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(MeshBinaryFlag)
 
+/// @name The vertex strides of the buffers of a compressed mesh after decoding them with meshoptimizer.
+/// @{
+
+/// The positions are U16Vec4 normalized to the AABB of the mesh.
+constexpr U32 MESH_BINARY_COMPRESSED_POSITION_STRIDE = 8;
+
+/// The normal and the tangent are the same as MainVertex. The UVs are U16Vec2 normalized to the UV range.
+constexpr U32 MESH_BINARY_COMPRESSED_MAIN_VERTEX_STRIDE = 12;
+
+/// The bone info is stored as is.
+constexpr U32 MESH_BINARY_COMPRESSED_BONE_INFO_STRIDE = 8;
+/// @}
+
 /// Vertex buffer info. The size of the buffer is m_vertexStride*MeshBinaryHeader::m_totalVertexCount aligned to
 /// MESH_BINARY_BUFFER_ALIGNMENT.
 class MeshBinaryVertexBuffer
@@ -118,6 +132,39 @@ public:
 	}
 };
 
+/// It follows the submeshes if the mesh has the MeshBinaryFlag::COMPRESSED flag. The buffers in the file are the
+/// meshoptimizer encoded streams and their sizes (before the alignment) are stored here.
+class MeshBinaryCompression
+{
+public:
+	U32 m_indexBufferSize;
+	Array<U32, U32(VertexAttributeLocation::COUNT)> m_vertexBufferSizes;
+	Vec2 m_uvMin; ///< UV range min.
+	Vec2 m_uvMax; ///< UV range max.
+
+	template<typename TSerializer, typename TClass>
+	static void serializeCommon(TSerializer& s, TClass self)
+	{
+		s.doValue("m_indexBufferSize", offsetof(MeshBinaryCompression, m_indexBufferSize), self.m_indexBufferSize);
+		s.doArray("m_vertexBufferSizes", offsetof(MeshBinaryCompression, m_vertexBufferSizes),
+				  &self.m_vertexBufferSizes[0], self.m_vertexBufferSizes.getSize());
+		s.doValue("m_uvMin", offsetof(MeshBinaryCompression, m_uvMin), self.m_uvMin);
+		s.doValue("m_uvMax", offsetof(MeshBinaryCompression, m_uvMax), self.m_uvMax);
+	}
+
+	template<typename TDeserializer>
+	void deserialize(TDeserializer& deserializer)
+	{
+		serializeCommon<TDeserializer, MeshBinaryCompression&>(deserializer, *this);
+	}
+
+	template<typename TSerializer>
+	void serialize(TSerializer& serializer) const
+	{
+		serializeCommon<TSerializer, const MeshBinaryCompression&>(serializer, *this);
+	}
+};
+
 /// The 1st things that appears in a mesh binary. @note The index and vertex buffers are aligned to
 /// MESH_BINARY_BUFFER_ALIGNMENT bytes.
 class MeshBinaryHeader
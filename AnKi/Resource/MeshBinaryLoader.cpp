@@ -5,6 +5,7 @@
 
 #include <AnKi/Resource/MeshBinaryLoader.h>
 #include <AnKi/Resource/ResourceManager.h>
+#include <MeshOptimizer/meshoptimizer.h>
 
 namespace anki
 {
@@ -14,17 +15,29 @@ MeshBinaryLoader::MeshBinaryLoader(ResourceManager* manager)
 {
 }
 
+MeshBinaryLoader::MeshBinaryLoader(ResourceManager* manager, GenericMemoryPoolAllocator<U8> alloc)
+	: MeshBinaryLoader(&manager->getFilesystem(), alloc)
+{
+}
+
 MeshBinaryLoader::~MeshBinaryLoader()
 {
 	m_subMeshes.destroy(m_alloc);
+	m_decodedIndexBuffer.destroy(m_alloc);
+	for(DynamicArray<U8>& buff : m_decodedVertexBuffers)
+	{
+		buff.destroy(m_alloc);
+	}
 }
 
 Error MeshBinaryLoader::load(const ResourceFilename& filename)
 {
 	auto& alloc = m_alloc;
 
+	// Open file. It will be mapped later, when the buffers are needed
+	ANKI_CHECK(m_fs->openFile(filename, m_file));
+
 	// Load header
-	ANKI_CHECK(m_manager->getFilesystem().openFile(filename, m_file));
 	ANKI_CHECK(m_file->read(&m_header, sizeof(m_header)));
 	ANKI_CHECK(checkHeader());
 
@@ -35,10 +48,10 @@ Error MeshBinaryLoader::load(const ResourceFilename& filename)
 
 		// Checks
 		const U32 indicesPerFace = !!(m_header.m_flags & MeshBinaryFlag::QUAD) ? 4 : 3;
-		U idxSum = 0;
-		for(U i = 0; i < m_subMeshes.getSize(); i++)
+		U32 idxSum = 0;
+		for(U32 i = 0; i < m_subMeshes.getSize(); i++)
 		{
-			const MeshBinarySubMesh& sm = m_subMeshes[0];
+			const MeshBinarySubMesh& sm = m_subMeshes[i];
 			if(sm.m_firstIndex != idxSum || (sm.m_indexCount % indicesPerFace) != 0)
 			{
 				ANKI_RESOURCE_LOGE("Incorrect sub mesh info");
@@ -47,7 +60,7 @@ Error MeshBinaryLoader::load(const ResourceFilename& filename)
 
 			for(U d = 0; d < 3; ++d)
 			{
-				if(sm.m_aabbMin[i] >= sm.m_aabbMax[i])
+				if(sm.m_aabbMin[d] >= sm.m_aabbMax[d])
 				{
 					ANKI_RESOURCE_LOGE("Wrong bounding box");
 					return Error::USER_DATA;
@@ -64,6 +77,19 @@ Error MeshBinaryLoader::load(const ResourceFilename& filename)
 		}
 	}
 
+	// Read the compression info
+	if(isCompressed())
+	{
+		ANKI_CHECK(m_file->read(&m_compression, sizeof(m_compression)));
+		ANKI_CHECK(checkCompression());
+	}
+	else
+	{
+		memset(&m_compression, 0, sizeof(m_compression));
+	}
+
+	ANKI_CHECK(checkFileSize());
+
 	return Error::NONE;
 }
 
@@ -203,15 +229,58 @@ Error MeshBinaryLoader::checkHeader() const
 		}
 	}
 
-	// Check the file size
-	PtrSize totalSize = sizeof(m_header);
+	return Error::NONE;
+}
+
+Error MeshBinaryLoader::checkCompression() const
+{
+	// The index codec only works with triangles
+	if(!!(m_header.m_flags & MeshBinaryFlag::QUAD))
+	{
+		ANKI_RESOURCE_LOGE("Compressed meshes can't have quads");
+		return Error::USER_DATA;
+	}
+
+	// The index buffer is decoded to 16bit indices
+	if(m_header.m_indexType != IndexType::U16)
+	{
+		ANKI_RESOURCE_LOGE("Compressed meshes should have 16bit indices");
+		return Error::USER_DATA;
+	}
+
+	if(m_compression.m_indexBufferSize == 0)
+	{
+		ANKI_RESOURCE_LOGE("Wrong compressed index buffer size");
+		return Error::USER_DATA;
+	}
+
+	for(U32 i = 0; i < m_header.m_vertexBufferCount; ++i)
+	{
+		if(m_compression.m_vertexBufferSizes[i] == 0)
+		{
+			ANKI_RESOURCE_LOGE("Wrong compressed vertex buffer size");
+			return Error::USER_DATA;
+		}
+	}
+
+	for(U32 d = 0; d < 2; ++d)
+	{
+		if(m_compression.m_uvMin[d] >= m_compression.m_uvMax[d])
+		{
+			ANKI_RESOURCE_LOGE("Wrong UV range");
+			return Error::USER_DATA;
+		}
+	}
 
-	totalSize += sizeof(MeshBinarySubMesh) * m_header.m_subMeshCount;
-	totalSize += getAlignedIndexBufferSize();
+	return Error::NONE;
+}
 
+Error MeshBinaryLoader::checkFileSize() const
+{
+	PtrSize totalSize = getIndexBufferOffset() + getAlignedStoredIndexBufferSize();
 	for(U32 i = 0; i < m_header.m_vertexBufferCount; ++i)
 	{
-		totalSize += getAlignedVertexBufferSize(i);
+		totalSize += getAlignedStoredVertexBufferSize(i);
 	}
 
 	if(totalSize != m_file->getSize())
@@ -223,17 +292,130 @@ Error MeshBinaryLoader::checkHeader() const
 	return Error::NONE;
 }
 
+Error MeshBinaryLoader::mapFile()
+{
+	ANKI_ASSERT(isLoaded());
+
+	if(m_fileData.getBegin() == nullptr)
+	{
+		ANKI_CHECK(m_file->mapAndPrefetch(m_fileData));
+	}
+
+	return Error::NONE;
+}
+
+Error MeshBinaryLoader::decodeBuffers()
+{
+	ANKI_ASSERT(isLoaded());
+
+	if(!isCompressed() || m_decodedIndexBuffer.getSize() > 0)
+	{
+		return Error::NONE;
+	}
+
+	ANKI_CHECK(mapFile());
+
+	// Indices
+	{
+		const PtrSize offset = getIndexBufferOffset();
+		const PtrSize size = getStoredIndexBufferSize();
+		ANKI_CHECK(checkFileRange(offset, size));
+
+		m_decodedIndexBuffer.create(m_alloc, U32(getIndexBufferSize()));
+		ANKI_ASSERT(m_header.m_indexType == IndexType::U16);
+		if(meshopt_decodeIndexBuffer(&m_decodedIndexBuffer[0], m_header.m_totalIndexCount, sizeof(U16),
+									 &m_fileData[offset], size))
+		{
+			ANKI_RESOURCE_LOGE("Failed to decode the index buffer");
+			return Error::USER_DATA;
+		}
+	}
+
+	// Vertices
+	DynamicArrayAuto<U8> quantized(m_alloc);
+	for(U32 i = 0; i < m_header.m_vertexBufferCount; ++i)
+	{
+		const PtrSize offset = getVertexBufferOffset(i);
+		const PtrSize size = getStoredVertexBufferSize(i);
+		ANKI_CHECK(checkFileRange(offset, size));
+
+		const U32 quantizedStride = (i == 0) ? MESH_BINARY_COMPRESSED_POSITION_STRIDE
+											 : (i == 1) ? MESH_BINARY_COMPRESSED_MAIN_VERTEX_STRIDE
+														: MESH_BINARY_COMPRESSED_BONE_INFO_STRIDE;
+		quantized.resize(m_header.m_totalVertexCount * quantizedStride);
+		if(meshopt_decodeVertexBuffer(&quantized[0], m_header.m_totalVertexCount, quantizedStride,
+									  &m_fileData[offset], size))
+		{
+			ANKI_RESOURCE_LOGE("Failed to decode vertex buffer %u", i);
+			return Error::USER_DATA;
+		}
+
+		m_decodedVertexBuffers[i].create(m_alloc, U32(getVertexBufferSize(i)));
+		dequantizeVertexBuffer(i, quantized, WeakArray<U8>(m_decodedVertexBuffers[i]));
+	}
+
+	return Error::NONE;
+}
+
+void MeshBinaryLoader::dequantizeVertexBuffer(U32 bufferIdx, ConstWeakArray<U8> quantized, WeakArray<U8> out) const
+{
+	const U32 vertexCount = m_header.m_totalVertexCount;
+	const U32 stride = m_header.m_vertexBuffers[bufferIdx].m_vertexStride;
+
+	if(bufferIdx == 0)
+	{
+		// Positions, relative to the AABB
+		ANKI_ASSERT(m_header.m_vertexAttributes[VertexAttributeLocation::POSITION].m_format
+					== Format::R32G32B32_SFLOAT);
+		const Vec3 scale = (m_header.m_aabbMax - m_header.m_aabbMin) / F32(MAX_U16);
+		for(U32 v = 0; v < vertexCount; ++v)
+		{
+			U16Vec4 in;
+			memcpy(&in, &quantized[v * MESH_BINARY_COMPRESSED_POSITION_STRIDE], sizeof(in));
+
+			const Vec3 pos = m_header.m_aabbMin + Vec3(F32(in.x()), F32(in.y()), F32(in.z())) * scale;
+			memcpy(&out[v * stride], &pos, sizeof(pos));
+		}
+	}
+	else if(bufferIdx == 1)
+	{
+		// The normal and the tangent are copied, the UVs are relative to the UV range
+		const U32 uvOffset = m_header.m_vertexAttributes[VertexAttributeLocation::UV].m_relativeOffset;
+		const Vec2 uvScale = (m_compression.m_uvMax - m_compression.m_uvMin) / F32(MAX_U16);
+		for(U32 v = 0; v < vertexCount; ++v)
+		{
+			const U8* in = &quantized[v * MESH_BINARY_COMPRESSED_MAIN_VERTEX_STRIDE];
+			memcpy(&out[v * stride], in, uvOffset);
+
+			U16Vec2 quantizedUv;
+			memcpy(&quantizedUv, in + uvOffset, sizeof(quantizedUv));
+			const Vec2 uv = m_compression.m_uvMin + Vec2(F32(quantizedUv.x()), F32(quantizedUv.y())) * uvScale;
+			memcpy(&out[v * stride + uvOffset], &uv, sizeof(uv));
+		}
+	}
+	else
+	{
+		// Bone info is the same
+		ANKI_ASSERT(stride == MESH_BINARY_COMPRESSED_BONE_INFO_STRIDE);
+		memcpy(&out[0], &quantized[0], out.getSizeInBytes());
+	}
+}
+
 Error MeshBinaryLoader::storeIndexBuffer(void* ptr, PtrSize size)
 {
 	ANKI_ASSERT(ptr);
 	ANKI_ASSERT(isLoaded());
 	ANKI_ASSERT(size == getIndexBufferSize());
 
-	const PtrSize seek = sizeof(m_header) + m_subMeshes.getSizeInBytes();
-	ANKI_CHECK(m_file->seek(seek, FileSeekOrigin::BEGINNING));
-	ANKI_CHECK(m_file->read(ptr, size));
+	if(isCompressed())
+	{
+		ANKI_CHECK(decodeBuffers());
+		memcpy(ptr, &m_decodedIndexBuffer[0], size);
+		return Error::NONE;
+	}
 
-	return Error::NONE;
+	ANKI_CHECK(mapFile());
+	return copyFromFile(getIndexBufferOffset(), ptr, size);
 }
 
 Error MeshBinaryLoader::storeVertexBuffer(U32 bufferIdx, void* ptr, PtrSize size)
@@ -243,14 +425,36 @@ Error MeshBinaryLoader::storeVertexBuffer(U32 bufferIdx, void* ptr, PtrSize size
 	ANKI_ASSERT(bufferIdx < m_header.m_vertexBufferCount);
 	ANKI_ASSERT(size == getVertexBufferSize(bufferIdx));
 
-	PtrSize seek = sizeof(m_header) + m_subMeshes.getSizeInBytes() + getAlignedIndexBufferSize();
-	for(U32 i = 0; i < bufferIdx; ++i)
+	if(isCompressed())
+	{
+		ANKI_CHECK(decodeBuffers());
+		memcpy(ptr, &m_decodedVertexBuffers[bufferIdx][0], size);
+		return Error::NONE;
+	}
+
+	ANKI_CHECK(mapFile());
+	return copyFromFile(getVertexBufferOffset(bufferIdx), ptr, size);
+}
+
+Error MeshBinaryLoader::checkFileRange(PtrSize offset, PtrSize size) const
+{
+	if(offset + size > m_fileData.getSize())
 	{
-		seek += getAlignedVertexBufferSize(i);
+		ANKI_RESOURCE_LOGE("Trying to read past the end of the file. The file is probably truncated");
+		return Error::USER_DATA;
 	}
 
-	ANKI_CHECK(m_file->seek(seek, FileSeekOrigin::BEGINNING));
-	ANKI_CHECK(m_file->read(ptr, size));
+	return Error::NONE;
+}
+
+Error MeshBinaryLoader::copyFromFile(PtrSize offset, void* ptr, PtrSize size) const
+{
+	ANKI_CHECK(checkFileRange(offset, size));
+
+	if(size)
+	{
+		memcpy(ptr, &m_fileData[offset], size);
+	}
 
 	return Error::NONE;
 }
@@ -258,21 +462,32 @@ Error MeshBinaryLoader::storeVertexBuffer(U32 bufferIdx, void* ptr, PtrSize size
 Error MeshBinaryLoader::storeIndicesAndPosition(DynamicArrayAuto<U32>& indices, DynamicArrayAuto<Vec3>& positions)
 {
 	ANKI_ASSERT(isLoaded());
+	ANKI_CHECK(mapFile());
 
 	// Store indices
 	{
 		indices.resize(m_header.m_totalIndexCount);
 
-		// Store to staging buff
-		DynamicArrayAuto<U8, PtrSize> staging(m_alloc);
-		staging.create(getIndexBufferSize());
-		ANKI_CHECK(storeIndexBuffer(&staging[0], staging.getSizeInBytes()));
-
-		// Copy from staging
+		// Convert straight from the file or the decoded buffer
 		ANKI_ASSERT(m_header.m_indexType == IndexType::U16);
+		const U8* data;
+		if(isCompressed())
+		{
+			ANKI_CHECK(decodeBuffers());
+			data = &m_decodedIndexBuffer[0];
+		}
+		else
+		{
+			const PtrSize offset = getIndexBufferOffset();
+			ANKI_CHECK(checkFileRange(offset, getIndexBufferSize()));
+			data = &m_fileData[offset];
+		}
+
 		for(U32 i = 0; i < m_header.m_totalIndexCount; ++i)
 		{
-			indices[i] = *reinterpret_cast<U16*>(&staging[PtrSize(i) * 2]);
+			U16 idx;
+			memcpy(&idx, data + PtrSize(i) * 2, sizeof(idx));
+			indices[i] = idx;
 		}
 	}
 
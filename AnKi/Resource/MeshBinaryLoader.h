@@ -22,16 +22,28 @@ class MeshBinaryLoader
 public:
 	MeshBinaryLoader(ResourceManager* manager);
 
-	MeshBinaryLoader(ResourceManager* manager, GenericMemoryPoolAllocator<U8> alloc)
-		: m_manager(manager)
+	MeshBinaryLoader(ResourceManager* manager, GenericMemoryPoolAllocator<U8> alloc);
+
+	MeshBinaryLoader(ResourceFilesystem* fs, GenericMemoryPoolAllocator<U8> alloc)
+		: m_fs(fs)
 		, m_alloc(alloc)
 	{
+		ANKI_ASSERT(fs);
 	}
 
 	~MeshBinaryLoader();
 
+	/// Open the file and read the header and the submeshes.
 	ANKI_USE_RESULT Error load(const ResourceFilename& filename);
 
+	/// Map the file and read it from the disk. The buffers are copied from the mapping. It's called by the store
+	/// methods if it hasn't been called before. Call it earlier to do the disk reads in another thread.
+	ANKI_USE_RESULT Error mapFile();
+
+	/// Decode the buffers of a compressed mesh. It's called by the store methods if it hasn't been called before. Call
+	/// it earlier to do the decoding in another thread. It does nothing if the mesh is not compressed.
+	ANKI_USE_RESULT Error decodeBuffers();
+
 	ANKI_USE_RESULT Error storeIndexBuffer(void* ptr, PtrSize size);
 
 	ANKI_USE_RESULT Error storeVertexBuffer(U32 bufferIdx, void* ptr, PtrSize size);
@@ -45,6 +57,12 @@ public:
 		return m_header;
 	}
 
+	Bool isCompressed() const
+	{
+		ANKI_ASSERT(isLoaded());
+		return !!(m_header.m_flags & MeshBinaryFlag::COMPRESSED);
+	}
+
 	Bool hasBoneInfo() const
 	{
 		ANKI_ASSERT(isLoaded());
@@ -57,29 +75,50 @@ public:
 	}
 
 private:
-	ResourceManager* m_manager;
+	ResourceFilesystem* m_fs;
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	ResourceFilePtr m_file;
+	ConstWeakArray<U8, PtrSize> m_fileData; ///< The mapped file. Empty until mapFile() is called.
 
 	MeshBinaryHeader m_header;
 
 	DynamicArray<MeshBinarySubMesh> m_subMeshes;
 
+	/// @name Compressed mesh data
+	/// @{
+	MeshBinaryCompression m_compression;
+	DynamicArray<U8> m_decodedIndexBuffer; ///< Empty until decodeBuffers() is called.
+	Array<DynamicArray<U8>, U32(VertexAttributeLocation::COUNT)> m_decodedVertexBuffers;
+	/// @}
+
 	Bool isLoaded() const
 	{
 		return m_file.get() != nullptr;
 	}
 
+	PtrSize getIndexBufferOffset() const
+	{
+		ANKI_ASSERT(isLoaded());
+		return sizeof(m_header) + m_subMeshes.getSizeInBytes() + ((isCompressed()) ? sizeof(m_compression) : 0);
+	}
+
 	PtrSize getIndexBufferSize() const
 	{
 		ANKI_ASSERT(isLoaded());
 		return PtrSize(m_header.m_totalIndexCount) * ((m_header.m_indexType == IndexType::U16) ? 2 : 4);
 	}
 
-	PtrSize getAlignedIndexBufferSize() const
+	/// The size of the index buffer in the file. It's different than getIndexBufferSize() if the mesh is compressed.
+	PtrSize getStoredIndexBufferSize() const
+	{
+		ANKI_ASSERT(isLoaded());
+		return (isCompressed()) ? m_compression.m_indexBufferSize : getIndexBufferSize();
+	}
+
+	PtrSize getAlignedStoredIndexBufferSize() const
 	{
 		ANKI_ASSERT(isLoaded());
-		return getAlignedRoundUp(MESH_BINARY_BUFFER_ALIGNMENT, getIndexBufferSize());
+		return getAlignedRoundUp(MESH_BINARY_BUFFER_ALIGNMENT, getStoredIndexBufferSize());
 	}
 
 	PtrSize getVertexBufferSize(U32 bufferIdx) const
@@ -89,14 +128,46 @@ private:
 		return PtrSize(m_header.m_totalVertexCount) * PtrSize(m_header.m_vertexBuffers[bufferIdx].m_vertexStride);
 	}
 
-	PtrSize getAlignedVertexBufferSize(U32 bufferIdx) const
+	/// The size of the vertex buffer in the file. It's different than getVertexBufferSize() if the mesh is compressed.
+	PtrSize getStoredVertexBufferSize(U32 bufferIdx) const
 	{
 		ANKI_ASSERT(isLoaded());
 		ANKI_ASSERT(bufferIdx < m_header.m_vertexBufferCount);
-		return getAlignedRoundUp(MESH_BINARY_BUFFER_ALIGNMENT, getVertexBufferSize(bufferIdx));
+		return (isCompressed()) ? m_compression.m_vertexBufferSizes[bufferIdx] : getVertexBufferSize(bufferIdx);
+	}
+
+	PtrSize getAlignedStoredVertexBufferSize(U32 bufferIdx) const
+	{
+		ANKI_ASSERT(isLoaded());
+		ANKI_ASSERT(bufferIdx < m_header.m_vertexBufferCount);
+		return getAlignedRoundUp(MESH_BINARY_BUFFER_ALIGNMENT, getStoredVertexBufferSize(bufferIdx));
+	}
+
+	PtrSize getVertexBufferOffset(U32 bufferIdx) const
+	{
+		PtrSize offset = getIndexBufferOffset() + getAlignedStoredIndexBufferSize();
+		for(U32 i = 0; i < bufferIdx; ++i)
+		{
+			offset += getAlignedStoredVertexBufferSize(i);
+		}
+
+		return offset;
 	}
 
 	ANKI_USE_RESULT Error checkHeader() const;
+
+	ANKI_USE_RESULT Error checkCompression() const;
+
+	ANKI_USE_RESULT Error checkFileSize() const;
+
+	ANKI_USE_RESULT Error checkFileRange(PtrSize offset, PtrSize size) const;
+
+	/// Copy a part of the file from the mapping.
+	ANKI_USE_RESULT Error copyFromFile(PtrSize offset, void* ptr, PtrSize size) const;
+
+	/// Convert a decoded vertex buffer of a compressed mesh to the format of the header.
+	void dequantizeVertexBuffer(U32 bufferIdx, ConstWeakArray<U8> quantized, WeakArray<U8> out) const;
+
 	ANKI_USE_RESULT Error checkFormat(VertexAttributeLocation type, ConstWeakArray<Format> supportedFormats,
 									  U32 vertexBufferIdx, U32 relativeOffset) const;
 };
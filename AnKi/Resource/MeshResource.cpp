@@ -39,6 +39,23 @@ public:
 
 	Error operator()(AsyncLoaderTaskContext& ctx) final
 	{
+		if(ctx.m_stage == AsyncLoaderStage::IO)
+		{
+			// Read the file. Compressed meshes need to be decoded before the transfer stage copies them
+			ANKI_CHECK(m_ctx.m_loader.mapFile());
+			ctx.m_nextStage =
+				(m_ctx.m_loader.isCompressed()) ? AsyncLoaderStage::DECODE : AsyncLoaderStage::TRANSFER;
+			return Error::NONE;
+		}
+
+		if(ctx.m_stage == AsyncLoaderStage::DECODE)
+		{
+			ANKI_CHECK(m_ctx.m_loader.decodeBuffers());
+			ctx.m_nextStage = AsyncLoaderStage::TRANSFER;
+			return Error::NONE;
+		}
+
+		ANKI_ASSERT(ctx.m_stage == AsyncLoaderStage::TRANSFER);
 		return m_ctx.m_mesh->loadAsync(m_ctx.m_loader);
 	}
 
@@ -5,6 +5,7 @@
 
 #include <AnKi/Resource/ResourceFilesystem.h>
 #include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/MemoryMappedFile.h>
 #include <AnKi/Core/ConfigSet.h>
 #include <AnKi/Util/Tracer.h>
 #include <ZLib/contrib/minizip/unzip.h>
@@ -17,12 +18,25 @@ class CResourceFile final : public ResourceFile
 {
 public:
 	File m_file;
+	String m_filename;
+	MemoryMappedFile m_mapping;
 
 	CResourceFile(GenericMemoryPoolAllocator<U8> alloc)
 		: ResourceFile(alloc)
 	{
 	}
 
+	~CResourceFile()
+	{
+		m_filename.destroy(getAllocator());
+	}
+
+	ANKI_USE_RESULT Error open(const CString& filename)
+	{
+		m_filename.create(getAllocator(), filename);
+		return m_file.open(filename, FileOpenFlag::READ);
+	}
+
 	ANKI_USE_RESULT Error read(void* buff, PtrSize size) override
 	{
 		ANKI_TRACE_SCOPED_EVENT(RSRC_FILE_READ);
@@ -56,6 +70,19 @@ public:
 	{
 		return m_file.getSize();
 	}
+
+	ANKI_USE_RESULT Error map(ConstWeakArray<U8, PtrSize>& data) override
+	{
+		ANKI_TRACE_SCOPED_EVENT(RSRC_FILE_READ);
+
+		if(!m_mapping.isMapped())
+		{
+			ANKI_CHECK(m_mapping.map(m_filename.toCString()));
+		}
+
+		data = m_mapping.getData();
+		return Error::NONE;
+	}
 };
 
 /// ZIP file
@@ -64,6 +91,10 @@ class ZipResourceFile final : public ResourceFile
 public:
 	unzFile m_archive = nullptr;
 	PtrSize m_size = 0;
+	String m_archiveFilename;
+	PtrSize m_dataOffset = 0; ///< Where the data of the file start inside the archive.
+	Bool m_stored = false; ///< Not compressed and not encrypted.
+	MemoryMappedFile m_mapping;
 
 	ZipResourceFile(GenericMemoryPoolAllocator<U8> alloc)
 		: ResourceFile(alloc)
@@ -79,6 +110,8 @@ public:
 			m_archive = nullptr;
 			m_size = 0;
 		}
+
+		m_archiveFilename.destroy(getAllocator());
 	}
 
 	ANKI_USE_RESULT Error open(const CString& archive, const CString& archivedFname)
@@ -113,6 +146,12 @@ public:
 		m_size = zinfo.uncompressed_size;
 		ANKI_ASSERT(m_size != 0);
 
+		// Stored files can be mapped straight from the archive
+		const uLong encryptedFlag = 1;
+		m_stored = zinfo.compression_method == 0 && (zinfo.flag & encryptedFlag) == 0;
+		m_dataOffset = PtrSize(unzGetCurrentFileZStreamPos64(m_archive));
+		m_archiveFilename.create(getAllocator(), archive);
+
 		return Error::NONE;
 	}
 
@@ -191,8 +230,57 @@ public:
 		ANKI_ASSERT(m_size > 0);
 		return m_size;
 	}
+
+	ANKI_USE_RESULT Error map(ConstWeakArray<U8, PtrSize>& data) override
+	{
+		ANKI_TRACE_SCOPED_EVENT(RSRC_FILE_READ);
+
+		if(!m_stored)
+		{
+			return readAllContents(PtrSize(unztell64(m_archive)), data);
+		}
+
+		if(!m_mapping.isMapped())
+		{
+			ANKI_CHECK(m_mapping.map(m_archiveFilename.toCString(), m_dataOffset, m_size));
+		}
+
+		data = m_mapping.getData();
+		return Error::NONE;
+	}
 };
 
+Error ResourceFile::mapAndPrefetch(ConstWeakArray<U8, PtrSize>& data)
+{
+	ANKI_CHECK(map(data));
+
+	// Touch one byte per page. The page size is at least 4K everywhere
+	constexpr PtrSize PAGE_SIZE = 4_KB;
+	U8 sum = 0;
+	for(PtrSize offset = 0; offset < data.getSize(); offset += PAGE_SIZE)
+	{
+		sum = U8(sum + static_cast<const volatile U8*>(data.getBegin())[offset]);
+	}
+	(void)sum;
+
+	return Error::NONE;
+}
+
+Error ResourceFile::readAllContents(PtrSize crntPosition, ConstWeakArray<U8, PtrSize>& data)
+{
+	const PtrSize size = getSize();
+	if(m_contents.getSize() != size)
+	{
+		m_contents.create(m_alloc, size);
+		ANKI_CHECK(seek(0, FileSeekOrigin::BEGINNING));
+		ANKI_CHECK(read(m_contents.getBegin(), size));
+		ANKI_CHECK(seek(crntPosition, FileSeekOrigin::BEGINNING));
+	}
+
+	data = ConstWeakArray<U8, PtrSize>(m_contents.getBegin(), size);
+	return Error::NONE;
+}
+
 ResourceFilesystem::~ResourceFilesystem()
 {
 	for(Path& p : m_paths)
@@ -263,7 +351,7 @@ void ResourceFilesystem::addCachePath(const CString& path)
 Error ResourceFilesystem::addNewPath(const CString& path)
 {
 	U32 fileCount = 0;
-	static const CString extension(".AnKiZLibip");
+	static const CString extension(".ankizip");
 
 	auto pos = path.find(extension);
 	if(pos != CString::NPOS && pos == path.getLength() - extension.getLength())
@@ -376,7 +464,7 @@ Error ResourceFilesystem::openFile(const ResourceFilename& filename, ResourceFil
 				CResourceFile* file = m_alloc.newInstance<CResourceFile>(m_alloc);
 				rfile = file;
 
-				err = file->m_file.open(&newFname[0], FileOpenFlag::READ);
+				err = file->open(newFname.toCString());
 			}
 		}
 		else
@@ -406,7 +494,7 @@ Error ResourceFilesystem::openFile(const ResourceFilename& filename, ResourceFil
 					CResourceFile* file = m_alloc.newInstance<CResourceFile>(m_alloc);
 					rfile = file;
 
-					err = file->m_file.open(&newFname[0], FileOpenFlag::READ);
+					err = file->open(newFname.toCString());
 
 #if 0
 					printf("Opening asset %s\n", &newFname[0]);
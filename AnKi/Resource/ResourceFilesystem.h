@@ -9,6 +9,7 @@
 #include <AnKi/Util/String.h>
 #include <AnKi/Util/StringList.h>
 #include <AnKi/Util/File.h>
+#include <AnKi/Util/WeakArray.h>
 #include <AnKi/Util/Ptr.h>
 
 namespace anki
@@ -31,6 +32,7 @@ public:
 
 	virtual ~ResourceFile()
 	{
+		m_contents.destroy(m_alloc);
 	}
 
 	/// Read data from the file
@@ -53,6 +55,15 @@ public:
 	/// Get the size of the file.
 	virtual PtrSize getSize() const = 0;
 
+	/// Get a view of the whole file. If the file can be memory mapped there is no copy, otherwise its contents are
+	/// read in memory that the file owns. The view is valid while the file is alive. Doesn't move the position
+	/// indicator.
+	virtual ANKI_USE_RESULT Error map(ConstWeakArray<U8, PtrSize>& data) = 0;
+
+	/// Same as map() but it also touches the pages of the mapping so the disk reads happen now and not when the data
+	/// are accessed.
+	ANKI_USE_RESULT Error mapAndPrefetch(ConstWeakArray<U8, PtrSize>& data);
+
 	Atomic<I32>& getRefcount()
 	{
 		return m_refcount;
@@ -63,9 +74,16 @@ public:
 		return m_alloc;
 	}
 
+protected:
+	/// Implement map() for files that can't be mapped by reading everything.
+	/// @param crntPosition The position indicator. It will be restored after reading.
+	/// @param data The contents.
+	ANKI_USE_RESULT Error readAllContents(PtrSize crntPosition, ConstWeakArray<U8, PtrSize>& data);
+
 private:
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	Atomic<I32> m_refcount = {0};
+	DynamicArray<U8, PtrSize> m_contents; ///< Used by readAllContents.
 };
 
 /// Resource file smart pointer.
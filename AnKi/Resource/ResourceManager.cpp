@@ -6,6 +6,7 @@
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Resource/AsyncLoader.h>
 #include <AnKi/Resource/ShaderProgramResourceSystem.h>
+#include <AnKi/Resource/ShaderVariantManifest.h>
 #include <AnKi/Resource/AnimationResource.h>
 #include <AnKi/Util/Logger.h>
 #include <AnKi/Core/ConfigSet.h>
@@ -32,6 +33,18 @@ ResourceManager::ResourceManager()
 
 ResourceManager::~ResourceManager()
 {
+	if(m_shaderVariantManifest)
+	{
+		StringAuto fname(m_alloc);
+		fname.sprintf("%s/ShaderVariants.ankivariants", m_cacheDir.cstr());
+		if(m_shaderVariantManifest->save(fname))
+		{
+			ANKI_RESOURCE_LOGW("Failed to save the shader variant manifest");
+		}
+
+		m_alloc.deleteInstance(m_shaderVariantManifest);
+	}
+
 	m_cacheDir.destroy(m_alloc);
 	m_alloc.deleteInstance(m_asyncLoader);
 	m_alloc.deleteInstance(m_shaderProgramSystem);
@@ -60,9 +73,13 @@ Error ResourceManager::init(ResourceManagerInitInfo& init)
 #undef ANKI_INSTANTIATE_RESOURCE
 #undef ANKI_INSTANSIATE_RESOURCE_DELIMITER
 
-	// Init the thread
+	// Init the threads
 	m_asyncLoader = m_alloc.newInstance<AsyncLoader>();
-	m_asyncLoader->init(m_alloc);
+	Array<U32, AsyncLoader::STAGE_COUNT> threadCounts;
+	threadCounts[AsyncLoaderStage::IO] = init.m_config->getNumberU32("rsrc_asyncLoaderIoThreadCount");
+	threadCounts[AsyncLoaderStage::DECODE] = init.m_config->getNumberU32("rsrc_asyncLoaderDecodeThreadCount");
+	threadCounts[AsyncLoaderStage::TRANSFER] = init.m_config->getNumberU32("rsrc_asyncLoaderTransferThreadCount");
+	m_asyncLoader->init(m_alloc, threadCounts);
 
 	m_transferGpuAlloc = m_alloc.newInstance<TransferGpuAllocator>();
 	ANKI_CHECK(m_transferGpuAlloc->init(init.m_config->getNumberU32("rsrc_transferScratchMemorySize"), m_gr, m_alloc));
@@ -71,6 +88,15 @@ Error ResourceManager::init(ResourceManagerInitInfo& init)
 	m_shaderProgramSystem = m_alloc.newInstance<ShaderProgramResourceSystem>(m_cacheDir, m_gr, m_fs, m_alloc);
 	ANKI_CHECK(m_shaderProgramSystem->init());
 
+	// Load the variants of the previous runs
+	if(init.m_config->getBool("rsrc_shaderVariantManifest"))
+	{
+		m_shaderVariantManifest = m_alloc.newInstance<ShaderVariantManifest>(m_alloc);
+		StringAuto fname(m_alloc);
+		fname.sprintf("%s/ShaderVariants.ankivariants", m_cacheDir.cstr());
+		ANKI_CHECK(m_shaderVariantManifest->load(fname));
+	}
+
 	return Error::NONE;
 }
 
@@ -103,6 +129,9 @@ Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out
 		// Increment the refcount in that case where async jobs increment it and decrement it in the scope of a load()
 		ptr->getRefcount().fetchAdd(1);
 
+		// Set the filename before loading because async jobs might need it
+		ptr->setFilename(filename);
+
 		// Populate the ptr. Use a block to cleanup temp_pool allocations
 		auto& pool = m_tmpAlloc.getMemoryPool();
 
@@ -121,7 +150,6 @@ Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out
 			ANKI_ASSERT(pool.getAllocationsCount() == allocsCountBefore && "Forgot to deallocate");
 		}
 
-		ptr->setFilename(filename);
 		ptr->setUuid(++m_uuid);
 
 		// Reset the memory pool if no-one is using it.
@@ -131,12 +159,21 @@ Error ResourceManager::loadResource(const CString& filename, ResourcePtr<T>& out
 			pool.reset();
 		}
 
-		// Register resource
-		registerResource(ptr);
-		out.reset(ptr);
+		// Register resource. Another thread might have loaded the same file in the meantime, use that one
+		T* const registered = registerResource(ptr);
+		out.reset(registered);
 
-		// Decrement because of the increment happened a few lines above
-		ptr->getRefcount().fetchSub(1);
+		if(registered != ptr)
+		{
+			// Let the refcount drop our copy (it might still be referenced by async tasks)
+			ResourcePtr<T> discarded(ptr);
+			ptr->getRefcount().fetchSub(1);
+		}
+		else
+		{
+			// Decrement because of the increment happened a few lines above
+			ptr->getRefcount().fetchSub(1);
+		}
 	}
 
 	return err;
@@ -6,7 +6,8 @@
 #pragma once
 
 #include <AnKi/Resource/TransferGpuAllocator.h>
-#include <AnKi/Util/List.h>
+#include <AnKi/Util/HashMap.h>
+#include <AnKi/Util/Thread.h>
 #include <AnKi/Util/Functions.h>
 #include <AnKi/Util/String.h>
 
@@ -22,11 +23,13 @@ class AsyncLoader;
 class ResourceManagerModel;
 class ShaderCompilerCache;
 class ShaderProgramResourceSystem;
+class ShaderVariantManifest;
 
 /// @addtogroup resource
 /// @{
 
-/// Manage resources of a certain type
+/// Manage resources of a certain type. The resources are indexed by their filename.
+/// @note It's thread-safe.
 template<typename Type>
 class TypeResourceManager
 {
@@ -43,21 +46,36 @@ protected:
 
 	Type* findLoadedResource(const CString& filename)
 	{
-		auto it = find(filename);
-		return (it != m_ptrs.end()) ? *it : nullptr;
+		RLockGuard<RWMutex> lock(m_mtx);
+		auto it = m_ptrs.find(filename);
+		return (it != m_ptrs.getEnd()) ? *it : nullptr;
 	}
 
-	void registerResource(Type* ptr)
+	/// Register a resource if no other resource with the same filename is registered.
+	/// @return The resource that ended up registered. It's not @a ptr if another thread loaded the same file first.
+	Type* registerResource(Type* ptr)
 	{
-		ANKI_ASSERT(find(ptr->getFilename()) == m_ptrs.getEnd());
-		m_ptrs.pushBack(m_alloc, ptr);
+		WLockGuard<RWMutex> lock(m_mtx);
+		auto it = m_ptrs.find(ptr->getFilename());
+		if(it != m_ptrs.getEnd())
+		{
+			return *it;
+		}
+
+		m_ptrs.emplace(m_alloc, ptr->getFilename(), ptr);
+		return ptr;
 	}
 
 	void unregisterResource(Type* ptr)
 	{
-		auto it = find(ptr->getFilename());
-		ANKI_ASSERT(it != m_ptrs.end());
-		m_ptrs.erase(m_alloc, it);
+		WLockGuard<RWMutex> lock(m_mtx);
+		auto it = m_ptrs.find(ptr->getFilename());
+
+		// It might not be registered if it lost the race in registerResource()
+		if(it != m_ptrs.getEnd() && *it == ptr)
+		{
+			m_ptrs.erase(m_alloc, it);
+		}
 	}
 
 	void init(ResourceAllocator<U8> alloc)
@@ -66,25 +84,9 @@ protected:
 	}
 
 private:
-	using Container = List<Type*>;
-
 	ResourceAllocator<U8> m_alloc;
-	Container m_ptrs;
-
-	typename Container::Iterator find(const CString& filename)
-	{
-		typename Container::Iterator it;
-
-		for(it = m_ptrs.getBegin(); it != m_ptrs.getEnd(); ++it)
-		{
-			if((*it)->getFilename() == filename)
-			{
-				break;
-			}
-		}
-
-		return it;
-	}
+	HashMap<CString, Type*> m_ptrs; ///< Filename to resource. The keys point to the filenames of the resources.
+	RWMutex m_mtx;
 };
 
 class ResourceManagerInitInfo
@@ -184,9 +186,9 @@ public:
 	}
 
 	template<typename T>
-	ANKI_INTERNAL void registerResource(T* ptr)
+	ANKI_INTERNAL T* registerResource(T* ptr)
 	{
-		TypeResourceManager<T>::registerResource(ptr);
+		return TypeResourceManager<T>::registerResource(ptr);
 	}
 
 	template<typename T>
@@ -209,6 +211,12 @@ public:
 	/// Get the total number of completed async tasks.
 	ANKI_INTERNAL U64 getAsyncTaskCompletedCount() const;
 
+	/// Get the manifest of the shader variants. It's nullptr if it's disabled.
+	ANKI_INTERNAL ShaderVariantManifest* getShaderVariantManifest()
+	{
+		return m_shaderVariantManifest;
+	}
+
 	/// Return the container of program libraries.
 	const ShaderProgramResourceSystem& getShaderProgramResourceSystem() const
 	{
@@ -225,6 +233,7 @@ private:
 	U32 m_maxTextureSize;
 	AsyncLoader* m_asyncLoader = nullptr; ///< Async loading thread
 	ShaderProgramResourceSystem* m_shaderProgramSystem = nullptr;
+	ShaderVariantManifest* m_shaderVariantManifest = nullptr;
 	U64 m_uuid = 0;
 	U64 m_loadRequestCount = 0;
 	TransferGpuAllocator* m_transferGpuAlloc = nullptr;
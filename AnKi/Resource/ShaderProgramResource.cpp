@@ -6,6 +6,8 @@
 #include <AnKi/Resource/ShaderProgramResource.h>
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Resource/ShaderProgramResourceSystem.h>
+#include <AnKi/Resource/ShaderVariantManifest.h>
+#include <AnKi/Resource/AsyncLoader.h>
 #include <AnKi/Gr/ShaderProgram.h>
 #include <AnKi/Gr/GrManager.h>
 #include <AnKi/Util/Filesystem.h>
@@ -14,6 +16,47 @@
 namespace anki
 {
 
+/// The variants of a ShaderProgramResource sorted by hash.
+class ShaderProgramResource::VariantTable
+{
+public:
+	DynamicArray<U64> m_hashes;
+	DynamicArray<const ShaderProgramResourceVariant*> m_variants;
+};
+
+/// Creates the variants that the ShaderVariantManifest remembers.
+class ShaderProgramResource::PrewarmTask : public AsyncLoaderTask
+{
+public:
+	ShaderProgramResourcePtr m_program;
+	DynamicArrayAuto<U8> m_variants;
+	U32 m_variantSize = 0;
+
+	PrewarmTask(const ShaderProgramResourcePtr& program)
+		: m_program(program)
+		, m_variants(program->getManager().getAsyncLoader().getAllocator())
+	{
+	}
+
+	Error operator()(AsyncLoaderTaskContext& ctx) final
+	{
+		if(ctx.m_stage == AsyncLoaderStage::IO)
+		{
+			// Nothing to read. Creating shaders is CPU work
+			ctx.m_nextStage = AsyncLoaderStage::DECODE;
+			return Error::NONE;
+		}
+
+		m_program->prewarmVariants(m_variants, m_variantSize);
+		return Error::NONE;
+	}
+
+	GenericMemoryPoolAllocator<U8> getAllocator() const
+	{
+		return m_program->getManager().getAsyncLoader().getAllocator();
+	}
+};
+
 ShaderProgramResourceVariant::ShaderProgramResourceVariant()
 {
 }
@@ -45,6 +88,14 @@ ShaderProgramResource::~ShaderProgramResource()
 		getAllocator().deleteInstance(variant);
 	}
 	m_variants.destroy(getAllocator());
+
+	VariantTable* table = m_variantTable.load();
+	if(table)
+	{
+		table->m_hashes.destroy(getAllocator());
+		table->m_variants.destroy(getAllocator());
+		getAllocator().deleteInstance(table);
+	}
 }
 
 Error ShaderProgramResource::load(const ResourceFilename& filename, Bool async)
@@ -66,6 +117,7 @@ Error ShaderProgramResource::load(const ResourceFilename& filename, Bool async)
 		{
 			m_mutators[i].m_name = binary.m_mutators[i].m_name.getBegin();
 			ANKI_ASSERT(m_mutators[i].m_name.getLength() > 0);
+			m_mutators[i].m_nameId = StringIdRegistry::registerString(m_mutators[i].m_name);
 			m_mutators[i].m_values = binary.m_mutators[i].m_values;
 		}
 	}
@@ -177,6 +229,29 @@ Error ShaderProgramResource::load(const ResourceFilename& filename, Bool async)
 		}
 	}
 
+	// Create the variants of the previous runs in the background
+	ShaderVariantManifest* manifest = getManager().getShaderVariantManifest();
+	if(manifest)
+	{
+		UniquePtr<PrewarmTask> task(getManager().getAsyncLoader().newTask<PrewarmTask>(ShaderProgramResourcePtr(this)));
+		manifest->getVariants(filename, task->m_variants, task->m_variantSize);
+
+		if(task->m_variantSize == 0)
+		{
+			// Nothing to create, the task will be deleted
+		}
+		else if(async)
+		{
+			getManager().getAsyncLoader().submitTask(task.get());
+			PrewarmTask* pTask;
+			task.moveAndReset(pTask);
+		}
+		else
+		{
+			prewarmVariants(task->m_variants, task->m_variantSize);
+		}
+	}
+
 	return Error::NONE;
 }
 
@@ -226,6 +301,18 @@ void ShaderProgramResource::getOrCreateVariant(const ShaderProgramResourceVarian
 			appendHash(info.m_constantValues.getBegin(), m_consts.getSize() * sizeof(info.m_constantValues[0]), hash);
 	}
 
+	// Check the variants that were created while loading. The table doesn't change so there is no need to lock
+	const VariantTable* table = m_variantTable.load(AtomicMemoryOrder::ACQUIRE);
+	if(table)
+	{
+		const U64* it = std::lower_bound(table->m_hashes.getBegin(), table->m_hashes.getEnd(), hash);
+		if(it != table->m_hashes.getEnd() && *it == hash)
+		{
+			variant = table->m_variants[U32(it - table->m_hashes.getBegin())];
+			return;
+		}
+	}
+
 	// Check if the variant is in the cache
 	{
 		RLockGuard<RWMutex> lock(m_mtx);
@@ -257,6 +344,115 @@ void ShaderProgramResource::getOrCreateVariant(const ShaderProgramResourceVarian
 	initVariant(info, *v);
 	m_variants.emplace(getAllocator(), hash, v);
 	variant = v;
+
+	// Remember it for the next runs
+	ShaderVariantManifest* manifest = getManager().getShaderVariantManifest();
+	if(manifest)
+	{
+		Array<U8, sizeof(info.m_mutation) + sizeof(info.m_constantValues)> manifestVariant;
+		// Programs without mutators and constants have one variant. Describe it with a zero byte
+		manifestVariant[0] = 0;
+		const U32 mutationSize = m_mutators.getSize() * sizeof(info.m_mutation[0]);
+		const U32 constantsSize = m_consts.getSize() * sizeof(info.m_constantValues[0]);
+		if(mutationSize)
+		{
+			memcpy(&manifestVariant[0], info.m_mutation.getBegin(), mutationSize);
+		}
+
+		if(constantsSize)
+		{
+			memcpy(&manifestVariant[mutationSize], info.m_constantValues.getBegin(), constantsSize);
+		}
+
+		manifest->recordVariant(getFilename(),
+								ConstWeakArray<U8>(&manifestVariant[0], getManifestVariantSize()));
+	}
+}
+
+U32 ShaderProgramResource::getManifestVariantSize() const
+{
+	const U32 size = m_mutators.getSize() * sizeof(MutatorValue)
+					 + m_consts.getSize() * sizeof(ShaderProgramResourceConstantValue);
+	return max(size, 1u);
+}
+
+void ShaderProgramResource::prewarmVariants(ConstWeakArray<U8> variants, U32 variantSize) const
+{
+	const ShaderProgramBinary& binary = m_binary.getBinary();
+
+	// If the size is different the program has changed and the variants are useless
+	if(variantSize == getManifestVariantSize())
+	{
+		const U32 mutationSize = m_mutators.getSize() * sizeof(MutatorValue);
+		const U32 constantsSize = m_consts.getSize() * sizeof(ShaderProgramResourceConstantValue);
+
+		for(U32 offset = 0; offset < variants.getSize(); offset += variantSize)
+		{
+			ShaderProgramResourceVariantInitInfo info;
+			Bool valid = true;
+
+			if(mutationSize)
+			{
+				memcpy(info.m_mutation.getBegin(), &variants[offset], mutationSize);
+				for(U32 i = 0; i < m_mutators.getSize(); ++i)
+				{
+					valid = valid && m_mutators[i].valueExists(info.m_mutation[i]);
+					info.m_setMutators.set(i);
+				}
+
+				// The mutation might have been rewritten or removed
+				const U64 mutationHash = computeHash(info.m_mutation.getBegin(), mutationSize);
+				Bool found = false;
+				for(const ShaderProgramBinaryMutation& mutation : binary.m_mutations)
+				{
+					found = found || mutation.m_hash == mutationHash;
+				}
+				valid = valid && found;
+			}
+
+			if(constantsSize)
+			{
+				memcpy(info.m_constantValues.getBegin(), &variants[offset + mutationSize], constantsSize);
+				for(U32 i = 0; i < m_consts.getSize(); ++i)
+				{
+					valid = valid && info.m_constantValues[i].m_constantIndex < m_consts.getSize();
+					info.m_setConstants.set(i);
+				}
+			}
+
+			if(valid)
+			{
+				const ShaderProgramResourceVariant* variant;
+				getOrCreateVariant(info, variant);
+			}
+		}
+	}
+
+	// Now that the common variants exist create the table that will be searched without locking
+	WLockGuard<RWMutex> lock(m_mtx);
+
+	if(m_variantTable.load() || m_variants.getSize() == 0)
+	{
+		return;
+	}
+
+	VariantTable* table = getAllocator().newInstance<VariantTable>();
+	table->m_hashes.create(getAllocator(), U32(m_variants.getSize()));
+	U32 count = 0;
+	for(auto it = m_variants.getBegin(); it != m_variants.getEnd(); ++it)
+	{
+		table->m_hashes[count++] = it.getKey();
+	}
+
+	std::sort(table->m_hashes.getBegin(), table->m_hashes.getEnd());
+
+	table->m_variants.create(getAllocator(), table->m_hashes.getSize());
+	for(U32 i = 0; i < table->m_hashes.getSize(); ++i)
+	{
+		table->m_variants[i] = *m_variants.find(table->m_hashes[i]);
+	}
+
+	m_variantTable.store(table, AtomicMemoryOrder::RELEASE);
 }
 
 void ShaderProgramResource::initVariant(const ShaderProgramResourceVariantInitInfo& info,
@@ -11,6 +11,7 @@
 #include <AnKi/Gr/ShaderProgram.h>
 #include <AnKi/Util/BitSet.h>
 #include <AnKi/Util/String.h>
+#include <AnKi/Util/StringId.h>
 #include <AnKi/Util/HashMap.h>
 #include <AnKi/Util/WeakArray.h>
 #include <AnKi/Math.h>
@@ -30,6 +31,7 @@ class ShaderProgramResourceMutator : public NonCopyable
 {
 public:
 	CString m_name;
+	StringId m_nameId;
 	ConstWeakArray<MutatorValue> m_values;
 
 	Bool valueExists(MutatorValue v) const
@@ -159,7 +161,13 @@ public:
 	template<typename T>
 	ShaderProgramResourceVariantInitInfo& addConstant(CString name, const T& value);
 
-	ShaderProgramResourceVariantInitInfo& addMutation(CString name, MutatorValue t);
+	ShaderProgramResourceVariantInitInfo& addMutation(CString name, MutatorValue t)
+	{
+		return addMutation(StringId(name), t);
+	}
+
+	/// Same as addMutation but with a precomputed name. See ANKI_STRING_ID.
+	ShaderProgramResourceVariantInitInfo& addMutation(StringId name, MutatorValue t);
 
 private:
 	static constexpr U32 MAX_CONSTANTS = 32;
@@ -212,10 +220,16 @@ public:
 
 	/// Try to find a mutator.
 	const ShaderProgramResourceMutator* tryFindMutator(CString name) const
+	{
+		return tryFindMutator(StringId(name));
+	}
+
+	/// Try to find a mutator using a precomputed name.
+	const ShaderProgramResourceMutator* tryFindMutator(StringId name) const
 	{
 		for(const ShaderProgramResourceMutator& m : m_mutators)
 		{
-			if(m.m_name == name)
+			if(m.m_nameId == name)
 			{
 				return &m;
 			}
@@ -233,7 +247,8 @@ public:
 		return m_binary.getBinary();
 	}
 
-	/// Get or create a graphics shader program variant.
+	/// Get or create a graphics shader program variant. The variants that were created while loading (see
+	/// ShaderVariantManifest) are found without locking.
 	/// @note It's thread-safe.
 	void getOrCreateVariant(const ShaderProgramResourceVariantInitInfo& info,
 							const ShaderProgramResourceVariant*& variant) const;
@@ -262,13 +277,25 @@ private:
 
 	DynamicArray<ConstMapping> m_constBinaryMapping;
 
+	class VariantTable;
+	class PrewarmTask;
+
 	mutable HashMap<U64, ShaderProgramResourceVariant*> m_variants;
 	mutable RWMutex m_mtx;
 
+	/// A copy of m_variants that is created after the prewarming. It never changes so it's searched without locking.
+	mutable Atomic<VariantTable*> m_variantTable = {nullptr};
+
 	ShaderTypeBit m_shaderStages = ShaderTypeBit::NONE;
 
 	void initVariant(const ShaderProgramResourceVariantInitInfo& info, ShaderProgramResourceVariant& variant) const;
 
+	/// Create the variants of the previous runs and then create the m_variantTable.
+	/// @param variants The variants that the ShaderVariantManifest holds.
+	void prewarmVariants(ConstWeakArray<U8> variants, U32 variantSize) const;
+
+	U32 getManifestVariantSize() const;
+
 	static ANKI_USE_RESULT Error parseConst(CString constName, U32& componentIdx, U32& componentCount, CString& name);
 };
 
@@ -292,7 +319,7 @@ inline ShaderProgramResourceVariantInitInfo& ShaderProgramResourceVariantInitInf
 	return *this;
 }
 
-inline ShaderProgramResourceVariantInitInfo& ShaderProgramResourceVariantInitInfo::addMutation(CString name,
+inline ShaderProgramResourceVariantInitInfo& ShaderProgramResourceVariantInitInfo::addMutation(StringId name,
 																							   MutatorValue t)
 {
 	const ShaderProgramResourceMutator* m = m_ptr->tryFindMutator(name);
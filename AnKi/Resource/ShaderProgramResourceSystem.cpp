@@ -8,234 +8,942 @@
 #include <AnKi/Util/Tracer.h>
 #include <AnKi/Gr/GrManager.h>
 #include <AnKi/ShaderCompiler/ShaderProgramCompiler.h>
+#include <AnKi/ShaderCompiler/ShaderProgramParser.h>
+#include <AnKi/ShaderCompiler/Glslang.h>
 #include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/StringList.h>
 #include <AnKi/Util/ThreadHive.h>
 #include <AnKi/Util/System.h>
+#include <AnKi/Util/HighRezTimer.h>
 
 namespace anki
 {
 
-ShaderProgramResourceSystem::~ShaderProgramResourceSystem()
+namespace
 {
-	m_cacheDir.destroy(m_alloc);
 
-	for(ShaderProgramRaytracingLibrary& lib : m_rtLibraries)
+/// A ShaderProgramAsyncTaskInterface that feeds a ThreadHive that is shared by all programs. Unlike
+/// ThreadHive::waitAllTasks() the joinTasks() waits only for the tasks of this interface and it runs them while
+/// waiting. That way it can be called from inside a hive task.
+class HiveShaderCompileTaskManager final : public ShaderProgramAsyncTaskInterface
+{
+public:
+	HiveShaderCompileTaskManager(ThreadHive& hive, GenericMemoryPoolAllocator<U8> alloc)
+		: m_hive(hive)
 	{
-		lib.m_libraryName.destroy(m_alloc);
-		lib.m_groupHashToGroupIndex.destroy(m_alloc);
+		m_queue = alloc.newInstance<Queue>(alloc);
 	}
 
-	m_rtLibraries.destroy(m_alloc);
-}
+	~HiveShaderCompileTaskManager()
+	{
+		ANKI_ASSERT(m_queue->m_pendingJobCount == 0);
+		m_queue->release();
+	}
 
-Error ShaderProgramResourceSystem::init()
+	void enqueueTask(void (*callback)(void* userData), void* userData) final
+	{
+		{
+			LockGuard<Mutex> lock(m_queue->m_mtx);
+			Job& job = *m_queue->m_jobs.emplaceBack(m_queue->m_alloc);
+			job.m_callback = callback;
+			job.m_userData = userData;
+			++m_queue->m_pendingJobCount;
+			m_queue->m_cvar.notifyAll();
+		}
+
+		// The hive task might find the queue empty because joinTasks() ran the job. That's why it holds a reference
+		m_queue->m_refcount.fetchAdd(1);
+		m_hive.submitTask(
+			[](void* userData, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* signalSemaphore) {
+				Queue& queue = *static_cast<Queue*>(userData);
+				queue.tryRunJob();
+				queue.release();
+			},
+			m_queue);
+	}
+
+	Error joinTasks() final
+	{
+		while(true)
+		{
+			if(m_queue->tryRunJob())
+			{
+				continue;
+			}
+
+			LockGuard<Mutex> lock(m_queue->m_mtx);
+			if(m_queue->m_pendingJobCount == 0)
+			{
+				break;
+			}
+
+			if(m_queue->m_jobs.getSize() == 0)
+			{
+				// Other threads are running the rest of the jobs, wait for them or for new jobs
+				m_queue->m_cvar.wait(m_queue->m_mtx);
+			}
+		}
+
+		return Error::NONE;
+	}
+
+private:
+	class Job
+	{
+	public:
+		void (*m_callback)(void* userData);
+		void* m_userData;
+	};
+
+	class Queue
+	{
+	public:
+		GenericMemoryPoolAllocator<U8> m_alloc;
+		Mutex m_mtx;
+		ConditionVariable m_cvar;
+		DynamicArray<Job> m_jobs;
+		U32 m_pendingJobCount = 0; ///< Queued and running jobs.
+		Atomic<U32> m_refcount = {1};
+
+		Queue(GenericMemoryPoolAllocator<U8> alloc)
+			: m_alloc(alloc)
+		{
+		}
+
+		~Queue()
+		{
+			ANKI_ASSERT(m_jobs.getSize() == 0);
+			m_jobs.destroy(m_alloc);
+		}
+
+		Bool tryRunJob()
+		{
+			Job job;
+			{
+				LockGuard<Mutex> lock(m_mtx);
+				if(m_jobs.getSize() == 0)
+				{
+					return false;
+				}
+
+				job = m_jobs.getBack();
+				m_jobs.popBack(m_alloc);
+			}
+
+			job.m_callback(job.m_userData);
+
+			LockGuard<Mutex> lock(m_mtx);
+			--m_pendingJobCount;
+			m_cvar.notifyAll();
+			return true;
+		}
+
+		void release()
+		{
+			if(m_refcount.fetchSub(1) == 1)
+			{
+				GenericMemoryPoolAllocator<U8> alloc = m_alloc;
+				alloc.deleteInstance(this);
+			}
+		}
+	};
+
+	ThreadHive& m_hive;
+	Queue* m_queue = nullptr;
+};
+
+/// A ShaderProgramSpirvCacheInterface that keeps one file per SPIR-V blob in a directory of the cache. Since the blobs
+/// are keyed by the hash of their source programs that share includes or that changed partially don't recompile all
+/// their stages. A file starts with the shader type and the source it was compiled from so a source with the same hash
+/// won't get the wrong SPIR-V. The blobs live in a subdirectory named after the hash of the compiler's version and
+/// options so a different compiler won't see them.
+class SpirvFileCache final : public ShaderProgramSpirvCacheInterface
 {
-	ANKI_TRACE_SCOPED_EVENT(COMPILE_SHADERS);
+public:
+	/// If the blobs of the current compiler are more than that they are all deleted.
+	static constexpr U32 MAX_FILE_COUNT = 4096;
 
-	StringListAuto rtProgramFilenames(m_alloc);
-	ANKI_CHECK(compileAllShaders(m_cacheDir, *m_gr, *m_fs, m_alloc, rtProgramFilenames));
+	SpirvFileCache(GenericMemoryPoolAllocator<U8> alloc)
+		: m_dir(alloc)
+		, m_storedHashes(alloc)
+	{
+	}
 
-	if(m_gr->getDeviceCapabilities().m_rayTracingEnabled)
+	ANKI_USE_RESULT Error init(CString cacheDir)
 	{
-		ANKI_CHECK(createRayTracingPrograms(m_cacheDir, rtProgramFilenames, *m_gr, m_alloc, m_rtLibraries));
+		const U64 compilerHash =
+			appendHash(&SHADER_BINARY_VERSION, sizeof(SHADER_BINARY_VERSION), computeGlslangCompilerHash());
+
+		StringAuto rootDir(m_dir.getAllocator());
+		rootDir.sprintf("%s/Spirv", cacheDir.cstr());
+		if(!directoryExists(rootDir))
+		{
+			ANKI_CHECK(createDirectory(rootDir));
+		}
+
+		StringAuto versionDirName(m_dir.getAllocator());
+		versionDirName.sprintf("%016" PRIx64, compilerHash);
+		m_dir.sprintf("%s/%s", rootDir.cstr(), versionDirName.cstr());
+
+		ANKI_CHECK(evict(rootDir, versionDirName));
+
+		if(!directoryExists(m_dir))
+		{
+			ANKI_CHECK(createDirectory(m_dir));
+		}
+
+		return Error::NONE;
 	}
 
-	return Error::NONE;
+	Bool find(U64 sourceHash, ShaderType shaderType, CString source, DynamicArrayAuto<U8>& spirv) final
+	{
+		StringAuto fname(m_dir.getAllocator());
+		fname.sprintf("%s/%016" PRIx64 ".spv", m_dir.cstr(), sourceHash);
+
+		{
+			// Writes happen under the lock so if the file exists now it's complete
+			LockGuard<Mutex> lock(m_mtx);
+			if(m_storedHashes.find(sourceHash) == m_storedHashes.getEnd() && !fileExists(fname))
+			{
+				return false;
+			}
+		}
+
+		File file;
+		if(file.open(fname, FileOpenFlag::READ | FileOpenFlag::BINARY))
+		{
+			return false;
+		}
+
+		// Check the source
+		const PtrSize sourceLength = source.getLength();
+		const PtrSize size = file.getSize();
+		Array<U32, 2> header;
+		if(size < sizeof(header) + sourceLength || file.read(&header[0], sizeof(header)) || header[0] != U32(shaderType)
+		   || header[1] != sourceLength)
+		{
+			return false;
+		}
+
+		DynamicArrayAuto<char> storedSource(m_dir.getAllocator());
+		storedSource.create(U32(sourceLength));
+		if(file.read(&storedSource[0], sourceLength) || memcmp(&storedSource[0], source.cstr(), sourceLength) != 0)
+		{
+			return false;
+		}
+
+		// Read the SPIR-V
+		const PtrSize spirvSize = size - sizeof(header) - sourceLength;
+		if(spirvSize == 0 || (spirvSize % sizeof(U32)) != 0)
+		{
+			ANKI_RESOURCE_LOGW("Ignoring corrupted SPIR-V in the cache: %s", fname.cstr());
+			return false;
+		}
+
+		spirv.create(U32(spirvSize));
+		if(file.read(&spirv[0], spirvSize))
+		{
+			spirv.destroy();
+			return false;
+		}
+
+		return true;
+	}
+
+	void store(U64 sourceHash, ShaderType shaderType, CString source, ConstWeakArray<U8> spirv) final
+	{
+		StringAuto fname(m_dir.getAllocator());
+		fname.sprintf("%s/%016" PRIx64 ".spv", m_dir.cstr(), sourceHash);
+
+		LockGuard<Mutex> lock(m_mtx);
+		if(m_storedHashes.find(sourceHash) != m_storedHashes.getEnd())
+		{
+			return;
+		}
+
+		// Write to a temp file and rename it at the end so a crash won't leave a truncated blob behind. Other processes
+		// might write to the same directory so make the temp file unique
+		StringAuto tmpFname(m_dir.getAllocator());
+		tmpFname.sprintf("%s.%016" PRIx64 ".tmp", fname.cstr(), getRandom());
+
+		// Failing to write is not fatal, it's just a cache
+		const Array<U32, 2> header = {U32(shaderType), U32(source.getLength())};
+		Error err = Error::NONE;
+		{
+			File file;
+			err = file.open(tmpFname, FileOpenFlag::WRITE | FileOpenFlag::BINARY);
+			if(!err)
+			{
+				err = file.write(&header[0], sizeof(header));
+			}
+
+			if(!err)
+			{
+				err = file.write(source.cstr(), source.getLength());
+			}
+
+			if(!err)
+			{
+				err = file.write(&spirv[0], spirv.getSize());
+			}
+		}
+
+		if(!err)
+		{
+			// Might fail if another process wrote the same blob first. That's fine
+			err = renameFile(tmpFname, fname);
+		}
+
+		if(err)
+		{
+			ANKI_RESOURCE_LOGW("Failed to write SPIR-V to the cache: %s", fname.cstr());
+			if(fileExists(tmpFname))
+			{
+				err = removeFile(tmpFname);
+				(void)err;
+			}
+			return;
+		}
+
+		m_storedHashes.emplace(sourceHash, true);
+	}
+
+private:
+	StringAuto m_dir;
+	Mutex m_mtx;
+	HashMapAuto<U64, Bool> m_storedHashes; ///< The blobs written in this session.
+
+	/// Delete the blobs of other compilers and the temp files crashes left behind. If the blobs of the current compiler
+	/// are too many delete them as well.
+	ANKI_USE_RESULT Error evict(CString rootDir, CString versionDirName)
+	{
+		class Ctx
+		{
+		public:
+			CString m_versionDirName;
+			StringListAuto m_staleFiles;
+			StringListAuto m_staleDirs;
+			U32 m_blobCount = 0;
+
+			Ctx(CString versionDirName, GenericMemoryPoolAllocator<U8> alloc)
+				: m_versionDirName(versionDirName)
+				, m_staleFiles(alloc)
+				, m_staleDirs(alloc)
+			{
+			}
+		} ctx(versionDirName, m_dir.getAllocator());
+
+		ANKI_CHECK(walkDirectoryTree(rootDir, &ctx, [](const CString& fname, void* ud, Bool isDir) -> Error {
+			Ctx& ctx = *static_cast<Ctx*>(ud);
+			const CString versionDir = ctx.m_versionDirName;
+			const Bool inVersionDir = fname.getLength() > versionDir.getLength()
+									  && fname[versionDir.getLength()] == '/'
+									  && strncmp(fname.cstr(), versionDir.cstr(), versionDir.getLength()) == 0;
+			if(inVersionDir)
+			{
+				if(fname.find(".tmp") != CString::NPOS)
+				{
+					ctx.m_staleFiles.pushBack(fname);
+				}
+				else if(!isDir)
+				{
+					++ctx.m_blobCount;
+				}
+			}
+			else if(fname.find("/") == CString::NPOS && fname != versionDir)
+			{
+				// Something at the top level that is not the current compiler's
+				if(isDir)
+				{
+					ctx.m_staleDirs.pushBack(fname);
+				}
+				else
+				{
+					ctx.m_staleFiles.pushBack(fname);
+				}
+			}
+
+			return Error::NONE;
+		}));
+
+		StringAuto path(m_dir.getAllocator());
+		for(const String& dir : ctx.m_staleDirs)
+		{
+			path.destroy();
+			path.sprintf("%s/%s", rootDir.cstr(), dir.cstr());
+			ANKI_CHECK(removeDirectory(path, m_dir.getAllocator()));
+		}
+
+		for(const String& file : ctx.m_staleFiles)
+		{
+			path.destroy();
+			path.sprintf("%s/%s", rootDir.cstr(), file.cstr());
+			ANKI_CHECK(removeFile(path));
+		}
+
+		if(ctx.m_blobCount > MAX_FILE_COUNT)
+		{
+			ANKI_RESOURCE_LOGI("Too many SPIR-V blobs in the cache (%u). Deleting them", ctx.m_blobCount);
+			ANKI_CHECK(removeDirectory(m_dir, m_dir.getAllocator()));
+		}
+
+		return Error::NONE;
+	}
+};
+
+/// The data that are common to all the programs that compileAllShaders() compiles.
+class ShaderCompileContext
+{
+public:
+	CString m_cacheDir;
+	ResourceFilesystem* m_fs;
+	ThreadHive* m_hive;
+	ShaderProgramSpirvCacheInterface* m_spirvCache;
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	GpuDeviceCapabilities m_caps;
+	BindlessLimits m_limits;
+	U64 m_gpuHash;
+	Atomic<U32> m_failed = {0};
+
+	Mutex m_dependencyHashesMtx;
+	HashMapAuto<StringAuto, U64> m_dependencyHashes = {m_alloc}; ///< Filename to content hash.
+
+	ShaderCompileContext(GenericMemoryPoolAllocator<U8> alloc)
+		: m_alloc(alloc)
+	{
+	}
+
+	/// Get the hash of a program or include. Programs share includes so every file is read once.
+	U64 getDependencyHash(CString filename);
+};
+
+U64 ShaderCompileContext::getDependencyHash(CString filename)
+{
+	{
+		LockGuard<Mutex> lock(m_dependencyHashesMtx);
+		auto it = m_dependencyHashes.find(filename);
+		if(it != m_dependencyHashes.getEnd())
+		{
+			return *it;
+		}
+	}
+
+	// Read it outside the lock. Files that went away get a zero hash that won't match anything
+	U64 hash = 0;
+	ResourceFilePtr file;
+	StringAuto txt(m_alloc);
+	if(!m_fs->openFile(filename, file) && !file->readAllText(txt))
+	{
+		hash = ShaderProgramParser::computeDependencyHash(txt);
+	}
+
+	LockGuard<Mutex> lock(m_dependencyHashesMtx);
+	if(m_dependencyHashes.find(filename) == m_dependencyHashes.getEnd())
+	{
+		m_dependencyHashes.emplace(StringAuto(m_alloc, filename), hash);
+	}
+
+	return hash;
 }
 
-Error ShaderProgramResourceSystem::compileAllShaders(CString cacheDir, GrManager& gr, ResourceFilesystem& fs,
-													 GenericMemoryPoolAllocator<U8>& alloc,
-													 StringListAuto& rtProgramFilenames)
+/// The contents of the .ankiprogmeta files. It's what decides if a program needs to be compiled again. The file layout
+/// is the header, then the dependencies (hash, name length, name) and then the mutations.
+class ShaderProgramMetaFile
 {
-	class MetaFileData
+public:
+	static constexpr const char* MAGIC = "ANKIPMT2";
+
+	class Header
 	{
 	public:
-		U64 m_hash;
+		Array<char, 8> m_magic;
+		U64 m_programHash; ///< The hash of the program and the GPU.
+		U64 m_gpuHash;
+		U32 m_dependencyCount;
+		U32 m_mutationCount;
 		ShaderTypeBit m_shaderTypes;
 		Array<U16, 3> m_padding = {};
 	};
 
-	ANKI_RESOURCE_LOGI("Compiling shader programs");
-	U32 shadersCompileCount = 0;
+	/// The hash of a mutation is the hash of the SPIR-V of its stages. If it changes the mutation has changed.
+	class Mutation
+	{
+	public:
+		U64 m_mutationHash;
+		U64 m_variantHash;
+	};
 
-	ThreadHive threadHive(getCpuCoresCount(), alloc, false);
+	Header m_header = {};
+	DynamicArrayAuto<U64> m_dependencyHashes;
+	StringListAuto m_dependencyNames;
+	DynamicArrayAuto<Mutation> m_mutations;
 
-	// Compute hash for both
-	const GpuDeviceCapabilities caps = gr.getDeviceCapabilities();
-	const BindlessLimits limits = gr.getBindlessLimits();
-	U64 gpuHash = computeHash(&caps, sizeof(caps));
-	gpuHash = appendHash(&limits, sizeof(limits), gpuHash);
-	gpuHash = appendHash(&SHADER_BINARY_VERSION, sizeof(SHADER_BINARY_VERSION), gpuHash);
+	ShaderProgramMetaFile(GenericMemoryPoolAllocator<U8> alloc)
+		: m_dependencyHashes(alloc)
+		, m_dependencyNames(alloc)
+		, m_mutations(alloc)
+	{
+	}
 
-	ANKI_CHECK(fs.iterateAllFilenames([&](CString fname) -> Error {
-		// Check file extension
-		StringAuto extension(alloc);
-		getFilepathExtension(fname, extension);
-		if(extension.getLength() != 8 || extension != "ankiprog")
+	/// Load the file. It sets valid to false if the file is from an older version or corrupted.
+	ANKI_USE_RESULT Error load(CString filename, Bool& valid);
+
+	ANKI_USE_RESULT Error store(CString filename) const;
+};
+
+Error ShaderProgramMetaFile::load(CString filename, Bool& valid)
+{
+	valid = false;
+
+	File file;
+	ANKI_CHECK(file.open(filename, FileOpenFlag::READ | FileOpenFlag::BINARY));
+	const PtrSize fileSize = file.getSize();
+
+	if(fileSize < sizeof(m_header))
+	{
+		return Error::NONE;
+	}
+
+	ANKI_CHECK(file.read(&m_header, sizeof(m_header)));
+	if(memcmp(&m_header.m_magic[0], MAGIC, sizeof(m_header.m_magic)) != 0)
+	{
+		return Error::NONE;
+	}
+
+	if(m_header.m_programHash == 0 || m_header.m_shaderTypes == ShaderTypeBit::NONE)
+	{
+		ANKI_RESOURCE_LOGE("Wrong data found in the metafile: %s", filename.cstr());
+		return Error::USER_DATA;
+	}
+
+	PtrSize offset = sizeof(m_header);
+	m_dependencyHashes.create(m_header.m_dependencyCount);
+	for(U32 i = 0; i < m_header.m_dependencyCount; ++i)
+	{
+		U32 nameLength;
+		offset += sizeof(U64) + sizeof(nameLength);
+		if(offset > fileSize)
 		{
 			return Error::NONE;
 		}
 
-		if(fname.find("/Rt") != CString::NPOS && !gr.getDeviceCapabilities().m_rayTracingEnabled)
+		ANKI_CHECK(file.read(&m_dependencyHashes[i], sizeof(U64)));
+		ANKI_CHECK(file.read(&nameLength, sizeof(nameLength)));
+
+		offset += nameLength;
+		if(nameLength == 0 || offset > fileSize)
 		{
-			// Skip RT programs when RT is disabled
 			return Error::NONE;
 		}
 
-		// Get some filenames
-		StringAuto baseFname(alloc);
-		getFilepathFilename(fname, baseFname);
-		StringAuto metaFname(alloc);
-		metaFname.sprintf("%s/%smeta", cacheDir.cstr(), baseFname.cstr());
+		StringAuto name(m_dependencyHashes.getAllocator());
+		name.create(' ', nameLength);
+		ANKI_CHECK(file.read(&name[0], nameLength));
+		m_dependencyNames.pushBack(name);
+	}
 
-		// Get the hash from the meta file
-		U64 metafileHash = 0;
-		ShaderTypeBit metafileShaderTypes = ShaderTypeBit::NONE;
-		if(fileExists(metaFname))
-		{
-			File metaFile;
-			ANKI_CHECK(metaFile.open(metaFname, FileOpenFlag::READ | FileOpenFlag::BINARY));
-			MetaFileData data;
-			ANKI_CHECK(metaFile.read(&data, sizeof(data)));
+	if(offset + m_header.m_mutationCount * sizeof(Mutation) != fileSize)
+	{
+		return Error::NONE;
+	}
+
+	if(m_header.m_mutationCount)
+	{
+		m_mutations.create(m_header.m_mutationCount);
+		ANKI_CHECK(file.read(&m_mutations[0], m_mutations.getSizeInBytes()));
+	}
+
+	valid = true;
+	return Error::NONE;
+}
+
+Error ShaderProgramMetaFile::store(CString filename) const
+{
+	ANKI_ASSERT(memcmp(&m_header.m_magic[0], MAGIC, sizeof(m_header.m_magic)) == 0);
+	ANKI_ASSERT(m_header.m_dependencyCount == m_dependencyHashes.getSize());
+	ANKI_ASSERT(m_header.m_mutationCount == m_mutations.getSize());
+
+	File file;
+	ANKI_CHECK(file.open(filename, FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+	ANKI_CHECK(file.write(&m_header, sizeof(m_header)));
+
+	U32 count = 0;
+	for(const String& name : m_dependencyNames)
+	{
+		const U32 nameLength = name.getLength();
+		ANKI_CHECK(file.write(&m_dependencyHashes[count++], sizeof(U64)));
+		ANKI_CHECK(file.write(&nameLength, sizeof(nameLength)));
+		ANKI_CHECK(file.write(name.cstr(), nameLength));
+	}
 
-			if(data.m_hash == 0 || data.m_shaderTypes == ShaderTypeBit::NONE)
+	if(m_mutations.getSize())
+	{
+		ANKI_CHECK(file.write(&m_mutations[0], m_mutations.getSizeInBytes()));
+	}
+
+	return Error::NONE;
+}
+
+/// A program that compileAllShaders() will check and maybe compile. It's a single task of the hive.
+class ShaderCompileProgram
+{
+public:
+	ShaderCompileContext* m_ctx = nullptr;
+	String m_fname;
+	ShaderTypeBit m_shaderTypes = ShaderTypeBit::NONE;
+	Bool m_compiled = false;
+	Second m_time = 0.0;
+	Error m_err = Error::NONE;
+
+	ANKI_USE_RESULT Error compile();
+};
+
+Error ShaderCompileProgram::compile()
+{
+	const CString fname = m_fname;
+	GenericMemoryPoolAllocator<U8> alloc = m_ctx->m_alloc;
+
+	// Get some filenames
+	StringAuto baseFname(alloc);
+	getFilepathFilename(fname, baseFname);
+	StringAuto metaFname(alloc);
+	metaFname.sprintf("%s/%smeta", m_ctx->m_cacheDir.cstr(), baseFname.cstr());
+	StringAuto storeFname(alloc);
+	storeFname.sprintf("%s/%sbin", m_ctx->m_cacheDir.cstr(), baseFname.cstr());
+
+	// Load the old meta file
+	ShaderProgramMetaFile oldMeta(alloc);
+	Bool oldMetaValid = false;
+	if(fileExists(metaFname))
+	{
+		ANKI_CHECK(oldMeta.load(metaFname, oldMetaValid));
+	}
+
+	// If the program and its includes didn't change there is no need to parse it. Check that first
+	if(oldMetaValid && oldMeta.m_header.m_gpuHash == m_ctx->m_gpuHash && fileExists(storeFname))
+	{
+		Bool changed = false;
+		U32 count = 0;
+		for(const String& depName : oldMeta.m_dependencyNames)
+		{
+			if(m_ctx->getDependencyHash(depName) != oldMeta.m_dependencyHashes[count++])
 			{
-				ANKI_RESOURCE_LOGE("Wrong data found in the metafile: %s", metaFname.cstr());
-				return Error::USER_DATA;
+				changed = true;
+				break;
 			}
-
-			metafileHash = data.m_hash;
-			metafileShaderTypes = data.m_shaderTypes;
 		}
 
-		// Load interface
-		class FSystem : public ShaderProgramFilesystemInterface
+		if(!changed)
 		{
-		public:
-			ResourceFilesystem* m_fsystem = nullptr;
+			m_shaderTypes = oldMeta.m_header.m_shaderTypes;
+			return Error::NONE;
+		}
+	}
 
-			Error readAllText(CString filename, StringAuto& txt) final
-			{
-				ResourceFilePtr file;
-				ANKI_CHECK(m_fsystem->openFile(filename, file));
-				ANKI_CHECK(file->readAllText(txt));
-				return Error::NONE;
-			}
-		} fsystem;
-		fsystem.m_fsystem = &fs;
+	// Load interface
+	class FSystem : public ShaderProgramFilesystemInterface
+	{
+	public:
+		ResourceFilesystem* m_fsystem = nullptr;
 
-		// Skip interface
-		class Skip : public ShaderProgramPostParseInterface
+		Error readAllText(CString filename, StringAuto& txt) final
 		{
-		public:
-			U64 m_metafileHash;
-			U64 m_newHash;
-			U64 m_gpuHash;
-			CString m_fname;
+			ResourceFilePtr file;
+			ANKI_CHECK(m_fsystem->openFile(filename, file));
+			ANKI_CHECK(file->readAllText(txt));
+			return Error::NONE;
+		}
+	} fsystem;
+	fsystem.m_fsystem = m_ctx->m_fs;
 
-			Bool skipCompilation(U64 hash)
-			{
-				ANKI_ASSERT(hash != 0);
-				const Array<U64, 2> hashes = {hash, m_gpuHash};
-				const U64 finalHash = computeHash(hashes.getBegin(), hashes.getSizeInBytes());
+	// Skip interface. Something in the files changed but it might not affect the program (eg a change in a part of an
+	// include that the program doesn't use). In that case just update the dependencies of the meta file
+	class Skip : public ShaderProgramPostParseInterface
+	{
+	public:
+		U64 m_metafileHash;
+		U64 m_newHash = 0;
+		U64 m_gpuHash;
+		ShaderProgramMetaFile* m_newMeta;
 
-				m_newHash = finalHash;
-				const Bool skip = finalHash == m_metafileHash;
+		Bool skipCompilation(U64 hash, ConstWeakArray<ShaderProgramDependency> dependencies)
+		{
+			ANKI_ASSERT(hash != 0);
+			const Array<U64, 2> hashes = {hash, m_gpuHash};
+			const U64 finalHash = computeHash(hashes.getBegin(), hashes.getSizeInBytes());
 
-				if(!skip)
-				{
-					ANKI_RESOURCE_LOGI("\t%s", m_fname.cstr());
-				}
+			m_newHash = finalHash;
 
-				return skip;
-			};
-		} skip;
-		skip.m_metafileHash = metafileHash;
-		skip.m_newHash = 0;
-		skip.m_gpuHash = gpuHash;
-		skip.m_fname = fname;
+			m_newMeta->m_dependencyHashes.create(dependencies.getSize());
+			U32 count = 0;
+			for(const ShaderProgramDependency& dep : dependencies)
+			{
+				m_newMeta->m_dependencyHashes[count++] = dep.m_hash;
+				m_newMeta->m_dependencyNames.pushBack(dep.m_filename);
+			}
 
-		// Threading interface
-		class TaskManager : public ShaderProgramAsyncTaskInterface
+			return finalHash == m_metafileHash;
+		};
+	} skip;
+	ShaderProgramMetaFile newMeta(alloc);
+	skip.m_metafileHash = (oldMetaValid && fileExists(storeFname)) ? oldMeta.m_header.m_programHash : 0;
+	skip.m_gpuHash = m_ctx->m_gpuHash;
+	skip.m_newMeta = &newMeta;
+
+	// Compile. The variants go to the same hive as the other programs
+	HiveShaderCompileTaskManager taskManager(*m_ctx->m_hive, alloc);
+	ShaderProgramBinaryWrapper binary(alloc);
+	ANKI_CHECK(compileShaderProgram(fname, fsystem, &skip, &taskManager, m_ctx->m_spirvCache, alloc, m_ctx->m_caps,
+									m_ctx->m_limits, binary));
+
+	memcpy(&newMeta.m_header.m_magic[0], ShaderProgramMetaFile::MAGIC, sizeof(newMeta.m_header.m_magic));
+	newMeta.m_header.m_programHash = skip.m_newHash;
+	newMeta.m_header.m_gpuHash = m_ctx->m_gpuHash;
+	newMeta.m_header.m_dependencyCount = newMeta.m_dependencyHashes.getSize();
+
+	m_compiled = skip.m_metafileHash != skip.m_newHash;
+	if(!m_compiled)
+	{
+		// Same program, keep the rest of the old meta
+		m_shaderTypes = oldMeta.m_header.m_shaderTypes;
+		newMeta.m_header.m_shaderTypes = m_shaderTypes;
+		newMeta.m_header.m_mutationCount = oldMeta.m_mutations.getSize();
+		newMeta.m_mutations = std::move(oldMeta.m_mutations);
+		ANKI_CHECK(newMeta.store(metaFname));
+		return Error::NONE;
+	}
+
+	// Hash the mutations to find out which of them really changed
+	const ShaderProgramBinary& bin = binary.getBinary();
+	U32 changedMutationCount = 0;
+	if(bin.m_mutations.getSize())
+	{
+		newMeta.m_mutations.create(bin.m_mutations.getSize());
+		for(U32 i = 0; i < bin.m_mutations.getSize(); ++i)
 		{
-		public:
-			ThreadHive* m_hive = nullptr;
-			GenericMemoryPoolAllocator<U8> m_alloc;
+			const ShaderProgramBinaryMutation& mutation = bin.m_mutations[i];
+			const ShaderProgramBinaryVariant& variant = bin.m_variants[mutation.m_variantIndex];
 
-			void enqueueTask(void (*callback)(void* userData), void* userData)
+			U64 variantHash = mutation.m_hash;
+			for(ShaderType shaderType : EnumIterable<ShaderType>())
 			{
-				class Ctx
+				const U32 codeBlockIndex = variant.m_codeBlockIndices[shaderType];
+				if(codeBlockIndex != MAX_U32)
 				{
-				public:
-					void (*m_callback)(void* userData);
-					void* m_userData;
-					GenericMemoryPoolAllocator<U8> m_alloc;
-				};
-				Ctx* ctx = m_alloc.newInstance<Ctx>();
-				ctx->m_callback = callback;
-				ctx->m_userData = userData;
-				ctx->m_alloc = m_alloc;
-
-				m_hive->submitTask(
-					[](void* userData, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* signalSemaphore) {
-						Ctx* ctx = static_cast<Ctx*>(userData);
-						ctx->m_callback(ctx->m_userData);
-						auto alloc = ctx->m_alloc;
-						alloc.deleteInstance(ctx);
-					},
-					ctx);
+					variantHash = appendHash(&bin.m_codeBlocks[codeBlockIndex].m_hash, sizeof(U64), variantHash);
+				}
 			}
 
-			Error joinTasks()
+			newMeta.m_mutations[i].m_mutationHash = mutation.m_hash;
+			newMeta.m_mutations[i].m_variantHash = variantHash;
+
+			// The old mutations are sorted by hash
+			const ShaderProgramMetaFile::Mutation* oldMutation =
+				std::lower_bound(oldMeta.m_mutations.getBegin(), oldMeta.m_mutations.getEnd(), mutation.m_hash,
+								 [](const ShaderProgramMetaFile::Mutation& a, U64 b) { return a.m_mutationHash < b; });
+			if(oldMutation == oldMeta.m_mutations.getEnd() || oldMutation->m_mutationHash != mutation.m_hash
+			   || oldMutation->m_variantHash != variantHash)
 			{
-				m_hive->waitAllTasks();
-				return Error::NONE;
+				++changedMutationCount;
 			}
-		} taskManager;
-		taskManager.m_hive = &threadHive;
-		taskManager.m_alloc = alloc;
+		}
 
-		// Compile
-		ShaderProgramBinaryWrapper binary(alloc);
-		ANKI_CHECK(compileShaderProgram(fname, fsystem, &skip, &taskManager, alloc, caps, limits, binary));
+		std::sort(newMeta.m_mutations.getBegin(), newMeta.m_mutations.getEnd(),
+				  [](const ShaderProgramMetaFile::Mutation& a, const ShaderProgramMetaFile::Mutation& b) {
+					  return a.m_mutationHash < b.m_mutationHash;
+				  });
+	}
 
-		const Bool cachedBinIsUpToDate = metafileHash == skip.m_newHash;
-		if(!cachedBinIsUpToDate)
+	if(bin.m_mutations.getSize())
+	{
+		ANKI_RESOURCE_LOGI("\t%s: %u of %u mutations changed", fname.cstr(), changedMutationCount,
+						   bin.m_mutations.getSize());
+	}
+	else
+	{
+		ANKI_RESOURCE_LOGI("\t%s", fname.cstr());
+	}
+
+	// Save the binary to the cache
+	ANKI_CHECK(binary.serializeToFile(storeFname));
+
+	// Update the meta file. Do that last so a failure will compile the program again
+	m_shaderTypes = bin.m_presentShaderTypes;
+	newMeta.m_header.m_shaderTypes = m_shaderTypes;
+	newMeta.m_header.m_mutationCount = newMeta.m_mutations.getSize();
+	ANKI_CHECK(newMeta.store(metaFname));
+
+	return Error::NONE;
+}
+
+} // end anonymous namespace
+
+ShaderProgramResourceSystem::~ShaderProgramResourceSystem()
+{
+	m_cacheDir.destroy(m_alloc);
+
+	for(ShaderProgramRaytracingLibrary& lib : m_rtLibraries)
+	{
+		lib.m_libraryName.destroy(m_alloc);
+		lib.m_groupHashToGroupIndex.destroy(m_alloc);
+	}
+
+	m_rtLibraries.destroy(m_alloc);
+}
+
+Error ShaderProgramResourceSystem::init()
+{
+	ANKI_TRACE_SCOPED_EVENT(COMPILE_SHADERS);
+
+	StringListAuto rtProgramFilenames(m_alloc);
+	ANKI_CHECK(compileAllShaders(m_cacheDir, *m_gr, *m_fs, m_alloc, rtProgramFilenames));
+
+	if(m_gr->getDeviceCapabilities().m_rayTracingEnabled)
+	{
+		ANKI_CHECK(createRayTracingPrograms(m_cacheDir, rtProgramFilenames, *m_gr, m_alloc, m_rtLibraries));
+	}
+
+	return Error::NONE;
+}
+
+Error ShaderProgramResourceSystem::recompileChangedPrograms(StringListAuto& changedProgramFilenames)
+{
+	ANKI_TRACE_SCOPED_EVENT(COMPILE_SHADERS);
+
+	StringListAuto rtProgramFilenames(m_alloc);
+	ANKI_CHECK(compileAllShaders(m_cacheDir, *m_gr, *m_fs, m_alloc, rtProgramFilenames, &changedProgramFilenames));
+
+	return Error::NONE;
+}
+
+Error ShaderProgramResourceSystem::compileAllShaders(CString cacheDir, GrManager& gr, ResourceFilesystem& fs,
+													 GenericMemoryPoolAllocator<U8>& alloc,
+													 StringListAuto& rtProgramFilenames,
+													 StringListAuto* compiledProgramFilenames)
+{
+	ANKI_RESOURCE_LOGI("Compiling shader programs");
+	const Second startTime = HighRezTimer::getCurrentTime();
+
+	ThreadHive threadHive(getCpuCoresCount(), alloc, false);
+
+	SpirvFileCache spirvCache(alloc);
+	ANKI_CHECK(spirvCache.init(cacheDir));
+
+	ShaderCompileContext ctx(alloc);
+	ctx.m_cacheDir = cacheDir;
+	ctx.m_fs = &fs;
+	ctx.m_hive = &threadHive;
+	ctx.m_spirvCache = &spirvCache;
+
+	// Compute hash for both
+	ctx.m_caps = gr.getDeviceCapabilities();
+	ctx.m_limits = gr.getBindlessLimits();
+	ctx.m_gpuHash = computeHash(&ctx.m_caps, sizeof(ctx.m_caps));
+	ctx.m_gpuHash = appendHash(&ctx.m_limits, sizeof(ctx.m_limits), ctx.m_gpuHash);
+	ctx.m_gpuHash = appendHash(&SHADER_BINARY_VERSION, sizeof(SHADER_BINARY_VERSION), ctx.m_gpuHash);
+
+	// Gather the programs
+	StringListAuto programFilenames(alloc);
+	ANKI_CHECK(fs.iterateAllFilenames([&](CString fname) -> Error {
+		// Check file extension
+		StringAuto extension(alloc);
+		getFilepathExtension(fname, extension);
+		if(extension.getLength() != 8 || extension != "ankiprog")
 		{
-			++shadersCompileCount;
+			return Error::NONE;
 		}
 
-		// Update the meta file
-		if(!cachedBinIsUpToDate)
+		if(fname.find("/Rt") != CString::NPOS && !gr.getDeviceCapabilities().m_rayTracingEnabled)
 		{
-			File metaFile;
-			ANKI_CHECK(metaFile.open(metaFname, FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+			// Skip RT programs when RT is disabled
+			return Error::NONE;
+		}
+
+		programFilenames.pushBack(fname);
+		return Error::NONE;
+	}));
+
+	// Compile all programs at once. Every program is a task and its variants and stages are more tasks in the same hive
+	// so programs with few variants don't leave threads idle
+	DynamicArrayAuto<ShaderCompileProgram> programs(alloc);
+	programs.create(U32(programFilenames.getSize()));
+	U32 count = 0;
+	for(const String& fname : programFilenames)
+	{
+		ShaderCompileProgram& program = programs[count++];
+		program.m_ctx = &ctx;
+		program.m_fname.create(alloc, fname);
+
+		threadHive.submitTask(
+			[](void* userData, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* signalSemaphore) {
+				ShaderCompileProgram& program = *static_cast<ShaderCompileProgram*>(userData);
+				if(program.m_ctx->m_failed.load() != 0)
+				{
+					// Some other program failed, don't bother
+					return;
+				}
 
-			MetaFileData data;
-			data.m_hash = skip.m_newHash;
-			data.m_shaderTypes = binary.getBinary().m_presentShaderTypes;
-			metafileShaderTypes = data.m_shaderTypes;
-			ANKI_CHECK(metaFile.write(&data, sizeof(data)));
+				const Second begin = HighRezTimer::getCurrentTime();
+				program.m_err = program.compile();
+				program.m_time = HighRezTimer::getCurrentTime() - begin;
+
+				if(program.m_err)
+				{
+					ANKI_RESOURCE_LOGE("Failed to compile shader program: %s", program.m_fname.cstr());
+					program.m_ctx->m_failed.store(1);
+				}
+			},
+			&program);
+	}
+
+	threadHive.waitAllTasks();
+
+	// Gather the results
+	Error err = Error::NONE;
+	U32 shadersCompileCount = 0;
+	for(ShaderCompileProgram& program : programs)
+	{
+		if(program.m_err)
+		{
+			err = program.m_err;
 		}
+		else if(!!(program.m_shaderTypes & ShaderTypeBit::ALL_RAY_TRACING))
+		{
+			rtProgramFilenames.pushBack(program.m_fname);
+		}
+
+		shadersCompileCount += program.m_compiled;
 
-		// Save the binary to the cache
-		if(!cachedBinIsUpToDate)
+		if(program.m_compiled && compiledProgramFilenames)
 		{
-			StringAuto storeFname(alloc);
-			storeFname.sprintf("%s/%sbin", cacheDir.cstr(), baseFname.cstr());
-			ANKI_CHECK(binary.serializeToFile(storeFname));
+			compiledProgramFilenames->pushBack(program.m_fname);
 		}
+	}
+
+	// Report the timings, slowest first
+	if(!err && shadersCompileCount > 0)
+	{
+		std::sort(programs.getBegin(), programs.getEnd(),
+				  [](const ShaderCompileProgram& a, const ShaderCompileProgram& b) { return a.m_time > b.m_time; });
 
-		// Gather RT programs
-		if(!!(metafileShaderTypes & ShaderTypeBit::ALL_RAY_TRACING))
+		for(const ShaderCompileProgram& program : programs)
 		{
-			rtProgramFilenames.pushBack(fname);
+			if(program.m_compiled)
+			{
+				ANKI_RESOURCE_LOGI("\t%s took %.3fms", program.m_fname.cstr(), program.m_time * 1000.0);
+			}
 		}
+	}
 
-		return Error::NONE;
-	}));
+	for(ShaderCompileProgram& program : programs)
+	{
+		program.m_fname.destroy(alloc);
+	}
+
+	ANKI_CHECK(err);
 
-	ANKI_RESOURCE_LOGI("Compiled %u shader programs", shadersCompileCount);
+	ANKI_RESOURCE_LOGI("Compiled %u shader programs in %.3fs using %u threads", shadersCompileCount,
+					   HighRezTimer::getCurrentTime() - startTime, threadHive.getThreadCount());
 	return Error::NONE;
 }
 
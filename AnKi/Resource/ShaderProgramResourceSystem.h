@@ -103,6 +103,12 @@ public:
 		return m_rtLibraries;
 	}
 
+	/// Check all programs again and compile the ones that changed. Programs whose sources and includes didn't change
+	/// are not even parsed so it's cheap enough to call it every time a filesystem watch (see INotify) fires.
+	/// @note It doesn't re-create the ray tracing libraries.
+	/// @param[out] changedProgramFilenames The programs that were compiled. Their resources should be reloaded.
+	ANKI_USE_RESULT Error recompileChangedPrograms(StringListAuto& changedProgramFilenames);
+
 private:
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	String m_cacheDir;
@@ -112,7 +118,8 @@ private:
 
 	/// Iterate all programs in the filesystem and compile them to AnKi's binary format.
 	static Error compileAllShaders(CString cacheDir, GrManager& gr, ResourceFilesystem& fs,
-								   GenericMemoryPoolAllocator<U8>& alloc, StringListAuto& rtProgramFilenames);
+								   GenericMemoryPoolAllocator<U8>& alloc, StringListAuto& rtProgramFilenames,
+								   StringListAuto* compiledProgramFilenames = nullptr);
 
 	static Error createRayTracingPrograms(CString cacheDir, const StringListAuto& rtProgramFilenames, GrManager& gr,
 										  GenericMemoryPoolAllocator<U8>& alloc,
@@ -0,0 +1,192 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Resource/ShaderVariantManifest.h>
+#include <AnKi/Util/File.h>
+#include <AnKi/Util/Filesystem.h>
+
+namespace anki
+{
+
+static constexpr const char* SHADER_VARIANT_MANIFEST_MAGIC = "ANKISVM1";
+
+class ShaderVariantManifestHeader
+{
+public:
+	Array<char, 8> m_magic;
+	U32 m_resourceCount;
+	U32 m_padding = 0;
+};
+
+class ShaderVariantManifestResourceHeader
+{
+public:
+	U32 m_filenameLength;
+	U32 m_variantSize;
+	U32 m_variantCount;
+};
+
+ShaderVariantManifest::~ShaderVariantManifest()
+{
+	for(Resource& rsrc : m_resources)
+	{
+		rsrc.m_filename.destroy(m_alloc);
+		rsrc.m_variants.destroy(m_alloc);
+	}
+
+	m_resources.destroy(m_alloc);
+}
+
+Error ShaderVariantManifest::load(CString filename)
+{
+	if(!fileExists(filename))
+	{
+		// First run, nothing to load
+		return Error::NONE;
+	}
+
+	File file;
+	ANKI_CHECK(file.open(filename, FileOpenFlag::READ | FileOpenFlag::BINARY));
+
+	ShaderVariantManifestHeader header;
+	if(file.getSize() < sizeof(header))
+	{
+		return Error::NONE;
+	}
+
+	ANKI_CHECK(file.read(&header, sizeof(header)));
+	if(memcmp(&header.m_magic[0], SHADER_VARIANT_MANIFEST_MAGIC, sizeof(header.m_magic)) != 0)
+	{
+		ANKI_RESOURCE_LOGW("Ignoring shader variant manifest of an older version: %s", filename.cstr());
+		return Error::NONE;
+	}
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	StringAuto rsrcFilename(m_alloc);
+	for(U32 i = 0; i < header.m_resourceCount; ++i)
+	{
+		ShaderVariantManifestResourceHeader rsrcHeader;
+		ANKI_CHECK(file.read(&rsrcHeader, sizeof(rsrcHeader)));
+
+		if(rsrcHeader.m_filenameLength == 0 || rsrcHeader.m_variantSize == 0 || rsrcHeader.m_variantCount == 0)
+		{
+			ANKI_RESOURCE_LOGE("Corrupted shader variant manifest: %s", filename.cstr());
+			return Error::USER_DATA;
+		}
+
+		rsrcFilename.destroy();
+		rsrcFilename.create(' ', rsrcHeader.m_filenameLength);
+		ANKI_CHECK(file.read(&rsrcFilename[0], rsrcHeader.m_filenameLength));
+
+		Resource rsrc;
+		rsrc.m_filename.create(m_alloc, rsrcFilename);
+		rsrc.m_variantSize = rsrcHeader.m_variantSize;
+		rsrc.m_variants.create(m_alloc, rsrcHeader.m_variantSize * rsrcHeader.m_variantCount);
+		const Error err = file.read(&rsrc.m_variants[0], rsrc.m_variants.getSizeInBytes());
+		if(err)
+		{
+			rsrc.m_filename.destroy(m_alloc);
+			rsrc.m_variants.destroy(m_alloc);
+			return err;
+		}
+
+		m_resources.emplace(m_alloc, rsrcFilename.toCString().computeHash(), std::move(rsrc));
+	}
+
+	return Error::NONE;
+}
+
+Error ShaderVariantManifest::save(CString filename)
+{
+	LockGuard<Mutex> lock(m_mtx);
+
+	if(!m_dirty)
+	{
+		return Error::NONE;
+	}
+
+	File file;
+	ANKI_CHECK(file.open(filename, FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+
+	ShaderVariantManifestHeader header;
+	memcpy(&header.m_magic[0], SHADER_VARIANT_MANIFEST_MAGIC, sizeof(header.m_magic));
+	header.m_resourceCount = U32(m_resources.getSize());
+	ANKI_CHECK(file.write(&header, sizeof(header)));
+
+	for(const Resource& rsrc : m_resources)
+	{
+		ShaderVariantManifestResourceHeader rsrcHeader;
+		rsrcHeader.m_filenameLength = rsrc.m_filename.getLength();
+		rsrcHeader.m_variantSize = rsrc.m_variantSize;
+		rsrcHeader.m_variantCount = rsrc.m_variants.getSize() / rsrc.m_variantSize;
+
+		ANKI_CHECK(file.write(&rsrcHeader, sizeof(rsrcHeader)));
+		ANKI_CHECK(file.write(rsrc.m_filename.cstr(), rsrcHeader.m_filenameLength));
+		ANKI_CHECK(file.write(&rsrc.m_variants[0], rsrc.m_variants.getSizeInBytes()));
+	}
+
+	m_dirty = false;
+	return Error::NONE;
+}
+
+void ShaderVariantManifest::recordVariant(CString resourceFilename, ConstWeakArray<U8> variant)
+{
+	ANKI_ASSERT(resourceFilename.getLength() > 0);
+	ANKI_ASSERT(variant.getSize() > 0);
+	const U64 hash = resourceFilename.computeHash();
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	auto it = m_resources.find(hash);
+	if(it == m_resources.getEnd())
+	{
+		Resource rsrc;
+		rsrc.m_filename.create(m_alloc, resourceFilename);
+		rsrc.m_variantSize = variant.getSize();
+		it = m_resources.emplace(m_alloc, hash, std::move(rsrc));
+	}
+	else if(it->m_variantSize != variant.getSize())
+	{
+		// The resource changed, forget the old variants
+		it->m_variants.destroy(m_alloc);
+		it->m_variantSize = variant.getSize();
+	}
+	else
+	{
+		// Skip it if it's already there
+		for(U32 offset = 0; offset < it->m_variants.getSize(); offset += it->m_variantSize)
+		{
+			if(memcmp(&it->m_variants[offset], &variant[0], variant.getSize()) == 0)
+			{
+				return;
+			}
+		}
+	}
+
+	const U32 offset = it->m_variants.getSize();
+	it->m_variants.resize(m_alloc, offset + variant.getSize());
+	memcpy(&it->m_variants[offset], &variant[0], variant.getSize());
+	m_dirty = true;
+}
+
+void ShaderVariantManifest::getVariants(CString resourceFilename, DynamicArrayAuto<U8>& variants,
+										U32& variantSize) const
+{
+	variants.destroy();
+	variantSize = 0;
+
+	LockGuard<Mutex> lock(m_mtx);
+
+	auto it = m_resources.find(resourceFilename.computeHash());
+	if(it != m_resources.getEnd() && it->m_variants.getSize() > 0)
+	{
+		variantSize = it->m_variantSize;
+		variants.create(it->m_variants.getSize());
+		memcpy(&variants[0], &it->m_variants[0], it->m_variants.getSizeInBytes());
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,66 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Resource/Common.h>
+#include <AnKi/Util/HashMap.h>
+#include <AnKi/Util/DynamicArray.h>
+#include <AnKi/Util/WeakArray.h>
+#include <AnKi/Util/Thread.h>
+
+namespace anki
+{
+
+/// @addtogroup resource
+/// @{
+
+/// Remembers the shader variants that the resources created so a later run can create them while loading and not the
+/// first time something is drawn. Every resource describes its variants with a few bytes that only the resource
+/// understands. All the variants of a resource should have the same size.
+/// @note It's thread-safe.
+class ShaderVariantManifest
+{
+public:
+	ShaderVariantManifest(GenericMemoryPoolAllocator<U8> alloc)
+		: m_alloc(alloc)
+	{
+	}
+
+	~ShaderVariantManifest();
+
+	/// Load the variants of previous runs. A missing or old file is not an error.
+	ANKI_USE_RESULT Error load(CString filename);
+
+	/// Store the variants. It does nothing if no new variants were recorded.
+	ANKI_USE_RESULT Error save(CString filename);
+
+	/// Record that a resource created a variant. If the size of the variant is not the same as the recorded ones (eg
+	/// the program changed) the old variants are dropped.
+	void recordVariant(CString resourceFilename, ConstWeakArray<U8> variant);
+
+	/// Get the recorded variants of a resource.
+	/// @param resourceFilename The resource.
+	/// @param[out] variants All the variants, one after the other.
+	/// @param[out] variantSize The size of a single variant.
+	void getVariants(CString resourceFilename, DynamicArrayAuto<U8>& variants, U32& variantSize) const;
+
+private:
+	class Resource
+	{
+	public:
+		String m_filename;
+		DynamicArray<U8> m_variants;
+		U32 m_variantSize = 0;
+	};
+
+	GenericMemoryPoolAllocator<U8> m_alloc;
+	HashMap<U64, Resource> m_resources; ///< Filename hash to resource.
+	mutable Mutex m_mtx;
+	Bool m_dirty = false;
+};
+/// @}
+
+} // end namespace anki
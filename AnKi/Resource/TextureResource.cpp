@@ -41,7 +41,20 @@ public:
 
 	Error operator()(AsyncLoaderTaskContext& ctx) final
 	{
-		return TextureResource::load(m_ctx);
+		switch(ctx.m_stage)
+		{
+		case AsyncLoaderStage::IO:
+			ANKI_CHECK(m_ctx.m_loader.prefetch());
+			ctx.m_nextStage = (m_ctx.m_loader.isDecoded()) ? AsyncLoaderStage::TRANSFER : AsyncLoaderStage::DECODE;
+			return Error::NONE;
+		case AsyncLoaderStage::DECODE:
+			ANKI_CHECK(m_ctx.m_loader.decode());
+			ctx.m_nextStage = AsyncLoaderStage::TRANSFER;
+			return Error::NONE;
+		default:
+			ANKI_ASSERT(ctx.m_stage == AsyncLoaderStage::TRANSFER);
+			return TextureResource::load(m_ctx);
+		}
 	}
 };
 
@@ -75,7 +88,8 @@ Error TextureResource::load(const ResourceFilename& filename, Bool async)
 	ResourceFilePtr file;
 	ANKI_CHECK(openFile(filename, file));
 
-	ANKI_CHECK(loader.load(file, filename, getManager().getMaxTextureSize()));
+	// The decoding of the pixels happens in the async loader
+	ANKI_CHECK(loader.load(file, filename, getManager().getMaxTextureSize(), async));
 
 	// Various sizes
 	init.m_width = loader.getWidth();
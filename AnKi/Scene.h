@@ -17,6 +17,7 @@
 #include <AnKi/Scene/PlayerNode.h>
 #include <AnKi/Scene/DecalNode.h>
 #include <AnKi/Scene/Octree.h>
+#include <AnKi/Scene/TransformStore.h>
 #include <AnKi/Scene/PhysicsDebugNode.h>
 #include <AnKi/Scene/TriggerNode.h>
 #include <AnKi/Scene/FogDensityNode.h>
@@ -24,9 +24,10 @@ namespace anki
 template<typename T>
 using SceneAllocator = HeapAllocator<T>;
 
-/// The type of the scene's frame allocator
+/// The type of the scene's frame allocator. Visibility and the render queues are built by many threads at the same
+/// time so it's thread local.
 template<typename T>
-using SceneFrameAllocator = StackAllocator<T>;
+using SceneFrameAllocator = ThreadLocalStackAllocator<T>;
 /// @}
 
 } // end namespace anki
@@ -50,12 +50,6 @@ Error LightComponent::update(SceneNode& node, Second prevTime, Second crntTime,
 		m_spot.m_textureMat = biasMat4 * proj * Mat4(m_worldtransform.getInverse());
 	}
 
-	// Update the scene bounds always
-	if(m_type == LightComponentType::DIRECTIONAL)
-	{
-		node.getSceneGraph().getOctree().getActualSceneBounds(m_dir.m_sceneMin, m_dir.m_sceneMax);
-	}
-
 	return Error::NONE;
 }
 
@@ -134,6 +128,10 @@ void LightComponent::setupDirectionalLightQueueElement(const FrustumComponent& f
 			boundingSpheres[i].setCenter(frustumComp.getWorldTransform().transform(C));
 		}
 
+		// Get the scene bounds here and not at update because the octree is updated at the end of the scene update
+		Vec3 actualSceneMin, actualSceneMax;
+		m_node->getSceneGraph().getOctree().getActualSceneBounds(actualSceneMin, actualSceneMax);
+
 		// Compute the matrices
 		for(U32 i = 0; i < shadowCascadeCount; ++i)
 		{
@@ -141,8 +139,8 @@ void LightComponent::setupDirectionalLightQueueElement(const FrustumComponent& f
 			const Vec3 sphereCenter = sphere.getCenter().xyz();
 			const F32 sphereRadius = sphere.getRadius();
 			const Vec3& lightDir = el.m_direction;
-			const Vec3 sceneMin = m_dir.m_sceneMin - Vec3(sphereRadius); // Push the bounds a bit
-			const Vec3 sceneMax = m_dir.m_sceneMax + Vec3(sphereRadius);
+			const Vec3 sceneMin = actualSceneMin - Vec3(sphereRadius); // Push the bounds a bit
+			const Vec3 sceneMax = actualSceneMax + Vec3(sphereRadius);
 
 			// Compute the intersections with the scene bounds
 			Vec3 eye;
@@ -202,18 +202,10 @@ private:
 		F32 m_innerAngle;
 	};
 
-	class Dir
-	{
-	public:
-		Vec3 m_sceneMin;
-		Vec3 m_sceneMax;
-	};
-
 	union
 	{
 		Point m_point;
 		Spot m_spot;
-		Dir m_dir;
 	};
 
 	TextureResourcePtr m_pointDebugTex;
@@ -5,6 +5,7 @@
 
 #include <AnKi/Scene/Components/MoveComponent.h>
 #include <AnKi/Scene/SceneNode.h>
+#include <AnKi/Scene/SceneGraph.h>
 
 namespace anki
 {
@@ -13,14 +14,18 @@ ANKI_SCENE_COMPONENT_STATICS(MoveComponent)
 
 MoveComponent::MoveComponent(SceneNode* node)
 	: SceneComponent(node, getStaticClassId())
+	, m_store(&node->getSceneGraph().getTransformStore())
 	, m_ignoreLocalTransform(false)
 	, m_ignoreParentTransform(false)
+	, m_updatedThisFrame(false)
 {
+	m_transform = m_store->newTransform();
 	markForUpdate();
 }
 
 MoveComponent::~MoveComponent()
 {
+	m_store->deleteTransform(m_transform);
 }
 
 Error MoveComponent::update(SceneNode& node, Second prevTime, Second crntTime, Bool& updated)
@@ -31,64 +36,23 @@ Error MoveComponent::update(SceneNode& node, Second prevTime, Second crntTime, B
 
 Bool MoveComponent::updateWorldTransform(SceneNode& node)
 {
-	m_prevWTrf = m_wtrf;
-	const Bool dirty = m_markedForUpdate;
+	// The parents are updated before the children so the parent's m_updatedThisFrame is from this frame
+	const SceneNode* parent = node.getParent();
+	const MoveComponent* parentMove =
+		(parent && !m_ignoreParentTransform) ? parent->tryGetFirstComponentOfType<MoveComponent>() : nullptr;
+
+	const Bool dirty = m_markedForUpdate || (parentMove && parentMove->m_updatedThisFrame);
 
 	// If dirty then update world transform
 	if(dirty)
 	{
-		const SceneNode* parent = node.getParent();
-
-		if(parent)
-		{
-			const MoveComponent* parentMove = parent->tryGetFirstComponentOfType<MoveComponent>();
-
-			if(parentMove == nullptr)
-			{
-				// Parent not movable
-				m_wtrf = m_ltrf;
-			}
-			else if(m_ignoreParentTransform)
-			{
-				m_wtrf = m_ltrf;
-			}
-			else if(m_ignoreLocalTransform)
-			{
-				m_wtrf = parentMove->getWorldTransform();
-			}
-			else
-			{
-				m_wtrf = parentMove->getWorldTransform().combineTransformations(m_ltrf);
-			}
-		}
-		else
-		{
-			// No parent
+		const U32 parentHandle = (parentMove) ? parentMove->m_transform : TransformStore::INVALID_HANDLE;
+		m_store->updateWorldTransform(m_transform, parentHandle, m_ignoreLocalTransform);
 
-			m_wtrf = m_ltrf;
-		}
-
-		// Now it's a good time to cleanse parent
 		m_markedForUpdate = false;
 	}
 
-	// If this is dirty then make children dirty as well. Don't walk the whole tree because you will re-walk it later
-	if(dirty)
-	{
-		Error err = node.visitChildrenMaxDepth(1, [](SceneNode& childNode) -> Error {
-			Error e = childNode.iterateComponentsOfType<MoveComponent>([](MoveComponent& mov) -> Error {
-				mov.markForUpdate();
-				return Error::NONE;
-			});
-
-			(void)e;
-
-			return Error::NONE;
-		});
-
-		(void)err;
-	}
-
+	m_updatedThisFrame = dirty;
 	return dirty;
 }
 
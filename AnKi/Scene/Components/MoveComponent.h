@@ -6,6 +6,7 @@
 #pragma once
 
 #include <AnKi/Scene/Components/SceneComponent.h>
+#include <AnKi/Scene/TransformStore.h>
 #include <AnKi/Util/BitMask.h>
 #include <AnKi/Util/Enum.h>
 #include <AnKi/Math.h>
@@ -16,7 +17,7 @@ namespace anki
 /// @addtogroup scene
 /// @{
 
-/// Interface for movable scene nodes.
+/// Interface for movable scene nodes. The transforms live in the TransformStore of the SceneGraph.
 class MoveComponent : public SceneComponent
 {
 	ANKI_SCENE_COMPONENT(MoveComponent)
@@ -38,58 +39,58 @@ public:
 		m_ignoreParentTransform = ignore;
 	}
 
-	const Transform& getLocalTransform() const
+	Transform getLocalTransform() const
 	{
-		return m_ltrf;
+		return m_store->getLocalTransform(m_transform);
 	}
 
 	void setLocalTransform(const Transform& x)
 	{
-		m_ltrf = x;
+		m_store->setLocalTransform(m_transform, x);
 		markForUpdate();
 	}
 
 	void setLocalOrigin(const Vec4& x)
 	{
-		m_ltrf.setOrigin(x);
+		m_store->getLocalOrigin(m_transform) = x;
 		markForUpdate();
 	}
 
 	const Vec4& getLocalOrigin() const
 	{
-		return m_ltrf.getOrigin();
+		return m_store->getLocalOrigin(m_transform);
 	}
 
 	void setLocalRotation(const Mat3x4& x)
 	{
-		m_ltrf.setRotation(x);
+		m_store->getLocalRotation(m_transform) = x;
 		markForUpdate();
 	}
 
 	const Mat3x4& getLocalRotation() const
 	{
-		return m_ltrf.getRotation();
+		return m_store->getLocalRotation(m_transform);
 	}
 
 	void setLocalScale(F32 x)
 	{
-		m_ltrf.setScale(x);
+		m_store->getLocalScale(m_transform) = x;
 		markForUpdate();
 	}
 
 	F32 getLocalScale() const
 	{
-		return m_ltrf.getScale();
+		return m_store->getLocalScale(m_transform);
 	}
 
-	const Transform& getWorldTransform() const
+	Transform getWorldTransform() const
 	{
-		return m_wtrf;
+		return m_store->getWorldTransform(m_transform);
 	}
 
-	const Transform& getPreviousWorldTransform() const
+	Transform getPreviousWorldTransform() const
 	{
-		return m_prevWTrf;
+		return m_store->getPreviousWorldTransform(m_transform);
 	}
 
 	ANKI_USE_RESULT Error update(SceneNode& node, Second prevTime, Second crntTime, Bool& updated) override;
@@ -98,70 +99,68 @@ public:
 	/// @{
 	void rotateLocalX(F32 angDegrees)
 	{
-		m_ltrf.getRotation().rotateXAxis(angDegrees);
+		m_store->getLocalRotation(m_transform).rotateXAxis(angDegrees);
 		markForUpdate();
 	}
 	void rotateLocalY(F32 angDegrees)
 	{
-		m_ltrf.getRotation().rotateYAxis(angDegrees);
+		m_store->getLocalRotation(m_transform).rotateYAxis(angDegrees);
 		markForUpdate();
 	}
 	void rotateLocalZ(F32 angDegrees)
 	{
-		m_ltrf.getRotation().rotateZAxis(angDegrees);
+		m_store->getLocalRotation(m_transform).rotateZAxis(angDegrees);
 		markForUpdate();
 	}
 	void moveLocalX(F32 distance)
 	{
-		Vec3 x_axis = m_ltrf.getRotation().getColumn(0);
-		m_ltrf.getOrigin() += Vec4(x_axis, 0.0) * distance;
+		Vec3 x_axis = m_store->getLocalRotation(m_transform).getColumn(0);
+		m_store->getLocalOrigin(m_transform) += Vec4(x_axis, 0.0) * distance;
 		markForUpdate();
 	}
 	void moveLocalY(F32 distance)
 	{
-		Vec3 y_axis = m_ltrf.getRotation().getColumn(1);
-		m_ltrf.getOrigin() += Vec4(y_axis, 0.0) * distance;
+		Vec3 y_axis = m_store->getLocalRotation(m_transform).getColumn(1);
+		m_store->getLocalOrigin(m_transform) += Vec4(y_axis, 0.0) * distance;
 		markForUpdate();
 	}
 	void moveLocalZ(F32 distance)
 	{
-		Vec3 z_axis = m_ltrf.getRotation().getColumn(2);
-		m_ltrf.getOrigin() += Vec4(z_axis, 0.0) * distance;
+		Vec3 z_axis = m_store->getLocalRotation(m_transform).getColumn(2);
+		m_store->getLocalOrigin(m_transform) += Vec4(z_axis, 0.0) * distance;
 		markForUpdate();
 	}
 	void scale(F32 s)
 	{
-		m_ltrf.getScale() *= s;
+		m_store->getLocalScale(m_transform) *= s;
 		markForUpdate();
 	}
 
 	void lookAtPoint(const Vec4& point)
 	{
-		m_ltrf.lookAt(point, Vec4(0.0f, 1.0f, 0.0f, 0.0f));
-		markForUpdate();
+		Transform trf = getLocalTransform();
+		trf.lookAt(point, Vec4(0.0f, 1.0f, 0.0f, 0.0f));
+		setLocalTransform(trf);
 	}
 	/// @}
 
 private:
-	/// The transformation in local space
-	Transform m_ltrf = Transform::getIdentity();
-
-	/// The transformation in world space (local combined with parent's transformation)
-	Transform m_wtrf = Transform::getIdentity();
+	TransformStore* m_store;
 
-	/// Keep the previous transformation for checking if it moved
-	Transform m_prevWTrf = Transform::getIdentity();
+	/// The handle of the local, world and previous world transforms in the store.
+	U32 m_transform;
 
 	Bool m_markedForUpdate : 1;
 	Bool m_ignoreLocalTransform : 1;
 	Bool m_ignoreParentTransform : 1;
+	Bool m_updatedThisFrame : 1; ///< The world transform changed in the last update. The children read it.
 
 	void markForUpdate()
 	{
 		m_markedForUpdate = true;
 	}
 
-	/// Called every frame. It updates the @a m_wtrf if @a shouldUpdateWTrf is true. Then it moves to the children.
+	/// Called every frame. It updates the world transform if this or the parent's transform changed.
 	Bool updateWorldTransform(SceneNode& node);
 };
 /// @}
@@ -5,6 +5,7 @@
 
 #include <AnKi/Scene/Components/ScriptComponent.h>
 #include <AnKi/Scene/SceneGraph.h>
+#include <AnKi/Scene/Components/MoveComponent.h>
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Resource/ScriptResource.h>
 #include <AnKi/Script/ScriptManager.h>
@@ -24,7 +25,24 @@ ScriptComponent::ScriptComponent(SceneNode* node)
 
 ScriptComponent::~ScriptComponent()
 {
-	m_node->getAllocator().deleteInstance(m_env);
+	destroyScript();
+}
+
+void ScriptComponent::destroyScript()
+{
+	if(m_env)
+	{
+		m_node->getAllocator().deleteInstance(m_env);
+		m_env = nullptr;
+		m_nodeRef = LUA_NOREF;
+	}
+
+	if(m_batch)
+	{
+		m_batch->deleteInstance(m_batchInstanceId);
+		m_batch = nullptr;
+		m_batchInstanceId = MAX_U32;
+	}
 }
 
 Error ScriptComponent::loadScriptResource(CString fname)
@@ -32,16 +50,37 @@ Error ScriptComponent::loadScriptResource(CString fname)
 	// Load
 	ANKI_CHECK(m_node->getSceneGraph().getResourceManager().loadResource(fname, m_script));
 
-	// Create the env
-	if(m_env)
+	destroyScript();
+
+	SceneGraph& scene = m_node->getSceneGraph();
+	if(scene.getConfig().m_sharedScriptStates)
 	{
-		m_node->getAllocator().deleteInstance(m_env);
+		// Become an instance of the batch
+		ScriptBatch* batch;
+		ANKI_CHECK(scene.getOrCreateScriptBatch(m_script, batch));
+		ANKI_CHECK(batch->newInstance("node", m_node, m_batchInstanceId));
+		m_batch = batch;
+
+		MoveComponent* move = m_node->tryGetFirstComponentOfType<MoveComponent>();
+		if(move)
+		{
+			m_batch->exposeInstanceVariable(m_batchInstanceId, "move", move);
+		}
 	}
-	m_env = m_node->getAllocator().newInstance<ScriptEnvironment>();
-	ANKI_CHECK(m_env->init(&m_node->getSceneGraph().getScriptManager()));
+	else
+	{
+		// Create the env
+		m_env = m_node->getAllocator().newInstance<ScriptEnvironment>();
+		ANKI_CHECK(m_env->init(&scene.getScriptManager()));
 
-	// Exec the script
-	ANKI_CHECK(m_env->evalString(m_script->getSource()));
+		// Exec the script
+		ANKI_CHECK(m_env->evalString(m_script->getSource()));
+
+		// Push the node once
+		lua_State* lua = &m_env->getLuaState();
+		LuaBinder::pushVariableToTheStack(lua, m_node);
+		m_nodeRef = luaL_ref(lua, LUA_REGISTRYINDEX);
+	}
 
 	return Error::NONE;
 }
@@ -52,6 +91,7 @@ Error ScriptComponent::update(SceneNode& node, Second prevTime, Second crntTime,
 	updated = false;
 	if(m_env == nullptr)
 	{
+		// Nothing to do or it's updated by the SceneGraph as part of the batch
 		return Error::NONE;
 	}
 
@@ -61,7 +101,7 @@ Error ScriptComponent::update(SceneNode& node, Second prevTime, Second crntTime,
 	lua_getglobal(lua, "update");
 
 	// Push args
-	LuaBinder::pushVariableToTheStack(lua, &node);
+	lua_rawgeti(lua, LUA_REGISTRYINDEX, m_nodeRef);
 	lua_pushnumber(lua, prevTime);
 	lua_pushnumber(lua, crntTime);
 
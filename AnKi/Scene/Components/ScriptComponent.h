@@ -8,6 +8,7 @@
 #include <AnKi/Scene/Components/SceneComponent.h>
 #include <AnKi/Resource/Forward.h>
 #include <AnKi/Script/ScriptEnvironment.h>
+#include <AnKi/Script/ScriptBatch.h>
 
 namespace anki
 {
@@ -15,7 +16,10 @@ namespace anki
 /// @addtogroup scene
 /// @{
 
-/// Component of scripts.
+/// Component of scripts. By default every component has its own LUA state and it's updated with the rest of the
+/// components. If SceneGraphConfig::m_sharedScriptStates is on all the ScriptComponents of the same script are
+/// instances of one ScriptBatch that the SceneGraph updates before the nodes. The environment of every instance has the
+/// "node" and the "move" (the MoveComponent of the node, if there is one) variables.
 class ScriptComponent : public SceneComponent
 {
 	ANKI_SCENE_COMPONENT(ScriptComponent)
@@ -38,6 +42,11 @@ private:
 	SceneNode* m_node;
 	ScriptResourcePtr m_script;
 	ScriptEnvironment* m_env = nullptr;
+	ScriptBatch* m_batch = nullptr;
+	U32 m_batchInstanceId = MAX_U32;
+	I32 m_nodeRef = LUA_NOREF; ///< The userdata of m_node in m_env.
+
+	void destroyScript();
 };
 /// @}
 
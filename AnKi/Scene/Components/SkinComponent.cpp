@@ -27,6 +27,11 @@ SkinComponent::~SkinComponent()
 	m_boneTrfs[0].destroy(m_node->getAllocator());
 	m_boneTrfs[1].destroy(m_node->getAllocator());
 	m_animationTrfs.destroy(m_node->getAllocator());
+
+	for(Track& track : m_tracks)
+	{
+		track.m_cursors.destroy(m_node->getAllocator());
+	}
 }
 
 Error SkinComponent::loadSkeletonResource(CString fname)
@@ -63,6 +68,9 @@ void SkinComponent::playAnimation(U32 track, AnimationResourcePtr anim, const An
 		m_tracks[track].m_blendOutTime = 0.0; // Irrelevant
 	}
 	m_tracks[track].m_repeatTimes = info.m_repeatTimes;
+
+	m_tracks[track].m_cursors.destroy(m_node->getAllocator());
+	m_tracks[track].m_cursors.create(m_node->getAllocator(), anim->getChannels().getSize(), AnimationChannelCursor());
 }
 
 Error SkinComponent::update(SceneNode& node, Second prevTime, Second crntTime, Bool& updated)
@@ -125,7 +133,7 @@ Error SkinComponent::update(SceneNode& node, Second prevTime, Second crntTime, B
 			Vec3 position;
 			Quat rotation;
 			F32 scale;
-			track.m_anim->interpolate(i, animTime, position, rotation, scale);
+			track.m_anim->interpolate(i, animTime, position, rotation, scale, &track.m_cursors[i]);
 
 			// Blend with previous track
 			if(bonesAnimated.get(boneIdx) && (track.m_blendInTime > 0.0 || track.m_blendOutTime > 0.0))
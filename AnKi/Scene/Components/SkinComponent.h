@@ -10,6 +10,7 @@
 #include <AnKi/Collision/Aabb.h>
 #include <AnKi/Util/Forward.h>
 #include <AnKi/Util/WeakArray.h>
+#include <AnKi/Util/DynamicArray.h>
 #include <AnKi/Math.h>
 
 namespace anki
@@ -89,6 +90,7 @@ private:
 		Second m_blendInTime = 0.0;
 		Second m_blendOutTime = 0.0f;
 		F32 m_repeatTimes = 1.0f;
+		DynamicArray<AnimationChannelCursor> m_cursors; ///< One per animation channel.
 	};
 
 	class Trf
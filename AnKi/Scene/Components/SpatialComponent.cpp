@@ -83,7 +83,8 @@ Error SpatialComponent::update(SceneNode& node, Second prevTime, Second crntTime
 
 		m_markedForUpdate = false;
 
-		m_node->getSceneGraph().getOctree().place(m_derivedAabb, &m_octreeInfo, m_updateOctreeBounds);
+		// Many spatials are updated in parallel so don't place it now, SceneGraph will do that at the end of the update
+		m_node->getSceneGraph().getOctree().placeDeferred(m_derivedAabb, &m_octreeInfo, m_updateOctreeBounds);
 		m_placed = true;
 	}
 
@@ -17,3 +17,5 @@ ANKI_CONFIG_OPTION(scene_reflectionProbeShadowEffectiveDistance, 32.0, 1.0, MAX_
 ANKI_CONFIG_OPTION(scene_rayTracedShadows, 0, 0, 1, "Enable or not ray traced shadows. Ignored if RT is not supported")
 ANKI_CONFIG_OPTION(scene_rayTracingExtendedFrustumDistance, 100.0, 10.0, 10000.0,
 				   "Every object that its distance from the camera is bellow that value will take part in ray tracing")
+ANKI_CONFIG_OPTION(scene_sharedScriptStates, 0, 0, 1,
+				   "The ScriptComponents of the same script share a LUA state and are updated together")
@@ -6,7 +6,7 @@
 #pragma once
 
 #include <AnKi/Scene/Common.h>
-#include <AnKi/Util/List.h>
+#include <AnKi/Util/SlotMap.h>
 #include <AnKi/Util/WeakArray.h>
 
 namespace anki
@@ -16,7 +16,7 @@ namespace anki
 /// @{
 
 /// The base class for all events
-class Event : public IntrusiveListEnabled<Event>
+class Event
 {
 	friend class EventManager;
 
@@ -105,6 +105,7 @@ public:
 
 protected:
 	EventManager* m_manager = nullptr;
+	SlotMapHandle m_handle; ///< The handle inside the EventManager.
 
 	Second m_startTime = 0.0;
 	Second m_duration = 0.0;
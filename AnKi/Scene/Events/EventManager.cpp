@@ -16,13 +16,14 @@ EventManager::EventManager()
 
 EventManager::~EventManager()
 {
-	while(!m_events.isEmpty())
+	for(Event* event : m_events)
 	{
-		Event* event = &m_events.getFront();
 		event->setMarkedForDeletion();
 	}
 
 	deleteEventsMarkedForDeletion(false);
+	m_events.destroy(getAllocator());
+	m_eventsMarkedForDeletion.destroy(getAllocator());
 }
 
 Error EventManager::init(SceneGraph* scene)
@@ -46,8 +47,11 @@ Error EventManager::updateAllEvents(Second prevUpdateTime, Second crntTime)
 {
 	Error err = Error::NONE;
 
-	for(Event& event : m_events)
+	// Iterate with an index because events may create new events while updating
+	for(U32 i = 0; i < m_events.getSize(); ++i)
 	{
+		Event& event = *m_events[i];
+
 		// If event or the node's event is marked for deletion then dont do anything else for that event
 		if(event.getMarkedForDeletion())
 		{
@@ -117,10 +121,14 @@ void EventManager::markEventForDeletion(Event* event)
 		return;
 	}
 
+	// Don't touch m_events here since this might be called while iterating it
 	LockGuard<Mutex> lock(m_mtx);
 	event->m_markedForDeletion = true;
-	m_events.erase(event);
-	m_eventsMarkedForDeletion.pushBack(event);
+	if(m_eventsMarkedForDeletionCount == m_eventsMarkedForDeletion.getSize())
+	{
+		m_eventsMarkedForDeletion.resize(getAllocator(), max<U32>(m_eventsMarkedForDeletionCount * 2, 16));
+	}
+	m_eventsMarkedForDeletion[m_eventsMarkedForDeletionCount++] = event;
 }
 
 void EventManager::deleteEventsMarkedForDeletion(Bool fullCleanup)
@@ -130,34 +138,28 @@ void EventManager::deleteEventsMarkedForDeletion(Bool fullCleanup)
 	// Mark events with to-be-deleted nodes as also to be deleted
 	if(fullCleanup)
 	{
-		// Gather in an array because we can't call setMarkedForDeletion while iterating m_events
-		DynamicArrayAuto<Event*> markedForDeletion(getFrameAllocator());
-		for(Event& event : m_events)
+		for(Event* event : m_events)
 		{
-			for(SceneNode* node : event.m_associatedNodes)
+			for(SceneNode* node : event->m_associatedNodes)
 			{
 				if(node->getMarkedForDeletion())
 				{
-					markedForDeletion.emplaceBack(&event);
+					event->setMarkedForDeletion();
 					break;
 				}
 			}
 		}
-
-		for(Event* event : markedForDeletion)
-		{
-			event->setMarkedForDeletion();
-		}
 	}
 
-	// Gather events for deletion
-	while(!m_eventsMarkedForDeletion.isEmpty())
+	// Delete the events. Keep the storage of m_eventsMarkedForDeletion for the next frames
+	for(U32 i = 0; i < m_eventsMarkedForDeletionCount; ++i)
 	{
-		Event* event = &m_eventsMarkedForDeletion.getFront();
-		m_eventsMarkedForDeletion.popFront();
-
+		Event* event = m_eventsMarkedForDeletion[i];
+		m_events.erase(alloc, event->m_handle);
 		alloc.deleteInstance(event);
 	}
+
+	m_eventsMarkedForDeletionCount = 0;
 }
 
 } // end namespace anki
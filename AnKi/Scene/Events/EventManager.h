@@ -6,7 +6,7 @@
 #pragma once
 
 #include <AnKi/Scene/Common.h>
-#include <AnKi/Util/List.h>
+#include <AnKi/Util/SlotMap.h>
 #include <AnKi/Math.h>
 
 namespace anki
@@ -51,7 +51,7 @@ public:
 		else
 		{
 			LockGuard<Mutex> lock(m_mtx);
-			m_events.pushBack(event);
+			event->m_handle = m_events.emplace(getAllocator(), event);
 		}
 		return err;
 	}
@@ -68,8 +68,13 @@ public:
 private:
 	SceneGraph* m_scene = nullptr;
 
-	IntrusiveList<Event> m_events;
-	IntrusiveList<Event> m_eventsMarkedForDeletion;
+	/// Packed so the per frame update walks an array instead of chasing list nodes. The events are polymorphic and of
+	/// different sizes so they can't be stored by value, the update still dereferences one pointer per event.
+	SlotMap<Event*> m_events;
+
+	/// It's not released between frames so marking events doesn't allocate once it has grown enough.
+	DynamicArray<Event*> m_eventsMarkedForDeletion;
+	U32 m_eventsMarkedForDeletionCount = 0;
 	Mutex m_mtx;
 };
 /// @}
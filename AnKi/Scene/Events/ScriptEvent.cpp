@@ -31,6 +31,10 @@ Error ScriptEvent::init(Second startTime, Second duration, CString script)
 	// Create the env
 	ANKI_CHECK(m_env.init(&getSceneGraph().getScriptManager()));
 
+	lua_State* lua = &m_env.getLuaState();
+	LuaBinder::pushVariableToTheStack(lua, static_cast<Event*>(this));
+	m_eventRef = luaL_ref(lua, LUA_REGISTRYINDEX);
+
 	// Do the rest
 	StringAuto extension(getAllocator());
 	getFilepathExtension(script, extension);
@@ -63,7 +67,7 @@ Error ScriptEvent::update(Second prevUpdateTime, Second crntTime)
 	lua_getglobal(lua, "update");
 
 	// Push args
-	LuaBinder::pushVariableToTheStack(lua, static_cast<Event*>(this));
+	lua_rawgeti(lua, LUA_REGISTRYINDEX, m_eventRef);
 	lua_pushnumber(lua, prevUpdateTime);
 	lua_pushnumber(lua, crntTime);
 
@@ -102,7 +106,7 @@ Error ScriptEvent::onKilled(Second prevUpdateTime, Second crntTime)
 	lua_getglobal(lua, "onKilled");
 
 	// Push args
-	LuaBinder::pushVariableToTheStack(lua, static_cast<Event*>(this));
+	lua_rawgeti(lua, LUA_REGISTRYINDEX, m_eventRef);
 	lua_pushnumber(lua, prevUpdateTime);
 	lua_pushnumber(lua, crntTime);
 
@@ -45,6 +45,7 @@ private:
 	ScriptResourcePtr m_scriptRsrc;
 	String m_script;
 	ScriptEnvironment m_env;
+	I32 m_eventRef = LUA_NOREF; ///< The userdata of this event. Pushed once.
 };
 /// @}
 
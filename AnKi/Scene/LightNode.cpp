@@ -192,7 +192,7 @@ Error PointLightNode::frameUpdate(Second prevUpdateTime, Second crntTime)
 		rot = Mat3(Euler(0.0, 0.0, PI));
 		m_shadowData[5].m_localTrf.setRotation(Mat3x4(Vec3(0.0f), rot));
 
-		const Vec4& origin = getFirstComponentOfType<MoveComponent>().getWorldTransform().getOrigin();
+		const Vec4 origin = getFirstComponentOfType<MoveComponent>().getWorldTransform().getOrigin();
 		for(U32 i = 0; i < 6; i++)
 		{
 			Transform trf = m_shadowData[i].m_localTrf;
@@ -55,6 +55,29 @@ public:
 	Leaf* m_leaf = nullptr;
 };
 
+class Octree::DeferredPlaceTaskCtx
+{
+public:
+	/// The leafs of the placeables that overlap a child of the root.
+	class Bin
+	{
+	public:
+		OctreePlaceable* m_placeable;
+		Leaf* m_leaf;
+	};
+
+	Octree* m_octree = nullptr;
+	U32 m_rootChild = MAX_U32;
+	DynamicArrayAuto<OctreePlaceable*> m_placeables; ///< The placeables that overlap the child of the root.
+	DynamicArrayAuto<Bin> m_bins;
+
+	DeferredPlaceTaskCtx(SceneAllocator<U8> alloc)
+		: m_placeables(alloc)
+		, m_bins(alloc)
+	{
+	}
+};
+
 Octree::~Octree()
 {
 	ANKI_ASSERT(m_placeableCount == 0);
@@ -72,93 +95,11 @@ void Octree::init(const Vec3& sceneAabbMin, const Vec3& sceneAabbMax, U32 maxDep
 	m_sceneAabbMax = sceneAabbMax;
 }
 
-void Octree::place(const Aabb& volume, OctreePlaceable* placeable, Bool updateActualSceneBounds)
-{
-	ANKI_ASSERT(placeable);
-	ANKI_ASSERT(testCollision(volume, Aabb(m_sceneAabbMin, m_sceneAabbMax)) && "volume is outside the scene");
-
-	LockGuard<Mutex> lock(m_globalMtx);
-
-	// Remove the placeable from the Octree
-	removeInternal(*placeable);
-
-	// Create the root leaf
-	if(!m_rootLeaf)
-	{
-		m_rootLeaf = newLeaf();
-		m_rootLeaf->m_aabbMin = m_sceneAabbMin;
-		m_rootLeaf->m_aabbMax = m_sceneAabbMax;
-	}
-
-	// And re-place it
-	placeRecursive(volume, placeable, m_rootLeaf, 0);
-	++m_placeableCount;
-
-	// Update the actual scene bounds
-	if(updateActualSceneBounds)
-	{
-		m_actualSceneAabbMin = m_actualSceneAabbMin.min(volume.getMin().xyz());
-		m_actualSceneAabbMax = m_actualSceneAabbMax.max(volume.getMax().xyz());
-	}
-}
-
-void Octree::remove(OctreePlaceable& placeable)
-{
-	LockGuard<Mutex> lock(m_globalMtx);
-	removeInternal(placeable);
-}
-
-Bool Octree::volumeTotallyInsideLeaf(const Aabb& volume, const Leaf& leaf)
+Octree::LeafMask Octree::computeChildrenMask(const Aabb& volume, const Vec3& parentAabbCenter)
 {
-	const Vec4& amin = volume.getMin();
-	const Vec4& amax = volume.getMax();
-	const Vec3& bmin = leaf.m_aabbMin;
-	const Vec3& bmax = leaf.m_aabbMax;
-
-	Bool superset = true;
-	superset = superset && amin.x() <= bmin.x();
-	superset = superset && amax.x() >= bmax.x();
-	superset = superset && amin.y() <= bmin.y();
-	superset = superset && amax.y() >= bmax.y();
-	superset = superset && amin.z() <= bmin.z();
-	superset = superset && amax.z() >= bmax.z();
-
-	return superset;
-}
-
-void Octree::placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf* parent, U32 depth)
-{
-	ANKI_ASSERT(placeable);
-	ANKI_ASSERT(parent);
-	ANKI_ASSERT(testCollision(volume, Aabb(parent->m_aabbMin, parent->m_aabbMax)) && "Should be inside");
-
-	if(depth == m_maxDepth || volumeTotallyInsideLeaf(volume, *parent))
-	{
-		// Need to stop and bin the placeable to the leaf
-
-		// Checks
-#if ANKI_ENABLE_ASSERTS
-		for(const LeafNode& node : placeable->m_leafs)
-		{
-			ANKI_ASSERT(node.m_leaf != parent && "Already binned. That's wrong");
-		}
-
-		for(const PlaceableNode& node : parent->m_placeables)
-		{
-			ANKI_ASSERT(node.m_placeable != placeable);
-		}
-#endif
-
-		// Connect placeable and leaf
-		placeable->m_leafs.pushBack(newLeafNode(parent));
-		parent->m_placeables.pushBack(newPlaceableNode(placeable));
-
-		return;
-	}
-
 	const Vec4& vMin = volume.getMin();
 	const Vec4& vMax = volume.getMax();
-	const Vec3 center = (parent->m_aabbMax + parent->m_aabbMin) / 2.0f;
+	const Vec3& center = parentAabbCenter;
 
 	LeafMask maskX;
 	if(vMin.x() > center.x())
@@ -210,6 +151,24 @@ void Octree::placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf
 
 	const LeafMask maskUnion = maskX & maskY & maskZ;
 	ANKI_ASSERT(!!maskUnion && "Should be inside at least one leaf");
+	return maskUnion;
+}
+
+template<typename TBinFunc>
+void Octree::placeRecursive(const Aabb& volume, Leaf* parent, U32 depth, TBinFunc binFunc)
+{
+	ANKI_ASSERT(parent);
+	ANKI_ASSERT(testCollision(volume, Aabb(parent->m_aabbMin, parent->m_aabbMax)) && "Should be inside");
+
+	if(depth == m_maxDepth || volumeTotallyInsideLeaf(volume, *parent))
+	{
+		// Need to stop and bin the placeable to the leaf
+		binFunc(parent);
+		return;
+	}
+
+	const Vec3 center = (parent->m_aabbMax + parent->m_aabbMin) / 2.0f;
+	const LeafMask maskUnion = computeChildrenMask(volume, center);
 
 	for(U i = 0; i < 8; ++i)
 	{
@@ -225,7 +184,6 @@ void Octree::placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf
 				Leaf* child = newLeaf();
 
 				// Compute AABB
-				Vec3 childAabbMin, childAabbMax;
 				computeChildAabb(crntBit, parent->m_aabbMin, parent->m_aabbMax, center, child->m_aabbMin,
 								 child->m_aabbMax);
 
@@ -233,11 +191,234 @@ void Octree::placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf
 			}
 
 			// Move deeper
-			placeRecursive(volume, placeable, parent->m_children[i], depth + 1);
+			placeRecursive(volume, parent->m_children[i], depth + 1, binFunc);
 		}
 	}
 }
 
+void Octree::place(const Aabb& volume, OctreePlaceable* placeable, Bool updateActualSceneBounds)
+{
+	ANKI_ASSERT(placeable);
+	ANKI_ASSERT(testCollision(volume, Aabb(m_sceneAabbMin, m_sceneAabbMax)) && "volume is outside the scene");
+	ANKI_ASSERT(!placeable->m_deferredQueued && "Can't mix place and placeDeferred");
+
+	LockGuard<Mutex> lock(m_globalMtx);
+
+	// Remove the placeable from the Octree
+	removeInternal(*placeable);
+
+	// Create the root leaf
+	createRootLeaf();
+
+	// And re-place it
+	placeRecursive(volume, m_rootLeaf, 0, [&](Leaf* leaf) {
+		binToLeaf(placeable, leaf);
+	});
+	++m_placeableCount;
+
+	// Update the actual scene bounds
+	if(updateActualSceneBounds)
+	{
+		m_actualSceneAabbMin = m_actualSceneAabbMin.min(volume.getMin().xyz());
+		m_actualSceneAabbMax = m_actualSceneAabbMax.max(volume.getMax().xyz());
+	}
+}
+
+void Octree::remove(OctreePlaceable& placeable)
+{
+	ANKI_ASSERT(!placeable.m_deferredQueued && "Can't remove a placeable that is queued");
+	LockGuard<Mutex> lock(m_globalMtx);
+	removeInternal(placeable);
+}
+
+void Octree::placeDeferred(const Aabb& volume, OctreePlaceable* placeable, Bool updateActualSceneBounds)
+{
+	ANKI_ASSERT(placeable);
+	ANKI_ASSERT(testCollision(volume, Aabb(m_sceneAabbMin, m_sceneAabbMax)) && "volume is outside the scene");
+
+	placeable->m_deferredVolume = volume;
+	placeable->m_deferredUpdateActualSceneBounds = updateActualSceneBounds;
+
+	if(!placeable->m_deferredQueued)
+	{
+		placeable->m_deferredQueued = true;
+
+		// Push it to the list
+		OctreePlaceable* head = m_deferredPlaceables.load();
+		do
+		{
+			placeable->m_deferredNext = head;
+		} while(!m_deferredPlaceables.compareExchange(head, placeable, AtomicMemoryOrder::RELEASE));
+	}
+}
+
+void Octree::applyDeferredPlacements(ThreadHive* hive)
+{
+	OctreePlaceable* const first = m_deferredPlaceables.exchange(nullptr, AtomicMemoryOrder::ACQUIRE);
+	if(first == nullptr)
+	{
+		return;
+	}
+
+	Array<DeferredPlaceTaskCtx, 8> taskCtxs = {{{m_alloc}, {m_alloc}, {m_alloc}, {m_alloc}, {m_alloc}, {m_alloc},
+												{m_alloc}, {m_alloc}}};
+	for(U32 i = 0; i < 8; ++i)
+	{
+		taskCtxs[i].m_octree = this;
+		taskCtxs[i].m_rootChild = i;
+	}
+
+	// Bin to the root whatever doesn't go deeper and give the rest to the children of the root they overlap
+	const Vec3 rootCenter = (m_sceneAabbMax + m_sceneAabbMin) / 2.0f;
+	OctreePlaceable* next;
+	for(OctreePlaceable* placeable = first; placeable; placeable = next)
+	{
+		// Pop it from the list
+		next = placeable->m_deferredNext;
+		placeable->m_deferredNext = nullptr;
+		placeable->m_deferredQueued = false;
+
+		// Remove it first. If that cleans the tree it will happen only at the 1st iteration so re-create the root
+		removeInternal(*placeable);
+		createRootLeaf();
+
+		const Aabb& volume = placeable->m_deferredVolume;
+
+		if(m_maxDepth == 0 || volumeTotallyInsideLeaf(volume, *m_rootLeaf))
+		{
+			binToLeaf(placeable, m_rootLeaf);
+		}
+		else
+		{
+			const LeafMask mask = computeChildrenMask(volume, rootCenter);
+			for(U32 i = 0; i < 8; ++i)
+			{
+				if(!!(mask & LeafMask(1u << i)))
+				{
+					taskCtxs[i].m_placeables.emplaceBack(placeable);
+				}
+			}
+		}
+
+		++m_placeableCount;
+
+		if(placeable->m_deferredUpdateActualSceneBounds)
+		{
+			m_actualSceneAabbMin = m_actualSceneAabbMin.min(volume.getMin().xyz());
+			m_actualSceneAabbMax = m_actualSceneAabbMax.max(volume.getMax().xyz());
+		}
+	}
+
+	// Walk the sub-trees of the root. Every task touches different leafs so they can run in parallel
+	if(hive)
+	{
+		Array<ThreadHiveTask, 8> tasks;
+		U32 taskCount = 0;
+		for(DeferredPlaceTaskCtx& taskCtx : taskCtxs)
+		{
+			if(taskCtx.m_placeables.getSize())
+			{
+				tasks[taskCount++] = ANKI_THREAD_HIVE_TASK({ self->m_octree->placeDeferredTask(*self); }, &taskCtx,
+														   nullptr, nullptr);
+			}
+		}
+
+		if(taskCount)
+		{
+			hive->submitTasks(&tasks[0], taskCount);
+			hive->waitAllTasks();
+		}
+	}
+	else
+	{
+		for(DeferredPlaceTaskCtx& taskCtx : taskCtxs)
+		{
+			placeDeferredTask(taskCtx);
+		}
+	}
+
+	// Connect the placeables with the leafs the tasks found. That touches the allocators so do it serially
+	for(const DeferredPlaceTaskCtx& taskCtx : taskCtxs)
+	{
+		for(const DeferredPlaceTaskCtx::Bin& bin : taskCtx.m_bins)
+		{
+			binToLeaf(bin.m_placeable, bin.m_leaf);
+		}
+	}
+}
+
+void Octree::placeDeferredTask(DeferredPlaceTaskCtx& taskCtx)
+{
+	if(taskCtx.m_placeables.getSize() == 0)
+	{
+		return;
+	}
+
+	// Only this task touches that child of the root
+	const U32 childIdx = taskCtx.m_rootChild;
+	if(m_rootLeaf->m_children[childIdx] == nullptr)
+	{
+		const Vec3 rootCenter = (m_rootLeaf->m_aabbMax + m_rootLeaf->m_aabbMin) / 2.0f;
+		Leaf* child = newLeaf();
+		computeChildAabb(LeafMask(1u << childIdx), m_rootLeaf->m_aabbMin, m_rootLeaf->m_aabbMax, rootCenter,
+						 child->m_aabbMin, child->m_aabbMax);
+		m_rootLeaf->m_children[childIdx] = child;
+	}
+
+	taskCtx.m_bins.resizeStorage(taskCtx.m_placeables.getSize());
+	for(OctreePlaceable* placeable : taskCtx.m_placeables)
+	{
+		placeRecursive(placeable->m_deferredVolume, m_rootLeaf->m_children[childIdx], 1, [&](Leaf* leaf) {
+			taskCtx.m_bins.emplaceBack(DeferredPlaceTaskCtx::Bin{placeable, leaf});
+		});
+	}
+}
+
+void Octree::createRootLeaf()
+{
+	if(!m_rootLeaf)
+	{
+		m_rootLeaf = newLeaf();
+		m_rootLeaf->m_aabbMin = m_sceneAabbMin;
+		m_rootLeaf->m_aabbMax = m_sceneAabbMax;
+	}
+}
+
+void Octree::binToLeaf(OctreePlaceable* placeable, Leaf* leaf)
+{
+	ANKI_ASSERT(placeable && leaf);
+
+	// Checks
+#if ANKI_ENABLE_ASSERTS
+	for(const LeafNode& node : placeable->m_leafs)
+	{
+		ANKI_ASSERT(node.m_leaf != leaf && "Already binned. That's wrong");
+	}
+#endif
+
+	PlaceableNode* placeableNode = newPlaceableNode(placeable);
+	leaf->m_placeables.pushBack(placeableNode);
+	placeable->m_leafs.pushBack(newLeafNode(leaf, placeableNode));
+}
+
+Bool Octree::volumeTotallyInsideLeaf(const Aabb& volume, const Leaf& leaf)
+{
+	const Vec4& amin = volume.getMin();
+	const Vec4& amax = volume.getMax();
+	const Vec3& bmin = leaf.m_aabbMin;
+	const Vec3& bmax = leaf.m_aabbMax;
+
+	Bool superset = true;
+	superset = superset && amin.x() <= bmin.x();
+	superset = superset && amax.x() >= bmax.x();
+	superset = superset && amin.y() <= bmin.y();
+	superset = superset && amax.y() >= bmax.y();
+	superset = superset && amin.z() <= bmin.z();
+	superset = superset && amax.z() >= bmax.z();
+
+	return superset;
+}
+
 void Octree::computeChildAabb(LeafMask child, const Vec3& parentAabbMin, const Vec3& parentAabbMax,
 							  const Vec3& parentAabbCenter, Vec3& childAabbMin, Vec3& childAabbMax)
 {
@@ -298,20 +479,11 @@ void Octree::removeInternal(OctreePlaceable& placeable)
 			LeafNode& leafNode = placeable.m_leafs.getFront();
 			placeable.m_leafs.popFront();
 
-			// Iterate the placeables of the leaf
-			Bool found = false;
-			(void)found;
-			for(PlaceableNode& placeableNode : leafNode.m_leaf->m_placeables)
-			{
-				if(placeableNode.m_placeable == &placeable)
-				{
-					found = true;
-					leafNode.m_leaf->m_placeables.erase(&placeableNode);
-					releasePlaceableNode(&placeableNode);
-					break;
-				}
-			}
-			ANKI_ASSERT(found);
+			// Remove the placeable from the leaf
+			PlaceableNode* placeableNode = leafNode.m_placeableNode;
+			ANKI_ASSERT(placeableNode->m_placeable == &placeable);
+			leafNode.m_leaf->m_placeables.erase(placeableNode);
+			releasePlaceableNode(placeableNode);
 
 			// Delete the leaf node
 			releaseLeafNode(&leafNode);
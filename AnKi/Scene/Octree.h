@@ -58,6 +58,18 @@ public:
 	/// @note It's thread-safe against place and remove methods.
 	void remove(OctreePlaceable& placeable);
 
+	/// Queue the placement of an element. It doesn't lock, the placeable is pushed to a lock-free list and it will be
+	/// re-placed when applyDeferredPlacements is called. Use it when many elements move at the same time.
+	/// @note It's thread-safe against other placeDeferred calls but the same placeable shouldn't be queued by two
+	///       threads at the same time.
+	void placeDeferred(const Aabb& volume, OctreePlaceable* placeable, Bool updateActualSceneBounds);
+
+	/// Apply the placements queued by placeDeferred. The tree is walked in parallel, one task for each child of the
+	/// root.
+	/// @param hive The hive to run the tasks. If it's nullptr everything will happen in the calling thread.
+	/// @note It's not thread-safe against any other method.
+	void applyDeferredPlacements(ThreadHive* hive);
+
 	/// Gather visible placeables.
 	/// @param frustumPlanes The frustum planes to test against.
 	/// @param testId A unique index for this test.
@@ -111,6 +123,7 @@ public:
 private:
 	class GatherParallelCtx;
 	class GatherParallelTaskCtx;
+	class DeferredPlaceTaskCtx;
 
 	/// List node.
 	class PlaceableNode : public IntrusiveListEnabled<PlaceableNode>
@@ -158,11 +171,13 @@ private:
 	{
 	public:
 		Leaf* m_leaf = nullptr;
+		PlaceableNode* m_placeableNode = nullptr; ///< The node in m_leaf's list. Used for fast removal.
 
 #if ANKI_ENABLE_ASSERTS
 		~LeafNode()
 		{
 			m_leaf = nullptr;
+			m_placeableNode = nullptr;
 		}
 #endif
 	};
@@ -196,6 +211,7 @@ private:
 	Vec3 m_sceneAabbMax = Vec3(0.0f);
 	mutable Mutex m_globalMtx;
 
+	SpinLock m_leafAllocLock; ///< Leafs are created by the tasks of applyDeferredPlacements as well.
 	ObjectAllocatorSameType<Leaf, 256> m_leafAlloc;
 	ObjectAllocatorSameType<LeafNode, 128> m_leafNodeAlloc;
 	ObjectAllocatorSameType<PlaceableNode, 256> m_placeableNodeAlloc;
@@ -207,8 +223,12 @@ private:
 	Vec3 m_actualSceneAabbMin = Vec3(MAX_F32);
 	Vec3 m_actualSceneAabbMax = Vec3(MIN_F32);
 
+	/// Placeables queued by placeDeferred.
+	Atomic<OctreePlaceable*> m_deferredPlaceables = {nullptr};
+
 	Leaf* newLeaf()
 	{
+		LockGuard<SpinLock> lock(m_leafAllocLock);
 		return m_leafAlloc.newInstance(m_alloc);
 	}
 
@@ -230,11 +250,12 @@ private:
 		m_placeableNodeAlloc.deleteInstance(m_alloc, placeable);
 	}
 
-	LeafNode* newLeafNode(Leaf* leaf)
+	LeafNode* newLeafNode(Leaf* leaf, PlaceableNode* placeableNode)
 	{
-		ANKI_ASSERT(leaf);
+		ANKI_ASSERT(leaf && placeableNode);
 		LeafNode* out = m_leafNodeAlloc.newInstance(m_alloc);
 		out->m_leaf = leaf;
+		out->m_placeableNode = placeableNode;
 		return out;
 	}
 
@@ -243,10 +264,22 @@ private:
 		m_leafNodeAlloc.deleteInstance(m_alloc, node);
 	}
 
-	void placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf* parent, U32 depth);
+	/// Walk the tree and call a functor for every leaf the volume should be binned to.
+	/// @tparam TBinFunc Signature: void(*)(Leaf* leaf).
+	template<typename TBinFunc>
+	void placeRecursive(const Aabb& volume, Leaf* parent, U32 depth, TBinFunc binFunc);
+
+	/// Connect a placeable and a leaf.
+	void binToLeaf(OctreePlaceable* placeable, Leaf* leaf);
+
+	/// Create the root leaf if it's not there.
+	void createRootLeaf();
 
 	static Bool volumeTotallyInsideLeaf(const Aabb& volume, const Leaf& leaf);
 
+	/// Compute the children of a leaf that a volume overlaps.
+	static LeafMask computeChildrenMask(const Aabb& volume, const Vec3& parentAabbCenter);
+
 	static void computeChildAabb(LeafMask child, const Vec3& parentAabbMin, const Vec3& parentAabbMax,
 								 const Vec3& parentAabbCenter, Vec3& childAabbMin, Vec3& childAabbMax);
 
@@ -263,6 +296,9 @@ private:
 	void gatherVisibleParallelTask(U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem,
 								   GatherParallelTaskCtx& taskCtx);
 
+	/// Walk the sub-tree of a child of the root and gather the leafs of the queued placeables.
+	void placeDeferredTask(DeferredPlaceTaskCtx& taskCtx);
+
 	/// Remove a leaf.
 	void cleanupRecursive(Leaf* leaf, Bool& canDeleteLeafUponReturn);
 
@@ -293,6 +329,14 @@ private:
 	Atomic<U64> m_visitedMask = {0u};
 	IntrusiveList<Octree::LeafNode> m_leafs; ///< A list of leafs this placeable belongs.
 
+	/// @name Deferred placement state
+	/// @{
+	Aabb m_deferredVolume;
+	OctreePlaceable* m_deferredNext = nullptr;
+	Bool m_deferredQueued = false;
+	Bool m_deferredUpdateActualSceneBounds = false;
+	/// @}
+
 	/// Check if already visited.
 	/// @note It's thread-safe.
 	Bool alreadyVisited(U32 testId)
@@ -8,31 +8,23 @@
 #include <AnKi/Scene/PhysicsDebugNode.h>
 #include <AnKi/Scene/ModelNode.h>
 #include <AnKi/Scene/Octree.h>
+#include <AnKi/Scene/TransformStore.h>
 #include <AnKi/Scene/Components/FrustumComponent.h>
 #include <AnKi/Physics/PhysicsWorld.h>
 #include <AnKi/Resource/ResourceManager.h>
+#include <AnKi/Resource/ScriptResource.h>
+#include <AnKi/Script/ScriptBatch.h>
 #include <AnKi/Renderer/MainRenderer.h>
 #include <AnKi/Core/ConfigSet.h>
 #include <AnKi/Util/ThreadHive.h>
+#include <AnKi/Util/HierarchyUpdater.h>
 #include <AnKi/Util/Tracer.h>
 #include <AnKi/Util/HighRezTimer.h>
 
 namespace anki
 {
 
-const U NODE_UPDATE_BATCH = 10;
-
-class SceneGraph::UpdateSceneNodesCtx
-{
-public:
-	SceneGraph* m_scene = nullptr;
-
-	IntrusiveList<SceneNode>::Iterator m_crntNode;
-	SpinLock m_crntNodeLock;
-
-	Second m_prevUpdateTime;
-	Second m_crntTime;
-};
+const U32 NODE_UPDATE_BATCH = 8;
 
 SceneGraph::SceneGraph()
 {
@@ -48,10 +40,21 @@ SceneGraph::~SceneGraph()
 
 	deleteNodesMarkedForDeletion();
 
+	for(ScriptBatch* batch : m_scriptBatches)
+	{
+		m_alloc.deleteInstance(batch);
+	}
+	m_scriptBatches.destroy(m_alloc);
+
 	if(m_octree)
 	{
 		m_alloc.deleteInstance(m_octree);
 	}
+
+	if(m_transforms)
+	{
+		m_alloc.deleteInstance(m_transforms);
+	}
 }
 
 Error SceneGraph::init(AllocAlignedCallback allocCb, void* allocCbData, ThreadHive* threadHive,
@@ -79,12 +82,15 @@ Error SceneGraph::init(AllocAlignedCallback allocCb, void* allocCbData, ThreadHi
 	m_config.m_rayTracingExtendedFrustumDistance = config.getNumberF32("scene_rayTracingExtendedFrustumDistance");
 	m_config.m_maxLodDistances[0] = config.getNumberF32("lod0MaxDistance");
 	m_config.m_maxLodDistances[1] = config.getNumberF32("lod1MaxDistance");
+	m_config.m_sharedScriptStates = config.getBool("scene_sharedScriptStates");
 
 	ANKI_CHECK(m_events.init(this));
 
 	m_octree = m_alloc.newInstance<Octree>(m_alloc);
 	m_octree->init(m_sceneMin, m_sceneMax, config.getNumberU32("scene_octreeMaxDepth"));
 
+	m_transforms = m_alloc.newInstance<TransformStore>(m_alloc);
+
 	// Init the default main camera
 	ANKI_CHECK(newSceneNode<PerspectiveCameraNode>("mainCamera", m_defaultMainCam));
 	m_defaultMainCam->getFirstComponentOfType<FrustumComponent>().setPerspective(0.1f, 1000.0f, toRad(60.0f),
@@ -215,35 +221,78 @@ Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
 		m_stats.m_physicsUpdate = HighRezTimer::getCurrentTime() - m_stats.m_physicsUpdate;
 	}
 
+	const Error err = updateNodes(prevUpdateTime, crntTime);
+
+	// Place in the octree whatever moved. Do that even on error, the placeables can't stay in the deferred list
 	{
-		ANKI_TRACE_SCOPED_EVENT(SCENE_NODES_UPDATE);
-		ANKI_CHECK(m_events.updateAllEvents(prevUpdateTime, crntTime));
-
-		// Then the rest
-		Array<ThreadHiveTask, ThreadHive::MAX_THREADS> tasks;
-		UpdateSceneNodesCtx updateCtx;
-		updateCtx.m_scene = this;
-		updateCtx.m_crntNode = m_nodes.getBegin();
-		updateCtx.m_prevUpdateTime = prevUpdateTime;
-		updateCtx.m_crntTime = crntTime;
-
-		for(U i = 0; i < m_threadHive->getThreadCount(); i++)
+		ANKI_TRACE_SCOPED_EVENT(SCENE_OCTREE_UPDATE);
+		m_octree->applyDeferredPlacements(m_threadHive);
+	}
+
+	m_stats.m_updateTime = HighRezTimer::getCurrentTime() - m_stats.m_updateTime;
+	return err;
+}
+
+Error SceneGraph::updateNodes(Second prevUpdateTime, Second crntTime)
+{
+	ANKI_TRACE_SCOPED_EVENT(SCENE_NODES_UPDATE);
+
+	// Remember last frame's world transforms before anything gets moved
+	m_transforms->beginFrame();
+
+	ANKI_CHECK(m_events.updateAllEvents(prevUpdateTime, crntTime));
+
+	// The scripts that share a LUA state can't run in parallel so run them before the nodes they might move
+	for(ScriptBatch* batch : m_scriptBatches)
+	{
+		ANKI_CHECK(batch->update(prevUpdateTime, crntTime));
+	}
+
+	// Then the rest. Parents are updated before their children and every depth is spread to all threads
+	HierarchyUpdater<SceneNode> updater(m_frameAlloc, m_nodesCount);
+	for(SceneNode& node : m_nodes)
+	{
+		if(node.getParent() == nullptr)
 		{
-			tasks[i] = ANKI_THREAD_HIVE_TASK(
-				{
-					if(self->m_scene->updateNodes(*self))
-					{
-						ANKI_SCENE_LOGF("Will not recover");
-					}
-				},
-				&updateCtx, nullptr, nullptr);
+			updater.addRoot(&node);
 		}
+	}
+
+	ANKI_CHECK(updater.update(
+		*m_threadHive,
+		[prevUpdateTime, crntTime](SceneNode& node) -> Error {
+			return updateNodeComponents(prevUpdateTime, crntTime, node);
+		},
+		[prevUpdateTime, crntTime](SceneNode& node) -> Error {
+			// The children are done at that point
+			return node.frameUpdate(prevUpdateTime, crntTime);
+		},
+		NODE_UPDATE_BATCH));
+
+	return Error::NONE;
+}
+
+Error SceneGraph::getOrCreateScriptBatch(const ScriptResourcePtr& script, ScriptBatch*& batch)
+{
+	const CString fname = script->getFilename();
 
-		m_threadHive->submitTasks(&tasks[0], m_threadHive->getThreadCount());
-		m_threadHive->waitAllTasks();
+	auto it = m_scriptBatches.find(fname);
+	if(it != m_scriptBatches.getEnd())
+	{
+		batch = *it;
+		return Error::NONE;
 	}
 
-	m_stats.m_updateTime = HighRezTimer::getCurrentTime() - m_stats.m_updateTime;
+	batch = m_alloc.newInstance<ScriptBatch>();
+	const Error err = batch->init(m_scriptManager, script->getSource());
+	if(err)
+	{
+		m_alloc.deleteInstance(batch);
+		batch = nullptr;
+		return err;
+	}
+
+	m_scriptBatches.emplace(m_alloc, StringAuto(m_alloc, fname), batch);
 	return Error::NONE;
 }
 
@@ -254,16 +303,14 @@ void SceneGraph::doVisibilityTests(RenderQueue& rqueue)
 	m_stats.m_visibilityTestsTime = HighRezTimer::getCurrentTime() - m_stats.m_visibilityTestsTime;
 }
 
-Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
+Error SceneGraph::updateNodeComponents(Second prevTime, Second crntTime, SceneNode& node)
 {
 	ANKI_TRACE_INC_COUNTER(SCENE_NODES_UPDATED, 1);
 
-	Error err = Error::NONE;
-
 	// Components update
 	Timestamp componentTimestamp = 0;
 	Bool atLeastOneComponentUpdated = false;
-	err = node.iterateComponents([&](SceneComponent& comp, Bool isFeedbackComponent) -> Error {
+	const Error err = node.iterateComponents([&](SceneComponent& comp, Bool isFeedbackComponent) -> Error {
 		Bool updated = false;
 		Error e = Error::NONE;
 		if(!atLeastOneComponentUpdated && isFeedbackComponent)
@@ -287,76 +334,10 @@ Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
 		return e;
 	});
 
-	// Update children
-	if(!err)
-	{
-		err = node.visitChildrenMaxDepth(
-			0, [&](SceneNode& child) -> Error { return updateNode(prevTime, crntTime, child); });
-	}
-
-	// Frame update
-	if(!err)
-	{
-		if(componentTimestamp != 0)
-		{
-			node.setComponentMaxTimestamp(componentTimestamp);
-		}
-		else
-		{
-			// No components or nothing updated, don't change the timestamp
-		}
-
-		err = node.frameUpdate(prevTime, crntTime);
-	}
-
-	return err;
-}
-
-Error SceneGraph::updateNodes(UpdateSceneNodesCtx& ctx) const
-{
-	ANKI_TRACE_SCOPED_EVENT(SCENE_NODES_UPDATE);
-
-	IntrusiveList<SceneNode>::ConstIterator end = m_nodes.getEnd();
-
-	Bool quit = false;
-	Error err = Error::NONE;
-	while(!quit && !err)
+	// If there are no components or nothing updated don't change the timestamp
+	if(!err && componentTimestamp != 0)
 	{
-		// Fetch a batch of scene nodes that don't have parent
-		Array<SceneNode*, NODE_UPDATE_BATCH> batch;
-		U batchSize = 0;
-
-		{
-			LockGuard<SpinLock> lock(ctx.m_crntNodeLock);
-
-			while(1)
-			{
-				if(batchSize == batch.getSize())
-				{
-					break;
-				}
-
-				if(ctx.m_crntNode == end)
-				{
-					quit = true;
-					break;
-				}
-
-				SceneNode& node = *ctx.m_crntNode;
-				if(node.getParent() == nullptr)
-				{
-					batch[batchSize++] = &node;
-				}
-
-				++ctx.m_crntNode;
-			}
-		}
-
-		// Process nodes
-		for(U i = 0; i < batchSize && !err; ++i)
-		{
-			err = updateNode(ctx.m_prevUpdateTime, ctx.m_crntTime, *batch[i]);
-		}
+		node.setComponentMaxTimestamp(componentTimestamp);
 	}
 
 	return err;
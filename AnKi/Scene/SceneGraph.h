@@ -24,6 +24,8 @@ class Input;
 class ConfigSet;
 class PerspectiveCameraNode;
 class Octree;
+class TransformStore;
+class ScriptBatch;
 
 /// @addtogroup scene
 /// @{
@@ -47,6 +49,7 @@ public:
 	Bool m_rayTracedShadows = false;
 	F32 m_rayTracingExtendedFrustumDistance = 100.0f; ///< The frustum distance from the eye to every direction.
 	Array<F32, MAX_LOD_COUNT - 1> m_maxLodDistances = {};
+	Bool m_sharedScriptStates = false; ///< ScriptComponents of the same script share a ScriptBatch.
 };
 
 /// The scene graph that  all the scene entities
@@ -224,14 +227,21 @@ public:
 		return *m_octree;
 	}
 
+	TransformStore& getTransformStore()
+	{
+		ANKI_ASSERT(m_transforms);
+		return *m_transforms;
+	}
+
 	const DebugDrawer2& getDebugDrawer() const
 	{
 		return m_debugDrawer;
 	}
 
-private:
-	class UpdateSceneNodesCtx;
+	/// Get the ScriptBatch that runs all the ScriptComponents of a script. It will be created if it doesn't exist.
+	ANKI_INTERNAL ANKI_USE_RESULT Error getOrCreateScriptBatch(const ScriptResourcePtr& script, ScriptBatch*& batch);
 
+private:
 	const Timestamp* m_globalTimestamp = nullptr;
 	Timestamp m_timestamp = 0; ///< Cached timestamp
 
@@ -258,6 +268,8 @@ private:
 
 	Octree* m_octree = nullptr;
 
+	TransformStore* m_transforms = nullptr;
+
 	Vec3 m_sceneMin = Vec3(-1000.0f, -200.0f, -1000.0f);
 	Vec3 m_sceneMax = Vec3(1000.0f, 200.0f, 1000.0f);
 
@@ -270,6 +282,8 @@ private:
 
 	DebugDrawer2 m_debugDrawer;
 
+	HashMap<StringAuto, ScriptBatch*> m_scriptBatches; ///< Indexed by the script's filename.
+
 	/// Put a node in the appropriate containers
 	ANKI_USE_RESULT Error registerNode(SceneNode* node);
 	void unregisterNode(SceneNode* node);
@@ -277,8 +291,11 @@ private:
 	/// Delete the nodes that are marked for deletion
 	void deleteNodesMarkedForDeletion();
 
-	ANKI_USE_RESULT Error updateNodes(UpdateSceneNodesCtx& ctx) const;
-	ANKI_USE_RESULT static Error updateNode(Second prevTime, Second crntTime, SceneNode& node);
+	/// Update the events, the scripts and the nodes. It might queue octree placements.
+	ANKI_USE_RESULT Error updateNodes(Second prevUpdateTime, Second crntTime);
+
+	/// Update the components of a node. The children and the SceneNode::frameUpdate are handled by the caller.
+	ANKI_USE_RESULT static Error updateNodeComponents(Second prevTime, Second crntTime, SceneNode& node);
 
 	/// Do visibility tests.
 	static void doVisibilityTests(SceneNode& frustumable, SceneGraph& scene, RenderQueue& rqueue);
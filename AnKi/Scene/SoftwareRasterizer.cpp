@@ -6,11 +6,200 @@
 #include <AnKi/Scene/SoftwareRasterizer.h>
 #include <AnKi/Collision/Aabb.h>
 #include <AnKi/Collision/Functions.h>
+#include <AnKi/Math/Simd.h>
 #include <AnKi/Util/Tracer.h>
 
 namespace anki
 {
 
+/// @name 4-wide helpers
+/// @{
+#if ANKI_SIMD_SSE
+using F32x4 = __m128;
+
+static inline F32x4 f32x4Set(F32 x, F32 y, F32 z, F32 w)
+{
+	return _mm_setr_ps(x, y, z, w);
+}
+
+static inline F32x4 f32x4Splat(F32 x)
+{
+	return _mm_set1_ps(x);
+}
+
+static inline F32x4 f32x4Load(const void* ptr)
+{
+	return _mm_loadu_ps(static_cast<const F32*>(ptr));
+}
+
+static inline void f32x4Store(F32* ptr, F32x4 a)
+{
+	_mm_storeu_ps(ptr, a);
+}
+
+static inline F32x4 f32x4Add(F32x4 a, F32x4 b)
+{
+	return _mm_add_ps(a, b);
+}
+
+static inline F32x4 f32x4Mad(F32x4 a, F32x4 b, F32x4 c)
+{
+	return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+/// Bit i is set if a[i] >= 0 && b[i] >= 0 && c[i] >= 0.
+static inline U32 f32x4AllPositiveMask(F32x4 a, F32x4 b, F32x4 c)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 m = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(a, zero), _mm_cmpge_ps(b, zero)), _mm_cmpge_ps(c, zero));
+	return U32(_mm_movemask_ps(m));
+}
+
+/// Bit i is set if a[i] < b[i].
+static inline U32 f32x4LessMask(F32x4 a, F32x4 b)
+{
+	return U32(_mm_movemask_ps(_mm_cmplt_ps(a, b)));
+}
+#elif ANKI_SIMD_NEON
+using F32x4 = float32x4_t;
+
+static inline F32x4 f32x4Set(F32 x, F32 y, F32 z, F32 w)
+{
+	alignas(16) const F32 v[4] = {x, y, z, w};
+	return vld1q_f32(v);
+}
+
+static inline F32x4 f32x4Splat(F32 x)
+{
+	return vdupq_n_f32(x);
+}
+
+static inline F32x4 f32x4Load(const void* ptr)
+{
+	return vld1q_f32(static_cast<const F32*>(ptr));
+}
+
+static inline void f32x4Store(F32* ptr, F32x4 a)
+{
+	vst1q_f32(ptr, a);
+}
+
+static inline F32x4 f32x4Add(F32x4 a, F32x4 b)
+{
+	return vaddq_f32(a, b);
+}
+
+static inline F32x4 f32x4Mad(F32x4 a, F32x4 b, F32x4 c)
+{
+	return vmlaq_f32(c, a, b);
+}
+
+static inline U32 neonMaskToBits(uint32x4_t m)
+{
+	alignas(16) static const U32 bits[4] = {1, 2, 4, 8};
+	const uint32x4_t masked = vandq_u32(m, vld1q_u32(bits));
+	return vgetq_lane_u32(masked, 0) | vgetq_lane_u32(masked, 1) | vgetq_lane_u32(masked, 2)
+		   | vgetq_lane_u32(masked, 3);
+}
+
+/// Bit i is set if a[i] >= 0 && b[i] >= 0 && c[i] >= 0.
+static inline U32 f32x4AllPositiveMask(F32x4 a, F32x4 b, F32x4 c)
+{
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const uint32x4_t m = vandq_u32(vandq_u32(vcgeq_f32(a, zero), vcgeq_f32(b, zero)), vcgeq_f32(c, zero));
+	return neonMaskToBits(m);
+}
+
+/// Bit i is set if a[i] < b[i].
+static inline U32 f32x4LessMask(F32x4 a, F32x4 b)
+{
+	return neonMaskToBits(vcltq_f32(a, b));
+}
+#else
+class F32x4
+{
+public:
+	Array<F32, 4> m_arr;
+};
+
+static inline F32x4 f32x4Set(F32 x, F32 y, F32 z, F32 w)
+{
+	return F32x4{{{x, y, z, w}}};
+}
+
+static inline F32x4 f32x4Splat(F32 x)
+{
+	return F32x4{{{x, x, x, x}}};
+}
+
+static inline F32x4 f32x4Load(const void* ptr)
+{
+	F32x4 out;
+	memcpy(&out.m_arr[0], ptr, sizeof(out.m_arr));
+	return out;
+}
+
+static inline void f32x4Store(F32* ptr, F32x4 a)
+{
+	memcpy(ptr, &a.m_arr[0], sizeof(a.m_arr));
+}
+
+static inline F32x4 f32x4Add(F32x4 a, F32x4 b)
+{
+	for(U32 i = 0; i < 4; ++i)
+	{
+		a.m_arr[i] += b.m_arr[i];
+	}
+	return a;
+}
+
+static inline F32x4 f32x4Mad(F32x4 a, F32x4 b, F32x4 c)
+{
+	for(U32 i = 0; i < 4; ++i)
+	{
+		c.m_arr[i] += a.m_arr[i] * b.m_arr[i];
+	}
+	return c;
+}
+
+/// Bit i is set if a[i] >= 0 && b[i] >= 0 && c[i] >= 0.
+static inline U32 f32x4AllPositiveMask(F32x4 a, F32x4 b, F32x4 c)
+{
+	U32 mask = 0;
+	for(U32 i = 0; i < 4; ++i)
+	{
+		mask |= (a.m_arr[i] >= 0.0f && b.m_arr[i] >= 0.0f && c.m_arr[i] >= 0.0f) ? (1u << i) : 0u;
+	}
+	return mask;
+}
+
+/// Bit i is set if a[i] < b[i].
+static inline U32 f32x4LessMask(F32x4 a, F32x4 b)
+{
+	U32 mask = 0;
+	for(U32 i = 0; i < 4; ++i)
+	{
+		mask |= (a.m_arr[i] < b.m_arr[i]) ? (1u << i) : 0u;
+	}
+	return mask;
+}
+#endif
+/// @}
+
+static inline U32 depthToBits(F32 depth)
+{
+	U32 bits;
+	memcpy(&bits, &depth, sizeof(bits));
+	return bits;
+}
+
+static inline F32 bitsToDepth(U32 bits)
+{
+	F32 depth;
+	memcpy(&depth, &bits, sizeof(depth));
+	return depth;
+}
+
 void SoftwareRasterizer::prepare(const Mat4& mv, const Mat4& p, U32 width, U32 height)
 {
 	m_mv = mv;
@@ -30,7 +219,30 @@ void SoftwareRasterizer::prepare(const Mat4& mv, const Mat4& p, U32 width, U32 h
 		m_zbuffer.destroy(m_alloc);
 		m_zbuffer.create(m_alloc, size);
 	}
-	memset(&m_zbuffer[0], 0xFF, sizeof(m_zbuffer[0]) * size);
+
+	const U32 farDepth = depthToBits(1.0f);
+	for(U32 i = 0; i < size; ++i)
+	{
+		m_zbuffer[i].setNonAtomically(farDepth);
+	}
+
+	// Reset the tiles
+	m_tileCountX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tileCountY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	size = m_tileCountX * m_tileCountY;
+	if(m_tileMinDepth.getSize() < size)
+	{
+		m_tileMinDepth.destroy(m_alloc);
+		m_tileMinDepth.create(m_alloc, size);
+		m_tileMaxDepth.destroy(m_alloc);
+		m_tileMaxDepth.create(m_alloc, size);
+	}
+
+	for(U32 i = 0; i < size; ++i)
+	{
+		m_tileMinDepth[i].setNonAtomically(farDepth);
+		m_tileMaxDepth[i] = 1.0f;
+	}
 }
 
 void SoftwareRasterizer::clipTriangle(const Vec4* inVerts, Vec4* outVerts, U& outVertCount) const
@@ -219,35 +431,6 @@ void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool back
 	}
 }
 
-Bool SoftwareRasterizer::computeBarycetrinc(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, Vec3& uvw) const
-{
-	Vec2 dca = c - a;
-	Vec2 dba = b - a;
-	Vec2 dap = a - p;
-
-	Vec3 n(dca.x(), dba.x(), dap.x());
-	Vec3 m(dca.y(), dba.y(), dap.y());
-
-	Vec3 k = n.cross(m);
-
-	Bool skip = false;
-	if(!isZero(k.z()))
-	{
-		uvw = Vec3(1.0f - (k.x() + k.y()) / k.z(), k.y() / k.z(), k.x() / k.z());
-
-		if(uvw.x() < 0.0f || uvw.y() < 0.0f || uvw.z() < 0.0f)
-		{
-			skip = true;
-		}
-	}
-	else
-	{
-		skip = true;
-	}
-
-	return skip;
-}
-
 void SoftwareRasterizer::rasterizeTriangle(const Vec4* tri)
 {
 	ANKI_ASSERT(tri);
@@ -271,28 +454,109 @@ void SoftwareRasterizer::rasterizeTriangle(const Vec4* tri)
 		}
 	}
 
-	for(F32 y = bboxMin.y() + 0.5f; y < bboxMax.y() + 0.5f; y += 1.0f)
+	const U32 minX = U32(bboxMin.x());
+	const U32 minY = U32(bboxMin.y());
+	const U32 maxX = U32(bboxMax.x());
+	const U32 maxY = U32(bboxMax.y());
+	if(minX >= maxX || minY >= maxY)
+	{
+		return;
+	}
+
+	// The edge functions. Edge i is the one opposite to vertex i. Divide them with the signed area so they become the
+	// barycentric coordinates and the inside test doesn't care about the winding
+	const Vec2 d10 = window[1] - window[0];
+	const Vec2 d20 = window[2] - window[0];
+	const F32 area = d10.x() * d20.y() - d10.y() * d20.x();
+	if(isZero(area))
 	{
-		for(F32 x = bboxMin.x() + 0.5f; x < bboxMax.x() + 0.5f; x += 1.0f)
+		return;
+	}
+	const F32 invArea = 1.0f / area;
+
+	Array<F32, 3> edgeA, edgeB, edgeC;
+	for(U32 i = 0; i < 3; ++i)
+	{
+		const Vec2& a = window[(i + 1) % 3];
+		const Vec2& b = window[(i + 2) % 3];
+		edgeA[i] = (a.y() - b.y()) * invArea;
+		edgeB[i] = (b.x() - a.x()) * invArea;
+		edgeC[i] = (a.x() * b.y() - a.y() * b.x()) * invArea;
+	}
+
+	// The depth is a plane in window space
+	const F32 depthA = ndc[0].z() * edgeA[0] + ndc[1].z() * edgeA[1] + ndc[2].z() * edgeA[2];
+	const F32 depthB = ndc[0].z() * edgeB[0] + ndc[1].z() * edgeB[1] + ndc[2].z() * edgeB[2];
+	const F32 depthC = ndc[0].z() * edgeC[0] + ndc[1].z() * edgeC[1] + ndc[2].z() * edgeC[2];
+
+	// Evaluate 4 pixel centers at once
+	const F32x4 laneOffsets = f32x4Set(0.5f, 1.5f, 2.5f, 3.5f);
+	const F32x4 e0Dx = f32x4Splat(edgeA[0]);
+	const F32x4 e1Dx = f32x4Splat(edgeA[1]);
+	const F32x4 e2Dx = f32x4Splat(edgeA[2]);
+	const F32x4 depthDx = f32x4Splat(depthA);
+	const F32x4 e0Step = f32x4Splat(edgeA[0] * 4.0f);
+	const F32x4 e1Step = f32x4Splat(edgeA[1] * 4.0f);
+	const F32x4 e2Step = f32x4Splat(edgeA[2] * 4.0f);
+	const F32x4 depthStep = f32x4Splat(depthA * 4.0f);
+
+	for(U32 y = minY; y < maxY; ++y)
+	{
+		const F32 py = F32(y) + 0.5f;
+		const F32 px = F32(minX);
+
+		F32x4 e0 = f32x4Mad(laneOffsets, e0Dx, f32x4Splat(edgeA[0] * px + edgeB[0] * py + edgeC[0]));
+		F32x4 e1 = f32x4Mad(laneOffsets, e1Dx, f32x4Splat(edgeA[1] * px + edgeB[1] * py + edgeC[1]));
+		F32x4 e2 = f32x4Mad(laneOffsets, e2Dx, f32x4Splat(edgeA[2] * px + edgeB[2] * py + edgeC[2]));
+		F32x4 depth = f32x4Mad(laneOffsets, depthDx, f32x4Splat(depthA * px + depthB * py + depthC));
+
+		Atomic<U32>* row = &m_zbuffer[y * m_width];
+		for(U32 x = minX; x < maxX; x += 4)
 		{
-			Vec2 p(x, y);
-			Vec3 bc;
-			if(!computeBarycetrinc(window[0], window[1], window[2], p, bc))
+			U32 mask = f32x4AllPositiveMask(e0, e1, e2);
+			if(x + 4 > maxX)
 			{
-				const F32 z0 = ndc[0].z();
-				const F32 z1 = ndc[1].z();
-				const F32 z2 = ndc[2].z();
+				mask &= (1u << (maxX - x)) - 1u;
+			}
 
-				F32 depth = z0 * bc[0] + z1 * bc[1] + z2 * bc[2];
-				ANKI_ASSERT(depth >= 0.0 && depth <= 1.0);
+			if(mask)
+			{
+				Array<F32, 4> depths;
+				f32x4Store(&depths[0], depth);
+
+				for(U32 lane = 0; lane < 4; ++lane)
+				{
+					if(mask & (1u << lane))
+					{
+						// The incremental plane evaluation drifts a bit for big triangles so clamp instead of assert
+						const U32 depthi = depthToBits(clamp(depths[lane], 0.0f, 1.0f));
+
+						// Store the min of the current value and new one
+						Atomic<U32>& pixel = row[x + lane];
+						if(depthi < pixel.load())
+						{
+							pixel.min(depthi);
+						}
+					}
+				}
+			}
 
-				// Clamp it to a bit less that 1.0f because 1.0f will produce a 0 depthi
-				depth = min(depth, 1.0f - EPSILON);
+			e0 = f32x4Add(e0, e0Step);
+			e1 = f32x4Add(e1, e1Step);
+			e2 = f32x4Add(e2, e2Step);
+			depth = f32x4Add(depth, depthStep);
+		}
+	}
 
-				// Store the min of the current value and new one
-				const U32 depthi = U32(depth * F32(MAX_U32));
-				m_zbuffer[U32(y) * m_width + U32(x)].min(depthi);
-			}
+	// Lower the min depth of the tiles the triangle touches. The min of the vertices is less or equal to any depth it
+	// wrote
+	const F32 triMinDepth = clamp(min(ndc[0].z(), min(ndc[1].z(), ndc[2].z())), 0.0f, 1.0f);
+	const U32 triMinDepthi = depthToBits(triMinDepth);
+	for(U32 ty = minY / TILE_SIZE; ty <= (maxY - 1) / TILE_SIZE; ++ty)
+	{
+		for(U32 tx = minX / TILE_SIZE; tx <= (maxX - 1) / TILE_SIZE; ++tx)
+		{
+			m_tileMinDepth[ty * m_tileCountX + tx].min(triMinDepthi);
 		}
 	}
 }
@@ -371,19 +635,63 @@ Bool SoftwareRasterizer::visibilityTestInternal(const Aabb& aabb) const
 	bboxMax.y() = ceilf(bboxMax.y());
 	bboxMax.y() = clamp(bboxMax.y(), 0.0f, F32(m_height));
 
+	const U32 minX = U32(bboxMin.x());
+	const U32 minY = U32(bboxMin.y());
+	const U32 maxX = U32(bboxMax.x());
+	const U32 maxY = U32(bboxMax.y());
+	if(minX >= maxX || minY >= maxY)
+	{
+		return false;
+	}
+
 	// Loop the tiles
-	F32 minZ = bboxMin.z();
-	for(F32 y = bboxMin.y(); y < bboxMax.y(); y += 1.0f)
+	const F32 minZ = bboxMin.z();
+	const F32x4 minZ4 = f32x4Splat(minZ);
+	for(U32 ty = minY / TILE_SIZE; ty <= (maxY - 1) / TILE_SIZE; ++ty)
 	{
-		for(F32 x = bboxMin.x(); x < bboxMax.x(); x += 1.0f)
+		for(U32 tx = minX / TILE_SIZE; tx <= (maxX - 1) / TILE_SIZE; ++tx)
 		{
-			const U32 idx = U32(y) * m_width + U32(x);
-			const U32 depthi = m_zbuffer[idx].getNonAtomically();
-			const F32 depthf = F32(depthi) / F32(MAX_U32);
-			if(minZ < depthf)
+			const U32 tileIdx = ty * m_tileCountX + tx;
+
+			if(minZ < bitsToDepth(m_tileMinDepth[tileIdx].getNonAtomically()))
 			{
+				// In front of all the pixels of the tile
 				return true;
 			}
+
+			if(minZ >= m_tileMaxDepth[tileIdx])
+			{
+				// Behind all the pixels of the tile
+				continue;
+			}
+
+			// Check the pixels
+			const U32 beginX = max(minX, tx * TILE_SIZE);
+			const U32 endX = min(maxX, (tx + 1) * TILE_SIZE);
+			const U32 beginY = max(minY, ty * TILE_SIZE);
+			const U32 endY = min(maxY, (ty + 1) * TILE_SIZE);
+			for(U32 y = beginY; y < endY; ++y)
+			{
+				const Atomic<U32>* row = &m_zbuffer[y * m_width];
+
+				U32 x = beginX;
+				for(; x + 4 <= endX; x += 4)
+				{
+					static_assert(sizeof(Atomic<U32>) == sizeof(F32), "Will load them as floats");
+					if(f32x4LessMask(minZ4, f32x4Load(&row[x])))
+					{
+						return true;
+					}
+				}
+
+				for(; x < endX; ++x)
+				{
+					if(minZ < bitsToDepth(row[x].getNonAtomically()))
+					{
+						return true;
+					}
+				}
+			}
 		}
 	}
 
@@ -392,18 +700,35 @@ Bool SoftwareRasterizer::visibilityTestInternal(const Aabb& aabb) const
 
 void SoftwareRasterizer::fillDepthBuffer(ConstWeakArray<F32> depthValues)
 {
-	ANKI_ASSERT(m_zbuffer.getSize() == depthValues.getSize());
+	ANKI_ASSERT(m_width * m_height == depthValues.getSize());
 
-	U32 count = depthValues.getSize();
-	while(count--)
+	for(U32 ty = 0; ty < m_tileCountY; ++ty)
 	{
-		F32 depth = depthValues[count];
-		ANKI_ASSERT(depth >= 0.0f && depth <= 1.0f);
+		for(U32 tx = 0; tx < m_tileCountX; ++tx)
+		{
+			F32 tileMin = 1.0f;
+			F32 tileMax = 0.0f;
 
-		depth = min(depth, 1.0f - EPSILON); // See a few lines above why is that
+			const U32 endY = min(m_height, (ty + 1) * TILE_SIZE);
+			const U32 endX = min(m_width, (tx + 1) * TILE_SIZE);
+			for(U32 y = ty * TILE_SIZE; y < endY; ++y)
+			{
+				for(U32 x = tx * TILE_SIZE; x < endX; ++x)
+				{
+					const U32 idx = y * m_width + x;
+					const F32 depth = depthValues[idx];
+					ANKI_ASSERT(depth >= 0.0f && depth <= 1.0f);
+
+					m_zbuffer[idx].setNonAtomically(depthToBits(depth));
+					tileMin = min(tileMin, depth);
+					tileMax = max(tileMax, depth);
+				}
+			}
 
-		const U32 depthi = U32(depth * F32(MAX_U32));
-		m_zbuffer[count].setNonAtomically(depthi);
+			const U32 tileIdx = ty * m_tileCountX + tx;
+			m_tileMinDepth[tileIdx].setNonAtomically(depthToBits(tileMin));
+			m_tileMaxDepth[tileIdx] = tileMax;
+		}
 	}
 }
 
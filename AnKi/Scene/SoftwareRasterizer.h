@@ -16,10 +16,15 @@ namespace anki
 /// @addtogroup scene
 /// @{
 
-/// Software rasterizer for visibility tests.
+/// Software rasterizer for visibility tests. The depth buffer is split in tiles and every tile keeps the min and max
+/// depth of its pixels so the visibility tests can accept or reject whole tiles without touching the pixels. The
+/// triangles are rasterized 4 pixels at a time.
 class SoftwareRasterizer
 {
 public:
+	/// The size of a tile in pixels.
+	static constexpr U32 TILE_SIZE = 8;
+
 	SoftwareRasterizer()
 	{
 	}
@@ -27,6 +32,8 @@ public:
 	~SoftwareRasterizer()
 	{
 		m_zbuffer.destroy(m_alloc);
+		m_tileMinDepth.destroy(m_alloc);
+		m_tileMaxDepth.destroy(m_alloc);
 	}
 
 	/// Initialize.
@@ -63,13 +70,22 @@ private:
 	Array<Plane, 6> m_planesW; ///< In world space.
 	U32 m_width;
 	U32 m_height;
+	U32 m_tileCountX;
+	U32 m_tileCountY;
+
+	/// The depth values as F32 bits. Since the depth is never negative the U32 comparisons work like F32 comparisons
+	/// and Atomic::min() can be used.
 	DynamicArray<Atomic<U32>> m_zbuffer;
 
+	/// Per tile minimum depth (as F32 bits). It's lowered by draw() so it's always less or equal to the real minimum.
+	DynamicArray<Atomic<U32>> m_tileMinDepth;
+
+	/// Per tile maximum depth. draw() doesn't update it so it's always greater or equal to the real maximum.
+	DynamicArray<F32> m_tileMaxDepth;
+
 	/// @param tri In clip space.
 	void rasterizeTriangle(const Vec4* tri);
 
-	Bool computeBarycetrinc(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, Vec3& uvw) const;
-
 	/// Clip triangle in the near plane.
 	/// @note Triangles in view space.
 	void clipTriangle(const Vec4* inTriangle, Vec4* outTriangles, U& outTriangleCount) const;
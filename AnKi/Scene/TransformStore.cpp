@@ -0,0 +1,125 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Scene/TransformStore.h>
+
+namespace anki
+{
+
+TransformStore::~TransformStore()
+{
+	ANKI_ASSERT(getTransformCount() == 0 && "Someone didn't delete their transforms");
+
+	for(U32 i = 0; i < m_chunkCount; ++i)
+	{
+		m_alloc.deleteInstance(m_chunks[i]);
+	}
+
+	m_freeHandles.destroy(m_alloc);
+}
+
+U32 TransformStore::newTransform()
+{
+	U32 handle;
+	{
+		LockGuard<Mutex> lock(m_mtx);
+
+		if(m_freeHandles.getSize())
+		{
+			handle = m_freeHandles.getBack();
+			m_freeHandles.popBack(m_alloc);
+		}
+		else
+		{
+			handle = m_handleCount++;
+
+			if(handle / CHUNK_SIZE == m_chunkCount)
+			{
+				ANKI_ASSERT(m_chunkCount < MAX_CHUNKS && "Too many transforms");
+				m_chunks[m_chunkCount++] = m_alloc.newInstance<Chunk>();
+			}
+		}
+	}
+
+	Chunk& chunk = getChunk(handle);
+	const U32 idx = handle % CHUNK_SIZE;
+	const Transform identity = Transform::getIdentity();
+	chunk.m_local.set(idx, identity);
+	chunk.m_world.set(idx, identity);
+	chunk.m_prevWorld.set(idx, identity);
+
+	return handle;
+}
+
+void TransformStore::deleteTransform(U32 handle)
+{
+	LockGuard<Mutex> lock(m_mtx);
+	ANKI_ASSERT(handle < m_handleCount);
+	m_freeHandles.emplaceBack(m_alloc, handle);
+}
+
+void TransformStore::beginFrame()
+{
+	// Copy the streams one after the other. The free handles are copied as well since skipping them would cost more
+	for(U32 i = 0; i < m_chunkCount; ++i)
+	{
+		const Streams& world = m_chunks[i]->m_world;
+		Streams& prevWorld = m_chunks[i]->m_prevWorld;
+		const U32 count = min(CHUNK_SIZE, m_handleCount - i * CHUNK_SIZE);
+
+		for(U32 j = 0; j < count; ++j)
+		{
+			prevWorld.m_origins[j] = world.m_origins[j];
+		}
+
+		for(U32 j = 0; j < count; ++j)
+		{
+			prevWorld.m_rotations[j] = world.m_rotations[j];
+		}
+
+		for(U32 j = 0; j < count; ++j)
+		{
+			prevWorld.m_scales[j] = world.m_scales[j];
+		}
+	}
+}
+
+void TransformStore::updateWorldTransform(U32 handle, U32 parentHandle, Bool ignoreLocalTransform)
+{
+	Chunk& chunk = getChunk(handle);
+	const U32 idx = handle % CHUNK_SIZE;
+	Streams& world = chunk.m_world;
+	const Streams& local = chunk.m_local;
+
+	if(parentHandle == INVALID_HANDLE)
+	{
+		world.m_origins[idx] = local.m_origins[idx];
+		world.m_rotations[idx] = local.m_rotations[idx];
+		world.m_scales[idx] = local.m_scales[idx];
+		return;
+	}
+
+	const Streams& parentWorld = getChunk(parentHandle).m_world;
+	const U32 parentIdx = parentHandle % CHUNK_SIZE;
+	const Vec4& pOrigin = parentWorld.m_origins[parentIdx];
+	const Mat3x4& pRotation = parentWorld.m_rotations[parentIdx];
+	const F32 pScale = parentWorld.m_scales[parentIdx];
+
+	if(ignoreLocalTransform)
+	{
+		world.m_origins[idx] = pOrigin;
+		world.m_rotations[idx] = pRotation;
+		world.m_scales[idx] = pScale;
+	}
+	else
+	{
+		// Same as Transform::combineTransformations without gathering the components in Transforms
+		world.m_origins[idx] = Vec4(pRotation * (local.m_origins[idx] * pScale), 0.0f) + pOrigin;
+		world.m_rotations[idx] = pRotation.combineTransformations(local.m_rotations[idx]);
+		world.m_scales[idx] = pScale * local.m_scales[idx];
+	}
+}
+
+} // end namespace anki
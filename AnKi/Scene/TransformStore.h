@@ -0,0 +1,159 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Scene/Common.h>
+#include <AnKi/Math.h>
+#include <AnKi/Util/DynamicArray.h>
+#include <AnKi/Util/Thread.h>
+
+namespace anki
+{
+
+/// @addtogroup scene
+/// @{
+
+/// Holds the local, world and previous world transforms of all the MoveComponents. The origins, rotations and scales
+/// are kept in separate dense arrays that are indexed by a handle. The arrays are split in chunks so the addresses of
+/// the transforms never change.
+class TransformStore : public NonCopyable
+{
+public:
+	static constexpr U32 CHUNK_SIZE = 256;
+	static constexpr U32 MAX_CHUNKS = 4096;
+	static constexpr U32 INVALID_HANDLE = MAX_U32;
+
+	TransformStore(SceneAllocator<U8> alloc)
+		: m_alloc(alloc)
+	{
+	}
+
+	~TransformStore();
+
+	/// Allocate a new transform. All of its transforms are set to identity.
+	/// @note It's thread-safe against newTransform and deleteTransform.
+	U32 newTransform();
+
+	/// @note It's thread-safe against newTransform and deleteTransform.
+	void deleteTransform(U32 handle);
+
+	/// Copy the world transforms to the previous world transforms. Called once at the beginning of the frame.
+	void beginFrame();
+
+	/// Compute the world transform of a transform.
+	/// @param handle The transform to update.
+	/// @param parentHandle The parent transform. If it's INVALID_HANDLE the world transform will be the local.
+	/// @param ignoreLocalTransform If true the world transform will be the parent's.
+	void updateWorldTransform(U32 handle, U32 parentHandle, Bool ignoreLocalTransform);
+
+	Vec4& getLocalOrigin(U32 handle)
+	{
+		return getChunk(handle).m_local.m_origins[handle % CHUNK_SIZE];
+	}
+
+	const Vec4& getLocalOrigin(U32 handle) const
+	{
+		return getChunk(handle).m_local.m_origins[handle % CHUNK_SIZE];
+	}
+
+	Mat3x4& getLocalRotation(U32 handle)
+	{
+		return getChunk(handle).m_local.m_rotations[handle % CHUNK_SIZE];
+	}
+
+	const Mat3x4& getLocalRotation(U32 handle) const
+	{
+		return getChunk(handle).m_local.m_rotations[handle % CHUNK_SIZE];
+	}
+
+	F32& getLocalScale(U32 handle)
+	{
+		return getChunk(handle).m_local.m_scales[handle % CHUNK_SIZE];
+	}
+
+	F32 getLocalScale(U32 handle) const
+	{
+		return getChunk(handle).m_local.m_scales[handle % CHUNK_SIZE];
+	}
+
+	Transform getLocalTransform(U32 handle) const
+	{
+		return getChunk(handle).m_local.get(handle % CHUNK_SIZE);
+	}
+
+	void setLocalTransform(U32 handle, const Transform& trf)
+	{
+		getChunk(handle).m_local.set(handle % CHUNK_SIZE, trf);
+	}
+
+	Transform getWorldTransform(U32 handle) const
+	{
+		return getChunk(handle).m_world.get(handle % CHUNK_SIZE);
+	}
+
+	Transform getPreviousWorldTransform(U32 handle) const
+	{
+		return getChunk(handle).m_prevWorld.get(handle % CHUNK_SIZE);
+	}
+
+	/// Get the number of live transforms.
+	U32 getTransformCount() const
+	{
+		return m_handleCount - m_freeHandles.getSize();
+	}
+
+private:
+	/// The transforms of a chunk split in components.
+	class Streams
+	{
+	public:
+		Array<Vec4, CHUNK_SIZE> m_origins;
+		Array<Mat3x4, CHUNK_SIZE> m_rotations;
+		Array<F32, CHUNK_SIZE> m_scales;
+
+		Transform get(U32 idx) const
+		{
+			return Transform(m_origins[idx], m_rotations[idx], m_scales[idx]);
+		}
+
+		void set(U32 idx, const Transform& trf)
+		{
+			m_origins[idx] = trf.getOrigin();
+			m_rotations[idx] = trf.getRotation();
+			m_scales[idx] = trf.getScale();
+		}
+	};
+
+	class Chunk
+	{
+	public:
+		Streams m_local;
+		Streams m_world;
+		Streams m_prevWorld;
+	};
+
+	SceneAllocator<U8> m_alloc;
+	Array<Chunk*, MAX_CHUNKS> m_chunks = {};
+	U32 m_chunkCount = 0;
+	U32 m_handleCount = 0; ///< Handles that were ever allocated.
+	DynamicArray<U32> m_freeHandles;
+	Mutex m_mtx;
+
+	Chunk& getChunk(U32 handle)
+	{
+		ANKI_ASSERT(handle < MAX_CHUNKS * CHUNK_SIZE);
+		return *m_chunks[handle / CHUNK_SIZE];
+	}
+
+	const Chunk& getChunk(U32 handle) const
+	{
+		ANKI_ASSERT(handle < MAX_CHUNKS * CHUNK_SIZE);
+		return *m_chunks[handle / CHUNK_SIZE];
+	}
+};
+/// @}
+
+} // end namespace anki
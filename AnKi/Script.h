@@ -7,3 +7,4 @@
 
 #include <AnKi/Script/ScriptManager.h>
 #include <AnKi/Script/ScriptEnvironment.h>
+#include <AnKi/Script/ScriptBatch.h>
@@ -16,6 +16,7 @@ ANKI_SCRIPT_CALL_WRAP(Logger);
 ANKI_SCRIPT_CALL_WRAP(Math);
 ANKI_SCRIPT_CALL_WRAP(Renderer);
 ANKI_SCRIPT_CALL_WRAP(Scene);
+ANKI_SCRIPT_CALL_WRAP(Tracer);
 #undef ANKI_SCRIPT_CALL_WRAP
 
 static void wrapModules(lua_State* l)
@@ -25,6 +26,7 @@ static void wrapModules(lua_State* l)
 	ANKI_SCRIPT_CALL_WRAP(Math);
 	ANKI_SCRIPT_CALL_WRAP(Renderer);
 	ANKI_SCRIPT_CALL_WRAP(Scene);
+	ANKI_SCRIPT_CALL_WRAP(Tracer);
 #undef ANKI_SCRIPT_CALL_WRAP
 }
 
@@ -696,14 +696,16 @@ static inline int pwrapMoveComponentgetLocalTransform(lua_State* l)
 	MoveComponent* self = ud->getData<MoveComponent>();
 
 	// Call the method
-	const Transform& ret = self->getLocalTransform();
+	Transform ret = self->getLocalTransform();
 
 	// Push return value
-	voidp = lua_newuserdata(l, sizeof(LuaUserData));
-	ud = static_cast<LuaUserData*>(voidp);
+	size = LuaUserData::computeSizeForGarbageCollected<Transform>();
+	voidp = lua_newuserdata(l, size);
 	luaL_setmetatable(l, "Transform");
+	ud = static_cast<LuaUserData*>(voidp);
 	extern LuaUserDataTypeInfo luaUserDataTypeInfoTransform;
-	ud->initPointed(&luaUserDataTypeInfoTransform, const_cast<Transform*>(&ret));
+	ud->initGarbageCollected(&luaUserDataTypeInfoTransform);
+	::new(ud->getData<Transform>()) Transform(std::move(ret));
 
 	return 1;
 }
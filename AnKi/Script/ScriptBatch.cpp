@@ -0,0 +1,265 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Script/ScriptBatch.h>
+#include <AnKi/Script/ScriptManager.h>
+#include <AnKi/Util/Logger.h>
+#include <AnKi/Util/Tracer.h>
+
+namespace anki
+{
+
+/// The function and its 3 arguments should be in the stack.
+static Error callUpdateFunction(lua_State* l, const char* funcName)
+{
+	if(lua_pcall(l, 3, 1, 0) != 0)
+	{
+		ANKI_SCRIPT_LOGE("Error running \"%s\": %s", funcName, lua_tostring(l, -1));
+		lua_pop(l, 1);
+		return Error::USER_DATA;
+	}
+
+	if(!lua_isnumber(l, -1))
+	{
+		ANKI_SCRIPT_LOGE("\"%s\" should return a number", funcName);
+		lua_pop(l, 1);
+		return Error::USER_DATA;
+	}
+
+	const lua_Number result = lua_tonumber(l, -1);
+	lua_pop(l, 1);
+
+	if(result < 0)
+	{
+		ANKI_SCRIPT_LOGE("\"%s\" returned an error code", funcName);
+		return Error::USER_DATA;
+	}
+
+	return Error::NONE;
+}
+
+/// Push a new table whose missing fields are looked up in the globals.
+static void pushNewEnvironment(lua_State* l)
+{
+	lua_newtable(l);
+	lua_newtable(l);
+	lua_pushglobaltable(l);
+	lua_setfield(l, -2, "__index");
+	lua_setmetatable(l, -2);
+}
+
+ScriptBatch::~ScriptBatch()
+{
+	if(isInitialized())
+	{
+		ANKI_ASSERT(m_instanceCount == 0 && "Forgot to delete some instances");
+		ScriptAllocator alloc = m_manager->getAllocator();
+		m_bytecode.destroy(alloc);
+		m_instances.destroy(alloc);
+		m_freeInstanceIds.destroy(alloc);
+	}
+}
+
+Error ScriptBatch::init(ScriptManager* manager, CString source)
+{
+	ANKI_ASSERT(!isInitialized());
+	ANKI_ASSERT(manager);
+	m_manager = manager;
+	ANKI_CHECK(m_binder.init(m_manager->getAllocator(), &m_manager->getOtherSystems()));
+	lua_State* l = m_binder.getLuaState();
+
+	// Compile once and keep the bytecode
+	if(luaL_loadstring(l, source.cstr()))
+	{
+		ANKI_SCRIPT_LOGE("%s", lua_tostring(l, -1));
+		lua_pop(l, 1);
+		return Error::USER_DATA;
+	}
+
+	auto writer = [](lua_State*, const void* data, size_t size, void* ud) -> int {
+		ScriptBatch& self = *static_cast<ScriptBatch*>(ud);
+		const U32 offset = self.m_bytecode.getSize();
+		self.m_bytecode.resize(self.m_manager->getAllocator(), offset + U32(size));
+		memcpy(&self.m_bytecode[offset], data, size);
+		return 0;
+	};
+	lua_dump(l, writer, this);
+	lua_pop(l, 1);
+
+	return Error::NONE;
+}
+
+Error ScriptBatch::runScript(lua_State* l)
+{
+	ANKI_TRACE_SCOPED_EVENT(LUA_EXEC);
+
+	// Load the bytecode every time because the closures of the script share the _ENV of the chunk
+	if(luaL_loadbufferx(l, reinterpret_cast<const char*>(&m_bytecode[0]), m_bytecode.getSize(), "=ScriptBatch", "b"))
+	{
+		ANKI_SCRIPT_LOGE("%s", lua_tostring(l, -1));
+		lua_pop(l, 1);
+		return Error::USER_DATA;
+	}
+
+	lua_pushvalue(l, -2);
+	lua_setupvalue(l, -2, 1);
+
+	if(lua_pcall(l, 0, 0, 0))
+	{
+		ANKI_SCRIPT_LOGE("%s", lua_tostring(l, -1));
+		lua_pop(l, 1);
+		return Error::USER_DATA;
+	}
+
+	return Error::NONE;
+}
+
+Error ScriptBatch::newInstanceInternal(CString objectName, U32& instanceId)
+{
+	lua_State* l = m_binder.getLuaState();
+	ScriptAllocator alloc = m_manager->getAllocator();
+
+	Instance instance;
+	instance.m_objectRef = luaL_ref(l, LUA_REGISTRYINDEX);
+
+	pushNewEnvironment(l);
+	lua_rawgeti(l, LUA_REGISTRYINDEX, instance.m_objectRef);
+	lua_setfield(l, -2, objectName.cstr());
+
+	const Error err = runScript(l);
+	if(err)
+	{
+		lua_pop(l, 1);
+		luaL_unref(l, LUA_REGISTRYINDEX, instance.m_objectRef);
+		return err;
+	}
+
+	// The first instance decides if the script is batched
+	if(!m_firstInstanceCreated)
+	{
+		lua_getfield(l, -1, "updateBatch");
+		if(lua_isfunction(l, -1))
+		{
+			m_updateBatchRef = luaL_ref(l, LUA_REGISTRYINDEX);
+		}
+		else
+		{
+			lua_pop(l, 1);
+		}
+
+		m_firstInstanceCreated = true;
+	}
+
+	if(!isBatched())
+	{
+		lua_getfield(l, -1, "update");
+		if(lua_isfunction(l, -1))
+		{
+			instance.m_updateRef = luaL_ref(l, LUA_REGISTRYINDEX);
+		}
+		else
+		{
+			lua_pop(l, 1);
+		}
+	}
+
+	instance.m_envRef = luaL_ref(l, LUA_REGISTRYINDEX);
+
+	if(m_freeInstanceIdCount > 0)
+	{
+		instanceId = m_freeInstanceIds[--m_freeInstanceIdCount];
+	}
+	else
+	{
+		instanceId = m_instances.getSize();
+		m_instances.resize(alloc, instanceId + 1);
+		m_freeInstanceIds.resize(alloc, instanceId + 1);
+	}
+
+	m_instances[instanceId] = instance;
+	++m_instanceCount;
+	m_instancesTableDirty = true;
+
+	return Error::NONE;
+}
+
+void ScriptBatch::deleteInstance(U32 instanceId)
+{
+	lua_State* l = m_binder.getLuaState();
+	Instance& instance = getInstance(instanceId);
+
+	luaL_unref(l, LUA_REGISTRYINDEX, instance.m_envRef);
+	luaL_unref(l, LUA_REGISTRYINDEX, instance.m_objectRef);
+	luaL_unref(l, LUA_REGISTRYINDEX, instance.m_updateRef);
+	instance = Instance();
+
+	m_freeInstanceIds[m_freeInstanceIdCount++] = instanceId;
+	ANKI_ASSERT(m_instanceCount > 0);
+	--m_instanceCount;
+	m_instancesTableDirty = true;
+}
+
+void ScriptBatch::rebuildInstancesTable(lua_State* l)
+{
+	luaL_unref(l, LUA_REGISTRYINDEX, m_instancesTableRef);
+
+	lua_createtable(l, I32(m_instanceCount), 0);
+	I32 idx = 1;
+	for(const Instance& instance : m_instances)
+	{
+		if(instance.m_envRef != LUA_NOREF)
+		{
+			lua_rawgeti(l, LUA_REGISTRYINDEX, instance.m_envRef);
+			lua_rawseti(l, -2, idx++);
+		}
+	}
+
+	m_instancesTableRef = luaL_ref(l, LUA_REGISTRYINDEX);
+	m_instancesTableDirty = false;
+}
+
+Error ScriptBatch::update(Second prevTime, Second crntTime)
+{
+	ANKI_ASSERT(isInitialized());
+	ANKI_TRACE_SCOPED_EVENT(LUA_EXEC);
+	lua_State* l = m_binder.getLuaState();
+
+	if(isBatched())
+	{
+		if(m_instanceCount == 0)
+		{
+			return Error::NONE;
+		}
+
+		if(m_instancesTableDirty)
+		{
+			rebuildInstancesTable(l);
+		}
+
+		lua_rawgeti(l, LUA_REGISTRYINDEX, m_updateBatchRef);
+		lua_rawgeti(l, LUA_REGISTRYINDEX, m_instancesTableRef);
+		lua_pushnumber(l, prevTime);
+		lua_pushnumber(l, crntTime);
+		return callUpdateFunction(l, "updateBatch");
+	}
+
+	for(const Instance& instance : m_instances)
+	{
+		if(instance.m_updateRef == LUA_NOREF)
+		{
+			continue;
+		}
+
+		lua_rawgeti(l, LUA_REGISTRYINDEX, instance.m_updateRef);
+		lua_rawgeti(l, LUA_REGISTRYINDEX, instance.m_objectRef);
+		lua_pushnumber(l, prevTime);
+		lua_pushnumber(l, crntTime);
+		ANKI_CHECK(callUpdateFunction(l, "update"));
+	}
+
+	return Error::NONE;
+}
+
+} // end namespace anki
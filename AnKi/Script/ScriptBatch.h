@@ -0,0 +1,144 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Script/LuaBinder.h>
+#include <AnKi/Util/DynamicArray.h>
+
+namespace anki
+{
+
+/// @addtogroup script
+/// @{
+
+/// Runs all the instances of a script in a single lua_State. Every instance has its own environment table that falls
+/// back to the globals so the instances don't see each other's variables. The objects that are bound to an instance
+/// are pushed to LUA once and the same userdata are re-used every frame.
+///
+/// The script is evaluated once per instance, in the instance's environment. There are two ways to write such a script.
+/// If the script defines an updateBatch function it's called once for all instances. The instances are the environment
+/// tables:
+/// @code
+/// function updateBatch(instances, prevTime, crntTime)
+/// 	for i = 1, #instances do
+/// 		local node = instances[i].node
+/// 		-- Do something
+/// 	end
+/// 	return 1
+/// end
+/// @endcode
+/// Else its update function is called per instance:
+/// @code
+/// function update(node, prevTime, crntTime)
+/// 	-- Do something
+/// 	return 1
+/// end
+/// @endcode
+/// @note The updateBatch of the first instance is the one that is called so it sees the globals of that instance.
+/// @note It's not thread-safe.
+class ScriptBatch : public NonCopyable
+{
+public:
+	ScriptBatch()
+	{
+	}
+
+	~ScriptBatch();
+
+	ANKI_USE_RESULT Error init(ScriptManager* manager, CString source);
+
+	Bool isInitialized() const
+	{
+		return m_manager != nullptr;
+	}
+
+	/// Is the script using updateBatch. It's known after the first instance is created.
+	Bool isBatched() const
+	{
+		return m_updateBatchRef != LUA_NOREF;
+	}
+
+	/// Create a new instance of the script.
+	/// @param objectName The name of the object in the instance's environment.
+	/// @param object The object that will be passed to update.
+	/// @param[out] instanceId The ID to use in the rest of the methods.
+	template<typename T>
+	ANKI_USE_RESULT Error newInstance(CString objectName, T* object, U32& instanceId)
+	{
+		ANKI_ASSERT(isInitialized());
+		lua_State* l = m_binder.getLuaState();
+		LuaBinder::pushVariableToTheStack(l, object);
+		return newInstanceInternal(objectName, instanceId);
+	}
+
+	void deleteInstance(U32 instanceId);
+
+	/// Expose a variable to the environment of an instance.
+	template<typename T>
+	void exposeInstanceVariable(U32 instanceId, CString name, T* y)
+	{
+		ANKI_ASSERT(isInitialized());
+		lua_State* l = m_binder.getLuaState();
+		lua_rawgeti(l, LUA_REGISTRYINDEX, getInstance(instanceId).m_envRef);
+		LuaBinder::pushVariableToTheStack(l, y);
+		lua_setfield(l, -2, name.cstr());
+		lua_pop(l, 1);
+	}
+
+	U32 getInstanceCount() const
+	{
+		return m_instanceCount;
+	}
+
+	/// Update all the instances.
+	ANKI_USE_RESULT Error update(Second prevTime, Second crntTime);
+
+	lua_State& getLuaState()
+	{
+		ANKI_ASSERT(isInitialized());
+		return *m_binder.getLuaState();
+	}
+
+private:
+	class Instance
+	{
+	public:
+		I32 m_envRef = LUA_NOREF;
+		I32 m_objectRef = LUA_NOREF;
+		I32 m_updateRef = LUA_NOREF;
+	};
+
+	ScriptManager* m_manager = nullptr;
+	LuaBinder m_binder;
+
+	DynamicArray<U8> m_bytecode; ///< The compiled script. Every instance loads it to get its own closures.
+	I32 m_updateBatchRef = LUA_NOREF; ///< The updateBatch of the first instance.
+	I32 m_instancesTableRef = LUA_NOREF; ///< The array of environments that is passed to updateBatch.
+	Bool m_instancesTableDirty = true;
+
+	DynamicArray<Instance> m_instances;
+	DynamicArray<U32> m_freeInstanceIds;
+	U32 m_freeInstanceIdCount = 0;
+	U32 m_instanceCount = 0;
+	Bool m_firstInstanceCreated = false;
+
+	Instance& getInstance(U32 instanceId)
+	{
+		ANKI_ASSERT(instanceId < m_instances.getSize() && m_instances[instanceId].m_envRef != LUA_NOREF);
+		return m_instances[instanceId];
+	}
+
+	/// The object is on the top of the stack.
+	ANKI_USE_RESULT Error newInstanceInternal(CString objectName, U32& instanceId);
+
+	/// Load the script and run it with the environment that is on the top of the stack.
+	ANKI_USE_RESULT Error runScript(lua_State* l);
+
+	void rebuildInstancesTable(lua_State* l);
+};
+/// @}
+
+} // end namespace anki
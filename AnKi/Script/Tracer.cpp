@@ -0,0 +1,55 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+// WARNING: This file is auto generated.
+
+#include <AnKi/Script/LuaBinder.h>
+#include <AnKi/Util/Tracer.h>
+
+namespace anki
+{
+
+/// Pre-wrap function requestTracerDump.
+static inline int pwraprequestTracerDump(lua_State* l)
+{
+	LuaUserData* ud;
+	(void)ud;
+	void* voidp;
+	(void)voidp;
+	PtrSize size;
+	(void)size;
+
+	if(ANKI_UNLIKELY(LuaBinder::checkArgsCount(l, 0)))
+	{
+		return -1;
+	}
+
+	// Call the function
+	TracerSingleton::get().requestDump();
+
+	return 0;
+}
+
+/// Wrap function requestTracerDump.
+static int wraprequestTracerDump(lua_State* l)
+{
+	int res = pwraprequestTracerDump(l);
+	if(res >= 0)
+	{
+		return res;
+	}
+
+	lua_error(l);
+	return 0;
+}
+
+/// Wrap the module.
+void wrapModuleTracer(lua_State* l)
+{
+	LuaBinder::pushLuaCFunc(l, "requestTracerDump", wraprequestTracerDump);
+}
+
+} // end namespace anki
+
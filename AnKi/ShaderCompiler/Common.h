@@ -8,6 +8,9 @@
 #include <AnKi/Util/Logger.h>
 #include <AnKi/Util/String.h>
 #include <AnKi/Util/BitSet.h>
+#include <AnKi/Util/DynamicArray.h>
+#include <AnKi/Util/WeakArray.h>
+#include <AnKi/Gr/Enums.h>
 
 namespace anki
 {
@@ -31,21 +34,47 @@ public:
 	virtual ANKI_USE_RESULT Error readAllText(CString filename, StringAuto& txt) = 0;
 };
 
+/// A file that a shader program read while parsing. It's the program itself or one of its includes.
+class ShaderProgramDependency
+{
+public:
+	CString m_filename;
+	U64 m_hash; ///< See ShaderProgramParser::computeDependencyHash().
+};
+
 /// This controls if the compilation will continue after the parsing stage.
 class ShaderProgramPostParseInterface
 {
 public:
-	virtual Bool skipCompilation(U64 programHash) = 0;
+	/// @param programHash The hash of the whole program.
+	/// @param dependencies The files that the program depends on. Valid only during the call.
+	virtual Bool skipCompilation(U64 programHash, ConstWeakArray<ShaderProgramDependency> dependencies) = 0;
 };
 
 /// An interface for asynchronous shader compilation.
 class ShaderProgramAsyncTaskInterface
 {
 public:
+	/// Enqueue a task. The tasks may also call it to enqueue more tasks.
 	virtual void enqueueTask(void (*callback)(void* userData), void* userData) = 0;
 
+	/// Wait for the tasks to finish, including the ones that were enqueued by other tasks.
 	virtual ANKI_USE_RESULT Error joinTasks() = 0;
 };
+
+/// A cache of SPIR-V that can be shared by many programs. The key is the hash of the GLSL source of a shader stage.
+/// Different sources may have the same hash so the implementations should check the source and the shader type on a
+/// hit.
+/// @note The methods will be called concurrently.
+class ShaderProgramSpirvCacheInterface
+{
+public:
+	/// Get the SPIR-V that was compiled from a source. Return false if it's not in the cache.
+	virtual Bool find(U64 sourceHash, ShaderType shaderType, CString source, DynamicArrayAuto<U8>& spirv) = 0;
+
+	/// Add the SPIR-V of a source to the cache.
+	virtual void store(U64 sourceHash, ShaderType shaderType, CString source, ConstWeakArray<U8> spirv) = 0;
+};
 /// @}
 
 } // end namespace anki
@@ -6,6 +6,7 @@
 #include <AnKi/ShaderCompiler/Glslang.h>
 #include <AnKi/Util/StringList.h>
 #include <AnKi/Util/File.h>
+#include <AnKi/Util/Hash.h>
 
 #if ANKI_COMPILER_GCC_COMPATIBLE
 #	pragma GCC diagnostic push
@@ -38,6 +39,17 @@ public:
 
 GlslangCtx g_glslangCtx;
 
+static const glslang::EShTargetClientVersion VULKAN_VERSION = glslang::EShTargetVulkan_1_2;
+static const glslang::EShTargetLanguageVersion SPIRV_VERSION = glslang::EShTargetSpv_1_5;
+
+static glslang::SpvOptions getSpvOptions()
+{
+	glslang::SpvOptions spvOptions;
+	spvOptions.optimizeSize = true;
+	spvOptions.disableOptimizer = false;
+	return spvOptions;
+}
+
 static TBuiltInResource setGlslangLimits()
 {
 	TBuiltInResource c = {};
@@ -250,8 +262,8 @@ Error compilerGlslToSpirv(CString src, ShaderType shaderType, GenericMemoryPoolA
 	glslang::TShader shader(stage);
 	Array<const char*, 1> csrc = {&src[0]};
 	shader.setStrings(&csrc[0], 1);
-	shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_2);
-	shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_5);
+	shader.setEnvClient(glslang::EShClientVulkan, VULKAN_VERSION);
+	shader.setEnvTarget(glslang::EShTargetSpv, SPIRV_VERSION);
 	if(!shader.parse(&GLSLANG_LIMITS, 100, false, messages))
 	{
 		logShaderErrorCode(shader.getInfoLog(), src, tmpAlloc);
@@ -269,9 +281,7 @@ Error compilerGlslToSpirv(CString src, ShaderType shaderType, GenericMemoryPoolA
 	}
 
 	// Gen SPIRV
-	glslang::SpvOptions spvOptions;
-	spvOptions.optimizeSize = true;
-	spvOptions.disableOptimizer = false;
+	glslang::SpvOptions spvOptions = getSpvOptions();
 	std::vector<unsigned int> glslangSpirv;
 	glslang::GlslangToSpv(*program.getIntermediate(stage), glslangSpirv, &spvOptions);
 
@@ -299,4 +309,31 @@ Error compilerGlslToSpirv(CString src, ShaderType shaderType, GenericMemoryPoolA
 	return Error::NONE;
 }
 
+U64 computeGlslangCompilerHash()
+{
+	const glslang::Version version = glslang::GetVersion();
+	const glslang::SpvOptions spvOptions = getSpvOptions();
+	const Array<U32, 12> values = {U32(version.major),
+								   U32(version.minor),
+								   U32(version.patch),
+								   U32(glslang::GetSpirvGeneratorVersion()),
+								   U32(VULKAN_VERSION),
+								   U32(SPIRV_VERSION),
+								   spvOptions.generateDebugInfo,
+								   spvOptions.stripDebugInfo,
+								   spvOptions.disableOptimizer,
+								   spvOptions.optimizeSize,
+								   spvOptions.disassemble,
+								   spvOptions.validate};
+
+	U64 hash = computeHash(&values[0], sizeof(values));
+	const CString flavor = version.flavor;
+	if(!flavor.isEmpty())
+	{
+		hash = appendHash(flavor.cstr(), flavor.getLength(), hash);
+	}
+
+	return hash;
+}
+
 } // end namespace anki
@@ -22,6 +22,10 @@ ANKI_USE_RESULT Error preprocessGlsl(CString in, StringAuto& out);
 /// Compile glsl to SPIR-V.
 ANKI_USE_RESULT Error compilerGlslToSpirv(CString src, ShaderType shaderType, GenericMemoryPoolAllocator<U8> tmpAlloc,
 										  DynamicArrayAuto<U8>& spirv);
+
+/// Get a hash of glslang's version and the options compilerGlslToSpirv() uses. If it changes the SPIR-V
+/// compilerGlslToSpirv() outputs might change as well.
+U64 computeGlslangCompilerHash();
 /// @}
 
 } // end namespace anki
@@ -168,152 +168,267 @@ static Bool spinDials(DynamicArrayAuto<U32>& dials, ConstWeakArray<ShaderProgram
 	return done;
 }
 
-static Error compileSpirv(ConstWeakArray<MutatorValue> mutation, const ShaderProgramParser& parser,
-						  GenericMemoryPoolAllocator<U8>& tmpAlloc,
-						  Array<DynamicArrayAuto<U8>, U32(ShaderType::COUNT)>& spirv)
+/// The state that the variant and stage compilation tasks of a program share.
+class CodeBlockStorage
 {
-	// Generate the source and the rest for the variant
-	ShaderProgramParserVariant parserVariant;
-	ANKI_CHECK(parser.generateVariant(mutation, parserVariant));
+public:
+	GenericMemoryPoolAllocator<U8> m_tmpAlloc;
+	GenericMemoryPoolAllocator<U8> m_binaryAlloc;
+	const ShaderProgramParser* m_parser = nullptr;
+	ShaderProgramAsyncTaskInterface* m_taskManager = nullptr;
+	ShaderProgramSpirvCacheInterface* m_spirvCache = nullptr;
+	Atomic<I32> m_err = {0};
+
+	/// A source that was compiled. It's kept to tell apart sources that have the same hash.
+	class Source
+	{
+	public:
+		StringAuto m_source;
+		ShaderType m_shaderType;
+		U32 m_codeBlockIdx;
+
+		Source(GenericMemoryPoolAllocator<U8> alloc, CString source, ShaderType shaderType, U32 codeBlockIdx)
+			: m_source(alloc, source)
+			, m_shaderType(shaderType)
+			, m_codeBlockIdx(codeBlockIdx)
+		{
+		}
+	};
 
-	// Compile stages
-	for(ShaderType shaderType : EnumIterable<ShaderType>())
+	Mutex m_mtx; ///< Protects the members bellow.
+	DynamicArrayAuto<ShaderProgramBinaryCodeBlock> m_codeBlocks;
+	HashMapAuto<U64, U32> m_spirvHashToCodeBlock; ///< Deduplicates the SPIR-V.
+	DynamicArrayAuto<Source> m_sources;
+	HashMapAuto<U64, U32> m_sourceHashToSource; ///< Avoids compiling the same GLSL twice. Points to m_sources.
+
+	CodeBlockStorage(const ShaderProgramParser& parser, ShaderProgramAsyncTaskInterface& taskManager,
+					 ShaderProgramSpirvCacheInterface* spirvCache, GenericMemoryPoolAllocator<U8> tmpAlloc,
+					 GenericMemoryPoolAllocator<U8> binaryAlloc)
+		: m_tmpAlloc(tmpAlloc)
+		, m_binaryAlloc(binaryAlloc)
+		, m_parser(&parser)
+		, m_taskManager(&taskManager)
+		, m_spirvCache(spirvCache)
+		, m_codeBlocks(binaryAlloc)
+		, m_spirvHashToCodeBlock(tmpAlloc)
+		, m_sources(tmpAlloc)
+		, m_sourceHashToSource(tmpAlloc)
 	{
-		if(!(ShaderTypeBit(1 << shaderType) & parser.getShaderTypes()))
+	}
+
+	/// Try to find a code block that was compiled from the same source. It's thread-safe.
+	U32 findCodeBlock(U64 sourceHash, ShaderType shaderType, CString source)
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		auto it = m_sourceHashToSource.find(sourceHash);
+		if(it == m_sourceHashToSource.getEnd())
 		{
-			continue;
+			return MAX_U32;
 		}
 
-		// Compile
-		ANKI_CHECK(compilerGlslToSpirv(parserVariant.getSource(shaderType), shaderType, tmpAlloc, spirv[shaderType]));
-		ANKI_ASSERT(spirv[shaderType].getSize() > 0);
+		const Source& src = m_sources[*it];
+		return (src.m_shaderType == shaderType && src.m_source.toCString() == source) ? src.m_codeBlockIdx : MAX_U32;
 	}
 
-	return Error::NONE;
-}
+	/// Store SPIR-V to the code blocks or reuse an identical one. It's thread-safe.
+	U32 storeCodeBlock(U64 sourceHash, ShaderType shaderType, CString source, ConstWeakArray<U8> spirv)
+	{
+		const U64 spirvHash = computeHash(&spirv[0], spirv.getSize());
+
+		LockGuard<Mutex> lock(m_mtx);
+
+		auto sameCode = [&](const ShaderProgramBinaryCodeBlock& block) {
+			return block.m_hash == spirvHash && block.m_binary.getSize() == spirv.getSize()
+				   && memcmp(&block.m_binary[0], &spirv[0], spirv.getSizeInBytes()) == 0;
+		};
 
-static void compileVariantAsync(ConstWeakArray<MutatorValue> mutation, const ShaderProgramParser& parser,
-								ShaderProgramBinaryVariant& variant,
-								DynamicArrayAuto<ShaderProgramBinaryCodeBlock>& codeBlocks,
-								DynamicArrayAuto<U64>& codeBlockHashes, GenericMemoryPoolAllocator<U8>& tmpAlloc,
-								GenericMemoryPoolAllocator<U8>& binaryAlloc,
-								ShaderProgramAsyncTaskInterface& taskManager, Mutex& mtx, Atomic<I32>& error)
+		U32 idx = MAX_U32;
+		auto it = m_spirvHashToCodeBlock.find(spirvHash);
+		if(it != m_spirvHashToCodeBlock.getEnd())
+		{
+			if(sameCode(m_codeBlocks[*it]))
+			{
+				idx = *it;
+			}
+			else
+			{
+				// Hash collision. The map points to the first block with that hash so search the rest the slow way
+				for(U32 i = 0; i < m_codeBlocks.getSize(); ++i)
+				{
+					if(sameCode(m_codeBlocks[i]))
+					{
+						idx = i;
+						break;
+					}
+				}
+			}
+		}
+
+		if(idx == MAX_U32)
+		{
+			U8* code = m_binaryAlloc.allocate(spirv.getSizeInBytes());
+			memcpy(code, &spirv[0], spirv.getSizeInBytes());
+
+			ShaderProgramBinaryCodeBlock block;
+			block.m_binary.setArray(code, U32(spirv.getSizeInBytes()));
+			block.m_hash = spirvHash;
+
+			m_codeBlocks.emplaceBack(block);
+			idx = m_codeBlocks.getSize() - 1;
+			if(it == m_spirvHashToCodeBlock.getEnd())
+			{
+				m_spirvHashToCodeBlock.emplace(spirvHash, idx);
+			}
+		}
+
+		// Two tasks with the same source might have raced to compile it. If the hash collides with a different source
+		// the first one is kept
+		if(m_sourceHashToSource.find(sourceHash) == m_sourceHashToSource.getEnd())
+		{
+			m_sources.emplaceBack(m_tmpAlloc, source, shaderType, idx);
+			m_sourceHashToSource.emplace(sourceHash, m_sources.getSize() - 1);
+		}
+
+		return idx;
+	}
+};
+
+/// Compile a variant. It's split into a task that generates the source of the variant and then one task per shader
+/// stage so a program with few variants can still use all the threads of the taskManager. A stage is not compiled if
+/// another variant or the spirvCache has the same source.
+static void compileVariantAsync(ConstWeakArray<MutatorValue> mutation, ShaderProgramBinaryVariant& variant,
+								CodeBlockStorage& storage)
 {
 	variant = {};
 
 	class Ctx
 	{
 	public:
-		GenericMemoryPoolAllocator<U8> m_tmpAlloc;
-		GenericMemoryPoolAllocator<U8> m_binaryAlloc;
-		DynamicArrayAuto<MutatorValue> m_mutation = {m_tmpAlloc};
-		const ShaderProgramParser* m_parser;
+		DynamicArrayAuto<MutatorValue> m_mutation;
+		ShaderProgramParserVariant m_parserVariant;
 		ShaderProgramBinaryVariant* m_variant;
-		DynamicArrayAuto<ShaderProgramBinaryCodeBlock>* m_codeBlocks;
-		DynamicArrayAuto<U64>* m_codeBlockHashes;
-		Mutex* m_mtx;
-		Atomic<I32>* m_err;
+		CodeBlockStorage* m_storage;
+		void (*m_stageCallback)(void* userData);
+		Atomic<U32> m_refcount = {1}; ///< The variant task and then one per stage task.
 
 		Ctx(GenericMemoryPoolAllocator<U8> tmpAlloc)
-			: m_tmpAlloc(tmpAlloc)
+			: m_mutation(tmpAlloc)
+		{
+		}
+
+		void release()
 		{
+			if(m_refcount.fetchSub(1) == 1)
+			{
+				GenericMemoryPoolAllocator<U8> alloc = m_storage->m_tmpAlloc;
+				alloc.deleteInstance(this);
+			}
 		}
 	};
 
-	Ctx* ctx = tmpAlloc.newInstance<Ctx>(tmpAlloc);
-	ctx->m_binaryAlloc = binaryAlloc;
+	class StageCtx
+	{
+	public:
+		Ctx* m_ctx;
+		ShaderType m_shaderType;
+	};
+
+	Ctx* ctx = storage.m_tmpAlloc.newInstance<Ctx>(storage.m_tmpAlloc);
 	ctx->m_mutation.create(mutation.getSize());
 	memcpy(ctx->m_mutation.getBegin(), mutation.getBegin(), mutation.getSizeInBytes());
-	ctx->m_parser = &parser;
 	ctx->m_variant = &variant;
-	ctx->m_codeBlocks = &codeBlocks;
-	ctx->m_codeBlockHashes = &codeBlockHashes;
-	ctx->m_mtx = &mtx;
-	ctx->m_err = &error;
+	ctx->m_storage = &storage;
 
-	auto callback = [](void* userData) {
-		Ctx& ctx = *static_cast<Ctx*>(userData);
-		GenericMemoryPoolAllocator<U8>& tmpAlloc = ctx.m_tmpAlloc;
+	ctx->m_stageCallback = [](void* userData) {
+		StageCtx& stageCtx = *static_cast<StageCtx*>(userData);
+		Ctx& ctx = *stageCtx.m_ctx;
+		CodeBlockStorage& storage = *ctx.m_storage;
+		const ShaderType shaderType = stageCtx.m_shaderType;
+		storage.m_tmpAlloc.deleteInstance(&stageCtx);
 
-		if(ctx.m_err->load() != 0)
+		if(storage.m_err.load() == 0)
 		{
-			// Cleanup and return
-			tmpAlloc.deleteInstance(&ctx);
-			return;
-		}
+			const CString source = ctx.m_parserVariant.getSource(shaderType);
+			const U64 sourceHash =
+				appendHash(&shaderType, sizeof(shaderType), computeHash(&source[0], source.getLength()));
 
-		// All good, compile the variant
-		Array<DynamicArrayAuto<U8>, U32(ShaderType::COUNT)> spirvs = {{{tmpAlloc},
-																	   {tmpAlloc},
-																	   {tmpAlloc},
-																	   {tmpAlloc},
-																	   {tmpAlloc},
-																	   {tmpAlloc},
-																	   {tmpAlloc},
-																	   {tmpAlloc},
-																	   {tmpAlloc},
-																	   {tmpAlloc},
-																	   {tmpAlloc},
-																	   {tmpAlloc}}};
-		const Error err = compileSpirv(ctx.m_mutation, *ctx.m_parser, tmpAlloc, spirvs);
-
-		if(!err)
-		{
-			// No error, check if the spirvs are common with some other variant and store it
-
-			LockGuard<Mutex> lock(*ctx.m_mtx);
-
-			for(ShaderType shaderType : EnumIterable<ShaderType>())
+			U32 codeBlockIdx = storage.findCodeBlock(sourceHash, shaderType, source);
+			if(codeBlockIdx == MAX_U32)
 			{
-				DynamicArrayAuto<U8>& spirv = spirvs[shaderType];
+				DynamicArrayAuto<U8> spirv(storage.m_tmpAlloc);
+				Error err = Error::NONE;
+				if(!storage.m_spirvCache || !storage.m_spirvCache->find(sourceHash, shaderType, source, spirv))
+				{
+					err = compilerGlslToSpirv(source, shaderType, storage.m_tmpAlloc, spirv);
+
+					if(!err && storage.m_spirvCache)
+					{
+						storage.m_spirvCache->store(sourceHash, shaderType, source, spirv);
+					}
+				}
 
-				if(spirv.isEmpty())
+				if(!err)
 				{
-					ctx.m_variant->m_codeBlockIndices[shaderType] = MAX_U32;
-					continue;
+					ANKI_ASSERT(spirv.getSize() > 0);
+					codeBlockIdx = storage.storeCodeBlock(sourceHash, shaderType, source, spirv);
 				}
+				else
+				{
+					storage.m_err.store(err._getCode());
+				}
+			}
 
-				// Check if the spirv is already generated
-				const U64 newHash = computeHash(&spirv[0], spirv.getSize());
-				Bool found = false;
-				for(U32 i = 0; i < ctx.m_codeBlockHashes->getSize(); ++i)
+			ctx.m_variant->m_codeBlockIndices[shaderType] = codeBlockIdx;
+		}
+
+		ctx.release();
+	};
+
+	auto variantCallback = [](void* userData) {
+		Ctx& ctx = *static_cast<Ctx*>(userData);
+		CodeBlockStorage& storage = *ctx.m_storage;
+
+		if(storage.m_err.load() == 0)
+		{
+			// Generate the source and the rest for the variant
+			const Error err = storage.m_parser->generateVariant(ctx.m_mutation, ctx.m_parserVariant);
+
+			if(!err)
+			{
+				// Mark the missing stages first because the stage tasks write the others concurrently
+				for(ShaderType shaderType : EnumIterable<ShaderType>())
 				{
-					if((*ctx.m_codeBlockHashes)[i] == newHash)
+					if(!(ShaderTypeBit(1 << shaderType) & storage.m_parser->getShaderTypes()))
 					{
-						// Found it
-						ctx.m_variant->m_codeBlockIndices[shaderType] = i;
-						found = true;
-						break;
+						ctx.m_variant->m_codeBlockIndices[shaderType] = MAX_U32;
 					}
 				}
 
-				// Create it if not found
-				if(!found)
+				// Compile stages
+				for(ShaderType shaderType : EnumIterable<ShaderType>())
 				{
-					U8* code = ctx.m_binaryAlloc.allocate(spirv.getSizeInBytes());
-					memcpy(code, &spirv[0], spirv.getSizeInBytes());
-
-					ShaderProgramBinaryCodeBlock block;
-					block.m_binary.setArray(code, U32(spirv.getSizeInBytes()));
-					block.m_hash = newHash;
-
-					ctx.m_codeBlocks->emplaceBack(block);
-					ctx.m_codeBlockHashes->emplaceBack(newHash);
+					if(!(ShaderTypeBit(1 << shaderType) & storage.m_parser->getShaderTypes()))
+					{
+						continue;
+					}
 
-					ctx.m_variant->m_codeBlockIndices[shaderType] = ctx.m_codeBlocks->getSize() - 1;
+					StageCtx* stageCtx = storage.m_tmpAlloc.newInstance<StageCtx>();
+					stageCtx->m_ctx = &ctx;
+					stageCtx->m_shaderType = shaderType;
+					ctx.m_refcount.fetchAdd(1);
+					storage.m_taskManager->enqueueTask(ctx.m_stageCallback, stageCtx);
 				}
 			}
-		}
-		else
-		{
-			ctx.m_err->store(err._getCode());
+			else
+			{
+				storage.m_err.store(err._getCode());
+			}
 		}
 
-		// Cleanup
-		tmpAlloc.deleteInstance(&ctx);
+		ctx.release();
 	};
 
-	taskManager.enqueueTask(callback, ctx);
+	storage.m_taskManager->enqueueTask(variantCallback, ctx);
 }
 
 class Refl final : public ShaderReflectionVisitorInterface
@@ -766,6 +881,7 @@ static Error doReflection(ShaderProgramBinary& binary, GenericMemoryPoolAllocato
 Error compileShaderProgramInternal(CString fname, ShaderProgramFilesystemInterface& fsystem,
 								   ShaderProgramPostParseInterface* postParseCallback,
 								   ShaderProgramAsyncTaskInterface* taskManager_,
+								   ShaderProgramSpirvCacheInterface* spirvCache,
 								   GenericMemoryPoolAllocator<U8> tempAllocator,
 								   const GpuDeviceCapabilities& gpuCapabilities, const BindlessLimits& bindlessLimits,
 								   ShaderProgramBinaryWrapper& binaryW)
@@ -783,7 +899,7 @@ Error compileShaderProgramInternal(CString fname, ShaderProgramFilesystemInterfa
 	ShaderProgramParser parser(fname, &fsystem, tempAllocator, gpuCapabilities, bindlessLimits);
 	ANKI_CHECK(parser.parse());
 
-	if(postParseCallback && postParseCallback->skipCompilation(parser.getHash()))
+	if(postParseCallback && postParseCallback->skipCompilation(parser.getHash(), parser.getDependencies()))
 	{
 		return Error::NONE;
 	}
@@ -816,8 +932,6 @@ Error compileShaderProgramInternal(CString fname, ShaderProgramFilesystemInterfa
 	}
 
 	// Create all variants
-	Mutex mtx;
-	Atomic<I32> errorAtomic(0);
 	class SyncronousShaderProgramAsyncTaskInterface : public ShaderProgramAsyncTaskInterface
 	{
 	public:
@@ -833,6 +947,7 @@ Error compileShaderProgramInternal(CString fname, ShaderProgramFilesystemInterfa
 		}
 	} syncTaskManager;
 	ShaderProgramAsyncTaskInterface& taskManager = (taskManager_) ? *taskManager_ : syncTaskManager;
+	CodeBlockStorage codeBlockStorage(parser, taskManager, spirvCache, tempAllocator, binaryAllocator);
 
 	if(parser.getMutators().getSize() > 0)
 	{
@@ -841,9 +956,7 @@ Error compileShaderProgramInternal(CString fname, ShaderProgramFilesystemInterfa
 		DynamicArrayAuto<MutatorValue> rewrittenMutationValues(tempAllocator, parser.getMutators().getSize());
 		DynamicArrayAuto<U32> dials(tempAllocator, parser.getMutators().getSize(), 0);
 		DynamicArrayAuto<ShaderProgramBinaryVariant> variants(binaryAllocator);
-		DynamicArrayAuto<ShaderProgramBinaryCodeBlock> codeBlocks(binaryAllocator);
 		DynamicArrayAuto<ShaderProgramBinaryMutation> mutations(binaryAllocator, mutationCount);
-		DynamicArrayAuto<U64> codeBlockHashes(tempAllocator);
 		HashMapAuto<U64, U32> mutationHashToIdx(tempAllocator);
 
 		// Grow the storage of the variants array. Can't have it resize, threads will work on stale data
@@ -884,8 +997,7 @@ Error compileShaderProgramInternal(CString fname, ShaderProgramFilesystemInterfa
 				ShaderProgramBinaryVariant& variant = *variants.emplaceBack();
 				baseVariant = (baseVariant == nullptr) ? variants.getBegin() : baseVariant;
 
-				compileVariantAsync(originalMutationValues, parser, variant, codeBlocks, codeBlockHashes, tempAllocator,
-									binaryAllocator, taskManager, mtx, errorAtomic);
+				compileVariantAsync(originalMutationValues, variant, codeBlockStorage);
 
 				mutation.m_variantIndex = variants.getSize() - 1;
 
@@ -907,8 +1019,7 @@ Error compileShaderProgramInternal(CString fname, ShaderProgramFilesystemInterfa
 					variant = variants.emplaceBack();
 					baseVariant = (baseVariant == nullptr) ? variants.getBegin() : baseVariant;
 
-					compileVariantAsync(originalMutationValues, parser, *variant, codeBlocks, codeBlockHashes,
-										tempAllocator, binaryAllocator, taskManager, mtx, errorAtomic);
+					compileVariantAsync(originalMutationValues, *variant, codeBlockStorage);
 
 					ShaderProgramBinaryMutation& otherMutation = mutations[mutationCount++];
 					otherMutation.m_values.setArray(
@@ -935,7 +1046,7 @@ Error compileShaderProgramInternal(CString fname, ShaderProgramFilesystemInterfa
 
 		// Done, wait the threads
 		ANKI_CHECK(taskManager.joinTasks());
-		ANKI_CHECK(Error(errorAtomic.getNonAtomically()));
+		ANKI_CHECK(Error(codeBlockStorage.m_err.getNonAtomically()));
 
 		// Store temp containers to binary
 		U32 size, storage;
@@ -944,7 +1055,7 @@ Error compileShaderProgramInternal(CString fname, ShaderProgramFilesystemInterfa
 		binary.m_variants.setArray(firstVariant, size);
 
 		ShaderProgramBinaryCodeBlock* firstCodeBlock;
-		codeBlocks.moveAndReset(firstCodeBlock, size, storage);
+		codeBlockStorage.m_codeBlocks.moveAndReset(firstCodeBlock, size, storage);
 		binary.m_codeBlocks.setArray(firstCodeBlock, size);
 
 		ShaderProgramBinaryMutation* firstMutation;
@@ -954,22 +1065,19 @@ Error compileShaderProgramInternal(CString fname, ShaderProgramFilesystemInterfa
 	else
 	{
 		DynamicArrayAuto<MutatorValue> mutation(tempAllocator);
-		DynamicArrayAuto<ShaderProgramBinaryCodeBlock> codeBlocks(binaryAllocator);
-		DynamicArrayAuto<U64> codeBlockHashes(tempAllocator);
 
 		binary.m_variants.setArray(binaryAllocator.newInstance<ShaderProgramBinaryVariant>(), 1);
 
-		compileVariantAsync(mutation, parser, binary.m_variants[0], codeBlocks, codeBlockHashes, tempAllocator,
-							binaryAllocator, taskManager, mtx, errorAtomic);
+		compileVariantAsync(mutation, binary.m_variants[0], codeBlockStorage);
 
 		ANKI_CHECK(taskManager.joinTasks());
-		ANKI_CHECK(Error(errorAtomic.getNonAtomically()));
+		ANKI_CHECK(Error(codeBlockStorage.m_err.getNonAtomically()));
 
-		ANKI_ASSERT(codeBlocks.getSize() == U32(__builtin_popcount(U32(parser.getShaderTypes()))));
+		ANKI_ASSERT(codeBlockStorage.m_codeBlocks.getSize() == U32(__builtin_popcount(U32(parser.getShaderTypes()))));
 
 		ShaderProgramBinaryCodeBlock* firstCodeBlock;
 		U32 size, storage;
-		codeBlocks.moveAndReset(firstCodeBlock, size, storage);
+		codeBlockStorage.m_codeBlocks.moveAndReset(firstCodeBlock, size, storage);
 		binary.m_codeBlocks.setArray(firstCodeBlock, size);
 
 		binary.m_mutations.setArray(binaryAllocator.newInstance<ShaderProgramBinaryMutation>(), 1);
@@ -1007,12 +1115,12 @@ Error compileShaderProgramInternal(CString fname, ShaderProgramFilesystemInterfa
 
 Error compileShaderProgram(CString fname, ShaderProgramFilesystemInterface& fsystem,
 						   ShaderProgramPostParseInterface* postParseCallback,
-						   ShaderProgramAsyncTaskInterface* taskManager, GenericMemoryPoolAllocator<U8> tempAllocator,
-						   const GpuDeviceCapabilities& gpuCapabilities, const BindlessLimits& bindlessLimits,
-						   ShaderProgramBinaryWrapper& binaryW)
+						   ShaderProgramAsyncTaskInterface* taskManager, ShaderProgramSpirvCacheInterface* spirvCache,
+						   GenericMemoryPoolAllocator<U8> tempAllocator, const GpuDeviceCapabilities& gpuCapabilities,
+						   const BindlessLimits& bindlessLimits, ShaderProgramBinaryWrapper& binaryW)
 {
-	const Error err = compileShaderProgramInternal(fname, fsystem, postParseCallback, taskManager, tempAllocator,
-												   gpuCapabilities, bindlessLimits, binaryW);
+	const Error err = compileShaderProgramInternal(fname, fsystem, postParseCallback, taskManager, spirvCache,
+												   tempAllocator, gpuCapabilities, bindlessLimits, binaryW);
 	if(err)
 	{
 		ANKI_SHADER_COMPILER_LOGE("Failed to compile: %s", fname.cstr());
@@ -24,6 +24,7 @@ class ShaderProgramBinaryWrapper : public NonCopyable
 	friend Error compileShaderProgramInternal(CString fname, ShaderProgramFilesystemInterface& fsystem,
 											  ShaderProgramPostParseInterface* postParseCallback,
 											  ShaderProgramAsyncTaskInterface* taskManager,
+											  ShaderProgramSpirvCacheInterface* spirvCache,
 											  GenericMemoryPoolAllocator<U8> tempAllocator,
 											  const GpuDeviceCapabilities& gpuCapabilities,
 											  const BindlessLimits& bindlessLimits, ShaderProgramBinaryWrapper& binary);
@@ -58,9 +59,12 @@ private:
 };
 
 /// Takes an AnKi special shader program and spits a binary.
+/// @param spirvCache Optional. If it's present the stages that have the same source with a cached one won't be
+///                   compiled.
 ANKI_USE_RESULT Error compileShaderProgram(CString fname, ShaderProgramFilesystemInterface& fsystem,
 										   ShaderProgramPostParseInterface* postParseCallback,
 										   ShaderProgramAsyncTaskInterface* taskManager,
+										   ShaderProgramSpirvCacheInterface* spirvCache,
 										   GenericMemoryPoolAllocator<U8> tempAllocator,
 										   const GpuDeviceCapabilities& gpuCapabilities,
 										   const BindlessLimits& bindlessLimits, ShaderProgramBinaryWrapper& binary);
@@ -142,6 +142,36 @@ void dumpShaderProgramBinary(const ShaderProgramBinary& binary, StringAuto& huma
 		lines.pushBack(ANKI_TAB "N/A\n");
 	}
 
+	// How well the identical SPIR-V got shared between the variants
+	lines.pushBack("\n**BINARY STATS**\n");
+	{
+		U32 stageCount = 0;
+		PtrSize sizeWithoutDedup = 0;
+		for(const ShaderProgramBinaryVariant& variant : binary.m_variants)
+		{
+			for(ShaderType shaderType : EnumIterable<ShaderType>())
+			{
+				if(variant.m_codeBlockIndices[shaderType] < MAX_U32)
+				{
+					++stageCount;
+					sizeWithoutDedup += binary.m_codeBlocks[variant.m_codeBlockIndices[shaderType]].m_binary.getSize();
+				}
+			}
+		}
+
+		PtrSize size = 0;
+		for(const ShaderProgramBinaryCodeBlock& code : binary.m_codeBlocks)
+		{
+			size += code.m_binary.getSize();
+		}
+
+		const U32 codeBlockCount = binary.m_codeBlocks.getSize();
+		lines.pushBackSprintf(ANKI_TAB "Variant stages %u, unique code blocks %u, dedup ratio %.2f\n", stageCount,
+							  codeBlockCount, (codeBlockCount) ? F32(stageCount) / F32(codeBlockCount) : 0.0f);
+		lines.pushBackSprintf(ANKI_TAB "SPIR-V size %" PRIu64 " bytes, %" PRIu64 " bytes without dedup\n", U64(size),
+							  U64(sizeWithoutDedup));
+	}
+
 	lines.pushBack("\n**BINARIES**\n");
 	U32 count = 0;
 	for(const ShaderProgramBinaryCodeBlock& code : binary.m_codeBlocks)
@@ -817,6 +817,25 @@ Error ShaderProgramParser::parseFile(CString fname, U32 depth)
 	StringAuto txt(m_alloc);
 	ANKI_CHECK(m_fsystem->readAllText(fname, txt));
 
+	// Remember the file. Files with pragma once might be included more than once
+	Bool newDependency = true;
+	for(const ShaderProgramDependency& dep : m_dependencies)
+	{
+		if(dep.m_filename == fname)
+		{
+			newDependency = false;
+			break;
+		}
+	}
+
+	if(newDependency)
+	{
+		m_dependencyFilenames.pushBack(fname);
+		ShaderProgramDependency& dep = *m_dependencies.emplaceBack();
+		dep.m_filename = m_dependencyFilenames.getBack().toCString();
+		dep.m_hash = computeDependencyHash(txt);
+	}
+
 	StringListAuto lines(m_alloc);
 	lines.splitString(txt.toCString(), '\n');
 	if(lines.getSize() < 1)
@@ -915,6 +934,13 @@ Error ShaderProgramParser::parse()
 	return Error::NONE;
 }
 
+U64 ShaderProgramParser::computeDependencyHash(CString source)
+{
+	// Seed with the header because it's part of every program but it's not a file
+	return (source.isEmpty()) ? SHADER_HEADER_HASH
+							  : appendHash(source.cstr(), source.getLength(), SHADER_HEADER_HASH);
+}
+
 void ShaderProgramParser::generateAnkiShaderHeader(ShaderType shaderType, const GpuDeviceCapabilities& caps,
 												   const BindlessLimits& limits, StringAuto& header)
 {
@@ -122,6 +122,16 @@ public:
 		return m_codeSourceHash;
 	}
 
+	/// Get the files that were read during parsing. The 1st is the program itself.
+	ConstWeakArray<ShaderProgramDependency> getDependencies() const
+	{
+		return m_dependencies;
+	}
+
+	/// Hash the contents of a file the same way the dependencies are hashed. If the hashes of all the dependencies of a
+	/// program are the same then the result of the parsing will be the same as well.
+	static U64 computeDependencyHash(CString source);
+
 	CString getLibraryName() const
 	{
 		return m_libName;
@@ -174,6 +184,9 @@ private:
 	StringAuto m_codeSource = {m_alloc};
 	U64 m_codeSourceHash = 0;
 
+	StringListAuto m_dependencyFilenames = {m_alloc};
+	DynamicArrayAuto<ShaderProgramDependency> m_dependencies = {m_alloc};
+
 	DynamicArrayAuto<Mutator> m_mutators = {m_alloc};
 	DynamicArrayAuto<MutationRewrite> m_mutationRewrites = {m_alloc};
 
@@ -15,6 +15,7 @@
 #include <AnKi/Util/WeakArray.h>
 #include <AnKi/Util/Enum.h>
 #include <AnKi/Util/File.h>
+#include <AnKi/Util/MemoryMappedFile.h>
 #include <AnKi/Util/Filesystem.h>
 #include <AnKi/Util/Functions.h>
 #include <AnKi/Util/Hash.h>
@@ -33,9 +34,11 @@
 #include <AnKi/Util/Thread.h>
 #include <AnKi/Util/ThreadPool.h>
 #include <AnKi/Util/ThreadHive.h>
+#include <AnKi/Util/HierarchyUpdater.h>
 #include <AnKi/Util/Visitor.h>
 #include <AnKi/Util/INotify.h>
 #include <AnKi/Util/SparseArray.h>
+#include <AnKi/Util/LockFreeQueue.h>
 #include <AnKi/Util/ObjectAllocator.h>
 #include <AnKi/Util/Tracer.h>
 #include <AnKi/Util/Serializer.h>
@@ -406,6 +406,10 @@ using StackAllocator = GenericPoolAllocator<T, StackMemoryPool>;
 /// Allocator that uses a ChainMemoryPool
 template<typename T>
 using ChainAllocator = GenericPoolAllocator<T, ChainMemoryPool>;
+
+/// Allocator that uses a ThreadLocalStackMemoryPool
+template<typename T>
+using ThreadLocalStackAllocator = GenericPoolAllocator<T, ThreadLocalStackMemoryPool>;
 /// @}
 
 } // end namespace anki
@@ -4,6 +4,10 @@
 // http://www.anki3d.org/LICENSE
 
 #include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/Logger.h>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
 
 namespace anki
 {
@@ -44,4 +48,26 @@ void getFilepathFilename(const CString& filename, StringAuto& out)
 	}
 }
 
+Error renameFile(const CString& oldFilename, const CString& newFilename)
+{
+	if(std::rename(oldFilename.cstr(), newFilename.cstr()) != 0)
+	{
+		ANKI_UTIL_LOGE("rename() failed for \"%s\": %s", oldFilename.cstr(), strerror(errno));
+		return Error::FUNCTION_FAILED;
+	}
+
+	return Error::NONE;
+}
+
+Error removeFile(const CString& filename)
+{
+	if(std::remove(filename.cstr()) != 0)
+	{
+		ANKI_UTIL_LOGE("remove() failed for \"%s\": %s", filename.cstr(), strerror(errno));
+		return Error::FUNCTION_FAILED;
+	}
+
+	return Error::NONE;
+}
+
 } // end namespace anki
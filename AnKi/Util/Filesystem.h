@@ -43,11 +43,20 @@ ANKI_USE_RESULT Error removeDirectory(const CString& dir, GenericMemoryPoolAlloc
 /// Equivalent to: mkdir dir
 ANKI_USE_RESULT Error createDirectory(const CString& dir);
 
+/// Rename or move a file. On some platforms it fails if @a newFilename exists.
+ANKI_USE_RESULT Error renameFile(const CString& oldFilename, const CString& newFilename);
+
+/// Equivalent to: rm filename
+ANKI_USE_RESULT Error removeFile(const CString& filename);
+
 /// Get the home directory.
 /// Write the home directory to @a buff. The @a buffSize is the size of the @a buff. If the @buffSize is not enough the
 /// function will throw an exception.
 ANKI_USE_RESULT Error getHomeDirectory(StringAuto& out);
 
+/// Get the directory for temporary files. It doesn't have a trailing slash.
+ANKI_USE_RESULT Error getTempDirectory(StringAuto& out);
+
 /// Get the time the file was last modified.
 ANKI_USE_RESULT Error getFileModificationTime(CString filename, U32& year, U32& month, U32& day, U32& hour, U32& min,
 											  U32& second);
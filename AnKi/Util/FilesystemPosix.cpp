@@ -209,6 +209,25 @@ Error getHomeDirectory(StringAuto& out)
 	return Error::NONE;
 }
 
+Error getTempDirectory(StringAuto& out)
+{
+	const char* tmp = getenv("TMPDIR");
+	if(tmp == nullptr || tmp[0] == '\0')
+	{
+		tmp = "/tmp";
+	}
+
+	// Remove the trailing slash
+	PtrSize len = strlen(tmp);
+	if(len > 1 && tmp[len - 1] == '/')
+	{
+		--len;
+	}
+
+	out.create(tmp, tmp + len);
+	return Error::NONE;
+}
+
 Error getFileModificationTime(CString filename, U32& year, U32& month, U32& day, U32& hour, U32& min, U32& second)
 {
 	struct stat buff;
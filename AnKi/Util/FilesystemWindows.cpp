@@ -79,6 +79,26 @@ Error getHomeDirectory(StringAuto& out)
 	return Error::NONE;
 }
 
+Error getTempDirectory(StringAuto& out)
+{
+	char path[MAX_PATH];
+	DWORD len = GetTempPathA(MAX_PATH, path);
+	if(len == 0 || len > MAX_PATH)
+	{
+		ANKI_UTIL_LOGE("GetTempPath() failed");
+		return Error::FUNCTION_FAILED;
+	}
+
+	// Remove the trailing slash
+	if(len > 1 && (path[len - 1] == '\\' || path[len - 1] == '/'))
+	{
+		path[len - 1] = '\0';
+	}
+
+	out.create(path);
+	return Error::NONE;
+}
+
 static Error walkDirectoryTreeInternal(const CString& dir, void* userData, WalkDirectoryTreeCallback callback,
 									   U baseDirLen)
 {
@@ -8,7 +8,14 @@
 #include <AnKi/Util/Allocator.h>
 #include <AnKi/Util/Functions.h>
 #include <AnKi/Util/NonCopyable.h>
-#include <AnKi/Util/SparseArray.h>
+#include <AnKi/Util/String.h>
+#include <utility>
+
+#if ANKI_SIMD_SSE
+#	include <emmintrin.h>
+#elif ANKI_SIMD_NEON
+#	include <arm_neon.h>
+#endif
 
 namespace anki
 {
@@ -65,33 +72,273 @@ public:
 	}
 };
 
-/// Hash map template.
+/// Specialization for StringAuto keys. The LookupKey allows searching the map using CStrings without allocating a new
+/// string. Hashers can define a LookupKey to enable this kind of heterogeneous lookups.
+template<>
+class DefaultHasher<StringAuto>
+{
+public:
+	using LookupKey = CString;
+
+	U64 operator()(const CString& a) const
+	{
+		return a.computeHash();
+	}
+};
+
+/// Find the key type HashMap::find accepts. It's THasher::LookupKey if it exists or TKey otherwise.
+template<typename THasher, typename TKey>
+class HashMapLookupKey
+{
+private:
+	template<typename Y>
+	static typename Y::LookupKey* test(int);
+
+	template<typename Y>
+	static TKey* test(...);
+
+public:
+	using Type = typename RemovePointer<decltype(test<THasher>(0))>::Type;
+};
+
+/// A group of HashMap control bytes that can be probed at once.
+class HashMapControlGroup
+{
+public:
+	static constexpr U32 SIZE = 16;
+
+	static constexpr I8 EMPTY = -128;
+	static constexpr I8 DELETED = -2;
+
+	/// A mask with one bit per slot of the group.
+	class BitMask
+	{
+	public:
+		BitMask(U64 mask)
+			: m_mask(mask)
+		{
+		}
+
+		explicit operator Bool() const
+		{
+			return m_mask != 0;
+		}
+
+		/// Get the first slot in the mask.
+		U32 getLowest() const
+		{
+			ANKI_ASSERT(m_mask);
+			return U32(__builtin_ctzll(m_mask)) >> BIT_SHIFT;
+		}
+
+		/// Remove the first slot from the mask.
+		void removeLowest()
+		{
+			m_mask &= m_mask - 1;
+		}
+
+	private:
+#if ANKI_SIMD_NEON
+		static constexpr U32 BIT_SHIFT = 2; ///< NEON doesn't have movemask. Every slot gets a nibble.
+#else
+		static constexpr U32 BIT_SHIFT = 0;
+#endif
+		U64 m_mask;
+	};
+
+	explicit HashMapControlGroup(const I8* ctrl)
+	{
+#if ANKI_SIMD_SSE
+		m_ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#elif ANKI_SIMD_NEON
+		m_ctrl = vld1q_s8(ctrl);
+#else
+		memcpy(&m_ctrl[0], ctrl, SIZE);
+#endif
+	}
+
+	/// Get the slots with a specific control byte.
+	BitMask match(I8 h2) const
+	{
+#if ANKI_SIMD_SSE
+		return BitMask(U32(_mm_movemask_epi8(_mm_cmpeq_epi8(m_ctrl, _mm_set1_epi8(h2)))));
+#elif ANKI_SIMD_NEON
+		return neonMask(vceqq_s8(m_ctrl, vdupq_n_s8(h2)));
+#else
+		U64 mask = 0;
+		for(U32 i = 0; i < SIZE; ++i)
+		{
+			mask |= U64(m_ctrl[i] == h2) << i;
+		}
+		return BitMask(mask);
+#endif
+	}
+
+	/// Get the empty slots.
+	BitMask matchEmpty() const
+	{
+		return match(EMPTY);
+	}
+
+	/// Get the slots that are either empty or deleted. Those are the control bytes with the sign bit set.
+	BitMask matchEmptyOrDeleted() const
+	{
+#if ANKI_SIMD_SSE
+		return BitMask(U32(_mm_movemask_epi8(m_ctrl)));
+#elif ANKI_SIMD_NEON
+		return neonMask(vcltq_s8(m_ctrl, vdupq_n_s8(0)));
+#else
+		U64 mask = 0;
+		for(U32 i = 0; i < SIZE; ++i)
+		{
+			mask |= U64(m_ctrl[i] < 0) << i;
+		}
+		return BitMask(mask);
+#endif
+	}
+
+private:
+#if ANKI_SIMD_SSE
+	__m128i m_ctrl;
+#elif ANKI_SIMD_NEON
+	int8x16_t m_ctrl;
+
+	static BitMask neonMask(uint8x16_t cmp)
+	{
+		// Narrow every 16bit lane to 8bits. That leaves a nibble per byte. Then keep one bit per nibble
+		const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+		return BitMask(vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ull);
+	}
+#else
+	Array<I8, SIZE> m_ctrl;
+#endif
+};
+
+/// HashMap iterator.
+template<typename TValuePointer, typename TValueReference, typename THashMapPtr>
+class HashMapIterator
+{
+	template<typename, typename, typename>
+	friend class HashMap;
+
+	template<typename, typename, typename>
+	friend class HashMapIterator;
+
+public:
+	/// Default constructor.
+	HashMapIterator()
+		: m_map(nullptr)
+		, m_slot(MAX_U32)
+	{
+	}
+
+	/// Copy.
+	HashMapIterator(const HashMapIterator& b) = default;
+
+	/// Allow conversion from iterator to const iterator.
+	template<typename YValuePointer, typename YValueReference, typename YHashMapPtr>
+	HashMapIterator(const HashMapIterator<YValuePointer, YValueReference, YHashMapPtr>& b)
+		: m_map(b.m_map)
+		, m_slot(b.m_slot)
+	{
+	}
+
+	HashMapIterator(THashMapPtr map, U32 slot)
+		: m_map(map)
+		, m_slot(slot)
+	{
+		ANKI_ASSERT(map);
+	}
+
+	HashMapIterator& operator=(const HashMapIterator& b) = default;
+
+	TValueReference operator*() const
+	{
+		check();
+		return m_map->m_values[m_slot];
+	}
+
+	TValuePointer operator->() const
+	{
+		check();
+		return &m_map->m_values[m_slot];
+	}
+
+	HashMapIterator& operator++()
+	{
+		check();
+		m_slot = m_map->findNextFull(m_slot + 1);
+		return *this;
+	}
+
+	HashMapIterator operator++(int)
+	{
+		check();
+		HashMapIterator out = *this;
+		++(*this);
+		return out;
+	}
+
+	Bool operator==(const HashMapIterator& b) const
+	{
+		ANKI_ASSERT(m_map == b.m_map);
+		return m_slot == b.m_slot;
+	}
+
+	Bool operator!=(const HashMapIterator& b) const
+	{
+		return !(*this == b);
+	}
+
+	/// Get the key of the element.
+	const typename RemovePointer<THashMapPtr>::Type::Key& getKey() const
+	{
+		check();
+		return m_map->m_keys[m_slot];
+	}
+
+private:
+	THashMapPtr m_map;
+	U32 m_slot;
+
+	void check() const
+	{
+		ANKI_ASSERT(m_map);
+		ANKI_ASSERT(m_slot < m_map->m_capacity && m_map->m_ctrl[m_slot] >= 0);
+	}
+};
+
+/// Hash map template. It's an open addressing map that keeps a control byte per slot. The control byte holds 7 bits of
+/// the hash and the slots are probed in groups of HashMapControlGroup::SIZE using SIMD. The keys are stored and
+/// compared so hash collisions are safe.
+/// @note Inserting or erasing elements invalidates the iterators.
 template<typename TKey, typename TValue, typename THasher = DefaultHasher<TKey>>
 class HashMap
 {
+	template<typename, typename, typename>
+	friend class HashMapIterator;
+
 public:
 	// Typedefs
-	using SparseArrayType = SparseArray<TValue, U64>;
 	using Value = TValue;
 	using Key = TKey;
+	using LookupKey = typename HashMapLookupKey<THasher, TKey>::Type;
 	using Hasher = THasher;
-	using Iterator = typename SparseArrayType::Iterator;
-	using ConstIterator = typename SparseArrayType::ConstIterator;
+	using Iterator = HashMapIterator<TValue*, TValue&, HashMap*>;
+	using ConstIterator = HashMapIterator<const TValue*, const TValue&, const HashMap*>;
 
 	// Consts
-	/// @see SparseArray::INITIAL_STORAGE_SIZE
-	static constexpr U32 INITIAL_STORAGE_SIZE = SparseArrayType::INITIAL_STORAGE_SIZE;
-	/// @see SparseArray::LINEAR_PROBING_COUNT
-	static constexpr U32 LINEAR_PROBING_COUNT = SparseArrayType::LINEAR_PROBING_COUNT;
-	/// @see SparseArray::MAX_LOAD_FACTOR
-	static constexpr F32 MAX_LOAD_FACTOR = SparseArrayType::MAX_LOAD_FACTOR;
+	static constexpr U32 INITIAL_STORAGE_SIZE = 32; ///< The initial number of slots.
+	static constexpr F32 MAX_LOAD_FACTOR = 0.875f; ///< If storage is loaded more than that then increase it.
 
 	/// Default constructor.
-	/// @copy doc SparseArray::SparseArray
-	HashMap(U32 initialStorageSize = INITIAL_STORAGE_SIZE, U32 probeCount = LINEAR_PROBING_COUNT,
-			F32 maxLoadFactor = MAX_LOAD_FACTOR)
-		: m_sparseArr(initialStorageSize, probeCount, maxLoadFactor)
+	/// @param initialStorageSize The initial number of slots. It will be rounded up to a power of two.
+	/// @param maxLoadFactor      If storage is loaded more than maxLoadFactor then increase it.
+	HashMap(U32 initialStorageSize = INITIAL_STORAGE_SIZE, F32 maxLoadFactor = MAX_LOAD_FACTOR)
+		: m_initialStorageSize(max<U32>(nextPowerOfTwo(initialStorageSize), U32(HashMapControlGroup::SIZE)))
+		, m_maxLoadFactor(maxLoadFactor)
 	{
+		ANKI_ASSERT(maxLoadFactor > 0.5f && maxLoadFactor < 1.0f);
 	}
 
 	/// Move.
@@ -104,37 +351,49 @@ public:
 	/// @see HashMap::destroy
 	~HashMap()
 	{
+		ANKI_ASSERT(m_ctrl == nullptr && "Forgot to call destroy");
 	}
 
 	/// Move.
 	HashMap& operator=(HashMap&& b)
 	{
-		m_sparseArr = std::move(b.m_sparseArr);
+		ANKI_ASSERT(m_ctrl == nullptr && "Forgot to call destroy");
+
+		m_keys = b.m_keys;
+		m_values = b.m_values;
+		m_ctrl = b.m_ctrl;
+		m_capacity = b.m_capacity;
+		m_elementCount = b.m_elementCount;
+		m_deletedCount = b.m_deletedCount;
+		m_initialStorageSize = b.m_initialStorageSize;
+		m_maxLoadFactor = b.m_maxLoadFactor;
+
+		b.resetMembers();
 		return *this;
 	}
 
 	/// Get begin.
 	Iterator getBegin()
 	{
-		return m_sparseArr.getBegin();
+		return Iterator(this, findNextFull(0));
 	}
 
 	/// Get begin.
 	ConstIterator getBegin() const
 	{
-		return m_sparseArr.getBegin();
+		return ConstIterator(this, findNextFull(0));
 	}
 
 	/// Get end.
 	Iterator getEnd()
 	{
-		return m_sparseArr.getEnd();
+		return Iterator(this, MAX_U32);
 	}
 
 	/// Get end.
 	ConstIterator getEnd() const
 	{
-		return m_sparseArr.getEnd();
+		return ConstIterator(this, MAX_U32);
 	}
 
 	/// Get begin.
@@ -164,52 +423,103 @@ public:
 	/// Return true if map is empty.
 	Bool isEmpty() const
 	{
-		return m_sparseArr.isEmpty();
+		return m_elementCount == 0;
 	}
 
 	PtrSize getSize() const
 	{
-		return m_sparseArr.getSize();
+		return m_elementCount;
 	}
 
 	/// Destroy the list.
 	template<typename TAllocator>
-	void destroy(TAllocator alloc)
+	void destroy(TAllocator alloc);
+
+	/// Construct an element inside the map. If the key already exists the value will be replaced.
+	template<typename TAllocator, typename... TArgs>
+	Iterator emplace(TAllocator alloc, const TKey& key, TArgs&&... args);
+
+	/// Erase element.
+	template<typename TAllocator>
+	void erase(TAllocator alloc, Iterator it);
+
+	/// Find a value using a key.
+	Iterator find(const LookupKey& key)
 	{
-		m_sparseArr.destroy(alloc);
+		return Iterator(this, findInternal(key, THasher()(key)));
 	}
 
-	/// Construct an element inside the map.
-	template<typename TAllocator, typename... TArgs>
-	Iterator emplace(TAllocator alloc, const TKey& key, TArgs&&... args)
+	/// Find a value using a key.
+	ConstIterator find(const LookupKey& key) const
 	{
-		const U64 hash = THasher()(key);
-		return m_sparseArr.emplace(alloc, hash, std::forward<TArgs>(args)...);
+		return ConstIterator(this, findInternal(key, THasher()(key)));
 	}
 
-	/// Erase element.
+	/// Clone the map.
 	template<typename TAllocator>
-	void erase(TAllocator alloc, Iterator it)
+	void clone(TAllocator alloc, HashMap& b) const;
+
+protected:
+	TKey* m_keys = nullptr;
+	TValue* m_values = nullptr;
+	I8* m_ctrl = nullptr; ///< One control byte per slot. The first group is mirrored at the end.
+	U32 m_capacity = 0;
+	U32 m_elementCount = 0;
+	U32 m_deletedCount = 0;
+	U32 m_initialStorageSize = 0;
+	F32 m_maxLoadFactor = 0.0f;
+
+	void resetMembers()
 	{
-		m_sparseArr.erase(alloc, it);
+		m_keys = nullptr;
+		m_values = nullptr;
+		m_ctrl = nullptr;
+		m_capacity = 0;
+		m_elementCount = 0;
+		m_deletedCount = 0;
 	}
 
-	/// Find a value using a key.
-	Iterator find(const Key& key)
+	/// Scramble the hash since some hashers (eg the DefaultHasher<U64>) are the identity.
+	static U64 mixHash(U64 h)
 	{
-		const U64 hash = THasher()(key);
-		return m_sparseArr.find(hash);
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ull;
+		h ^= h >> 33;
+		return h;
 	}
 
-	/// Find a value using a key.
-	ConstIterator find(const Key& key) const
+	/// Set a control byte and its mirror.
+	void setControl(U32 slot, I8 ctrl)
 	{
-		const U64 hash = THasher()(key);
-		return m_sparseArr.find(hash);
+		m_ctrl[slot] = ctrl;
+		if(slot < HashMapControlGroup::SIZE)
+		{
+			m_ctrl[m_capacity + slot] = ctrl;
+		}
 	}
 
-protected:
-	SparseArrayType m_sparseArr;
+	U32 findNextFull(U32 slot) const
+	{
+		for(; slot < m_capacity; ++slot)
+		{
+			if(m_ctrl[slot] >= 0)
+			{
+				return slot;
+			}
+		}
+
+		return MAX_U32;
+	}
+
+	U32 findInternal(const LookupKey& key, U64 hash) const;
+
+	/// Find a slot to insert a key that is not in the map.
+	U32 findInsertSlot(U64 hash) const;
+
+	template<typename TAllocator>
+	void rehash(TAllocator& alloc, U32 newCapacity);
 };
 
 /// Hash map template with automatic cleanup.
@@ -220,10 +530,10 @@ public:
 	using Base = HashMap<TKey, TValue, THasher>;
 
 	/// Default constructor.
-	/// @copy doc SparseArray::SparseArray
+	/// @copydoc HashMap::HashMap
 	HashMapAuto(const GenericMemoryPoolAllocator<U8>& alloc, U32 initialStorageSize = Base::INITIAL_STORAGE_SIZE,
-				U32 probeCount = Base::LINEAR_PROBING_COUNT, F32 maxLoadFactor = Base::MAX_LOAD_FACTOR)
-		: Base(initialStorageSize, probeCount, maxLoadFactor)
+				F32 maxLoadFactor = Base::MAX_LOAD_FACTOR)
+		: Base(initialStorageSize, maxLoadFactor)
 		, m_alloc(alloc)
 	{
 	}
@@ -250,7 +560,8 @@ public:
 	/// Move.
 	HashMapAuto& operator=(HashMapAuto&& b)
 	{
-		std::move(*static_cast<HashMapAuto>(this));
+		destroy();
+		Base::operator=(std::move(b));
 		m_alloc = std::move(b.m_alloc);
 		return *this;
 	}
@@ -288,9 +599,11 @@ private:
 	{
 		destroy();
 		m_alloc = b.m_alloc;
-		b.m_sparseArr.clone(m_alloc, Base::m_sparseArr);
+		b.clone(m_alloc, *this);
 	}
 };
 /// @}
 
 } // end namespace anki
+
+#include <AnKi/Util/HashMap.inl.h>
@@ -0,0 +1,235 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Util/HashMap.h>
+
+namespace anki
+{
+
+template<typename TKey, typename TValue, typename THasher>
+template<typename TAllocator>
+void HashMap<TKey, TValue, THasher>::destroy(TAllocator alloc)
+{
+	if(m_ctrl)
+	{
+		for(U32 i = 0; i < m_capacity; ++i)
+		{
+			if(m_ctrl[i] >= 0)
+			{
+				m_keys[i].~TKey();
+				m_values[i].~TValue();
+			}
+		}
+
+		alloc.getMemoryPool().free(m_keys);
+		alloc.getMemoryPool().free(m_values);
+		alloc.getMemoryPool().free(m_ctrl);
+	}
+
+	resetMembers();
+}
+
+template<typename TKey, typename TValue, typename THasher>
+U32 HashMap<TKey, TValue, THasher>::findInternal(const LookupKey& key, U64 hash) const
+{
+	if(m_elementCount == 0)
+	{
+		return MAX_U32;
+	}
+
+	hash = mixHash(hash);
+	const I8 h2 = I8(hash & 0x7F);
+	const U32 mask = m_capacity - 1;
+	U32 pos = U32(hash >> 7) & mask;
+
+	for(U32 probe = 1; probe <= m_capacity / HashMapControlGroup::SIZE; ++probe)
+	{
+		const HashMapControlGroup group(m_ctrl + pos);
+
+		HashMapControlGroup::BitMask matches = group.match(h2);
+		while(matches)
+		{
+			const U32 slot = (pos + matches.getLowest()) & mask;
+			if(ANKI_LIKELY(key == m_keys[slot]))
+			{
+				return slot;
+			}
+
+			matches.removeLowest();
+		}
+
+		// An empty slot stops the probing since the key would have been placed there
+		if(group.matchEmpty())
+		{
+			break;
+		}
+
+		pos = (pos + probe * HashMapControlGroup::SIZE) & mask;
+	}
+
+	return MAX_U32;
+}
+
+template<typename TKey, typename TValue, typename THasher>
+U32 HashMap<TKey, TValue, THasher>::findInsertSlot(U64 hash) const
+{
+	const U32 mask = m_capacity - 1;
+	U32 pos = U32(hash >> 7) & mask;
+
+	for(U32 probe = 1;; ++probe)
+	{
+		ANKI_ASSERT(probe <= m_capacity / HashMapControlGroup::SIZE);
+		const HashMapControlGroup::BitMask free = HashMapControlGroup(m_ctrl + pos).matchEmptyOrDeleted();
+		if(free)
+		{
+			return (pos + free.getLowest()) & mask;
+		}
+
+		pos = (pos + probe * HashMapControlGroup::SIZE) & mask;
+	}
+
+	ANKI_ASSERT(0);
+	return MAX_U32;
+}
+
+template<typename TKey, typename TValue, typename THasher>
+template<typename TAllocator, typename... TArgs>
+typename HashMap<TKey, TValue, THasher>::Iterator HashMap<TKey, TValue, THasher>::emplace(TAllocator alloc,
+																						   const TKey& key,
+																						   TArgs&&... args)
+{
+	const U64 hash = THasher()(key);
+
+	U32 slot = findInternal(key, hash);
+	if(slot != MAX_U32)
+	{
+		// Same key was found, replace the value
+		m_values[slot].~TValue();
+		alloc.construct(&m_values[slot], std::forward<TArgs>(args)...);
+		return Iterator(this, slot);
+	}
+
+	if(m_capacity == 0)
+	{
+		rehash(alloc, m_initialStorageSize);
+	}
+	else if(F32(m_elementCount + m_deletedCount + 1) > F32(m_capacity) * m_maxLoadFactor)
+	{
+		// If the tombstones take a big part of the storage then rehashing in place is enough
+		const Bool grow = F32(m_elementCount + 1) > F32(m_capacity) * m_maxLoadFactor * 0.5f;
+		rehash(alloc, (grow) ? m_capacity * 2 : m_capacity);
+	}
+
+	const U64 mixedHash = mixHash(hash);
+	slot = findInsertSlot(mixedHash);
+	m_deletedCount -= (m_ctrl[slot] == HashMapControlGroup::DELETED) ? 1 : 0;
+	setControl(slot, I8(mixedHash & 0x7F));
+	alloc.construct(&m_keys[slot], key);
+	alloc.construct(&m_values[slot], std::forward<TArgs>(args)...);
+	++m_elementCount;
+
+	return Iterator(this, slot);
+}
+
+template<typename TKey, typename TValue, typename THasher>
+template<typename TAllocator>
+void HashMap<TKey, TValue, THasher>::erase(TAllocator alloc, Iterator it)
+{
+	ANKI_ASSERT(it.m_map == this);
+	it.check();
+	const U32 slot = it.m_slot;
+
+	m_keys[slot].~TKey();
+	m_values[slot].~TValue();
+
+	// Leave a tombstone. An empty slot would break the probing of the keys that were placed after this one
+	setControl(slot, HashMapControlGroup::DELETED);
+	--m_elementCount;
+	++m_deletedCount;
+
+	if(m_elementCount == 0)
+	{
+		// Nothing to probe so the tombstones can go away
+		memset(m_ctrl, HashMapControlGroup::EMPTY, m_capacity + HashMapControlGroup::SIZE);
+		m_deletedCount = 0;
+	}
+}
+
+template<typename TKey, typename TValue, typename THasher>
+template<typename TAllocator>
+void HashMap<TKey, TValue, THasher>::rehash(TAllocator& alloc, U32 newCapacity)
+{
+	ANKI_ASSERT(isPowerOfTwo(newCapacity) && newCapacity >= HashMapControlGroup::SIZE);
+
+	TKey* oldKeys = m_keys;
+	TValue* oldValues = m_values;
+	I8* oldCtrl = m_ctrl;
+	const U32 oldCapacity = m_capacity;
+
+	m_capacity = newCapacity;
+	m_deletedCount = 0;
+	m_keys = static_cast<TKey*>(alloc.getMemoryPool().allocate(newCapacity * sizeof(TKey), alignof(TKey)));
+	m_values = static_cast<TValue*>(alloc.getMemoryPool().allocate(newCapacity * sizeof(TValue), alignof(TValue)));
+	m_ctrl = static_cast<I8*>(alloc.getMemoryPool().allocate(newCapacity + HashMapControlGroup::SIZE, 1));
+	memset(m_ctrl, HashMapControlGroup::EMPTY, newCapacity + HashMapControlGroup::SIZE);
+
+	for(U32 i = 0; i < oldCapacity; ++i)
+	{
+		if(oldCtrl[i] < 0)
+		{
+			continue;
+		}
+
+		const U64 mixedHash = mixHash(THasher()(oldKeys[i]));
+		const U32 slot = findInsertSlot(mixedHash);
+		setControl(slot, I8(mixedHash & 0x7F));
+
+		alloc.construct(&m_keys[slot], std::move(oldKeys[i]));
+		alloc.construct(&m_values[slot], std::move(oldValues[i]));
+		oldKeys[i].~TKey();
+		oldValues[i].~TValue();
+	}
+
+	if(oldCtrl)
+	{
+		alloc.getMemoryPool().free(oldKeys);
+		alloc.getMemoryPool().free(oldValues);
+		alloc.getMemoryPool().free(oldCtrl);
+	}
+}
+
+template<typename TKey, typename TValue, typename THasher>
+template<typename TAllocator>
+void HashMap<TKey, TValue, THasher>::clone(TAllocator alloc, HashMap& b) const
+{
+	ANKI_ASSERT(b.m_ctrl == nullptr && "Forgot to call destroy");
+
+	b.m_initialStorageSize = m_initialStorageSize;
+	b.m_maxLoadFactor = m_maxLoadFactor;
+	if(m_ctrl == nullptr)
+	{
+		return;
+	}
+
+	// Keep the same slots. That way there is no need to re-hash
+	b.m_capacity = m_capacity;
+	b.m_elementCount = m_elementCount;
+	b.m_deletedCount = m_deletedCount;
+	b.m_keys = static_cast<TKey*>(alloc.getMemoryPool().allocate(m_capacity * sizeof(TKey), alignof(TKey)));
+	b.m_values = static_cast<TValue*>(alloc.getMemoryPool().allocate(m_capacity * sizeof(TValue), alignof(TValue)));
+	b.m_ctrl = static_cast<I8*>(alloc.getMemoryPool().allocate(m_capacity + HashMapControlGroup::SIZE, 1));
+	memcpy(b.m_ctrl, m_ctrl, m_capacity + HashMapControlGroup::SIZE);
+
+	for(U32 i = 0; i < m_capacity; ++i)
+	{
+		if(m_ctrl[i] >= 0)
+		{
+			alloc.construct(&b.m_keys[i], m_keys[i]);
+			alloc.construct(&b.m_values[i], m_values[i]);
+		}
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,121 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Util/Hierarchy.h>
+#include <AnKi/Util/DynamicArray.h>
+#include <AnKi/Util/ThreadHive.h>
+
+namespace anki
+{
+
+/// @addtogroup util_patterns
+/// @{
+
+/// Updates a forest of Hierarchy objects using all the threads of a ThreadHive. The objects are updated level by level
+/// (breadth-first) so a parent is always updated before its children. The objects of a level are shared between the
+/// threads using an atomic cursor. Then the levels are visited again bottom-up for a post update so the post update of
+/// a parent happens after the post update of its children.
+/// @note It's meant to be re-created every frame with a per-frame allocator.
+template<typename T>
+class HierarchyUpdater : public NonCopyable
+{
+public:
+	/// @param alloc The allocator of the temporary arrays.
+	/// @param objectCountHint How many objects (roots and children) will be updated. Used to preallocate.
+	HierarchyUpdater(GenericMemoryPoolAllocator<U8> alloc, U32 objectCountHint = 0)
+		: m_objects(alloc)
+		, m_levels(alloc)
+		, m_cursors(alloc)
+	{
+		if(objectCountHint)
+		{
+			m_objects.resizeStorage(objectCountHint);
+		}
+	}
+
+	/// Add the root of a hierarchy. Its children will be added when update is called.
+	void addRoot(T* root)
+	{
+		ANKI_ASSERT(root && root->getParent() == nullptr);
+		ANKI_ASSERT(m_levels.getSize() == 0 && "Can't add roots after update");
+		m_objects.emplaceBack(root);
+	}
+
+	/// Update all the objects.
+	/// @tparam TUpdateFunc Signature: Error(*)(T& object). It's called for the parents before the children.
+	/// @tparam TPostUpdateFunc Signature: Error(*)(T& object). It's called for the children before the parents.
+	/// @param hive The hive to use.
+	/// @param updateFunc See TUpdateFunc.
+	/// @param postUpdateFunc See TPostUpdateFunc.
+	/// @param batchSize How many objects a thread will grab from a level at once.
+	/// @note It will call ThreadHive::waitAllTasks.
+	template<typename TUpdateFunc, typename TPostUpdateFunc>
+	ANKI_USE_RESULT Error update(ThreadHive& hive, TUpdateFunc updateFunc, TPostUpdateFunc postUpdateFunc,
+								 U32 batchSize = 8);
+
+	/// Get the number of levels of the deepest hierarchy. Valid after update.
+	U32 getLevelCount() const
+	{
+		return m_levels.getSize();
+	}
+
+private:
+	/// A range of m_objects.
+	class Level
+	{
+	public:
+		U32 m_begin;
+		U32 m_end;
+	};
+
+	/// Consecutive levels that are small enough to be processed by a single task are grouped together to avoid
+	/// waiting on a semaphore per level. Otherwise a stage has a single level.
+	template<typename TFunc>
+	class StageTaskCtx
+	{
+	public:
+		HierarchyUpdater* m_updater;
+		const TFunc* m_func;
+		Atomic<U32>* m_cursors; ///< One per level.
+		U32 m_firstLevel;
+		U32 m_levelCount;
+		Bool m_bottomUp;
+	};
+
+	DynamicArrayAuto<T*> m_objects; ///< All objects sorted by level.
+	DynamicArrayAuto<Level> m_levels;
+	DynamicArrayAuto<Atomic<U32>> m_cursors; ///< One per level and pass.
+	U32 m_batchSize = 0;
+	Atomic<I32> m_error = {Error::NONE};
+
+	/// Add the children of all roots.
+	void gatherLevels();
+
+	/// Create the tasks of one pass (top-down or bottom-up).
+	template<typename TFunc>
+	void submitPass(ThreadHive& hive, const TFunc& func, Bool bottomUp, ThreadHiveSemaphore*& prevSemaphore);
+
+	template<typename TFunc>
+	static void stageTaskCallback(void* ud, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem);
+
+	/// Get the i-th level a pass visits.
+	const Level& getPassLevel(U32 i, Bool bottomUp) const
+	{
+		return m_levels[(bottomUp) ? m_levels.getSize() - 1 - i : i];
+	}
+
+	U32 computeLevelTaskCount(const Level& level, U32 threadCount) const
+	{
+		const U32 objectCount = level.m_end - level.m_begin;
+		return min(threadCount, (objectCount + m_batchSize - 1) / m_batchSize);
+	}
+};
+/// @}
+
+} // end namespace anki
+
+#include <AnKi/Util/HierarchyUpdater.inl.h>
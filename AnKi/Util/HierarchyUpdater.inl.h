@@ -0,0 +1,162 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Util/HierarchyUpdater.h>
+
+namespace anki
+{
+
+template<typename T>
+void HierarchyUpdater<T>::gatherLevels()
+{
+	ANKI_ASSERT(m_levels.getSize() == 0);
+
+	// The roots are the 1st level. Then every level is formed by the children of the previous
+	U32 levelBegin = 0;
+	U32 levelEnd = m_objects.getSize();
+	while(levelBegin < levelEnd)
+	{
+		m_levels.emplaceBack(Level{levelBegin, levelEnd});
+
+		for(U32 i = levelBegin; i < levelEnd; ++i)
+		{
+			const Error err = m_objects[i]->visitChildrenMaxDepth(0, [this](T& child) -> Error {
+				m_objects.emplaceBack(&child);
+				return Error::NONE;
+			});
+			(void)err;
+		}
+
+		levelBegin = levelEnd;
+		levelEnd = m_objects.getSize();
+	}
+}
+
+template<typename T>
+template<typename TUpdateFunc, typename TPostUpdateFunc>
+Error HierarchyUpdater<T>::update(ThreadHive& hive, TUpdateFunc updateFunc, TPostUpdateFunc postUpdateFunc,
+								  U32 batchSize)
+{
+	ANKI_ASSERT(batchSize > 0);
+	m_batchSize = batchSize;
+	m_error.setNonAtomically(Error::NONE);
+
+	gatherLevels();
+	if(m_levels.getSize() == 0)
+	{
+		return Error::NONE;
+	}
+
+	// Don't use the hive's scratch memory for the cursors, deep hierarchies have too many levels
+	m_cursors.create(m_levels.getSize() * 2);
+
+	// Every stage waits for the previous so the post update pass starts after the update pass is done
+	ThreadHiveSemaphore* prevSemaphore = nullptr;
+	submitPass(hive, updateFunc, false, prevSemaphore);
+	submitPass(hive, postUpdateFunc, true, prevSemaphore);
+
+	hive.waitAllTasks();
+
+	return Error(m_error.load());
+}
+
+template<typename T>
+template<typename TFunc>
+void HierarchyUpdater<T>::submitPass(ThreadHive& hive, const TFunc& func, Bool bottomUp,
+									 ThreadHiveSemaphore*& prevSemaphore)
+{
+	const U32 threadCount = hive.getThreadCount();
+	const U32 levelCount = m_levels.getSize();
+
+	Atomic<U32>* cursors = &m_cursors[(bottomUp) ? levelCount : 0];
+
+	U32 stageBegin = 0;
+	while(stageBegin < levelCount)
+	{
+		// Group the levels that need a single task
+		const U32 taskCount = computeLevelTaskCount(getPassLevel(stageBegin, bottomUp), threadCount);
+		ANKI_ASSERT(taskCount > 0);
+
+		U32 stageEnd = stageBegin + 1;
+		if(taskCount == 1)
+		{
+			while(stageEnd < levelCount && computeLevelTaskCount(getPassLevel(stageEnd, bottomUp), threadCount) == 1)
+			{
+				++stageEnd;
+			}
+		}
+
+		// Create the task context
+		StageTaskCtx<TFunc>* ctx = static_cast<StageTaskCtx<TFunc>*>(
+			hive.allocateScratchMemory(sizeof(StageTaskCtx<TFunc>), alignof(StageTaskCtx<TFunc>)));
+		ctx->m_updater = this;
+		ctx->m_func = &func;
+		ctx->m_cursors = cursors;
+		ctx->m_firstLevel = stageBegin;
+		ctx->m_levelCount = stageEnd - stageBegin;
+		ctx->m_bottomUp = bottomUp;
+
+		for(U32 i = stageBegin; i < stageEnd; ++i)
+		{
+			cursors[i].setNonAtomically(0);
+		}
+
+		// Submit
+		ThreadHiveSemaphore* signalSemaphore = hive.newSemaphore(taskCount);
+
+		Array<ThreadHiveTask, ThreadHive::MAX_THREADS> tasks;
+		for(U32 i = 0; i < taskCount; ++i)
+		{
+			tasks[i].m_callback = stageTaskCallback<TFunc>;
+			tasks[i].m_argument = ctx;
+			tasks[i].m_waitSemaphore = prevSemaphore;
+			tasks[i].m_signalSemaphore = signalSemaphore;
+		}
+
+		hive.submitTasks(&tasks[0], taskCount);
+
+		prevSemaphore = signalSemaphore;
+		stageBegin = stageEnd;
+	}
+}
+
+template<typename T>
+template<typename TFunc>
+void HierarchyUpdater<T>::stageTaskCallback(void* ud, U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem)
+{
+	ANKI_ASSERT(ud);
+	StageTaskCtx<TFunc>& ctx = *static_cast<StageTaskCtx<TFunc>*>(ud);
+	HierarchyUpdater& self = *ctx.m_updater;
+	const U32 batchSize = self.m_batchSize;
+
+	for(U32 i = ctx.m_firstLevel; i < ctx.m_firstLevel + ctx.m_levelCount; ++i)
+	{
+		const Level& level = self.getPassLevel(i, ctx.m_bottomUp);
+		const U32 objectCount = level.m_end - level.m_begin;
+
+		U32 first;
+		while((first = ctx.m_cursors[i].fetchAdd(batchSize)) < objectCount)
+		{
+			// Stop updating if there was an error
+			if(self.m_error.load() != Error::NONE)
+			{
+				return;
+			}
+
+			const U32 end = min(first + batchSize, objectCount);
+			for(U32 j = first; j < end; ++j)
+			{
+				const Error err = (*ctx.m_func)(*self.m_objects[level.m_begin + j]);
+				if(err)
+				{
+					self.m_error.store(err._getCode());
+					return;
+				}
+			}
+		}
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,296 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Util/Atomic.h>
+#include <AnKi/Util/Allocator.h>
+#include <AnKi/Util/Functions.h>
+#include <utility>
+
+namespace anki
+{
+
+/// @addtogroup util_containers
+/// @{
+
+/// Bounded multi-producer multi-consumer queue. Every slot has a sequence number that tells the producers and the
+/// consumers if it's their turn to use the slot. It's Dmitry Vyukov's bounded MPMC queue.
+/// @note You need to manually create and destroy it.
+template<typename T>
+class MpmcQueue : public NonCopyable
+{
+public:
+	using Value = T;
+
+	MpmcQueue() = default;
+
+	~MpmcQueue()
+	{
+		ANKI_ASSERT(m_slots == nullptr && "Forgot to call destroy");
+	}
+
+	/// Allocate the storage.
+	/// @param capacity The max number of elements. It will be rounded up to a power of two.
+	template<typename TAllocator>
+	void create(TAllocator alloc, U32 capacity)
+	{
+		ANKI_ASSERT(m_slots == nullptr && capacity > 0);
+		capacity = nextPowerOfTwo(max(capacity, 2u));
+		m_mask = capacity - 1;
+
+		m_slots = static_cast<Slot*>(alloc.getMemoryPool().allocate(capacity * sizeof(Slot), alignof(Slot)));
+		for(U32 i = 0; i < capacity; ++i)
+		{
+			::new(&m_slots[i].m_sequence) Atomic<U32>(i);
+		}
+
+		m_pushPos.store(0);
+		m_popPos.store(0);
+	}
+
+	/// Destroy the queue and the elements that haven't been popped. It's not thread-safe.
+	template<typename TAllocator>
+	void destroy(TAllocator alloc)
+	{
+		if(m_slots)
+		{
+			for(U32 pos = m_popPos.load(); pos != m_pushPos.load(); ++pos)
+			{
+				reinterpret_cast<Value*>(&m_slots[pos & m_mask].m_storage[0])->~Value();
+			}
+
+			alloc.getMemoryPool().free(m_slots);
+			m_slots = nullptr;
+			m_mask = 0;
+		}
+	}
+
+	U32 getCapacity() const
+	{
+		return (m_slots) ? m_mask + 1 : 0;
+	}
+
+	/// Construct an element at the tail of the queue. It's thread-safe.
+	/// @return False if the queue is full.
+	template<typename... TArgs>
+	ANKI_USE_RESULT Bool tryPush(TArgs&&... args)
+	{
+		ANKI_ASSERT(m_slots);
+		U32 pos = m_pushPos.load();
+		Slot* slot;
+		while(true)
+		{
+			slot = &m_slots[pos & m_mask];
+			const U32 seq = slot->m_sequence.load(AtomicMemoryOrder::ACQUIRE);
+			const I32 diff = I32(seq - pos);
+			if(diff == 0)
+			{
+				// The slot is free, try to claim it
+				if(m_pushPos.compareExchange(pos, pos + 1))
+				{
+					break;
+				}
+			}
+			else if(diff < 0)
+			{
+				// The slot still holds an element from the previous lap. The queue is full
+				return false;
+			}
+			else
+			{
+				// Some other producer got it
+				pos = m_pushPos.load();
+			}
+		}
+
+		::new(&slot->m_storage[0]) Value(std::forward<TArgs>(args)...);
+		slot->m_sequence.store(pos + 1, AtomicMemoryOrder::RELEASE);
+		return true;
+	}
+
+	/// Remove an element from the head of the queue. It's thread-safe.
+	/// @return False if the queue is empty.
+	ANKI_USE_RESULT Bool tryPop(Value& out)
+	{
+		ANKI_ASSERT(m_slots);
+		U32 pos = m_popPos.load();
+		Slot* slot;
+		while(true)
+		{
+			slot = &m_slots[pos & m_mask];
+			const U32 seq = slot->m_sequence.load(AtomicMemoryOrder::ACQUIRE);
+			const I32 diff = I32(seq - (pos + 1));
+			if(diff == 0)
+			{
+				if(m_popPos.compareExchange(pos, pos + 1))
+				{
+					break;
+				}
+			}
+			else if(diff < 0)
+			{
+				// Nothing was pushed to that slot yet
+				return false;
+			}
+			else
+			{
+				pos = m_popPos.load();
+			}
+		}
+
+		Value& val = *reinterpret_cast<Value*>(&slot->m_storage[0]);
+		out = std::move(val);
+		val.~Value();
+		slot->m_sequence.store(pos + m_mask + 1, AtomicMemoryOrder::RELEASE);
+		return true;
+	}
+
+	/// Get an approximation of the element count. Other threads may change it while this runs.
+	U32 getApproximateSize() const
+	{
+		// The consumers might be ahead of the producers in the read so clamp it
+		const I32 diff = I32(m_pushPos.load() - m_popPos.load());
+		return U32(max(diff, 0));
+	}
+
+private:
+	class Slot
+	{
+	public:
+		Atomic<U32> m_sequence;
+		alignas(Value) U8 m_storage[sizeof(Value)];
+	};
+
+	Slot* m_slots = nullptr;
+	U32 m_mask = 0;
+
+	// Keep the positions in different cache lines since they are written by different threads
+	alignas(ANKI_CACHE_LINE_SIZE) Atomic<U32> m_pushPos{0};
+	alignas(ANKI_CACHE_LINE_SIZE) Atomic<U32> m_popPos{0};
+	U8 m_padding[ANKI_CACHE_LINE_SIZE - sizeof(Atomic<U32>)];
+};
+
+/// Bounded single-producer single-consumer ring buffer. It's cheaper than MpmcQueue since there is no contention on the
+/// positions.
+/// @note You need to manually create and destroy it.
+template<typename T>
+class SpscQueue : public NonCopyable
+{
+public:
+	using Value = T;
+
+	SpscQueue() = default;
+
+	~SpscQueue()
+	{
+		ANKI_ASSERT(m_storage == nullptr && "Forgot to call destroy");
+	}
+
+	/// Allocate the storage.
+	/// @param capacity The max number of elements. It will be rounded up to a power of two.
+	template<typename TAllocator>
+	void create(TAllocator alloc, U32 capacity)
+	{
+		ANKI_ASSERT(m_storage == nullptr && capacity > 0);
+		capacity = nextPowerOfTwo(max(capacity, 2u));
+		m_mask = capacity - 1;
+		m_storage = static_cast<Value*>(alloc.getMemoryPool().allocate(capacity * sizeof(Value), alignof(Value)));
+
+		m_pushPos.store(0);
+		m_popPos.store(0);
+		m_cachedPopPos = 0;
+		m_cachedPushPos = 0;
+	}
+
+	/// Destroy the queue and the elements that haven't been popped. It's not thread-safe.
+	template<typename TAllocator>
+	void destroy(TAllocator alloc)
+	{
+		if(m_storage)
+		{
+			for(U32 pos = m_popPos.load(); pos != m_pushPos.load(); ++pos)
+			{
+				m_storage[pos & m_mask].~Value();
+			}
+
+			alloc.getMemoryPool().free(m_storage);
+			m_storage = nullptr;
+			m_mask = 0;
+		}
+	}
+
+	U32 getCapacity() const
+	{
+		return (m_storage) ? m_mask + 1 : 0;
+	}
+
+	/// Construct an element at the tail of the queue. Only one thread is allowed to push.
+	/// @return False if the queue is full.
+	template<typename... TArgs>
+	ANKI_USE_RESULT Bool tryPush(TArgs&&... args)
+	{
+		ANKI_ASSERT(m_storage);
+		const U32 pos = m_pushPos.load();
+		if(pos - m_cachedPopPos > m_mask)
+		{
+			// Looks full, get the real position of the consumer
+			m_cachedPopPos = m_popPos.load(AtomicMemoryOrder::ACQUIRE);
+			if(pos - m_cachedPopPos > m_mask)
+			{
+				return false;
+			}
+		}
+
+		::new(&m_storage[pos & m_mask]) Value(std::forward<TArgs>(args)...);
+		m_pushPos.store(pos + 1, AtomicMemoryOrder::RELEASE);
+		return true;
+	}
+
+	/// Remove an element from the head of the queue. Only one thread is allowed to pop.
+	/// @return False if the queue is empty.
+	ANKI_USE_RESULT Bool tryPop(Value& out)
+	{
+		ANKI_ASSERT(m_storage);
+		const U32 pos = m_popPos.load();
+		if(pos == m_cachedPushPos)
+		{
+			// Looks empty, get the real position of the producer
+			m_cachedPushPos = m_pushPos.load(AtomicMemoryOrder::ACQUIRE);
+			if(pos == m_cachedPushPos)
+			{
+				return false;
+			}
+		}
+
+		Value& val = m_storage[pos & m_mask];
+		out = std::move(val);
+		val.~Value();
+		m_popPos.store(pos + 1, AtomicMemoryOrder::RELEASE);
+		return true;
+	}
+
+	/// Get an approximation of the element count. Other threads may change it while this runs.
+	U32 getApproximateSize() const
+	{
+		return m_pushPos.load() - m_popPos.load();
+	}
+
+private:
+	Value* m_storage = nullptr;
+	U32 m_mask = 0;
+
+	// The producer's data
+	alignas(ANKI_CACHE_LINE_SIZE) Atomic<U32> m_pushPos{0};
+	U32 m_cachedPopPos = 0; ///< The last m_popPos the producer saw.
+
+	// The consumer's data
+	alignas(ANKI_CACHE_LINE_SIZE) Atomic<U32> m_popPos{0};
+	U32 m_cachedPushPos = 0; ///< The last m_pushPos the consumer saw.
+	U8 m_padding[ANKI_CACHE_LINE_SIZE - sizeof(Atomic<U32>) - sizeof(U32)];
+};
+/// @}
+
+} // end namespace anki
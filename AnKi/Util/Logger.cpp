@@ -6,7 +6,11 @@
 #include <AnKi/Util/File.h>
 #include <AnKi/Util/Logger.h>
 #include <AnKi/Util/System.h>
+#include <AnKi/Util/Allocator.h>
+#include <AnKi/Util/LockFreeQueue.h>
+#include <AnKi/Util/HighRezTimer.h>
 #include <cstdarg>
+#include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -22,13 +26,92 @@ namespace anki
 
 static const Array<const char*, static_cast<U>(LoggerMessageType::COUNT)> MSG_TEXT = {"I", "E", "W", "F"};
 
+/// A preformated message.
+class Logger::AsyncRecord
+{
+public:
+	const char* m_file;
+	const char* m_func;
+	const char* m_subsystem;
+	ThreadId m_tid;
+	I32 m_line;
+	LoggerMessageType m_type;
+	Array<char, 512 - 5 * sizeof(void*)> m_msg;
+};
+
+/// The ring buffer of a thread. The thread is the producer and the logger's thread (or whoever flushes) the consumer.
+class Logger::ThreadRing
+{
+public:
+	static constexpr U32 RECORD_COUNT = 256;
+
+	HeapAllocator<U8> m_alloc;
+	SpscQueue<AsyncRecord> m_queue;
+	ThreadRing* m_next = nullptr;
+	U32 m_loggerUuid;
+	Atomic<U32> m_refcount = {2}; ///< One for the logger and one for the thread.
+
+	ThreadRing(HeapAllocator<U8> alloc, U32 loggerUuid)
+		: m_alloc(alloc)
+		, m_loggerUuid(loggerUuid)
+	{
+		m_queue.create(m_alloc, RECORD_COUNT);
+	}
+
+	~ThreadRing()
+	{
+		m_queue.destroy(m_alloc);
+	}
+
+	static void release(ThreadRing* ring)
+	{
+		// Acquire-release since the next thread that will get the ring buffer needs to see the writes of this one
+		if(ring->m_refcount.fetchSub(1, AtomicMemoryOrder::ACQ_REL) == 1)
+		{
+			HeapAllocator<U8> alloc = ring->m_alloc;
+			alloc.deleteInstance(ring);
+		}
+	}
+};
+
+/// Holds a ring buffer for as long as the thread lives.
+class Logger::ThreadRingRef
+{
+public:
+	ThreadRing* m_ring = nullptr;
+
+	~ThreadRingRef()
+	{
+		if(m_ring)
+		{
+			ThreadRing::release(m_ring);
+		}
+	}
+};
+
+thread_local Logger::ThreadRingRef Logger::m_threadRing;
+
+static Atomic<U32> g_loggerUuid = {1};
+
 Logger::Logger()
+	: m_asyncThread("AnKiLogger")
+	, m_uuid(g_loggerUuid.fetchAdd(1))
 {
 	addMessageHandler(this, &defaultSystemMessageHandler);
 }
 
 Logger::~Logger()
 {
+	setAsync(false);
+
+	// The threads might still hold their rings
+	ThreadRing* ring = m_rings;
+	while(ring)
+	{
+		ThreadRing* next = ring->m_next;
+		ThreadRing::release(ring);
+		ring = next;
+	}
 }
 
 void Logger::addMessageHandler(void* data, LoggerMessageHandlerCallback callback)
@@ -37,8 +120,19 @@ void Logger::addMessageHandler(void* data, LoggerMessageHandlerCallback callback
 	m_handlers[m_handlersCount++] = Handler(data, callback);
 }
 
+void Logger::addFileMessageHandler(File* file)
+{
+	addMessageHandler(file, &fileMessageHandler);
+}
+
 void Logger::removeMessageHandler(void* data, LoggerMessageHandlerCallback callback)
 {
+	// The handler might go away after that. Give it the pending messages
+	if(m_async.load())
+	{
+		flush();
+	}
+
 	LockGuard<Mutex> lock(m_mutex);
 
 	U i;
@@ -62,6 +156,30 @@ void Logger::removeMessageHandler(void* data, LoggerMessageHandlerCallback callb
 
 void Logger::write(const char* file, int line, const char* func, const char* subsystem, LoggerMessageType type,
 				   ThreadId tid, const char* msg)
+{
+	if(canWriteAsync(type) && m_async.load()
+	   && tryWriteAsyncFormated(file, line, func, subsystem, type, tid, "%s", msg))
+	{
+		return;
+	}
+
+	// The message didn't go to the ring buffer. Write the pending ones first to keep the order. That also flushes
+	// everything before an error or a fatal
+	if(m_async.load())
+	{
+		flush();
+	}
+
+	writeSync(file, line, func, subsystem, type, tid, msg);
+
+	if(type == LoggerMessageType::FATAL)
+	{
+		abort();
+	}
+}
+
+void Logger::writeSync(const char* file, int line, const char* func, const char* subsystem, LoggerMessageType type,
+					   ThreadId tid, const char* msg)
 {
 	m_mutex.lock();
 
@@ -74,19 +192,27 @@ void Logger::write(const char* file, int line, const char* func, const char* sub
 	}
 
 	m_mutex.unlock();
-
-	if(type == LoggerMessageType::FATAL)
-	{
-		abort();
-	}
 }
 
 void Logger::writeFormated(const char* file, int line, const char* func, const char* subsystem, LoggerMessageType type,
 						   ThreadId tid, const char* fmt, ...)
 {
-	char buffer[1024 * 10];
 	va_list args;
 
+	if(canWriteAsync(type) && m_async.load())
+	{
+		va_start(args, fmt);
+		const Bool written = tryWriteAsync(file, line, func, subsystem, type, tid, fmt, args);
+		va_end(args);
+
+		if(written)
+		{
+			return;
+		}
+	}
+
+	char buffer[1024 * 10];
+
 	va_start(args, fmt);
 	I len = vsnprintf(buffer, sizeof(buffer), fmt, args);
 	if(len < 0)
@@ -117,6 +243,164 @@ void Logger::writeFormated(const char* file, int line, const char* func, const c
 	}
 }
 
+Bool Logger::tryWriteAsync(const char* file, int line, const char* func, const char* subsystem,
+						   LoggerMessageType type, ThreadId tid, const char* fmt, va_list args)
+{
+	ThreadRing* ring = getThreadRing();
+
+	AsyncRecord record;
+	const I len = vsnprintf(&record.m_msg[0], record.m_msg.getSize(), fmt, args);
+	if(len < 0 || len >= I(record.m_msg.getSize()))
+	{
+		// Too big, will go the slow way
+		return false;
+	}
+
+	record.m_file = file;
+	record.m_func = func;
+	record.m_subsystem = subsystem;
+	record.m_tid = tid;
+	record.m_line = line;
+	record.m_type = type;
+
+	if(!ring->m_queue.tryPush(record))
+	{
+		m_droppedMessageCount.fetchAdd(1);
+	}
+
+	return true;
+}
+
+Bool Logger::tryWriteAsyncFormated(const char* file, int line, const char* func, const char* subsystem,
+								   LoggerMessageType type, ThreadId tid, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const Bool written = tryWriteAsync(file, line, func, subsystem, type, tid, fmt, args);
+	va_end(args);
+	return written;
+}
+
+Logger::ThreadRing* Logger::getThreadRing()
+{
+	ThreadRing* ring = m_threadRing.m_ring;
+	if(ANKI_LIKELY(ring && ring->m_loggerUuid == m_uuid))
+	{
+		return ring;
+	}
+
+	if(ring)
+	{
+		// Belongs to an old logger
+		ThreadRing::release(ring);
+		m_threadRing.m_ring = nullptr;
+		ring = nullptr;
+	}
+
+	LockGuard<Mutex> lock(m_ringsMutex);
+
+	// Try to re-use the ring of a thread that has exited. The logger is the only owner of those
+	for(ThreadRing* it = m_rings; it; it = it->m_next)
+	{
+		if(it->m_refcount.load(AtomicMemoryOrder::ACQUIRE) == 1)
+		{
+			it->m_refcount.fetchAdd(1);
+			ring = it;
+			break;
+		}
+	}
+
+	if(!ring)
+	{
+		HeapAllocator<U8> alloc(allocAligned, nullptr);
+		ring = alloc.newInstance<ThreadRing>(alloc, m_uuid);
+		ring->m_next = m_rings;
+		m_rings = ring;
+	}
+
+	m_threadRing.m_ring = ring;
+	return ring;
+}
+
+U32 Logger::drainRings()
+{
+	LockGuard<Mutex> drainLock(m_drainMutex);
+
+	// New rings are added to the front and rings are never removed so the list can be iterated without the lock
+	ThreadRing* rings;
+	{
+		LockGuard<Mutex> lock(m_ringsMutex);
+		rings = m_rings;
+	}
+
+	U32 count = 0;
+	AsyncRecord record;
+	for(ThreadRing* ring = rings; ring; ring = ring->m_next)
+	{
+		while(ring->m_queue.tryPop(record))
+		{
+			writeSync(record.m_file, record.m_line, record.m_func, record.m_subsystem, record.m_type, record.m_tid,
+					  &record.m_msg[0]);
+			++count;
+		}
+	}
+
+	const U64 droppedCount = m_droppedMessageCount.load();
+	if(droppedCount != m_reportedDroppedMessageCount)
+	{
+		char msg[128];
+		snprintf(msg, sizeof(msg), "%" PRIu64 " log messages were dropped because the ring buffers were full",
+				 droppedCount - m_reportedDroppedMessageCount);
+		m_reportedDroppedMessageCount = droppedCount;
+
+		writeSync(ANKI_FILE, __LINE__, ANKI_FUNC, "UTIL", LoggerMessageType::WARNING, Thread::getCurrentThreadId(),
+				  msg);
+	}
+
+	return count;
+}
+
+void Logger::flush()
+{
+	drainRings();
+}
+
+void Logger::setAsync(Bool async)
+{
+	if(async == m_async.load())
+	{
+		return;
+	}
+
+	if(async)
+	{
+		m_quitAsyncThread.store(false);
+		m_asyncThread.start(this, [](ThreadCallbackInfo& info) -> Error {
+			Logger& self = *static_cast<Logger*>(info.m_userData);
+			while(!self.m_quitAsyncThread.load())
+			{
+				if(self.drainRings() == 0)
+				{
+					HighRezTimer::sleep(ASYNC_THREAD_SLEEP_TIME);
+				}
+			}
+
+			return Error::NONE;
+		});
+
+		m_async.store(true);
+	}
+	else
+	{
+		m_async.store(false);
+		m_quitAsyncThread.store(true);
+		const Error err = m_asyncThread.join();
+		(void)err;
+
+		drainRings();
+	}
+}
+
 void Logger::defaultSystemMessageHandler(void*, const LoggerMessageInfo& info)
 {
 #if ANKI_OS_LINUX
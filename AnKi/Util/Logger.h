@@ -8,6 +8,7 @@
 #include <AnKi/Config.h>
 #include <AnKi/Util/Singleton.h>
 #include <AnKi/Util/Thread.h>
+#include <cstdarg>
 
 namespace anki
 {
@@ -51,6 +52,9 @@ using LoggerMessageHandlerCallback = void (*)(void*, const LoggerMessageInfo& in
 /// thread safe.
 /// To add a new signal:
 /// @code logger.addMessageHandler((void*)obj, &function) @endcode
+/// In the asynchronous mode the messages are formated on the calling thread and pushed to a per-thread ring buffer. A
+/// background thread passes them to the handlers. If a ring buffer is full the message is dropped. Errors and fatal
+/// messages are never deferred or dropped, they flush the pending messages and go to the handlers right away.
 class Logger
 {
 public:
@@ -77,7 +81,31 @@ public:
 	void writeFormated(const char* file, int line, const char* func, const char* subsystem, LoggerMessageType type,
 					   ThreadId tid, const char* fmt, ...);
 
+	/// Enable or disable the asynchronous mode. Disabling it will flush all the pending messages.
+	void setAsync(Bool async);
+
+	Bool isAsync() const
+	{
+		return m_async.load();
+	}
+
+	/// Pass all the pending messages of the asynchronous mode to the handlers. It's thread-safe.
+	void flush();
+
+	/// Get the number of messages that were dropped because some ring buffer was full.
+	U64 getDroppedMessageCount() const
+	{
+		return m_droppedMessageCount.load();
+	}
+
+	/// The handler that prints to the terminal. It's added by default.
+	static void defaultSystemMessageHandler(void*, const LoggerMessageInfo& info);
+
 private:
+	class ThreadRing;
+	class ThreadRingRef;
+	class AsyncRecord;
+
 	class Handler
 	{
 	public:
@@ -95,12 +123,52 @@ private:
 		}
 	};
 
+	static constexpr Second ASYNC_THREAD_SLEEP_TIME = 1.0 / 1000.0;
+
 	Mutex m_mutex; ///< For thread safety
 	Array<Handler, 4> m_handlers;
 	U32 m_handlersCount = 0;
 
-	static void defaultSystemMessageHandler(void*, const LoggerMessageInfo& info);
+	// Async mode
+	Atomic<Bool> m_async{false};
+	Atomic<Bool> m_quitAsyncThread{false};
+	Thread m_asyncThread;
+	Mutex m_drainMutex; ///< Only one thread at a time can consume the ring buffers.
+	Mutex m_ringsMutex; ///< Protects the list of ring buffers.
+	ThreadRing* m_rings = nullptr; ///< A list of ring buffers. One per thread that logged something.
+	U32 m_uuid; ///< Used to know if the ring buffer of a thread belongs to this logger.
+	Atomic<U64> m_droppedMessageCount{0};
+	U64 m_reportedDroppedMessageCount = 0;
+
+	static thread_local ThreadRingRef m_threadRing;
+
 	static void fileMessageHandler(void* file, const LoggerMessageInfo& info);
+
+	/// Only the normal messages and the warnings are allowed to be deferred or dropped.
+	static Bool canWriteAsync(LoggerMessageType type)
+	{
+		return type == LoggerMessageType::NORMAL || type == LoggerMessageType::WARNING;
+	}
+
+	/// Write to the handlers on the calling thread.
+	void writeSync(const char* file, int line, const char* func, const char* subsystem, LoggerMessageType type,
+				   ThreadId tid, const char* msg);
+
+	/// Try to write the message to the ring buffer of the current thread.
+	/// @return False if the message can't be written asynchronously.
+	Bool tryWriteAsync(const char* file, int line, const char* func, const char* subsystem, LoggerMessageType type,
+					   ThreadId tid, const char* fmt, va_list args);
+
+	/// @copydoc tryWriteAsync
+	ANKI_CHECK_FORMAT(7, 8)
+	Bool tryWriteAsyncFormated(const char* file, int line, const char* func, const char* subsystem,
+							   LoggerMessageType type, ThreadId tid, const char* fmt, ...);
+
+	ThreadRing* getThreadRing();
+
+	/// Pass the messages of all ring buffers to the handlers.
+	/// @return The number of messages.
+	U32 drainRings();
 };
 
 using LoggerSingleton = Singleton<Logger>;
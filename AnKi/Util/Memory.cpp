@@ -460,6 +460,153 @@ PtrSize StackMemoryPool::getMemoryCapacity() const
 	return sum;
 }
 
+/// The memory a thread allocates from. Every arena is on its own cache line.
+class alignas(ANKI_CACHE_LINE_SIZE) ThreadLocalStackMemoryPool::Arena
+{
+public:
+	U8* m_top = nullptr;
+	U8* m_end = nullptr;
+	ThreadId m_thread = 0;
+	Arena* m_next = nullptr;
+};
+
+class ThreadLocalStackMemoryPool::ThreadCache
+{
+public:
+	static constexpr U32 SIZE = 8;
+
+	Array<U64, SIZE> m_poolUuids;
+	Array<Arena*, SIZE> m_arenas;
+	U32 m_nextSlot;
+};
+
+thread_local ThreadLocalStackMemoryPool::ThreadCache ThreadLocalStackMemoryPool::m_threadCache;
+
+static Atomic<U64> g_threadLocalStackMemoryPoolUuid = {1};
+
+ThreadLocalStackMemoryPool::ThreadLocalStackMemoryPool()
+	: BaseMemoryPool(Type::THREAD_LOCAL_STACK)
+{
+}
+
+ThreadLocalStackMemoryPool::~ThreadLocalStackMemoryPool()
+{
+	Arena* arena = m_arenas;
+	while(arena)
+	{
+		Arena* next = arena->m_next;
+		arena->~Arena();
+		m_allocCb(m_allocCbUserData, arena, 0, 0);
+		arena = next;
+	}
+}
+
+void ThreadLocalStackMemoryPool::init(AllocAlignedCallback allocCb, void* allocCbUserData, PtrSize initialChunkSize,
+									  F32 nextChunkScale, PtrSize nextChunkBias, PtrSize blockSize)
+{
+	ANKI_ASSERT(!isInitialized());
+	ANKI_ASSERT(allocCb);
+	ANKI_ASSERT(blockSize > 0);
+
+	m_allocCb = allocCb;
+	m_allocCbUserData = allocCbUserData;
+	m_blockSize = min(blockSize, initialChunkSize);
+	m_uuid = g_threadLocalStackMemoryPoolUuid.fetchAdd(1);
+
+	m_stack.init(allocCb, allocCbUserData, initialChunkSize, nextChunkScale, nextChunkBias);
+}
+
+ThreadLocalStackMemoryPool::Arena& ThreadLocalStackMemoryPool::getThreadArena()
+{
+	ThreadCache& cache = m_threadCache;
+	for(U32 i = 0; i < ThreadCache::SIZE; ++i)
+	{
+		if(cache.m_poolUuids[i] == m_uuid)
+		{
+			return *cache.m_arenas[i];
+		}
+	}
+
+	// Not in the cache, find the arena of the thread or create a new one
+	const ThreadId tid = Thread::getCurrentThreadId();
+	Arena* arena = nullptr;
+	{
+		LockGuard<Mutex> lock(m_arenasMtx);
+
+		arena = m_arenas;
+		while(arena && arena->m_thread != tid)
+		{
+			arena = arena->m_next;
+		}
+
+		if(arena == nullptr)
+		{
+			void* mem = m_allocCb(m_allocCbUserData, nullptr, sizeof(Arena), alignof(Arena));
+			if(mem == nullptr)
+			{
+				ANKI_CREATION_OOM_ACTION();
+			}
+
+			arena = ::new(mem) Arena();
+			arena->m_thread = tid;
+			arena->m_next = m_arenas;
+			m_arenas = arena;
+		}
+	}
+
+	const U32 slot = cache.m_nextSlot++ % ThreadCache::SIZE;
+	cache.m_poolUuids[slot] = m_uuid;
+	cache.m_arenas[slot] = arena;
+
+	return *arena;
+}
+
+void* ThreadLocalStackMemoryPool::allocate(PtrSize size, PtrSize alignment)
+{
+	ANKI_ASSERT(isInitialized());
+	ANKI_ASSERT(size > 0 && alignment > 0);
+
+	if(ANKI_UNLIKELY(size + alignment > m_blockSize / 4))
+	{
+		// Too big for the blocks, go to the stack. Ask for more memory to be able to align it
+		void* mem = m_stack.allocate(size + alignment, ANKI_SAFE_ALIGNMENT);
+		return (mem) ? numberToPtr<void*>(getAlignedRoundUp(alignment, ptrToNumber(mem))) : nullptr;
+	}
+
+	Arena& arena = getThreadArena();
+	PtrSize out = getAlignedRoundUp(alignment, ptrToNumber(arena.m_top));
+
+	if(arena.m_top == nullptr || out + size > ptrToNumber(arena.m_end))
+	{
+		// Need a new block. The rest of the old one is wasted
+		U8* block = static_cast<U8*>(m_stack.allocate(m_blockSize, ANKI_SAFE_ALIGNMENT));
+		if(ANKI_UNLIKELY(block == nullptr))
+		{
+			ANKI_OOM_ACTION();
+			return nullptr;
+		}
+
+		arena.m_end = block + m_blockSize;
+		out = getAlignedRoundUp(alignment, ptrToNumber(block));
+	}
+
+	arena.m_top = numberToPtr<U8*>(out + size);
+	return numberToPtr<void*>(out);
+}
+
+void ThreadLocalStackMemoryPool::reset()
+{
+	ANKI_ASSERT(isInitialized());
+
+	m_stack.reset();
+
+	for(Arena* arena = m_arenas; arena; arena = arena->m_next)
+	{
+		arena->m_top = nullptr;
+		arena->m_end = nullptr;
+	}
+}
+
 ChainMemoryPool::ChainMemoryPool()
 	: BaseMemoryPool(Type::CHAIN)
 {
@@ -102,7 +102,8 @@ protected:
 		NONE,
 		HEAP,
 		STACK,
-		CHAIN
+		CHAIN,
+		THREAD_LOCAL_STACK
 	};
 
 	/// User allocation function.
@@ -262,6 +263,77 @@ private:
 	Mutex m_lock;
 };
 
+/// Thread safe memory pool that works like a StackMemoryPool without sharing an atomic between threads. Every thread
+/// takes big blocks from an internal StackMemoryPool and allocates from them without atomics. It's used in places where
+/// many threads allocate at the same time. The free() doesn't do anything and the allocations are not counted.
+class ThreadLocalStackMemoryPool final : public BaseMemoryPool
+{
+public:
+	/// Default constructor
+	ThreadLocalStackMemoryPool();
+
+	/// Destroy
+	~ThreadLocalStackMemoryPool();
+
+	/// Init with parameters
+	/// @param allocCb The allocation function callback
+	/// @param allocCbUserData The user data to pass to the allocation function
+	/// @param initialChunkSize The size of the first chunk of the StackMemoryPool.
+	/// @param nextChunkScale Value that controls the next chunk.
+	/// @param nextChunkBias Value that controls the next chunk.
+	/// @param blockSize The size of the blocks the threads allocate from. Bigger allocations than a quarter of that go
+	///        straight to the StackMemoryPool. It can't be bigger than initialChunkSize.
+	void init(AllocAlignedCallback allocCb, void* allocCbUserData, PtrSize initialChunkSize, F32 nextChunkScale = 2.0,
+			  PtrSize nextChunkBias = 0, PtrSize blockSize = 64_KB);
+
+	/// Allocate aligned memory. The operation is thread safe
+	/// @param size The size to allocate
+	/// @param alignmentBytes The alignment of the returned address
+	/// @return The allocated memory or nullptr on failure
+	void* allocate(PtrSize size, PtrSize alignmentBytes);
+
+	/// Free memory. It will not actially free anything.
+	/// @param[in, out] ptr Memory block to deallocate
+	void free(void* ptr)
+	{
+		(void)ptr;
+	}
+
+	/// Reinit the pool. All existing allocated memory will be lost. It's not thread safe.
+	void reset();
+
+	/// Get the current capacity of the pool. It's not thread safe.
+	PtrSize getMemoryCapacity() const
+	{
+		return m_stack.getMemoryCapacity();
+	}
+
+private:
+	class Arena;
+	class ThreadCache;
+
+	/// The pool that gives the blocks.
+	StackMemoryPool m_stack;
+
+	/// The size of the blocks.
+	PtrSize m_blockSize = 0;
+
+	/// Identifies the pool in the thread caches. Unlike the address of the pool it's never reused.
+	U64 m_uuid = 0;
+
+	/// The arenas of all threads.
+	Arena* m_arenas = nullptr;
+
+	/// Protect m_arenas.
+	Mutex m_arenasMtx;
+
+	/// The arenas of the pools the current thread used recently.
+	static thread_local ThreadCache m_threadCache;
+
+	/// Get the arena of the current thread.
+	Arena& getThreadArena();
+};
+
 /// Chain memory pool. Almost similar to StackMemoryPool but more flexible and at the same time a bit slower.
 class ChainMemoryPool final : public BaseMemoryPool
 {
@@ -373,6 +445,9 @@ inline void* BaseMemoryPool::allocate(PtrSize size, PtrSize alignmentBytes)
 	case Type::STACK:
 		out = static_cast<StackMemoryPool*>(this)->allocate(size, alignmentBytes);
 		break;
+	case Type::THREAD_LOCAL_STACK:
+		out = static_cast<ThreadLocalStackMemoryPool*>(this)->allocate(size, alignmentBytes);
+		break;
 	default:
 		ANKI_ASSERT(m_type == Type::CHAIN);
 		out = static_cast<ChainMemoryPool*>(this)->allocate(size, alignmentBytes);
@@ -391,6 +466,9 @@ inline void BaseMemoryPool::free(void* ptr)
 	case Type::STACK:
 		static_cast<StackMemoryPool*>(this)->free(ptr);
 		break;
+	case Type::THREAD_LOCAL_STACK:
+		static_cast<ThreadLocalStackMemoryPool*>(this)->free(ptr);
+		break;
 	default:
 		ANKI_ASSERT(m_type == Type::CHAIN);
 		static_cast<ChainMemoryPool*>(this)->free(ptr);
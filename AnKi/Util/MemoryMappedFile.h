@@ -0,0 +1,55 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Util/String.h>
+#include <AnKi/Util/WeakArray.h>
+
+namespace anki
+{
+
+/// @addtogroup util_file
+/// @{
+
+/// A read-only memory mapping of a file or a range of it.
+class MemoryMappedFile : public NonCopyable
+{
+public:
+	MemoryMappedFile() = default;
+
+	~MemoryMappedFile()
+	{
+		unmap();
+	}
+
+	/// Map a range of a file.
+	/// @param filename The file to map.
+	/// @param offset Where the range starts. It doesn't need to be aligned to the page size.
+	/// @param size The size of the range. If it's MAX_PTR_SIZE map till the end of the file.
+	ANKI_USE_RESULT Error map(CString filename, PtrSize offset = 0, PtrSize size = MAX_PTR_SIZE);
+
+	void unmap();
+
+	Bool isMapped() const
+	{
+		return m_data != nullptr;
+	}
+
+	/// Get the mapped range.
+	ConstWeakArray<U8, PtrSize> getData() const
+	{
+		return ConstWeakArray<U8, PtrSize>(m_data, m_size);
+	}
+
+private:
+	void* m_mapping = nullptr; ///< The start of the mapping. It's page aligned.
+	PtrSize m_mappingSize = 0;
+	const U8* m_data = nullptr;
+	PtrSize m_size = 0;
+};
+/// @}
+
+} // end namespace anki
@@ -0,0 +1,97 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+// For 64bit file offsets
+#define _FILE_OFFSET_BITS 64
+
+#include <AnKi/Util/MemoryMappedFile.h>
+#include <AnKi/Util/Functions.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace anki
+{
+
+Error MemoryMappedFile::map(CString filename, PtrSize offset, PtrSize size)
+{
+	ANKI_ASSERT(!isMapped() && "Already mapped");
+
+	const int fd = open(filename.cstr(), O_RDONLY);
+	if(fd < 0)
+	{
+		ANKI_UTIL_LOGE("open() failed for \"%s\": %s", filename.cstr(), strerror(errno));
+		return Error::FILE_ACCESS;
+	}
+
+	struct stat s;
+	if(fstat(fd, &s) != 0)
+	{
+		ANKI_UTIL_LOGE("fstat() failed for \"%s\": %s", filename.cstr(), strerror(errno));
+		close(fd);
+		return Error::FILE_ACCESS;
+	}
+
+	const PtrSize fileSize = PtrSize(s.st_size);
+	if(size == MAX_PTR_SIZE)
+	{
+		size = (offset < fileSize) ? fileSize - offset : 0;
+	}
+
+	if(offset + size > fileSize)
+	{
+		ANKI_UTIL_LOGE("Trying to map a range that is outside of \"%s\"", filename.cstr());
+		close(fd);
+		return Error::USER_DATA;
+	}
+
+	if(size == 0)
+	{
+		// Can't map nothing. Point to something valid
+		close(fd);
+		static const U8 dummy = 0;
+		m_data = &dummy;
+		return Error::NONE;
+	}
+
+	// The offset of mmap needs to be page aligned
+	const PtrSize pageSize = PtrSize(sysconf(_SC_PAGE_SIZE));
+	const PtrSize alignedOffset = offset - (offset % pageSize);
+	m_mappingSize = size + (offset - alignedOffset);
+
+	m_mapping = mmap(nullptr, m_mappingSize, PROT_READ, MAP_PRIVATE, fd, off_t(alignedOffset));
+	close(fd);
+
+	if(m_mapping == MAP_FAILED)
+	{
+		ANKI_UTIL_LOGE("mmap() failed for \"%s\": %s", filename.cstr(), strerror(errno));
+		m_mapping = nullptr;
+		m_mappingSize = 0;
+		return Error::FUNCTION_FAILED;
+	}
+
+	m_data = static_cast<const U8*>(m_mapping) + (offset - alignedOffset);
+	m_size = size;
+
+	return Error::NONE;
+}
+
+void MemoryMappedFile::unmap()
+{
+	if(m_mapping)
+	{
+		munmap(m_mapping, m_mappingSize);
+	}
+
+	m_mapping = nullptr;
+	m_mappingSize = 0;
+	m_data = nullptr;
+	m_size = 0;
+}
+
+} // end namespace anki
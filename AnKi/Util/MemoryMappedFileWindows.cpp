@@ -0,0 +1,101 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Util/MemoryMappedFile.h>
+#include <AnKi/Util/Logger.h>
+#include <AnKi/Util/Win32Minimal.h>
+
+namespace anki
+{
+
+Error MemoryMappedFile::map(CString filename, PtrSize offset, PtrSize size)
+{
+	ANKI_ASSERT(!isMapped() && "Already mapped");
+
+	const HANDLE file = CreateFileA(filename.cstr(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+									FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		ANKI_UTIL_LOGE("CreateFileA() failed for \"%s\": %lu", filename.cstr(), GetLastError());
+		return Error::FILE_ACCESS;
+	}
+
+	LARGE_INTEGER s;
+	if(!GetFileSizeEx(file, &s))
+	{
+		ANKI_UTIL_LOGE("GetFileSizeEx() failed for \"%s\": %lu", filename.cstr(), GetLastError());
+		CloseHandle(file);
+		return Error::FILE_ACCESS;
+	}
+
+	const PtrSize fileSize = PtrSize(s.QuadPart);
+	if(size == MAX_PTR_SIZE)
+	{
+		size = (offset < fileSize) ? fileSize - offset : 0;
+	}
+
+	if(offset + size > fileSize)
+	{
+		ANKI_UTIL_LOGE("Trying to map a range that is outside of \"%s\"", filename.cstr());
+		CloseHandle(file);
+		return Error::USER_DATA;
+	}
+
+	if(size == 0)
+	{
+		// Can't map nothing. Point to something valid
+		CloseHandle(file);
+		static const U8 dummy = 0;
+		m_data = &dummy;
+		return Error::NONE;
+	}
+
+	const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if(mapping == nullptr)
+	{
+		ANKI_UTIL_LOGE("CreateFileMappingA() failed for \"%s\": %lu", filename.cstr(), GetLastError());
+		return Error::FUNCTION_FAILED;
+	}
+
+	// The offset of the view needs to be aligned to the allocation granularity
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	const PtrSize granularity = sysInfo.dwAllocationGranularity;
+	const PtrSize alignedOffset = offset - (offset % granularity);
+	m_mappingSize = size + (offset - alignedOffset);
+
+	// The view keeps the mapping alive so the handle can be closed
+	m_mapping = MapViewOfFile(mapping, FILE_MAP_READ, DWORD(U64(alignedOffset) >> 32U),
+							  DWORD(alignedOffset & 0xFFFFFFFFu), m_mappingSize);
+	CloseHandle(mapping);
+
+	if(m_mapping == nullptr)
+	{
+		ANKI_UTIL_LOGE("MapViewOfFile() failed for \"%s\": %lu", filename.cstr(), GetLastError());
+		m_mappingSize = 0;
+		return Error::FUNCTION_FAILED;
+	}
+
+	m_data = static_cast<const U8*>(m_mapping) + (offset - alignedOffset);
+	m_size = size;
+
+	return Error::NONE;
+}
+
+void MemoryMappedFile::unmap()
+{
+	if(m_mapping)
+	{
+		UnmapViewOfFile(m_mapping);
+	}
+
+	m_mapping = nullptr;
+	m_mappingSize = 0;
+	m_data = nullptr;
+	m_size = 0;
+}
+
+} // end namespace anki
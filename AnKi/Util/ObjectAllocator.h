@@ -6,6 +6,7 @@
 #pragma once
 
 #include <AnKi/Util/Array.h>
+#include <AnKi/Util/DynamicArray.h>
 
 namespace anki
 {
@@ -33,6 +34,7 @@ public:
 	~ObjectAllocator()
 	{
 		ANKI_ASSERT(m_chunksHead == nullptr && m_chunksTail == nullptr && "Forgot to deallocate");
+		ANKI_ASSERT(m_sortedChunks.getSize() == 0);
 	}
 
 	/// Allocate and construct a new object instance.
@@ -64,8 +66,15 @@ private:
 		Chunk* m_prev = nullptr;
 	};
 
+	/// The chunks that have free space are always before the full ones.
 	Chunk* m_chunksHead = nullptr;
 	Chunk* m_chunksTail = nullptr;
+
+	DynamicArray<Chunk*> m_sortedChunks; ///< The chunks sorted by address. Used to find the chunk of an object.
+
+	void unlinkChunk(Chunk* chunk);
+	void linkChunkFront(Chunk* chunk);
+	void linkChunkBack(Chunk* chunk);
 };
 
 /// Convenience wrapper for ObjectAllocator.
@@ -16,24 +16,9 @@ T* ObjectAllocator<T_OBJECT_SIZE, T_OBJECT_ALIGNMENT, T_OBJECTS_PER_CHUNK, TInde
 	static_assert(alignof(T) <= OBJECT_ALIGNMENT, "Wrong object alignment");
 	static_assert(sizeof(T) <= OBJECT_SIZE, "Wrong object size");
 
-	T* out = nullptr;
-
-	// Try find one in the chunks
+	// The chunks with free space are first so check only the head
 	Chunk* chunk = m_chunksHead;
-	while(chunk)
-	{
-		if(chunk->m_unusedCount > 0)
-		{
-			// Pop an element
-			--chunk->m_unusedCount;
-			out = reinterpret_cast<T*>(&chunk->m_objects[chunk->m_unusedStack[chunk->m_unusedCount]]);
-			break;
-		}
-
-		chunk = chunk->m_next;
-	}
-
-	if(out == nullptr)
+	if(chunk == nullptr || chunk->m_unusedCount == 0)
 	{
 		// Need to create a new chunk
 
@@ -46,24 +31,24 @@ T* ObjectAllocator<T_OBJECT_SIZE, T_OBJECT_ALIGNMENT, T_OBJECTS_PER_CHUNK, TInde
 			chunk->m_unusedStack[i] = OBJECTS_PER_CHUNK - (i + 1);
 		}
 
-		if(m_chunksTail)
-		{
-			ANKI_ASSERT(m_chunksHead);
-			chunk->m_prev = m_chunksTail;
-			m_chunksTail->m_next = chunk;
-			m_chunksTail = chunk;
-		}
-		else
-		{
-			m_chunksTail = m_chunksHead = chunk;
-		}
+		linkChunkFront(chunk);
 
-		// Allocate one object
-		out = reinterpret_cast<T*>(&chunk->m_objects[0]);
-		--chunk->m_unusedCount;
+		// Keep the chunks sorted
+		Chunk** it = std::lower_bound(m_sortedChunks.getBegin(), m_sortedChunks.getEnd(), chunk);
+		m_sortedChunks.emplaceAt(alloc, it, chunk);
 	}
 
-	ANKI_ASSERT(out);
+	// Pop an element
+	ANKI_ASSERT(chunk->m_unusedCount > 0);
+	--chunk->m_unusedCount;
+	T* out = reinterpret_cast<T*>(&chunk->m_objects[chunk->m_unusedStack[chunk->m_unusedCount]]);
+
+	// If it's full move it after the chunks with free space
+	if(chunk->m_unusedCount == 0 && chunk != m_chunksTail)
+	{
+		unlinkChunk(chunk);
+		linkChunkBack(chunk);
+	}
 
 	// Construct it
 	alloc.construct(out, std::forward<TArgs>(args)...);
@@ -81,62 +66,112 @@ void ObjectAllocator<T_OBJECT_SIZE, T_OBJECT_ALIGNMENT, T_OBJECTS_PER_CHUNK, TIn
 
 	ANKI_ASSERT(obj);
 
-	// Find the chunk the obj is in
+	// Find the chunk the obj is in. It's the last chunk that starts before the obj
 	const Object* const mem = reinterpret_cast<Object*>(obj);
-	Chunk* chunk = m_chunksHead;
-	while(chunk)
+	Chunk** it = std::upper_bound(m_sortedChunks.getBegin(), m_sortedChunks.getEnd(), mem,
+								  [](const Object* m, const Chunk* chunk) { return m < chunk->m_objects.getBegin(); });
+	ANKI_ASSERT(it != m_sortedChunks.getBegin());
+	--it;
+	Chunk* chunk = *it;
+	ANKI_ASSERT(mem >= chunk->m_objects.getBegin() && mem < chunk->m_objects.getEnd());
+	ANKI_ASSERT(chunk->m_unusedCount < OBJECTS_PER_CHUNK);
+
+	const U32 idx = U32(mem - chunk->m_objects.getBegin());
+
+	// Destroy the object
+	obj->~T();
+
+	// Remove from the chunk
+	const Bool wasFull = chunk->m_unusedCount == 0;
+	chunk->m_unusedStack[chunk->m_unusedCount] = idx;
+	++chunk->m_unusedCount;
+
+	if(chunk->m_unusedCount == OBJECTS_PER_CHUNK)
 	{
-		const Object* const begin = chunk->m_objects.getBegin();
-		const Object* const end = chunk->m_objects.getEnd();
-		if(mem >= begin && mem < end)
+		// Delete the chunk if it's empty
+		unlinkChunk(chunk);
+
+		const U32 sortedIdx = U32(it - m_sortedChunks.getBegin());
+		for(U32 i = sortedIdx + 1; i < m_sortedChunks.getSize(); ++i)
 		{
-			// Found it, remove it from the chunk and maybe delete the chunk
-
-			ANKI_ASSERT(chunk->m_unusedCount < OBJECTS_PER_CHUNK);
-			const U32 idx = U32(mem - begin);
-
-			// Destroy the object
-			obj->~T();
-
-			// Remove from the chunk
-			chunk->m_unusedStack[chunk->m_unusedCount] = idx;
-			++chunk->m_unusedCount;
-
-			// Delete the chunk if it's empty
-			if(chunk->m_unusedCount == OBJECTS_PER_CHUNK)
-			{
-				if(chunk == m_chunksTail)
-				{
-					m_chunksTail = chunk->m_prev;
-				}
-
-				if(chunk == m_chunksHead)
-				{
-					m_chunksHead = chunk->m_next;
-				}
-
-				if(chunk->m_prev)
-				{
-					ANKI_ASSERT(chunk->m_prev->m_next == chunk);
-					chunk->m_prev->m_next = chunk->m_next;
-				}
-
-				if(chunk->m_next)
-				{
-					ANKI_ASSERT(chunk->m_next->m_prev == chunk);
-					chunk->m_next->m_prev = chunk->m_prev;
-				}
-
-				alloc.deleteInstance(chunk);
-			}
-
-			break;
+			m_sortedChunks[i - 1] = m_sortedChunks[i];
 		}
+		m_sortedChunks.popBack(alloc);
+
+		alloc.deleteInstance(chunk);
+	}
+	else if(wasFull)
+	{
+		// It has free space now, move it with the rest of the chunks with free space
+		unlinkChunk(chunk);
+		linkChunkFront(chunk);
+	}
+}
+
+template<PtrSize T_OBJECT_SIZE, U32 T_OBJECT_ALIGNMENT, U32 T_OBJECTS_PER_CHUNK, typename TIndexType>
+void ObjectAllocator<T_OBJECT_SIZE, T_OBJECT_ALIGNMENT, T_OBJECTS_PER_CHUNK, TIndexType>::unlinkChunk(Chunk* chunk)
+{
+	ANKI_ASSERT(chunk);
 
-		chunk = chunk->m_next;
+	if(chunk == m_chunksTail)
+	{
+		m_chunksTail = chunk->m_prev;
+	}
+
+	if(chunk == m_chunksHead)
+	{
+		m_chunksHead = chunk->m_next;
+	}
+
+	if(chunk->m_prev)
+	{
+		ANKI_ASSERT(chunk->m_prev->m_next == chunk);
+		chunk->m_prev->m_next = chunk->m_next;
+	}
+
+	if(chunk->m_next)
+	{
+		ANKI_ASSERT(chunk->m_next->m_prev == chunk);
+		chunk->m_next->m_prev = chunk->m_prev;
+	}
+
+	chunk->m_prev = chunk->m_next = nullptr;
+}
+
+template<PtrSize T_OBJECT_SIZE, U32 T_OBJECT_ALIGNMENT, U32 T_OBJECTS_PER_CHUNK, typename TIndexType>
+void ObjectAllocator<T_OBJECT_SIZE, T_OBJECT_ALIGNMENT, T_OBJECTS_PER_CHUNK, TIndexType>::linkChunkFront(Chunk* chunk)
+{
+	ANKI_ASSERT(chunk && chunk->m_prev == nullptr && chunk->m_next == nullptr);
+
+	if(m_chunksHead)
+	{
+		ANKI_ASSERT(m_chunksTail);
+		chunk->m_next = m_chunksHead;
+		m_chunksHead->m_prev = chunk;
+		m_chunksHead = chunk;
 	}
+	else
+	{
+		m_chunksTail = m_chunksHead = chunk;
+	}
+}
 
-	ANKI_ASSERT(chunk != nullptr);
+template<PtrSize T_OBJECT_SIZE, U32 T_OBJECT_ALIGNMENT, U32 T_OBJECTS_PER_CHUNK, typename TIndexType>
+void ObjectAllocator<T_OBJECT_SIZE, T_OBJECT_ALIGNMENT, T_OBJECTS_PER_CHUNK, TIndexType>::linkChunkBack(Chunk* chunk)
+{
+	ANKI_ASSERT(chunk && chunk->m_prev == nullptr && chunk->m_next == nullptr);
+
+	if(m_chunksTail)
+	{
+		ANKI_ASSERT(m_chunksHead);
+		chunk->m_prev = m_chunksTail;
+		m_chunksTail->m_next = chunk;
+		m_chunksTail = chunk;
+	}
+	else
+	{
+		m_chunksTail = m_chunksHead = chunk;
+	}
 }
 
 } // end namespace anki
@@ -0,0 +1,234 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Util/DynamicArray.h>
+
+namespace anki
+{
+
+/// @addtogroup util_containers
+/// @{
+
+/// A stable handle to an element of a SlotMap. It stays the same for the lifetime of the element and gets invalidated
+/// when the element is erased.
+class SlotMapHandle
+{
+	template<typename>
+	friend class SlotMap;
+
+public:
+	SlotMapHandle() = default;
+
+	Bool isValid() const
+	{
+		return m_slot != MAX_U32;
+	}
+
+	Bool operator==(const SlotMapHandle& b) const
+	{
+		return m_slot == b.m_slot && m_generation == b.m_generation;
+	}
+
+	Bool operator!=(const SlotMapHandle& b) const
+	{
+		return !(*this == b);
+	}
+
+	U32 getSlot() const
+	{
+		return m_slot;
+	}
+
+	U32 getGeneration() const
+	{
+		return m_generation;
+	}
+
+private:
+	U32 m_slot = MAX_U32;
+	U32 m_generation = 0;
+};
+
+/// Slot map. Keeps the values tightly packed in an array so iteration is linear and gives out generational handles that
+/// survive the moves that happen on erase. Insertion, removal and lookup are O(1).
+/// @note The order of the values changes on erase.
+template<typename T>
+class SlotMap
+{
+public:
+	using Value = T;
+	using Iterator = Value*;
+	using ConstIterator = const Value*;
+
+	SlotMap() = default;
+
+	/// Non-copyable.
+	SlotMap(const SlotMap&) = delete;
+
+	/// Move.
+	SlotMap(SlotMap&& b)
+	{
+		*this = std::move(b);
+	}
+
+	~SlotMap()
+	{
+		ANKI_ASSERT(m_values.getSize() == 0 && m_slots.getSize() == 0 && "Forgot to call destroy");
+	}
+
+	/// Non-copyable.
+	SlotMap& operator=(const SlotMap&) = delete;
+
+	/// Move.
+	SlotMap& operator=(SlotMap&& b)
+	{
+		ANKI_ASSERT(m_values.getSize() == 0 && m_slots.getSize() == 0 && "Forgot to call destroy");
+		m_values = std::move(b.m_values);
+		m_valueSlots = std::move(b.m_valueSlots);
+		m_slots = std::move(b.m_slots);
+		m_freeSlotHead = b.m_freeSlotHead;
+		b.m_freeSlotHead = MAX_U32;
+		return *this;
+	}
+
+	Iterator getBegin()
+	{
+		return m_values.getBegin();
+	}
+
+	ConstIterator getBegin() const
+	{
+		return m_values.getBegin();
+	}
+
+	Iterator getEnd()
+	{
+		return m_values.getEnd();
+	}
+
+	ConstIterator getEnd() const
+	{
+		return m_values.getEnd();
+	}
+
+	Iterator begin()
+	{
+		return getBegin();
+	}
+
+	ConstIterator begin() const
+	{
+		return getBegin();
+	}
+
+	Iterator end()
+	{
+		return getEnd();
+	}
+
+	ConstIterator end() const
+	{
+		return getEnd();
+	}
+
+	/// Access the packed values. The index is not stable, use handles to refer to a value for longer.
+	Value& operator[](U32 idx)
+	{
+		return m_values[idx];
+	}
+
+	/// Access the packed values. The index is not stable, use handles to refer to a value for longer.
+	const Value& operator[](U32 idx) const
+	{
+		return m_values[idx];
+	}
+
+	U32 getSize() const
+	{
+		return m_values.getSize();
+	}
+
+	Bool isEmpty() const
+	{
+		return m_values.getSize() == 0;
+	}
+
+	/// Destroy the container and all its values.
+	template<typename TAllocator>
+	void destroy(TAllocator alloc);
+
+	/// Construct a new value.
+	/// @return The handle of the new value.
+	template<typename TAllocator, typename... TArgs>
+	SlotMapHandle emplace(TAllocator alloc, TArgs&&... args);
+
+	/// Remove a value. The last value will be moved to the place of the erased one.
+	template<typename TAllocator>
+	void erase(TAllocator alloc, SlotMapHandle handle);
+
+	/// Return true if the handle points to a live value.
+	Bool isValid(SlotMapHandle handle) const
+	{
+		return handle.m_slot < m_slots.getSize() && m_slots[handle.m_slot].m_generation == handle.m_generation
+			   && m_slots[handle.m_slot].m_valueIdx != MAX_U32;
+	}
+
+	/// Get a value. Returns nullptr if the handle is stale.
+	Value* tryGet(SlotMapHandle handle)
+	{
+		return (isValid(handle)) ? &m_values[m_slots[handle.m_slot].m_valueIdx] : nullptr;
+	}
+
+	/// Get a value. Returns nullptr if the handle is stale.
+	const Value* tryGet(SlotMapHandle handle) const
+	{
+		return (isValid(handle)) ? &m_values[m_slots[handle.m_slot].m_valueIdx] : nullptr;
+	}
+
+	/// Get the value of a handle that is known to be valid.
+	Value& get(SlotMapHandle handle)
+	{
+		ANKI_ASSERT(isValid(handle));
+		return m_values[m_slots[handle.m_slot].m_valueIdx];
+	}
+
+	/// Get the value of a handle that is known to be valid.
+	const Value& get(SlotMapHandle handle) const
+	{
+		ANKI_ASSERT(isValid(handle));
+		return m_values[m_slots[handle.m_slot].m_valueIdx];
+	}
+
+	/// Get the handle of a packed value.
+	SlotMapHandle getHandle(U32 idx) const
+	{
+		SlotMapHandle handle;
+		handle.m_slot = m_valueSlots[idx];
+		handle.m_generation = m_slots[handle.m_slot].m_generation;
+		return handle;
+	}
+
+private:
+	/// The indirection between handles and packed values.
+	class Slot
+	{
+	public:
+		U32 m_valueIdx; ///< Index in m_values or MAX_U32 if the slot is free.
+		U32 m_nextFree; ///< Next slot in the free list.
+		U32 m_generation;
+	};
+
+	DynamicArray<Value> m_values;
+	DynamicArray<U32> m_valueSlots; ///< The slot of every value in m_values.
+	DynamicArray<Slot> m_slots;
+	U32 m_freeSlotHead = MAX_U32;
+};
+/// @}
+
+} // end namespace anki
+
+#include <AnKi/Util/SlotMap.inl.h>
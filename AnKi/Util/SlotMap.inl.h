@@ -0,0 +1,80 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Util/SlotMap.h>
+
+namespace anki
+{
+
+template<typename T>
+template<typename TAllocator>
+void SlotMap<T>::destroy(TAllocator alloc)
+{
+	m_values.destroy(alloc);
+	m_valueSlots.destroy(alloc);
+	m_slots.destroy(alloc);
+	m_freeSlotHead = MAX_U32;
+}
+
+template<typename T>
+template<typename TAllocator, typename... TArgs>
+SlotMapHandle SlotMap<T>::emplace(TAllocator alloc, TArgs&&... args)
+{
+	// Get a slot
+	U32 slotIdx;
+	if(m_freeSlotHead != MAX_U32)
+	{
+		slotIdx = m_freeSlotHead;
+		m_freeSlotHead = m_slots[slotIdx].m_nextFree;
+	}
+	else
+	{
+		slotIdx = m_slots.getSize();
+		Slot& newSlot = *m_slots.emplaceBack(alloc);
+		newSlot.m_generation = 0;
+	}
+
+	Slot& slot = m_slots[slotIdx];
+	slot.m_valueIdx = m_values.getSize();
+	slot.m_nextFree = MAX_U32;
+
+	// Create the value
+	m_values.emplaceBack(alloc, std::forward<TArgs>(args)...);
+	m_valueSlots.emplaceBack(alloc, slotIdx);
+
+	SlotMapHandle handle;
+	handle.m_slot = slotIdx;
+	handle.m_generation = slot.m_generation;
+	return handle;
+}
+
+template<typename T>
+template<typename TAllocator>
+void SlotMap<T>::erase(TAllocator alloc, SlotMapHandle handle)
+{
+	ANKI_ASSERT(isValid(handle));
+	Slot& slot = m_slots[handle.m_slot];
+	const U32 valueIdx = slot.m_valueIdx;
+	const U32 lastValueIdx = m_values.getSize() - 1;
+
+	// Move the last value to the hole
+	if(valueIdx != lastValueIdx)
+	{
+		m_values[valueIdx] = std::move(m_values[lastValueIdx]);
+		m_valueSlots[valueIdx] = m_valueSlots[lastValueIdx];
+		m_slots[m_valueSlots[valueIdx]].m_valueIdx = valueIdx;
+	}
+
+	m_values.popBack(alloc);
+	m_valueSlots.popBack(alloc);
+
+	// Retire the slot. Bumping the generation invalidates all handles that point to it
+	slot.m_valueIdx = MAX_U32;
+	++slot.m_generation;
+	slot.m_nextFree = m_freeSlotHead;
+	m_freeSlotHead = handle.m_slot;
+}
+
+} // end namespace anki
@@ -0,0 +1,79 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Util/StringId.h>
+#include <AnKi/Util/HashMap.h>
+#include <AnKi/Util/Thread.h>
+#include <AnKi/Util/Logger.h>
+
+namespace anki
+{
+
+namespace
+{
+
+class StringIdRegistryStorage
+{
+public:
+	HeapAllocator<U8> m_alloc;
+	HashMap<StringId, String> m_strings;
+	Mutex m_mtx;
+
+	StringIdRegistryStorage()
+		: m_alloc(allocAligned, nullptr)
+	{
+	}
+
+	~StringIdRegistryStorage()
+	{
+		for(String& str : m_strings)
+		{
+			str.destroy(m_alloc);
+		}
+		m_strings.destroy(m_alloc);
+	}
+};
+
+} // end anonymous namespace
+
+static StringIdRegistryStorage& getStorage()
+{
+	static StringIdRegistryStorage storage;
+	return storage;
+}
+
+StringId StringIdRegistry::registerString(CString str)
+{
+	const StringId id(str);
+	StringIdRegistryStorage& storage = getStorage();
+
+	LockGuard<Mutex> lock(storage.m_mtx);
+	auto it = storage.m_strings.find(id);
+	if(it == storage.m_strings.getEnd())
+	{
+		String copy;
+		copy.create(storage.m_alloc, str);
+		storage.m_strings.emplace(storage.m_alloc, id, std::move(copy));
+	}
+#if ANKI_EXTRA_CHECKS
+	else if(it->toCString() != str)
+	{
+		ANKI_UTIL_LOGF("StringId collision between \"%s\" and \"%s\"", it->cstr(), str.cstr());
+	}
+#endif
+
+	return id;
+}
+
+CString StringIdRegistry::find(StringId id)
+{
+	StringIdRegistryStorage& storage = getStorage();
+
+	LockGuard<Mutex> lock(storage.m_mtx);
+	auto it = storage.m_strings.find(id);
+	return (it != storage.m_strings.getEnd()) ? it->toCString() : CString();
+}
+
+} // end namespace anki
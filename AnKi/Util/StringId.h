@@ -0,0 +1,112 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <AnKi/Util/String.h>
+#include <type_traits>
+
+namespace anki
+{
+
+/// @addtogroup util_other
+/// @{
+
+/// A hashed string that can be computed at compile time. It's meant to replace string compares in lookups with integer
+/// compares. The hash is FNV-1a 64bit. Use StringIdRegistry to get the string back.
+class StringId
+{
+public:
+	constexpr StringId() = default;
+
+	/// Hash a string literal. Use ANKI_STRING_ID to be sure it's computed at compile time.
+	template<PtrSize N>
+	constexpr explicit StringId(const char (&str)[N])
+		: m_hash(hashString(str, N - 1))
+	{
+	}
+
+	/// Hash a string at runtime.
+	explicit StringId(CString str)
+		: m_hash(hashString(str.cstr(), (str.isEmpty()) ? 0 : str.getLength()))
+	{
+	}
+
+	static constexpr StringId fromHash(U64 hash)
+	{
+		return StringId(hash, 0);
+	}
+
+	constexpr U64 getHash() const
+	{
+		return m_hash;
+	}
+
+	/// Return false if it's default constructed.
+	constexpr Bool isValid() const
+	{
+		return m_hash != 0;
+	}
+
+	constexpr Bool operator==(const StringId& b) const
+	{
+		return m_hash == b.m_hash;
+	}
+
+	constexpr Bool operator!=(const StringId& b) const
+	{
+		return m_hash != b.m_hash;
+	}
+
+	constexpr Bool operator<(const StringId& b) const
+	{
+		return m_hash < b.m_hash;
+	}
+
+	/// For HashMap.
+	U64 computeHash() const
+	{
+		return m_hash;
+	}
+
+	static constexpr U64 hashString(const char* str, PtrSize length)
+	{
+		U64 hash = 0xCBF29CE484222325;
+		for(PtrSize i = 0; i < length; ++i)
+		{
+			hash = (hash ^ U64(U8(str[i]))) * 0x100000001B3;
+		}
+		return hash;
+	}
+
+private:
+	U64 m_hash = 0;
+
+	constexpr StringId(U64 hash, int)
+		: m_hash(hash)
+	{
+	}
+};
+
+/// Create a StringId out of a string literal at compile time.
+#define ANKI_STRING_ID(str_) \
+	anki::StringId::fromHash( \
+		std::integral_constant<anki::U64, anki::StringId::hashString(str_, sizeof(str_) - 1)>::value)
+
+/// Keeps the strings of the StringIds that got registered so they can be printed. When ANKI_EXTRA_CHECKS is on it also
+/// checks for hash collisions.
+/// @note It's thread-safe.
+class StringIdRegistry
+{
+public:
+	/// Register a string. It's cheap to register the same string multiple times.
+	static StringId registerString(CString str);
+
+	/// Get the string of a registered StringId. Returns an empty string if it's not registered.
+	static CString find(StringId id);
+};
+/// @}
+
+} // end namespace anki
@@ -18,20 +18,138 @@ namespace anki
 #	define ANKI_HIVE_DEBUG_PRINT(...) ((void)0)
 #endif
 
-class ThreadHive::Thread
+/// Marks a ThreadHiveSemaphore that reached zero. Tasks that want to wait on it can run immediately.
+static void* const SIGNALED_SEMAPHORE_MARKER = reinterpret_cast<void*>(PtrSize(1));
+
+/// The hive and the thread index of the calling thread if it's a hive thread.
+static thread_local ThreadHive* g_currentHive = nullptr;
+static thread_local U32 g_currentHiveThreadId = MAX_U32;
+
+class ThreadHive::Task : public NonCopyable
+{
+public:
+	Task* m_next; ///< Next in the list.
+
+	ThreadHiveTaskCallback m_cb; ///< Callback that defines the task.
+	void* m_arg; ///< Args for the callback.
+
+	ThreadHiveSemaphore* m_waitSemaphore;
+	ThreadHiveSemaphore* m_signalSemaphore;
+};
+
+/// A fixed size Chase-Lev deque. The owner thread pushes and pops from the bottom and the other threads steal from
+/// the top.
+class alignas(ANKI_CACHE_LINE_SIZE) ThreadHive::TaskDeque : public NonCopyable
+{
+public:
+	static constexpr U32 CAPACITY = 1024 * 4;
+
+	TaskDeque()
+	{
+		static_assert(isPowerOfTwo(CAPACITY), "Need to be power of two");
+	}
+
+	/// Push a task. Only the owner thread can call it.
+	/// @return False if the deque is full.
+	Bool push(Task* task)
+	{
+		const I64 bottom = m_bottom.load(AtomicMemoryOrder::RELAXED);
+		const I64 top = m_top.load(AtomicMemoryOrder::ACQUIRE);
+		if(bottom - top >= I64(CAPACITY))
+		{
+			return false;
+		}
+
+		m_tasks[bottom & (CAPACITY - 1)].store(task, AtomicMemoryOrder::RELAXED);
+		m_bottom.store(bottom + 1, AtomicMemoryOrder::RELEASE);
+		return true;
+	}
+
+	/// Pop the most recently pushed task. Only the owner thread can call it.
+	Task* pop()
+	{
+		const I64 bottom = m_bottom.load(AtomicMemoryOrder::RELAXED) - 1;
+		m_bottom.store(bottom, AtomicMemoryOrder::SEQ_CST);
+		I64 top = m_top.load(AtomicMemoryOrder::SEQ_CST);
+
+		Task* task = nullptr;
+		if(top <= bottom)
+		{
+			task = m_tasks[bottom & (CAPACITY - 1)].load(AtomicMemoryOrder::RELAXED);
+			if(top == bottom)
+			{
+				// Last task, race against the thieves
+				if(!m_top.compareExchange(top, top + 1, AtomicMemoryOrder::SEQ_CST, AtomicMemoryOrder::RELAXED))
+				{
+					task = nullptr;
+				}
+
+				m_bottom.store(bottom + 1, AtomicMemoryOrder::RELAXED);
+			}
+		}
+		else
+		{
+			// Empty
+			m_bottom.store(bottom + 1, AtomicMemoryOrder::RELAXED);
+		}
+
+		return task;
+	}
+
+	/// Steal the oldest task. Any thread can call it.
+	Task* steal()
+	{
+		I64 top = m_top.load(AtomicMemoryOrder::SEQ_CST);
+		const I64 bottom = m_bottom.load(AtomicMemoryOrder::SEQ_CST);
+
+		Task* task = nullptr;
+		if(top < bottom)
+		{
+			task = m_tasks[top & (CAPACITY - 1)].load(AtomicMemoryOrder::RELAXED);
+			if(!m_top.compareExchange(top, top + 1, AtomicMemoryOrder::SEQ_CST, AtomicMemoryOrder::RELAXED))
+			{
+				// Lost the race
+				task = nullptr;
+			}
+		}
+
+		return task;
+	}
+
+	/// How many tasks it can accept at the moment. Only the owner thread can call it.
+	U32 getFreeSpace() const
+	{
+		const I64 count = m_bottom.load(AtomicMemoryOrder::RELAXED) - m_top.load(AtomicMemoryOrder::ACQUIRE);
+		return CAPACITY - U32(max<I64>(count, 0));
+	}
+
+private:
+	alignas(ANKI_CACHE_LINE_SIZE) Atomic<I64> m_top = {0};
+	alignas(ANKI_CACHE_LINE_SIZE) Atomic<I64> m_bottom = {0};
+	alignas(ANKI_CACHE_LINE_SIZE) Array<Atomic<Task*>, CAPACITY> m_tasks;
+};
+
+class alignas(ANKI_CACHE_LINE_SIZE) ThreadHive::Thread
 {
 public:
+	TaskDeque m_deque; ///< Only used by the work-stealing scheduler.
 	U32 m_id; ///< An ID
 	anki::Thread m_thread; ///< Runs the workingFunc
 	ThreadHive* m_hive;
 
 	/// Constructor
-	Thread(U32 id, ThreadHive* hive, Bool pinToCores)
+	Thread(U32 id, ThreadHive* hive)
 		: m_id(id)
 		, m_thread("anki_threadhive")
 		, m_hive(hive)
 	{
 		ANKI_ASSERT(hive);
+	}
+
+	/// Start the thread. All threads need to be constructed before any of them starts because they steal from each
+	/// other.
+	void start(Bool pinToCores)
+	{
 		m_thread.start(this, threadCallback, (pinToCores) ? I32(m_id) : -1);
 	}
 
@@ -41,33 +159,36 @@ private:
 	{
 		Thread& self = *static_cast<Thread*>(info.m_userData);
 
-		self.m_hive->threadRun(self.m_id);
+		if(self.m_hive->m_workStealing)
+		{
+			self.m_hive->threadRunWorkStealing(self.m_id);
+		}
+		else
+		{
+			self.m_hive->threadRun(self.m_id);
+		}
+
 		return Error::NONE;
 	}
 };
 
-class ThreadHive::Task : public NonCopyable
-{
-public:
-	Task* m_next; ///< Next in the list.
-
-	ThreadHiveTaskCallback m_cb; ///< Callback that defines the task.
-	void* m_arg; ///< Args for the callback.
-
-	ThreadHiveSemaphore* m_waitSemaphore;
-	ThreadHiveSemaphore* m_signalSemaphore;
-};
-
-ThreadHive::ThreadHive(U32 threadCount, GenericMemoryPoolAllocator<U8> alloc, Bool pinToCores)
+ThreadHive::ThreadHive(U32 threadCount, GenericMemoryPoolAllocator<U8> alloc, Bool pinToCores, Bool workStealing)
 	: m_slowAlloc(alloc)
 	, m_alloc(alloc.getMemoryPool().getAllocationCallback(), alloc.getMemoryPool().getAllocationCallbackUserData(),
-			  1024 * 4)
+			  PtrSize(SCRATCH_CHUNK_SIZE))
 	, m_threadCount(threadCount)
+	, m_workStealing(workStealing)
 {
-	m_threads = reinterpret_cast<Thread*>(m_slowAlloc.allocate(sizeof(Thread) * threadCount));
+	PtrSize alignment = alignof(Thread);
+	m_threads = reinterpret_cast<Thread*>(m_slowAlloc.allocate(sizeof(Thread) * threadCount, &alignment));
 	for(U32 i = 0; i < threadCount; ++i)
 	{
-		::new(&m_threads[i]) Thread(i, this, pinToCores);
+		::new(&m_threads[i]) Thread(i, this);
+	}
+
+	for(U32 i = 0; i < threadCount; ++i)
+	{
+		m_threads[i].start(pinToCores);
 	}
 }
 
@@ -100,9 +221,40 @@ void ThreadHive::submitTasks(ThreadHiveTask* tasks, const U32 taskCount)
 {
 	ANKI_ASSERT(tasks && taskCount > 0);
 
+	// The tasks are allocated from the scratch memory and a single allocation can't be bigger than a chunk. Split the
+	// big submits
+	constexpr U32 MAX_TASKS_PER_ALLOCATION = U32(SCRATCH_CHUNK_SIZE / sizeof(Task));
+	for(U32 firstTask = 0; firstTask < taskCount; firstTask += MAX_TASKS_PER_ALLOCATION)
+	{
+		submitTasksInternal(tasks + firstTask, min(MAX_TASKS_PER_ALLOCATION, taskCount - firstTask));
+	}
+}
+
+void ThreadHive::submitTasksInternal(ThreadHiveTask* tasks, U32 taskCount)
+{
+	ANKI_ASSERT(tasks && taskCount > 0);
+
 	// Allocate tasks
 	Task* const htasks = m_alloc.newArray<Task>(taskCount);
 
+	if(m_workStealing)
+	{
+		for(U32 i = 0; i < taskCount; ++i)
+		{
+			const ThreadHiveTask& inTask = tasks[i];
+			Task& outTask = htasks[i];
+
+			outTask.m_next = nullptr;
+			outTask.m_cb = inTask.m_callback;
+			outTask.m_arg = inTask.m_argument;
+			outTask.m_waitSemaphore = inTask.m_waitSemaphore;
+			outTask.m_signalSemaphore = inTask.m_signalSemaphore;
+		}
+
+		submitTasksWorkStealing(htasks, taskCount);
+		return;
+	}
+
 	// Initialize tasks
 	Task* prevTask = nullptr;
 	for(U32 i = 0; i < taskCount; ++i)
@@ -249,14 +401,285 @@ ThreadHive::Task* ThreadHive::getNewTask()
 	return task;
 }
 
+void ThreadHive::submitTasksWorkStealing(Task* tasks, U32 taskCount)
+{
+	m_pendingTaskCount.fetchAdd(taskCount, AtomicMemoryOrder::RELAXED);
+
+	// Gather the tasks that can run now in a list and park the rest in their semaphores
+	Task* readyHead = nullptr;
+	Task* readyTail = nullptr;
+	U32 readyCount = 0;
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		Task& task = tasks[i];
+
+		Bool ready = true;
+		if(task.m_waitSemaphore)
+		{
+			void* head = task.m_waitSemaphore->m_waitingTasks.load(AtomicMemoryOrder::ACQUIRE);
+			while(head != SIGNALED_SEMAPHORE_MARKER)
+			{
+				task.m_next = static_cast<Task*>(head);
+				if(task.m_waitSemaphore->m_waitingTasks.compareExchange(head, &task, AtomicMemoryOrder::RELEASE,
+																		 AtomicMemoryOrder::ACQUIRE))
+				{
+					ready = false;
+					break;
+				}
+			}
+		}
+
+		if(ready)
+		{
+			task.m_next = nullptr;
+			if(readyTail)
+			{
+				readyTail->m_next = &task;
+			}
+			else
+			{
+				readyHead = &task;
+			}
+			readyTail = &task;
+			++readyCount;
+		}
+	}
+
+	if(readyCount)
+	{
+		const U32 threadId = (g_currentHive == this) ? g_currentHiveThreadId : MAX_U32;
+		pushReadyTasks(readyHead, readyCount, threadId);
+	}
+
+	ANKI_HIVE_DEBUG_PRINT("submit tasks\n");
+}
+
+void ThreadHive::pushReadyTasks(Task* first, U32 taskCount, U32 threadId)
+{
+	ANKI_ASSERT(first && taskCount > 0);
+
+	// Increment the count before the tasks become visible so it can't underflow when someone grabs them
+	m_readyTaskCount.fetchAdd(taskCount, AtomicMemoryOrder::SEQ_CST);
+
+	// Try the deque of the thread first
+	if(threadId < m_threadCount)
+	{
+		TaskDeque& deque = m_threads[threadId].m_deque;
+		while(first && deque.push(first))
+		{
+			first = first->m_next;
+		}
+	}
+
+	// The rest go to the global list
+	if(first)
+	{
+		Task* last = first;
+		U32 count = 1;
+		while(last->m_next)
+		{
+			last = last->m_next;
+			++count;
+		}
+
+		LockGuard<Mutex> lock(m_mtx);
+
+		if(m_head != nullptr)
+		{
+			m_tail->m_next = first;
+		}
+		else
+		{
+			m_head = first;
+		}
+		m_tail = last;
+
+		m_globalTaskCount.fetchAdd(count, AtomicMemoryOrder::SEQ_CST);
+	}
+
+	wakeThreads(taskCount);
+}
+
+void ThreadHive::wakeThreads(U32 newTaskCount)
+{
+	// The increment of m_readyTaskCount and the load of m_sleepingThreadCount are sequentially consistent. A thread
+	// that goes to sleep does the opposite under the lock so either it will see the new tasks or we will see it
+	if(m_sleepingThreadCount.load(AtomicMemoryOrder::SEQ_CST) > 0)
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		if(newTaskCount > 1)
+		{
+			m_cvar.notifyAll();
+		}
+		else
+		{
+			m_cvar.notifyOne();
+		}
+	}
+}
+
+ThreadHive::Task* ThreadHive::findTask(U32 threadId)
+{
+	// Own deque first
+	Task* task = m_threads[threadId].m_deque.pop();
+
+	// Then the global list
+	if(task == nullptr && m_globalTaskCount.load(AtomicMemoryOrder::SEQ_CST) > 0)
+	{
+		TaskDeque& deque = m_threads[threadId].m_deque;
+
+		LockGuard<Mutex> lock(m_mtx);
+
+		if(m_head)
+		{
+			// Take the first and move a fair share of the rest to the own deque so others can steal them
+			task = m_head;
+			m_head = m_head->m_next;
+			U32 takenCount = 1;
+
+			const U32 globalCount = m_globalTaskCount.load(AtomicMemoryOrder::RELAXED);
+			U32 toMove = min(globalCount / m_threadCount, deque.getFreeSpace());
+			while(toMove-- && m_head)
+			{
+				Task* next = m_head->m_next;
+				const Bool pushed = deque.push(m_head);
+				ANKI_ASSERT(pushed);
+				(void)pushed;
+				m_head = next;
+				++takenCount;
+			}
+
+			if(m_head == nullptr)
+			{
+				m_tail = nullptr;
+			}
+
+			m_globalTaskCount.fetchSub(takenCount, AtomicMemoryOrder::SEQ_CST);
+		}
+	}
+
+	// Then steal
+	for(U32 i = 1; i < m_threadCount && task == nullptr; ++i)
+	{
+		const U32 victim = (threadId + i) % m_threadCount;
+		task = m_threads[victim].m_deque.steal();
+	}
+
+	if(task)
+	{
+		m_readyTaskCount.fetchSub(1, AtomicMemoryOrder::SEQ_CST);
+	}
+
+	return task;
+}
+
+void ThreadHive::runTaskWorkStealing(Task& task, U32 threadId)
+{
+	ANKI_ASSERT(task.m_cb);
+	ANKI_HIVE_DEBUG_PRINT("tid: %lu will exec %p (udata: %p)\n", threadId, static_cast<void*>(&task),
+						  static_cast<void*>(task.m_arg));
+	task.m_cb(task.m_arg, threadId, *this, task.m_signalSemaphore);
+
+#if ANKI_EXTRA_CHECKS
+	task.m_cb = nullptr;
+#endif
+
+	if(task.m_signalSemaphore)
+	{
+		const U32 out = task.m_signalSemaphore->m_atomic.fetchSub(1, AtomicMemoryOrder::ACQ_REL);
+		ANKI_ASSERT(out > 0u);
+
+		if(out == 1)
+		{
+			// Reached zero, the dependent tasks can run on this thread's deque
+			void* waiting =
+				task.m_signalSemaphore->m_waitingTasks.exchange(SIGNALED_SEMAPHORE_MARKER, AtomicMemoryOrder::ACQ_REL);
+			ANKI_ASSERT(waiting != SIGNALED_SEMAPHORE_MARKER);
+
+			U32 count = 0;
+			for(Task* t = static_cast<Task*>(waiting); t; t = t->m_next)
+			{
+				++count;
+			}
+
+			if(count)
+			{
+				pushReadyTasks(static_cast<Task*>(waiting), count, threadId);
+			}
+		}
+	}
+
+	// Decrement the pending count after the dependents are pushed so waitAllTasks() can't see a zero too early
+	if(m_pendingTaskCount.fetchSub(1, AtomicMemoryOrder::ACQ_REL) == 1)
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		m_waitAllCvar.notifyAll();
+	}
+}
+
+void ThreadHive::threadRunWorkStealing(U32 threadId)
+{
+	g_currentHive = this;
+	g_currentHiveThreadId = threadId;
+
+	while(true)
+	{
+		Task* task = findTask(threadId);
+		if(task)
+		{
+			runTaskWorkStealing(*task, threadId);
+			continue;
+		}
+
+		if(m_readyTaskCount.load(AtomicMemoryOrder::SEQ_CST) > 0)
+		{
+			// Some other thread is moving tasks around, try again
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Nothing to do, sleep
+		LockGuard<Mutex> lock(m_mtx);
+		m_sleepingThreadCount.fetchAdd(1, AtomicMemoryOrder::SEQ_CST);
+		while(!m_quit && m_readyTaskCount.load(AtomicMemoryOrder::SEQ_CST) == 0)
+		{
+			ANKI_HIVE_DEBUG_PRINT("tid: %lu waiting\n", threadId);
+			m_cvar.wait(m_mtx);
+		}
+		m_sleepingThreadCount.fetchSub(1, AtomicMemoryOrder::SEQ_CST);
+
+		if(m_quit)
+		{
+			break;
+		}
+	}
+
+	g_currentHive = nullptr;
+	g_currentHiveThreadId = MAX_U32;
+
+	ANKI_HIVE_DEBUG_PRINT("tid: %lu thread quits!\n", threadId);
+}
+
 void ThreadHive::waitAllTasks()
 {
 	ANKI_HIVE_DEBUG_PRINT("mt: waiting all\n");
 
 	LockGuard<Mutex> lock(m_mtx);
-	while(m_pendingTasks > 0)
+	if(m_workStealing)
 	{
-		m_cvar.wait(m_mtx);
+		while(m_pendingTaskCount.load(AtomicMemoryOrder::ACQUIRE) > 0)
+		{
+			m_waitAllCvar.wait(m_mtx);
+		}
+
+		ANKI_ASSERT(m_readyTaskCount.load() == 0 && m_globalTaskCount.load() == 0);
+	}
+	else
+	{
+		while(m_pendingTasks > 0)
+		{
+			m_cvar.wait(m_mtx);
+		}
 	}
 
 	m_head = nullptr;
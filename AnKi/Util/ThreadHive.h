@@ -24,7 +24,8 @@ class ThreadHiveSemaphore
 	friend class ThreadHive;
 
 public:
-	/// Increase the value of the semaphore. It's easy to brake things with that.
+	/// Increase the value of the semaphore. It's easy to brake things with that. Only call it from a task that will
+	/// signal the same semaphore so the value can't reach zero in the meantime.
 	/// @note It's thread-safe.
 	void increaseSemaphore(U32 increase)
 	{
@@ -34,6 +35,9 @@ public:
 private:
 	Atomic<U32> m_atomic;
 
+	/// Intrusive list of tasks that wait on this semaphore. Only used by the work-stealing scheduler.
+	Atomic<void*> m_waitingTasks;
+
 	// No need to construct it or delete it
 	ThreadHiveSemaphore() = delete;
 	~ThreadHiveSemaphore() = delete;
@@ -75,13 +79,22 @@ public:
 
 /// A scheduler of small tasks. It takes a number of tasks and schedules them in one of the threads. The tasks can
 /// depend on previously submitted tasks or be completely independent.
+///
+/// It has two backends. The work-stealing one (default) gives every thread a lock-free deque. Tasks submitted from a
+/// hive thread go to its own deque, idle threads steal from the others and tasks that wait on a semaphore are pushed
+/// to the deque of the thread that signals it last. The legacy one keeps all tasks in a single list guarded by a mutex.
 class ThreadHive : public NonCopyable
 {
 public:
 	static const U32 MAX_THREADS = 32;
 
 	/// Create the hive.
-	ThreadHive(U32 threadCount, GenericMemoryPoolAllocator<U8> alloc, Bool pinToCores = false);
+	/// @param threadCount The number of threads.
+	/// @param alloc The allocator.
+	/// @param pinToCores Pin the threads to the cores.
+	/// @param workStealing Use the work-stealing scheduler instead of the single locked task list.
+	ThreadHive(U32 threadCount, GenericMemoryPoolAllocator<U8> alloc, Bool pinToCores = false,
+			   Bool workStealing = true);
 
 	~ThreadHive();
 
@@ -90,6 +103,11 @@ public:
 		return m_threadCount;
 	}
 
+	Bool isWorkStealing() const
+	{
+		return m_workStealing;
+	}
+
 	/// Create a new semaphore with some initial value.
 	/// @param initialValue  Can't be zero.
 	ThreadHiveSemaphore* newSemaphore(const U32 initialValue)
@@ -99,13 +117,16 @@ public:
 		ThreadHiveSemaphore* sem =
 			reinterpret_cast<ThreadHiveSemaphore*>(m_alloc.allocate(sizeof(ThreadHiveSemaphore), &alignment));
 		sem->m_atomic.setNonAtomically(initialValue);
+		sem->m_waitingTasks.setNonAtomically(nullptr);
 		return sem;
 	}
 
 	/// Allocate some scratch memory. The memory becomes invalid after waitAllTasks() is called.
+	/// @note The size can't be more than SCRATCH_CHUNK_SIZE.
 	void* allocateScratchMemory(PtrSize size, U32 alignment)
 	{
 		ANKI_ASSERT(size > 0 && alignment > 0);
+		ANKI_ASSERT(size <= SCRATCH_CHUNK_SIZE && "Scratch allocations can't be bigger than a chunk");
 		PtrSize align = alignment;
 		void* out = m_alloc.allocate(size, &align);
 #if ANKI_ENABLE_ASSERTS
@@ -114,7 +135,7 @@ public:
 		return out;
 	}
 
-	/// Submit tasks. The ThreadHiveTaskCallback callbacks can also call this.
+	/// Submit tasks. The ThreadHiveTaskCallback callbacks can also call this. There is no limit in the number of tasks.
 	void submitTasks(ThreadHiveTask* tasks, const U32 taskCount);
 
 	/// Submit a single task without dependencies. The ThreadHiveTaskCallback callbacks can also call this.
@@ -135,19 +156,37 @@ private:
 	/// Lightweight task.
 	class Task;
 
+	/// Per thread work-stealing deque.
+	class TaskDeque;
+
+	/// The size of the chunks of the scratch allocator. A single allocation can't be bigger than that.
+	static constexpr PtrSize SCRATCH_CHUNK_SIZE = 4 * 1024;
+
 	GenericMemoryPoolAllocator<U8> m_slowAlloc;
 	StackAllocator<U8> m_alloc;
 	Thread* m_threads = nullptr;
 	U32 m_threadCount = 0;
+	Bool m_workStealing = true;
 
-	Task* m_head = nullptr; ///< Head of the task list.
+	/// Head of the task list. In work-stealing mode it holds ready tasks submitted by non-hive threads or tasks that
+	/// didn't fit in a deque.
+	Task* m_head = nullptr;
 	Task* m_tail = nullptr; ///< Tail of the task list.
 	Bool m_quit = false;
-	U32 m_pendingTasks = 0;
+	U32 m_pendingTasks = 0; ///< Only for the legacy scheduler.
 
 	Mutex m_mtx;
 	ConditionVariable m_cvar;
 
+	/// @name Work-stealing state
+	/// @{
+	Atomic<U32> m_pendingTaskCount = {0}; ///< Submitted but not completed.
+	Atomic<U32> m_readyTaskCount = {0}; ///< Sitting in a deque or in the task list.
+	Atomic<U32> m_globalTaskCount = {0}; ///< Sitting in the task list.
+	Atomic<U32> m_sleepingThreadCount = {0};
+	ConditionVariable m_waitAllCvar;
+	/// @}
+
 	void threadRun(U32 threadId);
 
 	/// Wait for more tasks.
@@ -156,8 +195,24 @@ private:
 	/// Get new work from the queue.
 	Task* getNewTask();
 
-	/// Complete a task.
-	void completeTask(U32 taskId);
+	void threadRunWorkStealing(U32 threadId);
+
+	/// Submit tasks that fit in a single scratch allocation.
+	void submitTasksInternal(ThreadHiveTask* tasks, U32 taskCount);
+
+	void submitTasksWorkStealing(Task* tasks, U32 taskCount);
+
+	/// Push a list of ready tasks. If @a threadId is a valid hive thread push them to its deque.
+	void pushReadyTasks(Task* first, U32 taskCount, U32 threadId);
+
+	/// Get a task from the own deque, the global list or steal one from the other threads.
+	Task* findTask(U32 threadId);
+
+	/// Run a task and wake up the tasks that depend on it.
+	void runTaskWorkStealing(Task& task, U32 threadId);
+
+	/// Wake up sleeping threads if there are any.
+	void wakeThreads(U32 newTaskCount);
 };
 /// @}
 
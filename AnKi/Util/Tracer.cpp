@@ -18,6 +18,7 @@ public:
 	U32 m_eventCount = 0;
 	Array<TracerCounter, COUNTERS_PER_CHUNK> m_counters;
 	U32 m_counterCount = 0;
+	U64 m_frame = 0;
 };
 
 /// Thread local storage.
@@ -28,16 +29,30 @@ public:
 
 	Chunk* m_currentChunk = nullptr;
 	IntrusiveList<Chunk> m_allChunks;
+	U32 m_chunkCount = 0; ///< The size of m_allChunks.
+	IntrusiveList<Chunk> m_freeChunks; ///< Chunks that will be reused. Only the ring mode uses them.
 	SpinLock m_currentChunkLock;
 };
 
 thread_local Tracer::ThreadLocal* Tracer::m_threadLocal = nullptr;
+thread_local U32 Tracer::m_threadLocalTracerUuid = 0;
+Atomic<U32> Tracer::m_nextUuid = {1};
 
 Tracer::~Tracer()
 {
 	LockGuard<Mutex> lock(m_allThreadLocalMtx);
 	for(ThreadLocal* tlocal : m_allThreadLocal)
 	{
+		while(!tlocal->m_allChunks.isEmpty())
+		{
+			m_alloc.deleteInstance(tlocal->m_allChunks.popFront());
+		}
+
+		while(!tlocal->m_freeChunks.isEmpty())
+		{
+			m_alloc.deleteInstance(tlocal->m_freeChunks.popFront());
+		}
+
 		m_alloc.deleteInstance(tlocal);
 	}
 	m_allThreadLocal.destroy(m_alloc);
@@ -46,11 +61,12 @@ Tracer::~Tracer()
 Tracer::ThreadLocal& Tracer::getThreadLocal()
 {
 	ThreadLocal* out = m_threadLocal;
-	if(ANKI_UNLIKELY(out == nullptr))
+	if(ANKI_UNLIKELY(out == nullptr || m_threadLocalTracerUuid != m_uuid))
 	{
 		out = m_alloc.newInstance<ThreadLocal>();
 		out->m_tid = Thread::getCurrentThreadId();
 		m_threadLocal = out;
+		m_threadLocalTracerUuid = m_uuid;
 
 		// Store it
 		LockGuard<Mutex> lock(m_allThreadLocalMtx);
@@ -63,24 +79,54 @@ Tracer::ThreadLocal& Tracer::getThreadLocal()
 Tracer::Chunk& Tracer::getOrCreateChunk(ThreadLocal& tlocal)
 {
 	Chunk* out;
+	const U64 frame = m_frame.load();
 
 	if(tlocal.m_currentChunk && tlocal.m_currentChunk->m_eventCount < EVENTS_PER_CHUNK
-	   && tlocal.m_currentChunk->m_counterCount < COUNTERS_PER_CHUNK)
+	   && tlocal.m_currentChunk->m_counterCount < COUNTERS_PER_CHUNK && tlocal.m_currentChunk->m_frame == frame)
 	{
 		// There is a chunk and it has enough space
 		out = tlocal.m_currentChunk;
 	}
 	else
 	{
-		// Create a new
-		out = m_alloc.newInstance<Chunk>();
+		if(!tlocal.m_freeChunks.isEmpty())
+		{
+			out = tlocal.m_freeChunks.popFront();
+		}
+		else if(m_ringFrameCount > 0 && tlocal.m_chunkCount >= m_ringFrameCount * RING_CHUNKS_PER_FRAME)
+		{
+			// The ring is full, overwrite the oldest chunk
+			out = tlocal.m_allChunks.popFront();
+			--tlocal.m_chunkCount;
+		}
+		else
+		{
+			out = m_alloc.newInstance<Chunk>();
+		}
+
+		out->m_eventCount = 0;
+		out->m_counterCount = 0;
+		out->m_frame = frame;
 		tlocal.m_currentChunk = out;
 		tlocal.m_allChunks.pushBack(out);
+		++tlocal.m_chunkCount;
 	}
 
 	return *out;
 }
 
+void Tracer::releaseChunk(ThreadLocal& tlocal, Chunk* chunk)
+{
+	if(m_ringFrameCount > 0)
+	{
+		tlocal.m_freeChunks.pushBack(chunk);
+	}
+	else
+	{
+		m_alloc.deleteInstance(chunk);
+	}
+}
+
 TracerEventHandle Tracer::beginEvent()
 {
 	TracerEventHandle out;
@@ -153,7 +199,7 @@ void Tracer::addCustomEvent(const char* eventName, Second start, Second duration
 	writeCounter.m_value = U64(duration * 1000000000.0);
 }
 
-void Tracer::incrementCounter(const char* counterName, U64 value)
+void Tracer::incrementCounter(const char* counterName, StringId counterId, U64 value)
 {
 	if(!m_enabled)
 	{
@@ -167,6 +213,7 @@ void Tracer::incrementCounter(const char* counterName, U64 value)
 
 	TracerCounter& writeTo = chunk.m_counters[chunk.m_counterCount++];
 	writeTo.m_name = counterName;
+	writeTo.m_nameId = counterId;
 	writeTo.m_value = value;
 }
 
@@ -183,14 +230,50 @@ void Tracer::flush(TracerFlushCallback callback, void* callbackUserData)
 		{
 			Chunk* chunk = tlocal->m_allChunks.popFront();
 
-			callback(callbackUserData, tlocal->m_tid, WeakArray<TracerEvent>(&chunk->m_events[0], chunk->m_eventCount),
+			callback(callbackUserData, tlocal->m_tid, chunk->m_frame,
+					 WeakArray<TracerEvent>(&chunk->m_events[0], chunk->m_eventCount),
 					 WeakArray<TracerCounter>(&chunk->m_counters[0], chunk->m_counterCount));
 
-			m_alloc.deleteInstance(chunk);
+			releaseChunk(*tlocal, chunk);
 		}
 
+		tlocal->m_chunkCount = 0;
 		tlocal->m_currentChunk = nullptr;
 	}
 }
 
+void Tracer::newFrame(U64 frame)
+{
+	m_frame.store(frame);
+
+	if(m_ringFrameCount == 0)
+	{
+		return;
+	}
+
+	// Drop the chunks that are out of the window
+	LockGuard<Mutex> lock(m_allThreadLocalMtx);
+	for(ThreadLocal* tlocal : m_allThreadLocal)
+	{
+		LockGuard<SpinLock> lock2(tlocal->m_currentChunkLock);
+
+		while(!tlocal->m_allChunks.isEmpty() && tlocal->m_allChunks.getFront().m_frame + m_ringFrameCount <= frame)
+		{
+			Chunk* chunk = tlocal->m_allChunks.popFront();
+			if(chunk == tlocal->m_currentChunk)
+			{
+				tlocal->m_currentChunk = nullptr;
+			}
+
+			releaseChunk(*tlocal, chunk);
+			--tlocal->m_chunkCount;
+		}
+	}
+}
+
+void Tracer::setRingMode(U32 frameCount)
+{
+	m_ringFrameCount = frameCount;
+}
+
 } // end namespace anki
@@ -10,6 +10,7 @@
 #include <AnKi/Util/DynamicArray.h>
 #include <AnKi/Util/Singleton.h>
 #include <AnKi/Util/String.h>
+#include <AnKi/Util/StringId.h>
 
 namespace anki
 {
@@ -45,6 +46,7 @@ class TracerCounter
 {
 public:
 	CString m_name;
+	StringId m_nameId; ///< Might be invalid if the counter was incremented without one.
 	U64 m_value;
 
 	TracerCounter()
@@ -55,15 +57,18 @@ public:
 
 /// Tracer flush callback.
 /// @memberof Tracer
-using TracerFlushCallback = void (*)(void* userData, ThreadId tid, ConstWeakArray<TracerEvent> events,
+using TracerFlushCallback = void (*)(void* userData, ThreadId tid, U64 frame, ConstWeakArray<TracerEvent> events,
 									 ConstWeakArray<TracerCounter> counters);
 
-/// Tracer.
+/// Tracer. It has 2 modes. In the default mode it keeps everything until the next flush. In the ring mode it keeps only
+/// the events of the last few frames in a fixed amount of memory. Then a flush dumps that window. The ring mode is
+/// meant to be always on.
 class Tracer : public NonCopyable
 {
 public:
 	Tracer(GenericMemoryPoolAllocator<U8> alloc)
 		: m_alloc(alloc)
+		, m_uuid(m_nextUuid.fetchAdd(1))
 	{
 	}
 
@@ -83,12 +88,46 @@ public:
 
 	/// Increment a counter.
 	/// @note It's thread-safe.
-	void incrementCounter(const char* counterName, U64 value);
+	void incrementCounter(const char* counterName, U64 value)
+	{
+		incrementCounter(counterName, StringId(), value);
+	}
+
+	/// Increment a counter that has a precomputed ID. It saves the consumers of the counters from hashing the name.
+	/// @note It's thread-safe.
+	void incrementCounter(const char* counterName, StringId counterId, U64 value);
 
 	/// Flush all counters and events and start clean. The callback will be called multiple times.
 	/// @note It's thread-safe.
 	void flush(TracerFlushCallback callback, void* callbackUserData);
 
+	/// Set the frame that the next events belong to. In the ring mode it will also drop the events that are too old.
+	/// @note It's thread-safe.
+	void newFrame(U64 frame);
+
+	/// Enable the ring mode.
+	/// @param frameCount The number of frames to keep. Zero disables the ring mode.
+	/// @note It's not thread-safe. Call it before recording anything.
+	void setRingMode(U32 frameCount);
+
+	U32 getRingFrameCount() const
+	{
+		return m_ringFrameCount;
+	}
+
+	/// Ask for the ring to be dumped. It's up to the user of the Tracer to check it with consumeDumpRequest().
+	/// @note It's thread-safe and it can be called from a signal handler.
+	void requestDump()
+	{
+		m_dumpRequested.store(true);
+	}
+
+	/// Check if someone asked for a dump and clear the request.
+	Bool consumeDumpRequest()
+	{
+		return m_dumpRequested.exchange(false);
+	}
+
 	Bool getEnabled() const
 	{
 		return m_enabled;
@@ -102,6 +141,7 @@ public:
 private:
 	static constexpr U32 EVENTS_PER_CHUNK = 256;
 	static constexpr U32 COUNTERS_PER_CHUNK = 512;
+	static constexpr U32 RING_CHUNKS_PER_FRAME = 4; ///< Per thread. It bounds the memory of the ring mode.
 
 	class ThreadLocal;
 	class Chunk;
@@ -109,17 +149,27 @@ private:
 	GenericMemoryPoolAllocator<U8> m_alloc;
 
 	static thread_local ThreadLocal* m_threadLocal;
+	static thread_local U32 m_threadLocalTracerUuid; ///< The tracer that owns m_threadLocal.
+	static Atomic<U32> m_nextUuid;
+	U32 m_uuid; ///< Used to tell if m_threadLocal belongs to this tracer or to one that got destroyed.
 	DynamicArray<ThreadLocal*> m_allThreadLocal; ///< The Tracer should know about all the ThreadLocal.
 	Mutex m_allThreadLocalMtx;
 
 	Bool m_enabled = false;
 
+	Atomic<U64> m_frame = {0};
+	U32 m_ringFrameCount = 0;
+	Atomic<Bool> m_dumpRequested = {false};
+
 	/// Get the thread local ThreadLocal structure.
 	/// @note Thread-safe.
 	ThreadLocal& getThreadLocal();
 
 	/// Get or create a new chunk.
 	Chunk& getOrCreateChunk(ThreadLocal& tlocal);
+
+	/// Release a chunk that is no longer in the list of the thread.
+	void releaseChunk(ThreadLocal& tlocal, Chunk* chunk);
 };
 
 /// The global tracer.
@@ -151,7 +201,8 @@ private:
 #	define ANKI_TRACE_SCOPED_EVENT(name_) TracerScopedEvent _tse##name_(#    name_)
 #	define ANKI_TRACE_CUSTOM_EVENT(name_, start_, duration_) \
 		TracerSingleton::get().addCustomEvent(#name_, start_, duration_)
-#	define ANKI_TRACE_INC_COUNTER(name_, val_) TracerSingleton::get().incrementCounter(#    name_, val_)
+#	define ANKI_TRACE_INC_COUNTER(name_, val_) \
+		TracerSingleton::get().incrementCounter(#name_, ANKI_STRING_ID(#name_), val_)
 #else
 #	define ANKI_TRACE_SCOPED_EVENT(name_) ((void)0)
 #	define ANKI_TRACE_CUSTOM_EVENT(name_, start_, duration_) ((void)0)
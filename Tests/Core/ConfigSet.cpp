@@ -0,0 +1,89 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Core/ConfigSet.h>
+#include <AnKi/Util/HighRezTimer.h>
+
+ANKI_TEST(Core, ConfigSet)
+{
+	ConfigSet config;
+
+	// Handles
+	{
+		const ConfigOption<U32> clusterObjs = config.getOption<U32>("r_avgObjectsPerCluster");
+		const ConfigOption<F32> lodDist = config.getOption<F32>(ANKI_STRING_ID("lod0MaxDistance"));
+		const ConfigOption<Bool> dumpSources = config.getOption<Bool>("rsrc_dumpShaderSources");
+		ANKI_TEST_EXPECT_EQ(clusterObjs.isValid(), true);
+		ANKI_TEST_EXPECT_EQ(clusterObjs.get(), config.getNumberU32("r_avgObjectsPerCluster"));
+		ANKI_TEST_EXPECT_EQ(lodDist.get(), config.getNumberF32("lod0MaxDistance"));
+		ANKI_TEST_EXPECT_EQ(dumpSources.get(), config.getBool(ANKI_STRING_ID("rsrc_dumpShaderSources")));
+
+		// The handles see the new values
+		config.set("r_avgObjectsPerCluster", 32);
+		config.set("lod0MaxDistance", 5.0);
+		config.set("rsrc_dumpShaderSources", 1);
+		ANKI_TEST_EXPECT_EQ(clusterObjs.get(), 32);
+		ANKI_TEST_EXPECT_EQ(lodDist.get(), 5.0f);
+		ANKI_TEST_EXPECT_EQ(dumpSources.get(), true);
+	}
+
+	// Change callbacks
+	{
+		U32 callCount = 0;
+		auto callback = [](void* userData, CString option) {
+			ANKI_TEST_EXPECT_EQ(option, "r_avgObjectsPerCluster");
+			++(*static_cast<U32*>(userData));
+		};
+
+		config.addChangeCallback("r_avgObjectsPerCluster", callback, &callCount);
+		config.set("r_avgObjectsPerCluster", 64);
+		ANKI_TEST_EXPECT_NO_ERR(config.setFromString("r_avgObjectsPerCluster", "128"));
+		ANKI_TEST_EXPECT_EQ(callCount, 2);
+		ANKI_TEST_EXPECT_EQ(config.getNumberU32("r_avgObjectsPerCluster"), 128);
+
+		// Out of range values are rejected
+		ANKI_TEST_EXPECT_ERR(config.setFromString("r_avgObjectsPerCluster", "1024"), Error::USER_DATA);
+		ANKI_TEST_EXPECT_EQ(callCount, 2);
+
+		config.removeChangeCallback("r_avgObjectsPerCluster", callback, &callCount);
+		config.set("r_avgObjectsPerCluster", 16);
+		ANKI_TEST_EXPECT_EQ(callCount, 2);
+	}
+}
+
+ANKI_TEST(Core, ConfigSetBench)
+{
+	ConfigSet config;
+	const U32 ITERATIONS = 1000000;
+	U64 sum = 0; // To avoid compiler opts
+
+	Second begin = HighRezTimer::getCurrentTime();
+	for(U32 i = 0; i < ITERATIONS; ++i)
+	{
+		sum += config.getNumberU32("gr_vkmajor");
+	}
+	const Second nameTime = HighRezTimer::getCurrentTime() - begin;
+
+	begin = HighRezTimer::getCurrentTime();
+	for(U32 i = 0; i < ITERATIONS; ++i)
+	{
+		sum += config.getNumberU32(ANKI_STRING_ID("gr_vkmajor"));
+	}
+	const Second idTime = HighRezTimer::getCurrentTime() - begin;
+
+	const ConfigOption<U32> option = config.getOption<U32>("gr_vkmajor");
+	begin = HighRezTimer::getCurrentTime();
+	for(U32 i = 0; i < ITERATIONS; ++i)
+	{
+		sum += option.get();
+	}
+	const Second handleTime = HighRezTimer::getCurrentTime() - begin;
+
+	ANKI_TEST_EXPECT_EQ(sum, 3 * ITERATIONS);
+	ANKI_TEST_LOGI("Lookup cost. By name %fns, by StringId %fns, by ConfigOption %fns",
+				   nameTime / ITERATIONS * 1000000000.0, idTime / ITERATIONS * 1000000000.0,
+				   handleTime / ITERATIONS * 1000000000.0);
+}
@@ -0,0 +1,128 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Resource/AnimationResource.h>
+
+namespace anki
+{
+
+ANKI_TEST(Resource, AnimationFindKeyframe)
+{
+	const Array<AnimationKeyframe<F32>, 5> keys = {{{1.0, 10.0f}, {2.0, 20.0f}, {3.0, 30.0f}, {5.0, 50.0f},
+													{8.0, 80.0f}}};
+	const ConstWeakArray<AnimationKeyframe<F32>> weakKeys(keys);
+
+	for(U32 hint : {0u, 2u, 3u, 100u})
+	{
+		// Outside the keys
+		ANKI_TEST_EXPECT_EQ(AnimationResource::findKeyframe(weakKeys, 0.5, hint), MAX_U32);
+		ANKI_TEST_EXPECT_EQ(AnimationResource::findKeyframe(weakKeys, 8.5, hint), MAX_U32);
+
+		// Between keys
+		ANKI_TEST_EXPECT_EQ(AnimationResource::findKeyframe(weakKeys, 1.5, hint), 0);
+		ANKI_TEST_EXPECT_EQ(AnimationResource::findKeyframe(weakKeys, 4.0, hint), 2);
+		ANKI_TEST_EXPECT_EQ(AnimationResource::findKeyframe(weakKeys, 7.0, hint), 3);
+
+		// Exactly on a key. The time is either at the start or at the end of the returned pair
+		for(U32 k = 0; k < keys.getSize(); ++k)
+		{
+			const U32 i = AnimationResource::findKeyframe(weakKeys, keys[k].getTime(), hint);
+			ANKI_TEST_EXPECT_LEQ(i, keys.getSize() - 2);
+			ANKI_TEST_EXPECT_EQ(i == k || i + 1 == k, true);
+		}
+	}
+}
+
+ANKI_TEST(Resource, AnimationInterpolateChannel)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	AnimationChannel channel;
+	channel.m_positions.create(alloc, 4);
+	channel.m_positions[0] = {0.0, Vec3(0.0f)};
+	channel.m_positions[1] = {1.0, Vec3(1.0f, 0.0f, 0.0f)};
+	channel.m_positions[2] = {2.0, Vec3(1.0f, 2.0f, 0.0f)};
+	channel.m_positions[3] = {4.0, Vec3(1.0f, 2.0f, 4.0f)};
+	channel.m_scales.create(alloc, 2);
+	channel.m_scales[0] = {1.0, 1.0f};
+	channel.m_scales[1] = {3.0, 3.0f};
+
+	auto sample = [&](Second time, AnimationChannelCursor& cursor, Vec3& pos, F32& scale) {
+		Quat rot;
+		AnimationResource::interpolateChannel(channel, time, pos, rot, scale, cursor);
+		ANKI_TEST_EXPECT_EQ(rot, Quat::getIdentity());
+	};
+
+	// Boundaries
+	{
+		AnimationChannelCursor cursor;
+		Vec3 pos;
+		F32 scale;
+
+		// Before the first scale key
+		sample(0.5, cursor, pos, scale);
+		ANKI_TEST_EXPECT_EQ(pos, Vec3(0.5f, 0.0f, 0.0f));
+		ANKI_TEST_EXPECT_EQ(scale, 1.0f);
+
+		// On keys
+		sample(0.0, cursor, pos, scale);
+		ANKI_TEST_EXPECT_EQ(pos, Vec3(0.0f));
+		sample(2.0, cursor, pos, scale);
+		ANKI_TEST_EXPECT_EQ(pos, Vec3(1.0f, 2.0f, 0.0f));
+		ANKI_TEST_EXPECT_EQ(scale, 2.0f);
+		sample(4.0, cursor, pos, scale);
+		ANKI_TEST_EXPECT_EQ(pos, Vec3(1.0f, 2.0f, 4.0f));
+		ANKI_TEST_EXPECT_EQ(cursor.m_position, 2);
+
+		// After the last scale key
+		sample(3.5, cursor, pos, scale);
+		ANKI_TEST_EXPECT_EQ(pos, Vec3(1.0f, 2.0f, 3.0f));
+		ANKI_TEST_EXPECT_EQ(scale, 1.0f);
+
+		// After the last key
+		sample(4.5, cursor, pos, scale);
+		ANKI_TEST_EXPECT_EQ(pos, Vec3(0.0f));
+	}
+
+	// Forward playback reuses the cursor and a jump back in time (looping) finds the right keys again
+	{
+		AnimationChannelCursor cursor;
+		AnimationChannelCursor noCursorReuse;
+		for(U32 loop = 0; loop < 2; ++loop)
+		{
+			for(Second time = 0.0; time <= 4.0; time += 0.25)
+			{
+				Vec3 pos, expectedPos;
+				F32 scale, expectedScale;
+				sample(time, cursor, pos, scale);
+				noCursorReuse = {};
+				sample(time, noCursorReuse, expectedPos, expectedScale);
+
+				ANKI_TEST_EXPECT_EQ(pos, expectedPos);
+				ANKI_TEST_EXPECT_EQ(scale, expectedScale);
+				ANKI_TEST_EXPECT_LEQ(channel.m_positions[cursor.m_position].getTime(), time);
+				ANKI_TEST_EXPECT_GEQ(channel.m_positions[cursor.m_position + 1].getTime(), time);
+			}
+		}
+
+		// Backwards
+		for(Second time = 4.0; time >= 0.0; time -= 0.5)
+		{
+			Vec3 pos, expectedPos;
+			F32 scale, expectedScale;
+			sample(time, cursor, pos, scale);
+			noCursorReuse = {};
+			sample(time, noCursorReuse, expectedPos, expectedScale);
+
+			ANKI_TEST_EXPECT_EQ(pos, expectedPos);
+			ANKI_TEST_EXPECT_EQ(scale, expectedScale);
+		}
+	}
+
+	channel.destroy(alloc);
+}
+
+} // end namespace anki
@@ -97,6 +97,68 @@ public:
 	}
 };
 
+/// Writes its ID in a shared array.
+class OrderTask : public AsyncLoaderTask
+{
+public:
+	Atomic<U32>* m_count = nullptr;
+	U32* m_order = nullptr;
+	U32 m_id = 0;
+	F32 m_sleepTime = 0.0f;
+
+	OrderTask(Atomic<U32>* count, U32* order, U32 id, F32 sleepTime = 0.0f)
+		: m_count(count)
+		, m_order(order)
+		, m_id(id)
+		, m_sleepTime(sleepTime)
+	{
+	}
+
+	Error operator()(AsyncLoaderTaskContext& ctx)
+	{
+		if(m_sleepTime != 0.0f)
+		{
+			HighRezTimer::sleep(m_sleepTime);
+		}
+
+		m_order[m_count->fetchAdd(1)] = m_id;
+		return Error::NONE;
+	}
+};
+
+/// Runs in all stages.
+class PipelineTask : public AsyncLoaderTask
+{
+public:
+	F32 m_sleepTime;
+	Atomic<U32>* m_wrongStageCount;
+	AsyncLoaderStage m_expectedStage = AsyncLoaderStage::IO;
+
+	PipelineTask(F32 sleepTime, Atomic<U32>* wrongStageCount)
+		: m_sleepTime(sleepTime)
+		, m_wrongStageCount(wrongStageCount)
+	{
+	}
+
+	Error operator()(AsyncLoaderTaskContext& ctx)
+	{
+		if(ctx.m_stage != m_expectedStage)
+		{
+			m_wrongStageCount->fetchAdd(1);
+		}
+
+		HighRezTimer::sleep(m_sleepTime);
+
+		if(ctx.m_stage < AsyncLoaderStage::TRANSFER)
+		{
+			ctx.m_nextStage = ctx.m_stage + 1;
+			m_expectedStage = ctx.m_nextStage;
+		}
+
+		return Error::NONE;
+	}
+};
+
 ANKI_TEST(Resource, AsyncLoader)
 {
 	HeapAllocator<U8> alloc(allocAligned, nullptr);
@@ -268,6 +330,182 @@ ANKI_TEST(Resource, AsyncLoader)
 		barrier.wait();
 		ANKI_TEST_EXPECT_EQ(counter.load(), 10);
 	}
+
+	// Priorities
+	{
+		AsyncLoader a;
+		a.init(alloc);
+		Atomic<U32> counter = {0};
+		Array<U32, 6> order;
+
+		a.pause();
+		a.submitNewTask<OrderTask>(&counter, &order[0], 0);
+		a.submitTask(a.newTask<OrderTask>(&counter, &order[0], 1), 10);
+		a.submitTask(a.newTask<OrderTask>(&counter, &order[0], 2), 5);
+		a.submitTask(a.newTask<OrderTask>(&counter, &order[0], 3), 10);
+		a.submitNewTask<OrderTask>(&counter, &order[0], 4);
+
+		// Bump one after the submission
+		AsyncLoaderTaskTokenPtr token = a.newTaskToken();
+		a.submitTask(a.newTask<OrderTask>(&counter, &order[0], 5), 1, token);
+		a.setTaskPriority(token, 20);
+
+		a.resume();
+		while(counter.load() < order.getSize())
+		{
+			HighRezTimer::sleep(0.01);
+		}
+
+		ANKI_TEST_EXPECT_EQ(order[0], 5);
+		ANKI_TEST_EXPECT_EQ(order[1], 1);
+		ANKI_TEST_EXPECT_EQ(order[2], 3);
+		ANKI_TEST_EXPECT_EQ(order[3], 2);
+		ANKI_TEST_EXPECT_EQ(order[4], 0);
+		ANKI_TEST_EXPECT_EQ(order[5], 4);
+	}
+
+	// Cancellation
+	{
+		AsyncLoader a;
+		a.init(alloc);
+		Atomic<U32> counter = {0};
+		Array<U32, 10> order;
+		Barrier barrier(2);
+
+		AsyncLoaderTaskTokenPtr token = a.newTaskToken();
+		a.pause();
+		for(U32 i = 0; i < 5; ++i)
+		{
+			a.submitTask(a.newTask<OrderTask>(&counter, &order[0], i), AsyncLoader::DEFAULT_PRIORITY, token);
+		}
+		a.submitNewTask<Task>(0.0f, &barrier, nullptr);
+		token->cancel();
+		a.resume();
+		barrier.wait();
+
+		ANKI_TEST_EXPECT_EQ(counter.load(), 0);
+		ANKI_TEST_EXPECT_EQ(a.getCancelledTaskCount(), 5);
+	}
+
+	// Many threads
+	{
+		AsyncLoader a;
+		a.init(alloc, 4);
+		Atomic<U32> counter = {0};
+		const U32 COUNT = 40;
+
+		const Second begin = HighRezTimer::getCurrentTime();
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			a.submitNewTask<Task>(0.05f, nullptr, &counter);
+		}
+
+		while(counter.load() < COUNT)
+		{
+			HighRezTimer::sleep(0.01);
+		}
+		const Second duration = HighRezTimer::getCurrentTime() - begin;
+
+		// Serially it would take 2 seconds
+		ANKI_TEST_EXPECT_LEQ(duration, 1.5);
+
+		// Pause should wait for all threads
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			a.submitNewTask<Task>(0.05f, nullptr, &counter);
+		}
+		HighRezTimer::sleep(0.01);
+		a.pause();
+		const U32 pausedCount = counter.load();
+		HighRezTimer::sleep(0.2);
+		ANKI_TEST_EXPECT_EQ(counter.load(), pausedCount);
+		a.resume();
+	}
+
+	// Pipeline stages overlap
+	{
+		AsyncLoader a;
+		a.init(alloc);
+		Atomic<U32> wrongStageCount = {0};
+		const U32 COUNT = 10;
+		const F32 STAGE_TIME = 0.05f;
+
+		const Second begin = HighRezTimer::getCurrentTime();
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			a.submitNewTask<PipelineTask>(STAGE_TIME, &wrongStageCount);
+		}
+
+		while(a.getCompletedTaskCount() < COUNT)
+		{
+			HighRezTimer::sleep(0.01);
+		}
+		const Second duration = HighRezTimer::getCurrentTime() - begin;
+
+		ANKI_TEST_EXPECT_EQ(wrongStageCount.load(), 0);
+
+		// Serially it would take 1.5 seconds. Pipelined (COUNT + 2) * STAGE_TIME
+		ANKI_TEST_EXPECT_LEQ(duration, 1.1);
+	}
+}
+
+/// Measures how long a task that needs to run right now waits behind a full queue of background tasks.
+ANKI_TEST(Resource, AsyncLoaderTimeToFirstVisibleBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const U32 BACKGROUND_TASK_COUNT = 200;
+	constexpr F32 TASK_DURATION = 0.002f;
+	const U32 VISIBLE_PRIORITY = 100;
+
+	class VisibleTask : public AsyncLoaderTask
+	{
+	public:
+		Second* m_doneTime;
+
+		VisibleTask(Second* doneTime)
+			: m_doneTime(doneTime)
+		{
+		}
+
+		Error operator()(AsyncLoaderTaskContext& ctx)
+		{
+			HighRezTimer::sleep(TASK_DURATION);
+			*m_doneTime = HighRezTimer::getCurrentTime();
+			return Error::NONE;
+		}
+	};
+
+	auto run = [&](U32 threadCount, U32 priority) -> Second {
+		AsyncLoader a;
+		a.init(alloc, threadCount);
+		Atomic<U32> counter = {0};
+
+		for(U32 i = 0; i < BACKGROUND_TASK_COUNT; ++i)
+		{
+			a.submitNewTask<Task>(TASK_DURATION, nullptr, &counter);
+		}
+
+		Second doneTime = 0.0;
+		const Second begin = HighRezTimer::getCurrentTime();
+		a.submitTask(a.newTask<VisibleTask>(&doneTime), priority);
+
+		while(counter.load() < BACKGROUND_TASK_COUNT || doneTime == 0.0)
+		{
+			HighRezTimer::sleep(0.001);
+		}
+
+		return doneTime - begin;
+	};
+
+	const Second fifo = run(1, AsyncLoader::DEFAULT_PRIORITY);
+	const Second prioritized = run(1, VISIBLE_PRIORITY);
+	const Second prioritizedPool = run(4, VISIBLE_PRIORITY);
+
+	ANKI_TEST_LOGI("Time to the first visible resource behind %u tasks. FIFO %fms, prioritized %fms, prioritized "
+				   "with 4 threads %fms",
+				   BACKGROUND_TASK_COUNT, fifo * 1000.0, prioritized * 1000.0, prioritizedPool * 1000.0);
+
+	ANKI_TEST_EXPECT_LEQ(prioritized, fifo);
 }
 
 } // end namespace anki
@@ -0,0 +1,301 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Resource/MeshBinaryLoader.h>
+#include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/File.h>
+#include <AnKi/Shaders/Include/ModelTypes.h>
+#include <MeshOptimizer/meshoptimizer.h>
+
+namespace anki
+{
+
+namespace
+{
+
+/// The layout of the 2nd vertex buffer of a compressed mesh.
+class QuantizedMainVertex
+{
+public:
+	U32 m_normal;
+	U32 m_tangent;
+	U16Vec2 m_uv;
+};
+static_assert(sizeof(QuantizedMainVertex) == MESH_BINARY_COMPRESSED_MAIN_VERTEX_STRIDE, "See file");
+
+class TestMesh
+{
+public:
+	Array<Vec3, 7> m_positions;
+	Array<MainVertex, 7> m_mainVerts;
+	Array<U16, 9> m_indices;
+	Array<MeshBinarySubMesh, 2> m_subMeshes;
+	Vec3 m_aabbMin;
+	Vec3 m_aabbMax;
+	Vec2 m_uvMin;
+	Vec2 m_uvMax;
+	IndexType m_indexType = IndexType::U16;
+};
+
+U16 quantizeUnorm16(F32 value, F32 min, F32 max)
+{
+	const F32 f = clamp((value - min) / (max - min), 0.0f, 1.0f);
+	return U16(f * F32(MAX_U16) + 0.5f);
+}
+
+/// A quad and a triangle. The indices of the triangle point after the vertices of the quad.
+void createTestMesh(TestMesh& mesh)
+{
+	mesh.m_positions = {Vec3(-1.0f, -1.0f, 0.5f), Vec3(1.0f, -1.0f, 0.25f), Vec3(-1.0f, 1.0f, 0.0f),
+						Vec3(1.0f, 1.0f, -0.3f),  Vec3(2.0f, 0.0f, 1.0f),   Vec3(3.5f, 0.1f, 2.0f),
+						Vec3(2.5f, 1.7f, -1.0f)};
+
+	for(U32 v = 0; v < mesh.m_mainVerts.getSize(); ++v)
+	{
+		mesh.m_mainVerts[v].m_normal = 0x12345678u + v;
+		mesh.m_mainVerts[v].m_tangent = 0x9ABCDEF0u - v;
+		mesh.m_mainVerts[v].m_uvs[0] = Vec2(F32(v) * 0.3f - 0.5f, 1.0f - F32(v) * 0.15f);
+	}
+
+	mesh.m_indices = {0, 1, 2, 2, 1, 3, 4, 5, 6};
+
+	mesh.m_subMeshes[0].m_firstIndex = 0;
+	mesh.m_subMeshes[0].m_indexCount = 6;
+	mesh.m_subMeshes[0].m_aabbMin = Vec3(-1.0f, -1.0f, -0.3f);
+	mesh.m_subMeshes[0].m_aabbMax = Vec3(1.0f, 1.0f, 0.5f);
+	mesh.m_subMeshes[1].m_firstIndex = 6;
+	mesh.m_subMeshes[1].m_indexCount = 3;
+	mesh.m_subMeshes[1].m_aabbMin = Vec3(2.0f, 0.0f, -1.0f);
+	mesh.m_subMeshes[1].m_aabbMax = Vec3(3.5f, 1.7f, 2.0f);
+
+	mesh.m_aabbMin = Vec3(-1.0f, -1.0f, -1.0f);
+	mesh.m_aabbMax = Vec3(3.5f, 1.7f, 2.0f);
+	mesh.m_uvMin = Vec2(-0.5f, 0.1f);
+	mesh.m_uvMax = Vec2(1.3f, 1.0f);
+}
+
+void writeBuffer(const void* data, PtrSize size, File& file)
+{
+	ANKI_TEST_EXPECT_NO_ERR(file.write(data, size));
+
+	const Array<U8, MESH_BINARY_BUFFER_ALIGNMENT> zeros = {};
+	const PtrSize extraBytes = getAlignedRoundUp(MESH_BINARY_BUFFER_ALIGNMENT, size) - size;
+	if(extraBytes)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(file.write(&zeros[0], extraBytes));
+	}
+}
+
+/// Quantize and encode the mesh the way the GltfImporter does.
+void writeCompressedMesh(const TestMesh& mesh, CString filename, HeapAllocator<U8> alloc)
+{
+	MeshBinaryHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(&header.m_magic[0], MESH_MAGIC, 8);
+	header.m_flags = MeshBinaryFlag::COMPRESSED;
+	header.m_vertexBuffers[0].m_vertexStride = sizeof(Vec3);
+	header.m_vertexBuffers[1].m_vertexStride = sizeof(MainVertex);
+	header.m_vertexBufferCount = 2;
+
+	auto setAttrib = [&](VertexAttributeLocation loc, U32 binding, Format fmt, U32 relativeOffset) {
+		MeshBinaryVertexAttribute& attrib = header.m_vertexAttributes[loc];
+		attrib.m_bufferBinding = binding;
+		attrib.m_format = fmt;
+		attrib.m_relativeOffset = relativeOffset;
+		attrib.m_scale = 1.0f;
+	};
+	setAttrib(VertexAttributeLocation::POSITION, 0, Format::R32G32B32_SFLOAT, 0);
+	setAttrib(VertexAttributeLocation::NORMAL, 1, Format::A2B10G10R10_SNORM_PACK32, 0);
+	setAttrib(VertexAttributeLocation::TANGENT, 1, Format::A2B10G10R10_SNORM_PACK32, 4);
+	setAttrib(VertexAttributeLocation::UV, 1, Format::R32G32_SFLOAT, 8);
+
+	header.m_indexType = mesh.m_indexType;
+	header.m_totalIndexCount = mesh.m_indices.getSize();
+	header.m_totalVertexCount = mesh.m_positions.getSize();
+	header.m_subMeshCount = mesh.m_subMeshes.getSize();
+	header.m_aabbMin = mesh.m_aabbMin;
+	header.m_aabbMax = mesh.m_aabbMax;
+
+	const U32 vertCount = header.m_totalVertexCount;
+	MeshBinaryCompression compression;
+	memset(&compression, 0, sizeof(compression));
+	compression.m_uvMin = mesh.m_uvMin;
+	compression.m_uvMax = mesh.m_uvMax;
+
+	// Indices
+	Array<U32, 9> indices32;
+	for(U32 i = 0; i < indices32.getSize(); ++i)
+	{
+		indices32[i] = mesh.m_indices[i];
+	}
+
+	DynamicArrayAuto<U8> encodedIndices(alloc);
+	encodedIndices.create(U32(meshopt_encodeIndexBufferBound(indices32.getSize(), vertCount)));
+	compression.m_indexBufferSize = U32(
+		meshopt_encodeIndexBuffer(&encodedIndices[0], encodedIndices.getSize(), &indices32[0], indices32.getSize()));
+	ANKI_TEST_EXPECT_GT(compression.m_indexBufferSize, 0);
+
+	// Positions
+	Array<U16Vec4, 7> quantizedPositions;
+	for(U32 v = 0; v < vertCount; ++v)
+	{
+		for(U32 d = 0; d < 3; ++d)
+		{
+			quantizedPositions[v][d] =
+				quantizeUnorm16(mesh.m_positions[v][d], mesh.m_aabbMin[d], mesh.m_aabbMax[d]);
+		}
+		quantizedPositions[v].w() = 0;
+	}
+
+	DynamicArrayAuto<U8> encodedPositions(alloc);
+	encodedPositions.create(
+		U32(meshopt_encodeVertexBufferBound(vertCount, MESH_BINARY_COMPRESSED_POSITION_STRIDE)));
+	compression.m_vertexBufferSizes[0] =
+		U32(meshopt_encodeVertexBuffer(&encodedPositions[0], encodedPositions.getSize(), &quantizedPositions[0],
+									   vertCount, MESH_BINARY_COMPRESSED_POSITION_STRIDE));
+	ANKI_TEST_EXPECT_GT(compression.m_vertexBufferSizes[0], 0);
+
+	// Normals, tangents and UVs
+	Array<QuantizedMainVertex, 7> quantizedMainVerts;
+	for(U32 v = 0; v < vertCount; ++v)
+	{
+		const Vec2 uv = mesh.m_mainVerts[v].m_uvs[0];
+		quantizedMainVerts[v].m_normal = mesh.m_mainVerts[v].m_normal;
+		quantizedMainVerts[v].m_tangent = mesh.m_mainVerts[v].m_tangent;
+		quantizedMainVerts[v].m_uv = U16Vec2(quantizeUnorm16(uv.x(), mesh.m_uvMin.x(), mesh.m_uvMax.x()),
+											 quantizeUnorm16(uv.y(), mesh.m_uvMin.y(), mesh.m_uvMax.y()));
+	}
+
+	DynamicArrayAuto<U8> encodedMainVerts(alloc);
+	encodedMainVerts.create(
+		U32(meshopt_encodeVertexBufferBound(vertCount, MESH_BINARY_COMPRESSED_MAIN_VERTEX_STRIDE)));
+	compression.m_vertexBufferSizes[1] =
+		U32(meshopt_encodeVertexBuffer(&encodedMainVerts[0], encodedMainVerts.getSize(), &quantizedMainVerts[0],
+									   vertCount, MESH_BINARY_COMPRESSED_MAIN_VERTEX_STRIDE));
+	ANKI_TEST_EXPECT_GT(compression.m_vertexBufferSizes[1], 0);
+
+	// Write
+	File file;
+	ANKI_TEST_EXPECT_NO_ERR(file.open(filename, FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+	ANKI_TEST_EXPECT_NO_ERR(file.write(&header, sizeof(header)));
+	ANKI_TEST_EXPECT_NO_ERR(file.write(&mesh.m_subMeshes[0], mesh.m_subMeshes.getSizeInBytes()));
+	ANKI_TEST_EXPECT_NO_ERR(file.write(&compression, sizeof(compression)));
+	writeBuffer(&encodedIndices[0], compression.m_indexBufferSize, file);
+	writeBuffer(&encodedPositions[0], compression.m_vertexBufferSizes[0], file);
+	writeBuffer(&encodedMainVerts[0], compression.m_vertexBufferSizes[1], file);
+}
+
+} // end anonymous namespace
+
+ANKI_TEST(Resource, MeshBinaryLoaderCompressed)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// The meshes are written to a temp directory that is removed at the end
+	StringAuto dir(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(dir));
+	dir.append("/AnKiMeshBinaryLoaderTest");
+	if(!directoryExists(dir.toCString()))
+	{
+		ANKI_TEST_EXPECT_NO_ERR(createDirectory(dir.toCString()));
+	}
+
+	// A good mesh, one where the 2nd submesh doesn't start where the 1st ends, one where the 2nd submesh has a wrong
+	// bounding box and one with 32bit indices
+	TestMesh mesh;
+	createTestMesh(mesh);
+
+	TestMesh badFirstIndexMesh = mesh;
+	badFirstIndexMesh.m_subMeshes[1].m_firstIndex = 3;
+
+	TestMesh badAabbMesh = mesh;
+	badAabbMesh.m_subMeshes[1].m_aabbMin.y() = badAabbMesh.m_subMeshes[1].m_aabbMax.y();
+
+	TestMesh badIndexTypeMesh = mesh;
+	badIndexTypeMesh.m_indexType = IndexType::U32;
+
+	auto writeMesh = [&](const TestMesh& m, CString filename) {
+		StringAuto fname(alloc);
+		fname.sprintf("%s/%s", dir.cstr(), filename.cstr());
+		writeCompressedMesh(m, fname.toCString(), alloc);
+	};
+	writeMesh(mesh, "Good.ankimesh");
+	writeMesh(badFirstIndexMesh, "BadFirstIndex.ankimesh");
+	writeMesh(badAabbMesh, "BadAabb.ankimesh");
+	writeMesh(badIndexTypeMesh, "BadIndexType.ankimesh");
+
+	ResourceFilesystem fs(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath(dir.toCString()));
+
+	// Round trip
+	{
+		MeshBinaryLoader loader(&fs, alloc);
+		ANKI_TEST_EXPECT_NO_ERR(loader.load("Good.ankimesh"));
+		ANKI_TEST_EXPECT_EQ(loader.isCompressed(), true);
+		ANKI_TEST_EXPECT_NO_ERR(loader.decodeBuffers());
+
+		// Indices are lossless. The ones of the 2nd submesh point to its own vertices
+		Array<U16, 9> indices;
+		ANKI_TEST_EXPECT_NO_ERR(loader.storeIndexBuffer(&indices[0], indices.getSizeInBytes()));
+		for(U32 i = 0; i < indices.getSize(); ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(indices[i], mesh.m_indices[i]);
+		}
+
+		const ConstWeakArray<MeshBinarySubMesh> subMeshes = loader.getSubMeshes();
+		ANKI_TEST_EXPECT_EQ(subMeshes.getSize(), 2);
+		ANKI_TEST_EXPECT_EQ(subMeshes[1].m_firstIndex, 6);
+		ANKI_TEST_EXPECT_EQ(subMeshes[1].m_indexCount, 3);
+		for(U32 i = subMeshes[1].m_firstIndex; i < subMeshes[1].m_firstIndex + subMeshes[1].m_indexCount; ++i)
+		{
+			ANKI_TEST_EXPECT_GEQ(indices[i], 4);
+		}
+
+		// Positions within the precision of the quantization
+		Array<Vec3, 7> positions;
+		ANKI_TEST_EXPECT_NO_ERR(loader.storeVertexBuffer(0, &positions[0], positions.getSizeInBytes()));
+		const Vec3 posTolerance = (mesh.m_aabbMax - mesh.m_aabbMin) / F32(MAX_U16);
+		for(U32 v = 0; v < positions.getSize(); ++v)
+		{
+			for(U32 d = 0; d < 3; ++d)
+			{
+				ANKI_TEST_EXPECT_NEAR(positions[v][d], mesh.m_positions[v][d], posTolerance[d]);
+			}
+		}
+
+		// Normals and tangents are copied, UVs are quantized
+		Array<MainVertex, 7> mainVerts;
+		ANKI_TEST_EXPECT_NO_ERR(loader.storeVertexBuffer(1, &mainVerts[0], mainVerts.getSizeInBytes()));
+		const Vec2 uvTolerance = (mesh.m_uvMax - mesh.m_uvMin) / F32(MAX_U16);
+		for(U32 v = 0; v < mainVerts.getSize(); ++v)
+		{
+			ANKI_TEST_EXPECT_EQ(mainVerts[v].m_normal, mesh.m_mainVerts[v].m_normal);
+			ANKI_TEST_EXPECT_EQ(mainVerts[v].m_tangent, mesh.m_mainVerts[v].m_tangent);
+			ANKI_TEST_EXPECT_NEAR(mainVerts[v].m_uvs[0].x(), mesh.m_mainVerts[v].m_uvs[0].x(), uvTolerance.x());
+			ANKI_TEST_EXPECT_NEAR(mainVerts[v].m_uvs[0].y(), mesh.m_mainVerts[v].m_uvs[0].y(), uvTolerance.y());
+		}
+	}
+
+	// Per submesh validation
+	{
+		MeshBinaryLoader loader(&fs, alloc);
+		ANKI_TEST_EXPECT_ERR(loader.load("BadFirstIndex.ankimesh"), Error::USER_DATA);
+	}
+
+	{
+		MeshBinaryLoader loader(&fs, alloc);
+		ANKI_TEST_EXPECT_ERR(loader.load("BadAabb.ankimesh"), Error::USER_DATA);
+	}
+
+	{
+		MeshBinaryLoader loader(&fs, alloc);
+		ANKI_TEST_EXPECT_ERR(loader.load("BadIndexType.ankimesh"), Error::USER_DATA);
+	}
+
+	ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir.toCString(), alloc));
+}
+
+} // end namespace anki
@@ -20,15 +20,29 @@ ANKI_TEST(Resource, ResourceFilesystem)
 		ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath("Tests/Data/Dir/../Dir/"));
 		ResourceFilePtr file;
 		ANKI_TEST_EXPECT_NO_ERR(fs.openFile("subdir0/hello.txt", file));
+
+		// Mapping doesn't move the position
+		ConstWeakArray<U8, PtrSize> data;
+		ANKI_TEST_EXPECT_NO_ERR(file->map(data));
+		ANKI_TEST_EXPECT_EQ(data.getSize(), 6);
+		ANKI_TEST_EXPECT_EQ(memcmp(&data[0], "hello\n", 6), 0);
+
 		StringAuto txt(alloc);
 		ANKI_TEST_EXPECT_NO_ERR(file->readAllText(txt));
 		ANKI_TEST_EXPECT_EQ(txt, "hello\n");
 	}
 
 	{
-		ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath("./Tests/Data/Dir.AnKiZLibip"));
+		ANKI_TEST_EXPECT_NO_ERR(fs.addNewPath("./Tests/Data/Dir.ankizip"));
 		ResourceFilePtr file;
 		ANKI_TEST_EXPECT_NO_ERR(fs.openFile("subdir0/hello.txt", file));
+
+		// The file is stored (not compressed) in the archive so it's mapped from there
+		ConstWeakArray<U8, PtrSize> data;
+		ANKI_TEST_EXPECT_NO_ERR(file->map(data));
+		ANKI_TEST_EXPECT_EQ(data.getSize(), 5);
+		ANKI_TEST_EXPECT_EQ(memcmp(&data[0], "hell\n", 5), 0);
+
 		StringAuto txt(alloc);
 		ANKI_TEST_EXPECT_NO_ERR(file->readAllText(txt));
 		ANKI_TEST_EXPECT_EQ(txt, "hell\n");
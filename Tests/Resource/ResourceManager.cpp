@@ -7,6 +7,7 @@
 #include <AnKi/Resource/DummyResource.h>
 #include <AnKi/Resource/ResourceManager.h>
 #include <AnKi/Core/ConfigSet.h>
+#include <AnKi/Util/HighRezTimer.h>
 
 namespace anki
 {
@@ -87,4 +88,84 @@ ANKI_TEST(Resource, ResourceManager)
 	alloc.deleteInstance(resources);
 }
 
+/// A resource that only has a filename. Enough for TypeResourceManager.
+class BenchResource
+{
+public:
+	StringAuto m_fname;
+
+	BenchResource(HeapAllocator<U8> alloc)
+		: m_fname(alloc)
+	{
+	}
+
+	CString getFilename() const
+	{
+		return m_fname.toCString();
+	}
+};
+
+/// Exposes the internals of TypeResourceManager. It avoids a full ResourceManager that needs a GrManager.
+class BenchTypeResourceManager : public TypeResourceManager<BenchResource>
+{
+public:
+	using TypeResourceManager<BenchResource>::init;
+	using TypeResourceManager<BenchResource>::findLoadedResource;
+	using TypeResourceManager<BenchResource>::registerResource;
+	using TypeResourceManager<BenchResource>::unregisterResource;
+};
+
+ANKI_TEST(Resource, ResourceManagerLoadBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	BenchTypeResourceManager resources;
+	resources.init(ResourceAllocator<U8>(allocAligned, nullptr));
+
+	const U32 RESOURCE_COUNT = 50000;
+	const U32 REFERENCES_PER_RESOURCE = 4;
+
+	{
+		DynamicArrayAuto<BenchResource*> ptrs(alloc);
+		ptrs.create(RESOURCE_COUNT, nullptr);
+
+		// First load of every resource. Do what ResourceManager::loadResource() does
+		Array<char, 128> fname;
+		const Second beginLoad = HighRezTimer::getCurrentTime();
+		for(U32 i = 0; i < RESOURCE_COUNT; ++i)
+		{
+			snprintf(&fname[0], fname.getSize(), "Assets/Level/Mesh_%u.ankimesh", i);
+			ANKI_TEST_EXPECT_EQ(resources.findLoadedResource(&fname[0]), nullptr);
+
+			BenchResource* ptr = alloc.newInstance<BenchResource>(alloc);
+			ptr->m_fname.create(&fname[0]);
+			ptrs[i] = resources.registerResource(ptr);
+			ANKI_TEST_EXPECT_EQ(ptrs[i], ptr);
+		}
+		const Second endLoad = HighRezTimer::getCurrentTime();
+
+		// References to already loaded resources, like the ones materials and models do
+		const Second beginLookup = HighRezTimer::getCurrentTime();
+		for(U32 r = 0; r < REFERENCES_PER_RESOURCE; ++r)
+		{
+			for(U32 i = 0; i < RESOURCE_COUNT; ++i)
+			{
+				snprintf(&fname[0], fname.getSize(), "Assets/Level/Mesh_%u.ankimesh", i);
+				ANKI_TEST_EXPECT_EQ(resources.findLoadedResource(&fname[0]), ptrs[i]);
+			}
+		}
+		const Second endLookup = HighRezTimer::getCurrentTime();
+
+		ANKI_TEST_LOGI("Loading %u resources took %fms. %u lookups of loaded resources took %fms", RESOURCE_COUNT,
+					   (endLoad - beginLoad) * 1000.0, RESOURCE_COUNT * REFERENCES_PER_RESOURCE,
+					   (endLookup - beginLookup) * 1000.0);
+
+		for(BenchResource* ptr : ptrs)
+		{
+			resources.unregisterResource(ptr);
+			alloc.deleteInstance(ptr);
+		}
+	}
+}
+
 } // end namespace anki
@@ -0,0 +1,63 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Resource/ShaderVariantManifest.h>
+
+ANKI_TEST(Resource, ShaderVariantManifest)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const CString fname = "ShaderVariantManifestTest.ankivariants";
+
+	// Record and save
+	{
+		ShaderVariantManifest manifest(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(manifest.load("ShaderVariantManifestTestMissing.ankivariants"));
+
+		const Array<U8, 2> a = {1, 2};
+		const Array<U8, 2> b = {3, 4};
+		manifest.recordVariant("Prog.ankiprog", a);
+		manifest.recordVariant("Prog.ankiprog", b);
+		manifest.recordVariant("Prog.ankiprog", a);
+		manifest.recordVariant("Mtl.ankimtl", a);
+
+		DynamicArrayAuto<U8> variants(alloc);
+		U32 variantSize;
+		manifest.getVariants("Prog.ankiprog", variants, variantSize);
+		ANKI_TEST_EXPECT_EQ(variantSize, 2);
+		ANKI_TEST_EXPECT_EQ(variants.getSize(), 4);
+		ANKI_TEST_EXPECT_EQ(variants[2], 3);
+
+		manifest.getVariants("Other.ankiprog", variants, variantSize);
+		ANKI_TEST_EXPECT_EQ(variantSize, 0);
+		ANKI_TEST_EXPECT_EQ(variants.getSize(), 0);
+
+		ANKI_TEST_EXPECT_NO_ERR(manifest.save(fname));
+	}
+
+	// Load
+	{
+		ShaderVariantManifest manifest(alloc);
+		ANKI_TEST_EXPECT_NO_ERR(manifest.load(fname));
+
+		DynamicArrayAuto<U8> variants(alloc);
+		U32 variantSize;
+		manifest.getVariants("Prog.ankiprog", variants, variantSize);
+		ANKI_TEST_EXPECT_EQ(variantSize, 2);
+		ANKI_TEST_EXPECT_EQ(variants.getSize(), 4);
+		ANKI_TEST_EXPECT_EQ(variants[0], 1);
+		ANKI_TEST_EXPECT_EQ(variants[3], 4);
+
+		manifest.getVariants("Mtl.ankimtl", variants, variantSize);
+		ANKI_TEST_EXPECT_EQ(variants.getSize(), 2);
+
+		// A different size means that the resource changed. The old variants are dropped
+		const Array<U8, 3> c = {5, 6, 7};
+		manifest.recordVariant("Prog.ankiprog", c);
+		manifest.getVariants("Prog.ankiprog", variants, variantSize);
+		ANKI_TEST_EXPECT_EQ(variantSize, 3);
+		ANKI_TEST_EXPECT_EQ(variants.getSize(), 3);
+	}
+}
@@ -5,6 +5,10 @@
 
 #include <Tests/Framework/Framework.h>
 #include <AnKi/Scene/Octree.h>
+#include <AnKi/Collision/Functions.h>
+#include <AnKi/Util/ThreadHive.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/System.h>
 
 namespace anki
 {
@@ -86,4 +90,168 @@ ANKI_TEST(Scene, Octree)
 #endif
 }
 
+ANKI_TEST(Scene, OctreeMovingObjectsBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 OBJECT_COUNT = 100000;
+	const U32 FRAME_COUNT = 10;
+	const F32 SCENE_SIZE = 1000.0f;
+
+	class Object
+	{
+	public:
+		OctreePlaceable m_placeable;
+		Aabb m_volume;
+	};
+
+	std::vector<Object> objects(OBJECT_COUNT);
+	for(Object& obj : objects)
+	{
+		obj.m_placeable.m_userData = &obj;
+	}
+
+	auto moveObjects = [&]() {
+		for(Object& obj : objects)
+		{
+			const F32 halfSize = getRandomRange(0.1f, 5.0f);
+			const Vec3 center(getRandomRange(-SCENE_SIZE + halfSize, SCENE_SIZE - halfSize),
+							  getRandomRange(-SCENE_SIZE + halfSize, SCENE_SIZE - halfSize),
+							  getRandomRange(-SCENE_SIZE + halfSize, SCENE_SIZE - halfSize));
+			obj.m_volume = Aabb((center - halfSize).xyz0(), (center + halfSize).xyz0());
+		}
+	};
+
+	// Update the objects in parallel, like the scene update does
+	ThreadHive hive(getCpuCoresCount(), alloc);
+
+	class TaskCtx
+	{
+	public:
+		Octree* m_octree;
+		Object* m_objects;
+		U32 m_objectCount;
+		Bool m_deferred;
+	};
+
+	auto update = [&](Octree& octree, Bool deferred) -> Second {
+		const U32 taskCount = hive.getThreadCount() * 4;
+		const U32 objectsPerTask = (OBJECT_COUNT + taskCount - 1) / taskCount;
+		std::vector<TaskCtx> ctxs(taskCount);
+		std::vector<ThreadHiveTask> tasks(taskCount);
+		for(U32 i = 0; i < taskCount; ++i)
+		{
+			const U32 first = min(i * objectsPerTask, OBJECT_COUNT);
+			const U32 end = min(first + objectsPerTask, OBJECT_COUNT);
+			ctxs[i] = {&octree, &objects[first], end - first, deferred};
+			tasks[i] = ANKI_THREAD_HIVE_TASK(
+				{
+					for(U32 j = 0; j < self->m_objectCount; ++j)
+					{
+						Object& obj = self->m_objects[j];
+						if(self->m_deferred)
+						{
+							self->m_octree->placeDeferred(obj.m_volume, &obj.m_placeable, true);
+						}
+						else
+						{
+							self->m_octree->place(obj.m_volume, &obj.m_placeable, true);
+						}
+					}
+				},
+				&ctxs[i], nullptr, nullptr);
+		}
+
+		const Second begin = HighRezTimer::getCurrentTime();
+		hive.submitTasks(&tasks[0], taskCount);
+		hive.waitAllTasks();
+		if(deferred)
+		{
+			octree.applyDeferredPlacements(&hive);
+		}
+		return HighRezTimer::getCurrentTime() - begin;
+	};
+
+	// Check that a query returns at least the objects that overlap it
+	auto validate = [&](Octree& octree, U32 testId) {
+		for(Object& obj : objects)
+		{
+			obj.m_placeable.reset();
+		}
+
+		const Aabb query(Vec4(-200.0f, -300.0f, -100.0f, 0.0f), Vec4(100.0f, 50.0f, 250.0f, 0.0f));
+		std::vector<Bool> found(OBJECT_COUNT, false);
+		U32 foundCount = 0;
+		octree.walkTree(
+			testId, [&](const Aabb& leafBox) { return testCollision(leafBox, query); },
+			[&](void* ud) {
+				const Object* obj = static_cast<const Object*>(ud);
+				found[obj - &objects[0]] = true;
+				++foundCount;
+			});
+
+		U32 missingCount = 0;
+		U32 expectedCount = 0;
+		for(U32 i = 0; i < OBJECT_COUNT; ++i)
+		{
+			if(testCollision(objects[i].m_volume, query))
+			{
+				++expectedCount;
+				missingCount += !found[i];
+			}
+		}
+
+		ANKI_TEST_EXPECT_GT(expectedCount, 0);
+		ANKI_TEST_EXPECT_GEQ(foundCount, expectedCount);
+		ANKI_TEST_EXPECT_EQ(missingCount, 0);
+	};
+
+	Second lockedTime = 0.0;
+	Second deferredTime = 0.0;
+	{
+		Octree octree(alloc);
+		octree.init(Vec3(-SCENE_SIZE), Vec3(SCENE_SIZE), 5);
+
+		for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			moveObjects();
+			lockedTime += update(octree, false);
+		}
+
+		validate(octree, 0);
+
+		for(Object& obj : objects)
+		{
+			octree.remove(obj.m_placeable);
+		}
+	}
+
+	{
+		Octree octree(alloc);
+		octree.init(Vec3(-SCENE_SIZE), Vec3(SCENE_SIZE), 5);
+
+		for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			moveObjects();
+			deferredTime += update(octree, true);
+		}
+
+		validate(octree, 0);
+
+		// Also check the bounds
+		Vec3 sceneMin, sceneMax;
+		octree.getActualSceneBounds(sceneMin, sceneMax);
+		ANKI_TEST_EXPECT_GEQ(sceneMin.x(), -SCENE_SIZE);
+		ANKI_TEST_EXPECT_LEQ(sceneMax.x(), SCENE_SIZE);
+
+		for(Object& obj : objects)
+		{
+			octree.remove(obj.m_placeable);
+		}
+	}
+
+	ANKI_TEST_LOGI("Moving %u objects for %u frames with %u threads. Locked %fms, deferred %fms", OBJECT_COUNT,
+				   FRAME_COUNT, hive.getThreadCount(), lockedTime * 1000.0, deferredTime * 1000.0);
+}
+
 } // end namespace anki
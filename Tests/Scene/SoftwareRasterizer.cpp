@@ -0,0 +1,269 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Scene/SoftwareRasterizer.h>
+#include <AnKi/Collision/Aabb.h>
+#include <AnKi/Util/ThreadHive.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/System.h>
+
+namespace anki
+{
+
+/// The scalar per pixel rasterizer the SoftwareRasterizer used to have. Used as a reference.
+class ReferenceRasterizer
+{
+public:
+	U32 m_width;
+	U32 m_height;
+	Mat4 m_mvp;
+	std::vector<U32> m_zbuffer;
+
+	void prepare(const Mat4& mvp, U32 width, U32 height)
+	{
+		m_mvp = mvp;
+		m_width = width;
+		m_height = height;
+		m_zbuffer.assign(width * height, MAX_U32);
+	}
+
+	void draw(const Vec3* verts, U32 vertCount)
+	{
+		for(U32 i = 0; i < vertCount; i += 3)
+		{
+			Array<Vec4, 3> clip;
+			for(U32 j = 0; j < 3; ++j)
+			{
+				clip[j] = m_mvp * Vec4(verts[i + j], 1.0f);
+			}
+
+			rasterizeTriangle(&clip[0]);
+		}
+	}
+
+	Bool visibilityTest(const Aabb& aabb) const
+	{
+		Vec4 bboxMin, bboxMax;
+		if(!computeBounds(aabb, bboxMin, bboxMax))
+		{
+			return true;
+		}
+
+		for(F32 y = bboxMin.y(); y < bboxMax.y(); y += 1.0f)
+		{
+			for(F32 x = bboxMin.x(); x < bboxMax.x(); x += 1.0f)
+			{
+				const F32 depthf = F32(m_zbuffer[U32(y) * m_width + U32(x)]) / F32(MAX_U32);
+				if(bboxMin.z() < depthf)
+				{
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+private:
+	void rasterizeTriangle(const Vec4* tri)
+	{
+		const Vec2 windowSize{F32(m_width), F32(m_height)};
+		Array<Vec3, 3> ndc;
+		Array<Vec2, 3> window;
+		Vec2 bboxMin(MAX_F32), bboxMax(MIN_F32);
+		for(U i = 0; i < 3; i++)
+		{
+			ndc[i] = tri[i].xyz() / tri[i].w();
+			window[i] = (ndc[i].xy() / 2.0f + 0.5f) * windowSize;
+
+			for(U j = 0; j < 2; j++)
+			{
+				bboxMin[j] = clamp(std::floor(min(bboxMin[j], window[i][j])), 0.0f, windowSize[j]);
+				bboxMax[j] = clamp(std::ceil(max(bboxMax[j], window[i][j])), 0.0f, windowSize[j]);
+			}
+		}
+
+		for(F32 y = bboxMin.y() + 0.5f; y < bboxMax.y(); y += 1.0f)
+		{
+			for(F32 x = bboxMin.x() + 0.5f; x < bboxMax.x(); x += 1.0f)
+			{
+				const Vec2 dca = window[2] - window[0];
+				const Vec2 dba = window[1] - window[0];
+				const Vec2 dap = window[0] - Vec2(x, y);
+				const Vec3 k = Vec3(dca.x(), dba.x(), dap.x()).cross(Vec3(dca.y(), dba.y(), dap.y()));
+				if(isZero(k.z()))
+				{
+					continue;
+				}
+
+				const Vec3 bc(1.0f - (k.x() + k.y()) / k.z(), k.y() / k.z(), k.x() / k.z());
+				if(bc.x() < 0.0f || bc.y() < 0.0f || bc.z() < 0.0f)
+				{
+					continue;
+				}
+
+				F32 depth = ndc[0].z() * bc[0] + ndc[1].z() * bc[1] + ndc[2].z() * bc[2];
+				depth = min(depth, 1.0f - EPSILON);
+				U32& z = m_zbuffer[U32(y) * m_width + U32(x)];
+				z = min(z, U32(depth * F32(MAX_U32)));
+			}
+		}
+	}
+
+	Bool computeBounds(const Aabb& aabb, Vec4& bboxMin, Vec4& bboxMax) const
+	{
+		bboxMin = Vec4(MAX_F32);
+		bboxMax = Vec4(MIN_F32);
+		for(U32 i = 0; i < 8; ++i)
+		{
+			const Vec4 p((i & 1) ? aabb.getMax().x() : aabb.getMin().x(),
+						 (i & 2) ? aabb.getMax().y() : aabb.getMin().y(),
+						 (i & 4) ? aabb.getMax().z() : aabb.getMin().z(), 1.0f);
+			Vec4 c = m_mvp * p;
+			if(c.w() <= 0.0f)
+			{
+				return false;
+			}
+
+			c /= c.w();
+			c = (c * Vec4(0.5f, 0.5f, 1.0f, 1.0f) + Vec4(0.5f, 0.5f, 0.0f, 0.0f))
+				* Vec4(F32(m_width), F32(m_height), 1.0f, 1.0f);
+			bboxMin = bboxMin.min(c);
+			bboxMax = bboxMax.max(c);
+		}
+
+		bboxMin.x() = clamp(floorf(bboxMin.x()), 0.0f, F32(m_width));
+		bboxMax.x() = clamp(ceilf(bboxMax.x()), 0.0f, F32(m_width));
+		bboxMin.y() = clamp(floorf(bboxMin.y()), 0.0f, F32(m_height));
+		bboxMax.y() = clamp(ceilf(bboxMax.y()), 0.0f, F32(m_height));
+		return true;
+	}
+};
+
+ANKI_TEST(Scene, SoftwareRasterizerBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 WIDTH = 640;
+	const U32 HEIGHT = 360;
+	const U32 TRIANGLE_COUNT = 100000;
+	const U32 AABB_COUNT = 20000;
+
+	const Mat4 view = Mat4::getIdentity();
+	const Mat4 proj =
+		Mat4::calculatePerspectiveProjectionMatrix(toRad(90.0f), toRad(90.0f) * F32(HEIGHT) / F32(WIDTH), 0.1f, 200.0f);
+
+	// Random occluders in front of the camera
+	std::vector<Vec3> verts(TRIANGLE_COUNT * 3);
+	for(U32 i = 0; i < TRIANGLE_COUNT; ++i)
+	{
+		const Vec3 center(getRandomRange(-60.0f, 60.0f), getRandomRange(-35.0f, 35.0f), getRandomRange(-150.0f, -5.0f));
+		const F32 size = getRandomRange(0.1f, 3.0f);
+		for(U32 j = 0; j < 3; ++j)
+		{
+			verts[i * 3 + j] =
+				center + Vec3(getRandomRange(-size, size), getRandomRange(-size, size), getRandomRange(-size, size));
+		}
+	}
+
+	std::vector<Aabb> aabbs(AABB_COUNT);
+	for(Aabb& aabb : aabbs)
+	{
+		const Vec3 center(getRandomRange(-60.0f, 60.0f), getRandomRange(-35.0f, 35.0f), getRandomRange(-150.0f, -5.0f));
+		const Vec3 extend(getRandomRange(0.1f, 4.0f), getRandomRange(0.1f, 4.0f), getRandomRange(0.1f, 4.0f));
+		aabb = Aabb((center - extend).xyz0(), (center + extend).xyz0());
+	}
+
+	// Reference
+	ReferenceRasterizer ref;
+	ref.prepare(proj * view, WIDTH, HEIGHT);
+	Second begin = HighRezTimer::getCurrentTime();
+	ref.draw(&verts[0], U32(verts.size()));
+	const Second refDrawTime = HighRezTimer::getCurrentTime() - begin;
+
+	std::vector<Bool> refResults(AABB_COUNT);
+	begin = HighRezTimer::getCurrentTime();
+	for(U32 i = 0; i < AABB_COUNT; ++i)
+	{
+		refResults[i] = ref.visibilityTest(aabbs[i]);
+	}
+	const Second refTestTime = HighRezTimer::getCurrentTime() - begin;
+
+	// New
+	SoftwareRasterizer r;
+	r.init(alloc);
+	r.prepare(view, proj, WIDTH, HEIGHT);
+	begin = HighRezTimer::getCurrentTime();
+	r.draw(&verts[0].x(), U32(verts.size()), sizeof(Vec3), false);
+	const Second drawTime = HighRezTimer::getCurrentTime() - begin;
+
+	U32 mismatchCount = 0;
+	U32 visibleCount = 0;
+	begin = HighRezTimer::getCurrentTime();
+	for(U32 i = 0; i < AABB_COUNT; ++i)
+	{
+		const Bool visible = r.visibilityTest(aabbs[i]);
+		mismatchCount += visible != refResults[i];
+		visibleCount += visible;
+	}
+	const Second testTime = HighRezTimer::getCurrentTime() - begin;
+
+	// New with a few threads drawing in parallel
+	const U32 threadCount = getCpuCoresCount();
+	ThreadHive hive(threadCount, alloc);
+	r.prepare(view, proj, WIDTH, HEIGHT);
+
+	class DrawTaskCtx
+	{
+	public:
+		SoftwareRasterizer* m_r;
+		const F32* m_verts;
+		U32 m_vertCount;
+	};
+	std::vector<DrawTaskCtx> ctxs(threadCount);
+	std::vector<ThreadHiveTask> tasks(threadCount);
+	const U32 trisPerTask = (TRIANGLE_COUNT + threadCount - 1) / threadCount;
+	U32 taskCount = 0;
+	for(U32 i = 0; i < threadCount; ++i)
+	{
+		const U32 firstTri = i * trisPerTask;
+		const U32 lastTri = min(firstTri + trisPerTask, TRIANGLE_COUNT);
+		if(firstTri >= lastTri)
+		{
+			break;
+		}
+
+		ctxs[i] = {&r, &verts[firstTri * 3].x(), (lastTri - firstTri) * 3};
+		tasks[i].m_argument = &ctxs[i];
+		tasks[i].m_callback = [](void* ud, U32, ThreadHive&, ThreadHiveSemaphore*) {
+			DrawTaskCtx& ctx = *static_cast<DrawTaskCtx*>(ud);
+			ctx.m_r->draw(ctx.m_verts, ctx.m_vertCount, sizeof(Vec3), false);
+		};
+		++taskCount;
+	}
+
+	begin = HighRezTimer::getCurrentTime();
+	hive.submitTasks(&tasks[0], taskCount);
+	hive.waitAllTasks();
+	const Second parallelDrawTime = HighRezTimer::getCurrentTime() - begin;
+
+	U32 parallelMismatchCount = 0;
+	for(U32 i = 0; i < AABB_COUNT; ++i)
+	{
+		parallelMismatchCount += r.visibilityTest(aabbs[i]) != refResults[i];
+	}
+
+	ANKI_TEST_LOGI("Rasterizing %u triangles. Reference %fms, new %fms, new with %u threads %fms", TRIANGLE_COUNT,
+				   refDrawTime * 1000.0, drawTime * 1000.0, threadCount, parallelDrawTime * 1000.0);
+	ANKI_TEST_LOGI("Testing %u boxes (%u visible). Reference %fms, new %fms. Mismatches %u", AABB_COUNT, visibleCount,
+				   refTestTime * 1000.0, testTime * 1000.0, mismatchCount);
+
+	// The depth is interpolated and stored with different precision so boxes that intersect the occluders may differ
+	ANKI_TEST_EXPECT_LEQ(mismatchCount, AABB_COUNT / 50);
+	ANKI_TEST_EXPECT_EQ(parallelMismatchCount, mismatchCount);
+}
+
+} // end namespace anki
@@ -0,0 +1,184 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Scene/TransformStore.h>
+#include <AnKi/Util/HighRezTimer.h>
+
+namespace anki
+{
+
+static Transform randomTransform()
+{
+	Mat3x4 rot = Mat3x4::getIdentity();
+	rot.rotateXAxis(getRandomRange(-PI, PI));
+	rot.rotateYAxis(getRandomRange(-PI, PI));
+	return Transform(Vec4(getRandomRange(-10.0f, 10.0f), getRandomRange(-10.0f, 10.0f), getRandomRange(-10.0f, 10.0f),
+						  0.0f),
+					 rot, getRandomRange(0.5f, 2.0f));
+}
+
+static Bool transformsEqual(const Transform& a, const Transform& b)
+{
+	const Vec3 p(1.0f, 2.0f, 3.0f);
+	return (a.getOrigin() - b.getOrigin()).getLength() < 0.001f && absolute(a.getScale() - b.getScale()) < 0.001f
+		   && (a.transform(p) - b.transform(p)).getLength() < 0.01f;
+}
+
+ANKI_TEST(Scene, TransformStore)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Handles are recycled
+	{
+		TransformStore store(alloc);
+		const U32 a = store.newTransform();
+		const U32 b = store.newTransform();
+		ANKI_TEST_EXPECT_NEQ(a, b);
+		ANKI_TEST_EXPECT_EQ(store.getTransformCount(), 2);
+
+		store.getLocalOrigin(a) = Vec4(1.0f, 2.0f, 3.0f, 0.0f);
+		store.deleteTransform(a);
+		const U32 c = store.newTransform();
+		ANKI_TEST_EXPECT_EQ(c, a);
+		ANKI_TEST_EXPECT_EQ(store.getLocalOrigin(c), Vec4(0.0f));
+
+		store.deleteTransform(b);
+		store.deleteTransform(c);
+		ANKI_TEST_EXPECT_EQ(store.getTransformCount(), 0);
+	}
+
+	// World transforms and previous world transforms of chains that span many chunks
+	{
+		const U32 CHAIN_COUNT = 1000;
+		const U32 CHAIN_LENGTH = 4;
+		TransformStore store(alloc);
+		std::vector<U32> handles;
+		std::vector<Transform> expected;
+
+		for(U32 c = 0; c < CHAIN_COUNT; ++c)
+		{
+			for(U32 i = 0; i < CHAIN_LENGTH; ++i)
+			{
+				const Transform local = randomTransform();
+				const U32 handle = store.newTransform();
+				store.setLocalTransform(handle, local);
+
+				// A parent is always updated before the children
+				const U32 parent = (i == 0) ? TransformStore::INVALID_HANDLE : handles.back();
+				store.updateWorldTransform(handle, parent, false);
+
+				expected.push_back((i == 0) ? local : expected.back().combineTransformations(local));
+				handles.push_back(handle);
+			}
+		}
+
+		U32 wrongCount = 0;
+		for(U32 i = 0; i < handles.size(); ++i)
+		{
+			wrongCount += !transformsEqual(store.getWorldTransform(handles[i]), expected[i]);
+			wrongCount += !transformsEqual(store.getPreviousWorldTransform(handles[i]), Transform::getIdentity());
+		}
+		ANKI_TEST_EXPECT_EQ(wrongCount, 0);
+
+		store.beginFrame();
+		wrongCount = 0;
+		for(U32 i = 0; i < handles.size(); ++i)
+		{
+			wrongCount += !transformsEqual(store.getPreviousWorldTransform(handles[i]), expected[i]);
+		}
+		ANKI_TEST_EXPECT_EQ(wrongCount, 0);
+
+		// Ignore the local
+		store.updateWorldTransform(handles[1], handles[0], true);
+		ANKI_TEST_EXPECT_EQ(transformsEqual(store.getWorldTransform(handles[1]), expected[0]), true);
+
+		for(U32 handle : handles)
+		{
+			store.deleteTransform(handle);
+		}
+	}
+}
+
+ANKI_TEST(Scene, TransformStoreBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const U32 COUNT = 100000;
+	const U32 ITERATIONS = 10;
+
+	// The way MoveComponent used to keep the transforms. The objects are spread around the heap
+	class InlineTransforms
+	{
+	public:
+		Transform m_local = Transform::getIdentity();
+		Transform m_world = Transform::getIdentity();
+		Transform m_prevWorld = Transform::getIdentity();
+		Array<U8, 200> m_otherStuff;
+		InlineTransforms* m_parent = nullptr;
+	};
+
+	std::vector<InlineTransforms*> objects(COUNT);
+	std::vector<void*> padding(COUNT);
+	TransformStore store(alloc);
+	std::vector<U32> handles(COUNT);
+	std::vector<U32> parents(COUNT);
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		const Transform local = randomTransform();
+
+		objects[i] = alloc.newInstance<InlineTransforms>();
+		objects[i]->m_local = local;
+		objects[i]->m_parent = (i % 4) ? objects[i - 1] : nullptr;
+		padding[i] = alloc.getMemoryPool().allocate(getRandomRange<PtrSize>(16, 256), 16);
+
+		handles[i] = store.newTransform();
+		store.setLocalTransform(handles[i], local);
+		parents[i] = (i % 4) ? handles[i - 1] : TransformStore::INVALID_HANDLE;
+	}
+
+	Second inlineTime = 0.0;
+	Second storeTime = 0.0;
+	for(U32 it = 0; it < ITERATIONS; ++it)
+	{
+		Second begin = HighRezTimer::getCurrentTime();
+		for(InlineTransforms* obj : objects)
+		{
+			obj->m_prevWorld = obj->m_world;
+		}
+		for(InlineTransforms* obj : objects)
+		{
+			obj->m_world = (obj->m_parent) ? obj->m_parent->m_world.combineTransformations(obj->m_local) : obj->m_local;
+		}
+		inlineTime += HighRezTimer::getCurrentTime() - begin;
+
+		begin = HighRezTimer::getCurrentTime();
+		store.beginFrame();
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			store.updateWorldTransform(handles[i], parents[i], false);
+		}
+		storeTime += HighRezTimer::getCurrentTime() - begin;
+	}
+
+	U32 wrongCount = 0;
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		wrongCount += !transformsEqual(store.getWorldTransform(handles[i]), objects[i]->m_world);
+		wrongCount += !transformsEqual(store.getPreviousWorldTransform(handles[i]), objects[i]->m_prevWorld);
+	}
+	ANKI_TEST_EXPECT_EQ(wrongCount, 0);
+
+	ANKI_TEST_LOGI("Updating %u transforms. Inline %fms, store %fms", COUNT, inlineTime / ITERATIONS * 1000.0,
+				   storeTime / ITERATIONS * 1000.0);
+
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		alloc.deleteInstance(objects[i]);
+		alloc.getMemoryPool().free(padding[i]);
+		store.deleteTransform(handles[i]);
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,217 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Script.h>
+#include <AnKi/Math.h>
+#include <AnKi/Util/HighRezTimer.h>
+
+static const char* PER_INSTANCE_SCRIPT = R"(
+count = 0
+
+function update(v, prevTime, crntTime)
+	count = count + 1
+	v:setX(count)
+	if other then
+		other:setY(other:getY() + 1)
+	end
+	return 1
+end
+)";
+
+static const char* BATCHED_SCRIPT = R"(
+-- The top-level code runs once per instance and sees the instance's object
+object:setY(object:getY() + 1)
+
+function updateBatch(instances, prevTime, crntTime)
+	for i = 1, #instances do
+		local v = instances[i].object
+		v:setX(v:getX() + crntTime - prevTime)
+	end
+	return 1
+end
+)";
+
+ANKI_TEST(Script, ScriptBatch)
+{
+	ScriptManager sm;
+	ANKI_TEST_EXPECT_NO_ERR(sm.init(allocAligned, nullptr));
+
+	// Every instance has its own globals
+	{
+		ScriptBatch batch;
+		ANKI_TEST_EXPECT_NO_ERR(batch.init(&sm, PER_INSTANCE_SCRIPT));
+
+		Array<Vec4, 3> vecs = {Vec4(0.0f), Vec4(0.0f), Vec4(0.0f)};
+		Array<U32, 3> ids;
+		for(U32 i = 0; i < 3; ++i)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(batch.newInstance("object", &vecs[i], ids[i]));
+		}
+		ANKI_TEST_EXPECT_EQ(batch.isBatched(), false);
+
+		Vec3 other(0.0f);
+		batch.exposeInstanceVariable(ids[1], "other", &other);
+
+		ANKI_TEST_EXPECT_NO_ERR(batch.update(0.0, 1.0));
+		ANKI_TEST_EXPECT_NO_ERR(batch.update(1.0, 2.0));
+		for(const Vec4& v : vecs)
+		{
+			ANKI_TEST_EXPECT_EQ(v.x(), 2.0f);
+		}
+		ANKI_TEST_EXPECT_EQ(other.y(), 2.0f);
+
+		// Deleted instances are not updated and their IDs are re-used
+		batch.deleteInstance(ids[0]);
+		ANKI_TEST_EXPECT_NO_ERR(batch.update(2.0, 3.0));
+		ANKI_TEST_EXPECT_EQ(vecs[0].x(), 2.0f);
+		ANKI_TEST_EXPECT_EQ(vecs[1].x(), 3.0f);
+		ANKI_TEST_EXPECT_EQ(batch.getInstanceCount(), 2);
+
+		U32 id;
+		ANKI_TEST_EXPECT_NO_ERR(batch.newInstance("object", &vecs[0], id));
+		ANKI_TEST_EXPECT_EQ(id, ids[0]);
+		ANKI_TEST_EXPECT_NO_ERR(batch.update(3.0, 4.0));
+		ANKI_TEST_EXPECT_EQ(vecs[0].x(), 1.0f);
+
+		for(U32 i = 0; i < 3; ++i)
+		{
+			batch.deleteInstance(ids[i]);
+		}
+	}
+
+	// One call for all instances
+	{
+		ScriptBatch batch;
+		ANKI_TEST_EXPECT_NO_ERR(batch.init(&sm, BATCHED_SCRIPT));
+
+		Array<Vec4, 4> vecs = {Vec4(0.0f), Vec4(0.0f), Vec4(0.0f), Vec4(0.0f)};
+		Array<U32, 4> ids;
+		for(U32 i = 0; i < 4; ++i)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(batch.newInstance("object", &vecs[i], ids[i]));
+		}
+		ANKI_TEST_EXPECT_EQ(batch.isBatched(), true);
+		for(const Vec4& v : vecs)
+		{
+			ANKI_TEST_EXPECT_EQ(v.y(), 1.0f);
+		}
+
+		ANKI_TEST_EXPECT_NO_ERR(batch.update(0.0, 0.5));
+		batch.deleteInstance(ids[2]);
+		ANKI_TEST_EXPECT_NO_ERR(batch.update(0.5, 1.0));
+
+		ANKI_TEST_EXPECT_EQ(vecs[0].x(), 1.0f);
+		ANKI_TEST_EXPECT_EQ(vecs[2].x(), 0.5f);
+		ANKI_TEST_EXPECT_EQ(vecs[3].x(), 1.0f);
+
+		batch.deleteInstance(ids[0]);
+		batch.deleteInstance(ids[1]);
+		batch.deleteInstance(ids[3]);
+	}
+
+	// Errors
+	{
+		ScriptBatch batch;
+		ANKI_TEST_EXPECT_NO_ERR(batch.init(&sm, "function update(v, prevTime, crntTime) return -1 end"));
+		Vec4 v(0.0f);
+		U32 id;
+		ANKI_TEST_EXPECT_NO_ERR(batch.newInstance("object", &v, id));
+		ANKI_TEST_EXPECT_ERR(batch.update(0.0, 1.0), Error::USER_DATA);
+		batch.deleteInstance(id);
+
+		ScriptBatch batch2;
+		ANKI_TEST_EXPECT_ERR(batch2.init(&sm, "function update("), Error::USER_DATA);
+	}
+}
+
+ANKI_TEST(Script, ScriptBatchBench)
+{
+	ScriptManager sm;
+	ANKI_TEST_EXPECT_NO_ERR(sm.init(allocAligned, nullptr));
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 ENTITY_COUNT = 256;
+	const U32 FRAME_COUNT = 200;
+	static const char* UPDATE_SCRIPT = R"(
+function update(v, prevTime, crntTime)
+	v:setX(v:getX() + crntTime - prevTime)
+	return 1
+end
+)";
+
+	DynamicArrayAuto<Vec4> vecs(alloc);
+	vecs.create(ENTITY_COUNT, Vec4(0.0f));
+
+	// One LUA state per entity, the way the ScriptComponent used to do it
+	Second separateTime;
+	{
+		DynamicArrayAuto<ScriptEnvironment*> envs(alloc);
+		for(U32 i = 0; i < ENTITY_COUNT; ++i)
+		{
+			ScriptEnvironment* env = alloc.newInstance<ScriptEnvironment>();
+			ANKI_TEST_EXPECT_NO_ERR(env->init(&sm));
+			ANKI_TEST_EXPECT_NO_ERR(env->evalString(UPDATE_SCRIPT));
+			envs.emplaceBack(env);
+		}
+
+		const Second begin = HighRezTimer::getCurrentTime();
+		for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			for(U32 i = 0; i < ENTITY_COUNT; ++i)
+			{
+				lua_State* l = &envs[i]->getLuaState();
+				lua_getglobal(l, "update");
+				LuaBinder::pushVariableToTheStack(l, &vecs[i]);
+				lua_pushnumber(l, frame);
+				lua_pushnumber(l, frame + 1);
+				ANKI_TEST_EXPECT_EQ(lua_pcall(l, 3, 1, 0), 0);
+				lua_pop(l, 1);
+			}
+		}
+		separateTime = HighRezTimer::getCurrentTime() - begin;
+
+		for(ScriptEnvironment* env : envs)
+		{
+			alloc.deleteInstance(env);
+		}
+	}
+
+	auto benchBatch = [&](CString script) -> Second {
+		ScriptBatch batch;
+		ANKI_TEST_EXPECT_NO_ERR(batch.init(&sm, script));
+		DynamicArrayAuto<U32> ids(alloc);
+		ids.create(ENTITY_COUNT);
+		for(U32 i = 0; i < ENTITY_COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(batch.newInstance("object", &vecs[i], ids[i]));
+		}
+
+		const Second begin = HighRezTimer::getCurrentTime();
+		for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(batch.update(frame, frame + 1));
+		}
+		const Second time = HighRezTimer::getCurrentTime() - begin;
+
+		for(U32 id : ids)
+		{
+			batch.deleteInstance(id);
+		}
+		return time;
+	};
+
+	const Second sharedTime = benchBatch(UPDATE_SCRIPT);
+	const Second batchedTime = benchBatch(BATCHED_SCRIPT);
+
+	for(const Vec4& v : vecs)
+	{
+		ANKI_TEST_EXPECT_EQ(v.x(), F32(FRAME_COUNT * 3));
+	}
+
+	const F64 toNsPerEntity = 1000000000.0 / (ENTITY_COUNT * FRAME_COUNT);
+	ANKI_TEST_LOGI("Per entity update: Separate states %fns, shared state %fns, batched %fns",
+				   separateTime * toNsPerEntity, sharedTime * toNsPerEntity, batchedTime * toNsPerEntity);
+}
@@ -6,6 +6,7 @@
 #include <Tests/Framework/Framework.h>
 #include <AnKi/ShaderCompiler/ShaderProgramCompiler.h>
 #include <AnKi/Util/ThreadHive.h>
+#include <AnKi/Util/HashMap.h>
 
 ANKI_TEST(ShaderCompiler, ShaderProgramCompilerSimple)
 {
@@ -139,14 +140,81 @@ void main()
 	ShaderProgramBinaryWrapper binary(alloc);
 	BindlessLimits bindlessLimits;
 	GpuDeviceCapabilities gpuCapabilities;
-	ANKI_TEST_EXPECT_NO_ERR(compileShaderProgram("test.glslp", fsystem, nullptr, &taskManager, alloc, gpuCapabilities,
-												 bindlessLimits, binary));
+	ANKI_TEST_EXPECT_NO_ERR(compileShaderProgram("test.glslp", fsystem, nullptr, &taskManager, nullptr, alloc,
+												 gpuCapabilities, bindlessLimits, binary));
 
 #if 1
 	StringAuto dis(alloc);
 	dumpShaderProgramBinary(binary.getBinary(), dis);
 	ANKI_LOGI("Binary disassembly:\n%s\n", dis.cstr());
 #endif
+
+	// Compile again with a SPIR-V cache. The 2nd time shouldn't invoke glslang at all
+	class SpirvCache : public ShaderProgramSpirvCacheInterface
+	{
+	public:
+		class Blob
+		{
+		public:
+			String m_source;
+			ShaderType m_shaderType;
+			DynamicArray<U8> m_spirv;
+		};
+
+		HeapAllocator<U8> m_alloc;
+		Mutex m_mtx;
+		HashMap<U64, Blob> m_blobs;
+		U32 m_hits = 0;
+		U32 m_misses = 0;
+
+		Bool find(U64 sourceHash, ShaderType shaderType, CString source, DynamicArrayAuto<U8>& spirv) final
+		{
+			LockGuard<Mutex> lock(m_mtx);
+			auto it = m_blobs.find(sourceHash);
+			if(it == m_blobs.getEnd() || it->m_shaderType != shaderType || it->m_source.toCString() != source)
+			{
+				++m_misses;
+				return false;
+			}
+
+			++m_hits;
+			spirv.create(it->m_spirv.getSize());
+			memcpy(&spirv[0], it->m_spirv.getBegin(), it->m_spirv.getSizeInBytes());
+			return true;
+		}
+
+		void store(U64 sourceHash, ShaderType shaderType, CString source, ConstWeakArray<U8> spirv) final
+		{
+			LockGuard<Mutex> lock(m_mtx);
+			Blob blob;
+			blob.m_source.create(m_alloc, source);
+			blob.m_shaderType = shaderType;
+			blob.m_spirv.create(m_alloc, spirv.getSize());
+			memcpy(blob.m_spirv.getBegin(), spirv.getBegin(), spirv.getSizeInBytes());
+			m_blobs.emplace(m_alloc, sourceHash, std::move(blob));
+		}
+	} spirvCache;
+	spirvCache.m_alloc = alloc;
+
+	ShaderProgramBinaryWrapper binary2(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(compileShaderProgram("test.glslp", fsystem, nullptr, &taskManager, &spirvCache, alloc,
+												 gpuCapabilities, bindlessLimits, binary2));
+	ANKI_TEST_EXPECT_EQ(spirvCache.m_hits, 0);
+	const U32 misses = spirvCache.m_misses;
+
+	ShaderProgramBinaryWrapper binary3(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(compileShaderProgram("test.glslp", fsystem, nullptr, &taskManager, &spirvCache, alloc,
+												 gpuCapabilities, bindlessLimits, binary3));
+	ANKI_TEST_EXPECT_EQ(spirvCache.m_hits, misses);
+	ANKI_TEST_EXPECT_EQ(spirvCache.m_misses, misses);
+	ANKI_TEST_EXPECT_EQ(binary3.getBinary().m_codeBlocks.getSize(), binary.getBinary().m_codeBlocks.getSize());
+
+	for(auto& blob : spirvCache.m_blobs)
+	{
+		blob.m_source.destroy(alloc);
+		blob.m_spirv.destroy(alloc);
+	}
+	spirvCache.m_blobs.destroy(alloc);
 }
 
 ANKI_TEST(ShaderCompiler, ShaderProgramCompiler)
@@ -336,8 +404,8 @@ void main()
 	ShaderProgramBinaryWrapper binary(alloc);
 	BindlessLimits bindlessLimits;
 	GpuDeviceCapabilities gpuCapabilities;
-	ANKI_TEST_EXPECT_NO_ERR(compileShaderProgram("test.glslp", fsystem, nullptr, &taskManager, alloc, gpuCapabilities,
-												 bindlessLimits, binary));
+	ANKI_TEST_EXPECT_NO_ERR(compileShaderProgram("test.glslp", fsystem, nullptr, &taskManager, nullptr, alloc,
+												 gpuCapabilities, bindlessLimits, binary));
 
 #if 1
 	StringAuto dis(alloc);
@@ -63,3 +63,66 @@ ANKI_TEST(ShaderCompiler, ShaderCompilerParser)
 
 	// printf("%s\n", variant.getSource(ShaderType::VERTEX).cstr());
 }
+
+ANKI_TEST(ShaderCompiler, ShaderCompilerParserDependencies)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	class FilesystemInterface : public ShaderProgramFilesystemInterface
+	{
+	public:
+		CString m_includeSource = "#pragma once\n// inc\n";
+
+		Error readAllText(CString filename, StringAuto& txt) final
+		{
+			if(filename == "filename0")
+			{
+				txt = R"(
+#include "Inc.glsl"
+#include "Inc.glsl"
+
+#pragma anki start comp
+#pragma anki end
+				)";
+			}
+			else if(filename == "Inc.glsl")
+			{
+				txt = m_includeSource;
+			}
+			else
+			{
+				return Error::FUNCTION_FAILED;
+			}
+
+			return Error::NONE;
+		}
+	} interface;
+
+	BindlessLimits bindlessLimits;
+	GpuDeviceCapabilities gpuCapabilities;
+	U64 includeHash;
+	{
+		ShaderProgramParser parser("filename0", &interface, alloc, gpuCapabilities, bindlessLimits);
+		ANKI_TEST_EXPECT_NO_ERR(parser.parse());
+
+		// The program is first and the include is there once
+		ConstWeakArray<ShaderProgramDependency> deps = parser.getDependencies();
+		ANKI_TEST_EXPECT_EQ(deps.getSize(), 2);
+		ANKI_TEST_EXPECT_EQ(deps[0].m_filename, "filename0");
+		ANKI_TEST_EXPECT_EQ(deps[1].m_filename, "Inc.glsl");
+		ANKI_TEST_EXPECT_EQ(deps[1].m_hash, ShaderProgramParser::computeDependencyHash(interface.m_includeSource));
+		includeHash = deps[1].m_hash;
+	}
+
+	// Change the include and only its hash changes
+	interface.m_includeSource = "#pragma once\n// inc changed\n";
+	{
+		ShaderProgramParser parser("filename0", &interface, alloc, gpuCapabilities, bindlessLimits);
+		ANKI_TEST_EXPECT_NO_ERR(parser.parse());
+
+		ConstWeakArray<ShaderProgramDependency> deps = parser.getDependencies();
+		ANKI_TEST_EXPECT_EQ(deps.getSize(), 2);
+		ANKI_TEST_EXPECT_NEQ(deps[1].m_hash, includeHash);
+		ANKI_TEST_EXPECT_EQ(deps[1].m_hash, ShaderProgramParser::computeDependencyHash(interface.m_includeSource));
+	}
+}
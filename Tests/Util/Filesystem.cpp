@@ -6,6 +6,7 @@
 #include <Tests/Framework/Framework.h>
 #include <AnKi/Util/Filesystem.h>
 #include <AnKi/Util/File.h>
+#include <AnKi/Util/MemoryMappedFile.h>
 
 ANKI_TEST(Util, FileExists)
 {
@@ -53,6 +54,31 @@ ANKI_TEST(Util, Directory)
 	ANKI_TEST_EXPECT_EQ(directoryExists("./dir"), false);
 }
 
+ANKI_TEST(Util, RenameAndRemoveFile)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	if(directoryExists("./dir"))
+	{
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory("./dir", alloc));
+	}
+
+	ANKI_TEST_EXPECT_NO_ERR(createDirectory("./dir"));
+	File file;
+	ANKI_TEST_EXPECT_NO_ERR(file.open("./dir/tmp", FileOpenFlag::WRITE));
+	file.close();
+
+	ANKI_TEST_EXPECT_NO_ERR(renameFile("./dir/tmp", "./dir/tmp2"));
+	ANKI_TEST_EXPECT_EQ(fileExists("./dir/tmp"), false);
+	ANKI_TEST_EXPECT_EQ(fileExists("./dir/tmp2"), true);
+
+	ANKI_TEST_EXPECT_NO_ERR(removeFile("./dir/tmp2"));
+	ANKI_TEST_EXPECT_EQ(fileExists("./dir/tmp2"), false);
+	ANKI_TEST_EXPECT_ANY_ERR(removeFile("./dir/tmp2"));
+
+	ANKI_TEST_EXPECT_NO_ERR(removeDirectory("./dir", alloc));
+}
+
 ANKI_TEST(Util, HomeDir)
 {
 	HeapAllocator<char> alloc(allocAligned, nullptr);
@@ -131,3 +157,70 @@ ANKI_TEST(Util, WalkDir)
 
 	ANKI_TEST_EXPECT_EQ(count, 1);
 }
+
+ANKI_TEST(Util, MemoryMappedFile)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	StringAuto dir(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(dir));
+	dir.append("/AnKiMemoryMappedFileTest");
+	if(directoryExists(dir.toCString()))
+	{
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir.toCString(), alloc));
+	}
+	ANKI_TEST_EXPECT_NO_ERR(createDirectory(dir.toCString()));
+
+	StringAuto fname(alloc);
+	fname.sprintf("%s/mapped.bin", dir.cstr());
+
+	// Write a file bigger than a page
+	const U32 COUNT = 10000;
+	{
+		File file;
+		ANKI_TEST_EXPECT_NO_ERR(file.open(fname.toCString(), FileOpenFlag::WRITE | FileOpenFlag::BINARY));
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(file.write(&i, sizeof(i)));
+		}
+	}
+
+	// Whole file
+	{
+		MemoryMappedFile mapping;
+		ANKI_TEST_EXPECT_NO_ERR(mapping.map(fname.toCString()));
+		ANKI_TEST_EXPECT_EQ(mapping.getData().getSize(), COUNT * sizeof(U32));
+
+		U32 wrongCount = 0;
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			U32 u;
+			memcpy(&u, &mapping.getData()[i * sizeof(U32)], sizeof(u));
+			wrongCount += u != i;
+		}
+		ANKI_TEST_EXPECT_EQ(wrongCount, 0);
+	}
+
+	// A range that doesn't start at a page boundary
+	{
+		MemoryMappedFile mapping;
+		const U32 first = 1234;
+		ANKI_TEST_EXPECT_NO_ERR(mapping.map(fname.toCString(), first * sizeof(U32), 10 * sizeof(U32)));
+		ANKI_TEST_EXPECT_EQ(mapping.getData().getSize(), 10 * sizeof(U32));
+
+		U32 u;
+		memcpy(&u, &mapping.getData()[0], sizeof(u));
+		ANKI_TEST_EXPECT_EQ(u, first);
+
+		mapping.unmap();
+		ANKI_TEST_EXPECT_EQ(mapping.isMapped(), false);
+	}
+
+	// Out of range
+	{
+		MemoryMappedFile mapping;
+		ANKI_TEST_EXPECT_ERR(mapping.map(fname.toCString(), COUNT * sizeof(U32), 1), Error::USER_DATA);
+	}
+
+	ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir.toCString(), alloc));
+}
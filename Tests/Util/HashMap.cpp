@@ -6,6 +6,7 @@
 #include <Tests/Framework/Framework.h>
 #include <Tests/Util/Foo.h>
 #include <AnKi/Util/HashMap.h>
+#include <AnKi/Util/SparseArray.h>
 #include <AnKi/Util/DynamicArray.h>
 #include <AnKi/Util/HighRezTimer.h>
 #include <unordered_map>
@@ -139,118 +140,217 @@ ANKI_TEST(Util, HashMap)
 
 		akMap.destroy(alloc);
 	}
+}
+
+ANKI_TEST(Util, HashMapCollisions)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// All keys have the same hash
+	class BadHasher
+	{
+	public:
+		U64 operator()(int x)
+		{
+			return x & 1;
+		}
+	};
 
-	// Bench it
 	{
-		using AkMap = HashMap<int, int, Hasher>;
-		AkMap akMap(128, 32, 0.9f);
-		using StlMap =
-			std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, HeapAllocator<std::pair<const int, int>>>;
-		StlMap stdMap(10, std::hash<int>(), std::equal_to<int>(), alloc);
+		const int COUNT = 200;
+		HashMap<int, int, BadHasher> map;
 
-		std::unordered_map<int, int> tmpMap;
+		for(int i = 0; i < COUNT; ++i)
+		{
+			map.emplace(alloc, i, i * 10);
+		}
+		ANKI_TEST_EXPECT_EQ(map.getSize(), COUNT);
+
+		U32 wrongCount = 0;
+		for(int i = 0; i < COUNT; ++i)
+		{
+			auto it = map.find(i);
+			wrongCount += it == map.getEnd() || *it != i * 10 || it.getKey() != i;
+		}
+		ANKI_TEST_EXPECT_EQ(wrongCount, 0);
+		ANKI_TEST_EXPECT_EQ(map.find(COUNT), map.getEnd());
+
+		// Erase the odd ones and make sure the rest are still reachable
+		for(int i = 1; i < COUNT; i += 2)
+		{
+			map.erase(alloc, map.find(i));
+		}
+		ANKI_TEST_EXPECT_EQ(map.getSize(), COUNT / 2);
+
+		for(int i = 0; i < COUNT; ++i)
+		{
+			wrongCount += (map.find(i) != map.getEnd()) != ((i & 1) == 0);
+		}
+		ANKI_TEST_EXPECT_EQ(wrongCount, 0);
 
-		HighRezTimer timer;
+		// Replace
+		map.emplace(alloc, 0, 1234);
+		ANKI_TEST_EXPECT_EQ(*map.find(0), 1234);
+		ANKI_TEST_EXPECT_EQ(map.getSize(), COUNT / 2);
 
-		// Create a huge set
-		const U32 COUNT = 1024 * 1024 * 10;
-		DynamicArrayAuto<int> vals(alloc);
+		map.destroy(alloc);
+	}
+
+	// String keys and CString lookups
+	{
+		HashMapAuto<StringAuto, U32> map(alloc);
+		for(U32 i = 0; i < 100; ++i)
+		{
+			StringAuto str(alloc);
+			str.sprintf("key_%u", i);
+			map.emplace(str, i);
+		}
+
+		// The original strings are gone, the map should have its own copy
+		auto it = map.find("key_42");
+		ANKI_TEST_EXPECT_NEQ(it, map.getEnd());
+		ANKI_TEST_EXPECT_EQ(*it, 42);
+		ANKI_TEST_EXPECT_EQ(it.getKey(), "key_42");
+		ANKI_TEST_EXPECT_EQ(map.find("key_100"), map.getEnd());
+
+		HashMapAuto<StringAuto, U32> copy(map);
+		map.destroy();
+		ANKI_TEST_EXPECT_EQ(copy.getSize(), 100);
+		ANKI_TEST_EXPECT_EQ(*copy.find(CString("key_99")), 99);
+	}
+}
+
+ANKI_TEST(Util, HashMapBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	HighRezTimer timer;
+
+	// The previous HashMap implementation. A sparse array indexed by the hash
+	using SparseMap = SparseArray<int, U64>;
+	SparseMap sparseMap(128, 32, 0.9f);
+	HashMap<int, int, Hasher> akMap;
+	using StlMap =
+		std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, HeapAllocator<std::pair<const int, int>>>;
+	StlMap stdMap(10, std::hash<int>(), std::equal_to<int>(), alloc);
+
+	// Create a huge set of unique keys and a set of keys that are not in the maps
+	const U32 COUNT = 1024 * 1024;
+	DynamicArrayAuto<int> vals(alloc);
+	DynamicArrayAuto<int> missingVals(alloc);
+	{
+		std::unordered_map<int, int> tmpMap;
 		vals.create(COUNT);
+		missingVals.create(COUNT);
 
-		for(U32 i = 0; i < COUNT; ++i)
+		for(U32 i = 0; i < COUNT * 2; ++i)
 		{
-			// Put unique keys
 			int v;
 			do
 			{
-				v = rand();
+				v = int(getRandom() & MAX_I32);
 			} while(tmpMap.find(v) != tmpMap.end());
 			tmpMap[v] = 1;
 
-			vals[i] = v;
+			((i & 1) ? vals[i / 2] : missingVals[i / 2]) = v;
 		}
+	}
 
-		// Insertion
+	// Insertion
+	{
+		timer.start();
+		for(U32 i = 0; i < COUNT; ++i)
 		{
-			// Put the vals AnKi
-			timer.start();
-			for(U32 i = 0; i < COUNT; ++i)
-			{
-				akMap.emplace(alloc, vals[i], vals[i]);
-			}
-			timer.stop();
-			Second akTime = timer.getElapsedTime();
-
-			// Put the vals STL
-			timer.start();
-			for(U32 i = 0; i < COUNT; ++i)
-			{
-				stdMap[vals[i]] = vals[i];
-			}
-			timer.stop();
-			Second stlTime = timer.getElapsedTime();
+			sparseMap.emplace(alloc, Hasher()(vals[i]), vals[i]);
+		}
+		timer.stop();
+		const Second sparseTime = timer.getElapsedTime();
 
-			ANKI_TEST_LOGI("Inserting bench: STL %f AnKi %f | %f%%", stlTime, akTime, stlTime / akTime * 100.0);
+		timer.start();
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			akMap.emplace(alloc, vals[i], vals[i]);
 		}
+		timer.stop();
+		const Second akTime = timer.getElapsedTime();
 
-		// Search
+		timer.start();
+		for(U32 i = 0; i < COUNT; ++i)
 		{
-			I64 count = 0; // To avoid compiler opts
+			stdMap[vals[i]] = vals[i];
+		}
+		timer.stop();
+		const Second stlTime = timer.getElapsedTime();
 
-			// Find values AnKi
-			timer.start();
-			for(U32 i = 0; i < COUNT; ++i)
-			{
-				auto it = akMap.find(vals[i]);
-				count += *it;
-			}
-			timer.stop();
-			Second akTime = timer.getElapsedTime();
+		ANKI_TEST_LOGI("Inserting bench: STL %f SparseArray %f HashMap %f", stlTime, sparseTime, akTime);
+	}
 
-			// Find values STL
-			timer.start();
-			for(U32 i = 0; i < COUNT; ++i)
-			{
-				count += stdMap[vals[i]];
-			}
-			timer.stop();
-			Second stlTime = timer.getElapsedTime();
+	// Search
+	{
+		I64 count = 0; // To avoid compiler opts
 
-			ANKI_TEST_LOGI("Find bench: STL %f AnKi %f | %f%% (%ld)", stlTime, akTime, stlTime / akTime * 100.0, count);
+		timer.start();
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			count += *sparseMap.find(Hasher()(vals[i]));
+			count += sparseMap.find(Hasher()(missingVals[i])) != sparseMap.getEnd();
 		}
+		timer.stop();
+		const Second sparseTime = timer.getElapsedTime();
 
-		// Delete
+		timer.start();
+		for(U32 i = 0; i < COUNT; ++i)
 		{
-			// Remove in random order
-			std::random_shuffle(vals.begin(), vals.end());
+			count += *akMap.find(vals[i]);
+			count += akMap.find(missingVals[i]) != akMap.getEnd();
+		}
+		timer.stop();
+		const Second akTime = timer.getElapsedTime();
 
-			// Random delete AnKi
-			Second akTime = 0.0;
-			for(U32 i = 0; i < vals.getSize(); ++i)
-			{
-				auto it = akMap.find(vals[i]);
+		timer.start();
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			count += stdMap.find(vals[i])->second;
+			count += stdMap.find(missingVals[i]) != stdMap.end();
+		}
+		timer.stop();
+		const Second stlTime = timer.getElapsedTime();
 
-				timer.start();
-				akMap.erase(alloc, it);
-				timer.stop();
-				akTime += timer.getElapsedTime();
-			}
+		ANKI_TEST_LOGI("Find bench (hits and misses): STL %f SparseArray %f HashMap %f (%ld)", stlTime, sparseTime,
+					   akTime, count);
+	}
 
-			// Random delete STL
-			Second stlTime = 0.0;
-			for(U32 i = 0; i < vals.getSize(); ++i)
-			{
-				auto it = stdMap.find(vals[i]);
+	// Delete in random order
+	{
+		std::random_shuffle(vals.begin(), vals.end());
 
-				timer.start();
-				stdMap.erase(it);
-				timer.stop();
-				stlTime += timer.getElapsedTime();
-			}
+		timer.start();
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			sparseMap.erase(alloc, sparseMap.find(Hasher()(vals[i])));
+		}
+		timer.stop();
+		const Second sparseTime = timer.getElapsedTime();
 
-			ANKI_TEST_LOGI("Deleting bench: STL %f AnKi %f | %f%%", stlTime, akTime, stlTime / akTime * 100.0);
+		timer.start();
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			akMap.erase(alloc, akMap.find(vals[i]));
 		}
+		timer.stop();
+		const Second akTime = timer.getElapsedTime();
 
-		akMap.destroy(alloc);
+		timer.start();
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			stdMap.erase(stdMap.find(vals[i]));
+		}
+		timer.stop();
+		const Second stlTime = timer.getElapsedTime();
+
+		ANKI_TEST_LOGI("Deleting bench: STL %f SparseArray %f HashMap %f", stlTime, sparseTime, akTime);
 	}
+
+	ANKI_TEST_EXPECT_EQ(akMap.isEmpty(), true);
+	sparseMap.destroy(alloc);
+	akMap.destroy(alloc);
 }
@@ -0,0 +1,344 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Util/HierarchyUpdater.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/System.h>
+#include <AnKi/Math.h>
+
+namespace anki
+{
+
+namespace
+{
+
+/// Something like a scene node. The update computes the world transform from the parent's.
+class UpdaterTestNode : public Hierarchy<UpdaterTestNode>
+{
+public:
+	Transform m_localTrf = Transform::getIdentity();
+	Transform m_worldTrf = Transform::getIdentity();
+	F32 m_work = 0.0f;
+	U32 m_childrenPostUpdated = 0;
+	Bool m_postUpdated = false;
+
+	void update()
+	{
+		const UpdaterTestNode* parent = getParent();
+		m_worldTrf = (parent) ? parent->m_worldTrf.combineTransformations(m_localTrf) : m_localTrf;
+
+		// Make it a bit heavier
+		for(U32 i = 0; i < 32; ++i)
+		{
+			m_work = sin(m_work + m_worldTrf.getOrigin().x());
+		}
+	}
+
+	void postUpdate()
+	{
+		// All the children should be post updated by now
+		U32 count = 0;
+		const Error err = visitChildrenMaxDepth(0, [&](UpdaterTestNode& child) -> Error {
+			count += child.m_postUpdated;
+			return Error::NONE;
+		});
+		(void)err;
+		m_childrenPostUpdated = count;
+		m_postUpdated = true;
+	}
+};
+
+class UpdaterTestScene
+{
+public:
+	HeapAllocator<U8> m_alloc;
+	std::vector<UpdaterTestNode*> m_nodes;
+	std::vector<UpdaterTestNode*> m_roots;
+
+	UpdaterTestScene(HeapAllocator<U8> alloc)
+		: m_alloc(alloc)
+	{
+	}
+
+	~UpdaterTestScene()
+	{
+		// The parents are created first so destroying in that order never searches the parent's children
+		for(UpdaterTestNode* node : m_nodes)
+		{
+			node->destroy(m_alloc);
+		}
+
+		for(UpdaterTestNode* node : m_nodes)
+		{
+			m_alloc.deleteInstance(node);
+		}
+	}
+
+	UpdaterTestNode* newNode(UpdaterTestNode* parent)
+	{
+		UpdaterTestNode* node = m_alloc.newInstance<UpdaterTestNode>();
+		node->m_localTrf = Transform(Vec4(getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), 0.0f, 0.0f),
+									 Mat3x4::getIdentity(), 1.0f);
+		m_nodes.push_back(node);
+
+		if(parent)
+		{
+			parent->addChild(m_alloc, node);
+		}
+		else
+		{
+			m_roots.push_back(node);
+		}
+
+		return node;
+	}
+
+	/// Many small hierarchies.
+	void createWide(U32 rootCount, U32 childrenPerRoot)
+	{
+		for(U32 i = 0; i < rootCount; ++i)
+		{
+			UpdaterTestNode* root = newNode(nullptr);
+			for(U32 j = 0; j < childrenPerRoot; ++j)
+			{
+				newNode(root);
+			}
+		}
+	}
+
+	/// A few big hierarchies. Every level has a few nodes that have a lot of children.
+	void createDeep(U32 rootCount, U32 depth, U32 childrenPerNode)
+	{
+		for(U32 i = 0; i < rootCount; ++i)
+		{
+			UpdaterTestNode* parent = newNode(nullptr);
+			for(U32 d = 0; d < depth; ++d)
+			{
+				UpdaterTestNode* nextParent = nullptr;
+				for(U32 j = 0; j < childrenPerNode; ++j)
+				{
+					UpdaterTestNode* node = newNode(parent);
+					nextParent = (nextParent) ? nextParent : node;
+				}
+
+				parent = nextParent;
+			}
+		}
+	}
+
+	void reset()
+	{
+		for(UpdaterTestNode* node : m_nodes)
+		{
+			node->m_worldTrf = Transform::getIdentity();
+			node->m_postUpdated = false;
+			node->m_childrenPostUpdated = 0;
+		}
+	}
+};
+
+/// The way SceneGraph used to update: batches of roots with a SpinLock and every hierarchy on a single thread.
+class RootBatchUpdater
+{
+public:
+	UpdaterTestScene* m_scene;
+	U32 m_crntRoot = 0;
+	SpinLock m_lock;
+
+	static void updateRecursive(UpdaterTestNode& node)
+	{
+		node.update();
+		const Error err = node.visitChildrenMaxDepth(0, [](UpdaterTestNode& child) -> Error {
+			updateRecursive(child);
+			return Error::NONE;
+		});
+		(void)err;
+		node.postUpdate();
+	}
+
+	void run()
+	{
+		const U32 BATCH = 10;
+		Bool quit = false;
+		while(!quit)
+		{
+			U32 begin, end;
+			{
+				LockGuard<SpinLock> lock(m_lock);
+				begin = m_crntRoot;
+				end = min<U32>(begin + BATCH, U32(m_scene->m_roots.size()));
+				m_crntRoot = end;
+			}
+
+			quit = begin == end;
+			for(U32 i = begin; i < end; ++i)
+			{
+				updateRecursive(*m_scene->m_roots[i]);
+			}
+		}
+	}
+};
+
+void validateScene(const UpdaterTestScene& scene)
+{
+	U32 wrongTrfCount = 0;
+	U32 wrongOrderCount = 0;
+	for(const UpdaterTestNode* node : scene.m_nodes)
+	{
+		const UpdaterTestNode* parent = node->getParent();
+		const Transform expected = (parent) ? parent->m_worldTrf.combineTransformations(node->m_localTrf)
+											: node->m_localTrf;
+		wrongTrfCount += (expected.getOrigin() - node->m_worldTrf.getOrigin()).getLength() >= 0.001f;
+
+		U32 childCount = 0;
+		UpdaterTestNode& mutableNode = const_cast<UpdaterTestNode&>(*node);
+		const Error err = mutableNode.visitChildrenMaxDepth(0, [&](UpdaterTestNode&) -> Error {
+			++childCount;
+			return Error::NONE;
+		});
+		(void)err;
+		wrongOrderCount += !node->m_postUpdated || node->m_childrenPostUpdated != childCount;
+	}
+
+	ANKI_TEST_EXPECT_EQ(wrongTrfCount, 0);
+	ANKI_TEST_EXPECT_EQ(wrongOrderCount, 0);
+}
+
+void benchHierarchyUpdater(HeapAllocator<U8> alloc, ThreadHive& hive, UpdaterTestScene& scene, CString name)
+{
+	const U32 ITERATIONS = 10;
+
+	// Old way
+	Second oldTime = 0.0;
+	for(U32 i = 0; i < ITERATIONS; ++i)
+	{
+		scene.reset();
+
+		RootBatchUpdater updater;
+		updater.m_scene = &scene;
+		Array<ThreadHiveTask, ThreadHive::MAX_THREADS> tasks;
+		for(U32 t = 0; t < hive.getThreadCount(); ++t)
+		{
+			tasks[t] = ANKI_THREAD_HIVE_TASK({ self->run(); }, &updater, nullptr, nullptr);
+		}
+
+		const Second begin = HighRezTimer::getCurrentTime();
+		hive.submitTasks(&tasks[0], hive.getThreadCount());
+		hive.waitAllTasks();
+		oldTime += HighRezTimer::getCurrentTime() - begin;
+	}
+
+	validateScene(scene);
+
+	// New way
+	Second newTime = 0.0;
+	U32 levelCount = 0;
+	for(U32 i = 0; i < ITERATIONS; ++i)
+	{
+		scene.reset();
+
+		const Second begin = HighRezTimer::getCurrentTime();
+		HierarchyUpdater<UpdaterTestNode> updater(alloc, U32(scene.m_nodes.size()));
+		for(UpdaterTestNode* root : scene.m_roots)
+		{
+			updater.addRoot(root);
+		}
+
+		const Error err = updater.update(
+			hive,
+			[](UpdaterTestNode& node) -> Error {
+				node.update();
+				return Error::NONE;
+			},
+			[](UpdaterTestNode& node) -> Error {
+				node.postUpdate();
+				return Error::NONE;
+			});
+		newTime += HighRezTimer::getCurrentTime() - begin;
+
+		ANKI_TEST_EXPECT_NO_ERR(err);
+		levelCount = updater.getLevelCount();
+	}
+
+	validateScene(scene);
+
+	ANKI_TEST_LOGI("%s: %u nodes, %u levels, %u threads. Root batches %fms, level order %fms", name.cstr(),
+				   U32(scene.m_nodes.size()), levelCount, hive.getThreadCount(), oldTime / ITERATIONS * 1000.0,
+				   newTime / ITERATIONS * 1000.0);
+}
+
+} // end anonymous namespace
+
+ANKI_TEST(Util, HierarchyUpdater)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), alloc);
+
+	// Errors stop the update
+	{
+		UpdaterTestScene scene(alloc);
+		scene.createDeep(4, 10, 4);
+
+		HierarchyUpdater<UpdaterTestNode> updater(alloc);
+		for(UpdaterTestNode* root : scene.m_roots)
+		{
+			updater.addRoot(root);
+		}
+
+		Atomic<U32> postUpdateCount = {0};
+		const Error err = updater.update(
+			hive,
+			[](UpdaterTestNode& node) -> Error {
+				return (node.getParent() && node.getParent()->getParent()) ? Error::USER_DATA : Error::NONE;
+			},
+			[&](UpdaterTestNode& node) -> Error {
+				postUpdateCount.fetchAdd(1);
+				return Error::NONE;
+			});
+
+		ANKI_TEST_EXPECT_EQ(err, Error::USER_DATA);
+		ANKI_TEST_EXPECT_EQ(postUpdateCount.load(), 0);
+	}
+
+	// Empty
+	{
+		HierarchyUpdater<UpdaterTestNode> updater(alloc);
+		const Error err = updater.update(
+			hive, [](UpdaterTestNode&) -> Error { return Error::NONE; },
+			[](UpdaterTestNode&) -> Error { return Error::NONE; });
+		ANKI_TEST_EXPECT_NO_ERR(err);
+		ANKI_TEST_EXPECT_EQ(updater.getLevelCount(), 0);
+	}
+}
+
+ANKI_TEST(Util, HierarchyUpdaterBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), alloc);
+
+	// Lots of small hierarchies like props with a few attached nodes
+	{
+		UpdaterTestScene scene(alloc);
+		scene.createWide(20000, 4);
+		benchHierarchyUpdater(alloc, hive, scene, "Wide");
+	}
+
+	// A few huge hierarchies like vehicles with hundreds of attached nodes
+	{
+		UpdaterTestScene scene(alloc);
+		scene.createDeep(2, 200, 200);
+		benchHierarchyUpdater(alloc, hive, scene, "Deep");
+	}
+
+	// A long chain
+	{
+		UpdaterTestScene scene(alloc);
+		scene.createDeep(1, 2000, 1);
+		benchHierarchyUpdater(alloc, hive, scene, "Chain");
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,319 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Util/LockFreeQueue.h>
+#include <AnKi/Util/Thread.h>
+#include <AnKi/Util/DynamicArray.h>
+#include <AnKi/Util/HighRezTimer.h>
+
+namespace anki
+{
+
+namespace
+{
+
+/// The queue the lock-free ones are compared against.
+class MutexQueue
+{
+public:
+	template<typename TAllocator>
+	void create(TAllocator alloc, U32 capacity)
+	{
+		m_storage.create(alloc, capacity);
+	}
+
+	template<typename TAllocator>
+	void destroy(TAllocator alloc)
+	{
+		m_storage.destroy(alloc);
+	}
+
+	Bool tryPush(U64 val)
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		if(m_pushPos - m_popPos == m_storage.getSize())
+		{
+			return false;
+		}
+
+		m_storage[m_pushPos++ % m_storage.getSize()] = val;
+		return true;
+	}
+
+	Bool tryPop(U64& val)
+	{
+		LockGuard<Mutex> lock(m_mtx);
+		if(m_pushPos == m_popPos)
+		{
+			return false;
+		}
+
+		val = m_storage[m_popPos++ % m_storage.getSize()];
+		return true;
+	}
+
+private:
+	Mutex m_mtx;
+	DynamicArray<U64> m_storage;
+	U32 m_pushPos = 0;
+	U32 m_popPos = 0;
+};
+
+/// Push from a few threads and pop from a few others. The values encode the producer and the sequence number so the
+/// consumers can check that every producer's values come out in order.
+template<typename TQueue>
+class QueueStress
+{
+public:
+	TQueue* m_queue = nullptr;
+	U32 m_itemsPerProducer = 0;
+	U32 m_producerCount = 0;
+	Atomic<U32> m_producerIdx = {0};
+	Atomic<U64> m_popCount = {0};
+	Atomic<U64> m_sum = {0};
+	Atomic<U32> m_outOfOrderCount = {0};
+
+	Second run(HeapAllocator<U8>& alloc, U32 producerCount, U32 consumerCount)
+	{
+		m_producerCount = producerCount;
+		DynamicArrayAuto<Thread*> threads(alloc);
+		for(U32 i = 0; i < producerCount + consumerCount; ++i)
+		{
+			threads.emplaceBack(alloc.newInstance<Thread>((i < producerCount) ? "Producer" : "Consumer"));
+		}
+
+		const Second begin = HighRezTimer::getCurrentTime();
+		for(U32 i = 0; i < producerCount + consumerCount; ++i)
+		{
+			threads[i]->start(this, (i < producerCount) ? produce : consume);
+		}
+
+		for(Thread* thread : threads)
+		{
+			const Error err = thread->join();
+			(void)err;
+			alloc.deleteInstance(thread);
+		}
+
+		return HighRezTimer::getCurrentTime() - begin;
+	}
+
+private:
+	static Error produce(ThreadCallbackInfo& info)
+	{
+		QueueStress& self = *static_cast<QueueStress*>(info.m_userData);
+		const U64 producerIdx = self.m_producerIdx.fetchAdd(1);
+		for(U32 i = 0; i < self.m_itemsPerProducer; ++i)
+		{
+			while(!self.m_queue->tryPush((producerIdx << 32) | i))
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		return Error::NONE;
+	}
+
+	static Error consume(ThreadCallbackInfo& info)
+	{
+		QueueStress& self = *static_cast<QueueStress*>(info.m_userData);
+		const U64 total = U64(self.m_itemsPerProducer) * self.m_producerCount;
+		Array<I64, 16> lastSeen;
+		for(I64& seq : lastSeen)
+		{
+			seq = -1;
+		}
+		U64 sum = 0;
+		U32 outOfOrder = 0;
+
+		while(self.m_popCount.load() < total)
+		{
+			U64 val;
+			if(!self.m_queue->tryPop(val))
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			const U32 producer = U32(val >> 32);
+			const I64 seq = I64(val & MAX_U32);
+			outOfOrder += seq <= lastSeen[producer];
+			lastSeen[producer] = seq;
+			sum += seq;
+			self.m_popCount.fetchAdd(1);
+		}
+
+		self.m_sum.fetchAdd(sum);
+		self.m_outOfOrderCount.fetchAdd(outOfOrder);
+		return Error::NONE;
+	}
+};
+
+class Counted
+{
+public:
+	static I32 m_aliveCount;
+
+	U32 m_val = 0;
+
+	Counted()
+	{
+		++m_aliveCount;
+	}
+
+	Counted(U32 val)
+		: m_val(val)
+	{
+		++m_aliveCount;
+	}
+
+	Counted(const Counted& b)
+		: m_val(b.m_val)
+	{
+		++m_aliveCount;
+	}
+
+	~Counted()
+	{
+		--m_aliveCount;
+	}
+
+	Counted& operator=(const Counted& b)
+	{
+		m_val = b.m_val;
+		return *this;
+	}
+};
+
+I32 Counted::m_aliveCount = 0;
+
+} // end anonymous namespace
+
+template<typename TQueue>
+static void testSingleThreaded(HeapAllocator<U8>& alloc)
+{
+	TQueue queue;
+	queue.create(alloc, 5);
+	ANKI_TEST_EXPECT_EQ(queue.getCapacity(), 8);
+
+	Counted out;
+	ANKI_TEST_EXPECT_EQ(queue.tryPop(out), false);
+
+	// Go around the ring a few times
+	U32 pushed = 0;
+	U32 popped = 0;
+	for(U32 lap = 0; lap < 10; ++lap)
+	{
+		while(queue.tryPush(pushed))
+		{
+			++pushed;
+		}
+		ANKI_TEST_EXPECT_EQ(queue.getApproximateSize(), 8);
+
+		for(U32 i = 0; i < 5; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(queue.tryPop(out), true);
+			ANKI_TEST_EXPECT_EQ(out.m_val, popped);
+			++popped;
+		}
+	}
+
+	// The remaining elements are destroyed with the queue
+	ANKI_TEST_EXPECT_EQ(Counted::m_aliveCount, 1 + 3);
+	queue.destroy(alloc);
+	ANKI_TEST_EXPECT_EQ(Counted::m_aliveCount, 1);
+}
+
+ANKI_TEST(Util, MpmcQueue)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	testSingleThreaded<MpmcQueue<Counted>>(alloc);
+
+	// Many producers and consumers
+	{
+		MpmcQueue<U64> queue;
+		queue.create(alloc, 64);
+
+		QueueStress<MpmcQueue<U64>> stress;
+		stress.m_queue = &queue;
+		stress.m_itemsPerProducer = 50000;
+		stress.run(alloc, 4, 4);
+
+		const U64 n = stress.m_itemsPerProducer;
+		ANKI_TEST_EXPECT_EQ(stress.m_popCount.load(), n * 4);
+		ANKI_TEST_EXPECT_EQ(stress.m_sum.load(), 4 * (n * (n - 1) / 2));
+		ANKI_TEST_EXPECT_EQ(stress.m_outOfOrderCount.load(), 0);
+		ANKI_TEST_EXPECT_EQ(queue.getApproximateSize(), 0);
+
+		queue.destroy(alloc);
+	}
+}
+
+ANKI_TEST(Util, SpscQueue)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	testSingleThreaded<SpscQueue<Counted>>(alloc);
+
+	// One producer and one consumer
+	{
+		SpscQueue<U64> queue;
+		queue.create(alloc, 64);
+
+		QueueStress<SpscQueue<U64>> stress;
+		stress.m_queue = &queue;
+		stress.m_itemsPerProducer = 200000;
+		stress.run(alloc, 1, 1);
+
+		const U64 n = stress.m_itemsPerProducer;
+		ANKI_TEST_EXPECT_EQ(stress.m_popCount.load(), n);
+		ANKI_TEST_EXPECT_EQ(stress.m_sum.load(), n * (n - 1) / 2);
+		ANKI_TEST_EXPECT_EQ(stress.m_outOfOrderCount.load(), 0);
+
+		queue.destroy(alloc);
+	}
+}
+
+ANKI_TEST(Util, LockFreeQueueBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const U32 ITEMS = 1000000;
+	const U32 CAPACITY = 1024;
+
+	auto bench = [&](auto& queue, U32 producerCount, U32 consumerCount) -> Second {
+		queue.create(alloc, CAPACITY);
+		QueueStress<std::remove_reference_t<decltype(queue)>> stress;
+		stress.m_queue = &queue;
+		stress.m_itemsPerProducer = ITEMS / producerCount;
+		const Second time = stress.run(alloc, producerCount, consumerCount);
+		queue.destroy(alloc);
+		return time;
+	};
+
+	// 1 producer 1 consumer
+	{
+		MutexQueue mutexQueue;
+		MpmcQueue<U64> mpmcQueue;
+		SpscQueue<U64> spscQueue;
+		const Second mutexTime = bench(mutexQueue, 1, 1);
+		const Second mpmcTime = bench(mpmcQueue, 1, 1);
+		const Second spscTime = bench(spscQueue, 1, 1);
+		ANKI_TEST_LOGI("1P/1C %u items. Mutex %fms, MPMC %fms, SPSC %fms", ITEMS, mutexTime * 1000.0,
+					   mpmcTime * 1000.0, spscTime * 1000.0);
+	}
+
+	// 4 producers 4 consumers
+	{
+		MutexQueue mutexQueue;
+		MpmcQueue<U64> mpmcQueue;
+		const Second mutexTime = bench(mutexQueue, 4, 4);
+		const Second mpmcTime = bench(mpmcQueue, 4, 4);
+		ANKI_TEST_LOGI("4P/4C %u items. Mutex %fms, MPMC %fms", ITEMS, mutexTime * 1000.0, mpmcTime * 1000.0);
+	}
+}
+
+} // end namespace anki
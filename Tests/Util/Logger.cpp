@@ -0,0 +1,219 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Util/Logger.h>
+#include <AnKi/Util/File.h>
+#include <AnKi/Util/Filesystem.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <cstring>
+
+namespace anki
+{
+
+namespace
+{
+
+/// Counts the messages of the "TEST" subsystem and checks that the messages of every thread come in order.
+class LogReceiver
+{
+public:
+	static constexpr U32 MAX_THREADS = 8;
+
+	Array<U32, MAX_THREADS> m_received;
+	Array<I64, MAX_THREADS> m_lastSeq;
+	U32 m_outOfOrderCount = 0;
+	Second m_sleepTime = 0.0;
+
+	LogReceiver()
+	{
+		for(U32 i = 0; i < MAX_THREADS; ++i)
+		{
+			m_received[i] = 0;
+			m_lastSeq[i] = -1;
+		}
+	}
+
+	U32 getTotalReceived() const
+	{
+		U32 total = 0;
+		for(U32 count : m_received)
+		{
+			total += count;
+		}
+		return total;
+	}
+
+	static void callback(void* userData, const LoggerMessageInfo& info)
+	{
+		if(strcmp(info.m_subsystem, "TEST") != 0)
+		{
+			return;
+		}
+
+		// The logger calls the handlers serially so no need for locking
+		LogReceiver& self = *static_cast<LogReceiver*>(userData);
+		U32 thread, seq;
+		if(sscanf(info.m_msg, "%u %u", &thread, &seq) != 2 || thread >= MAX_THREADS)
+		{
+			++self.m_outOfOrderCount;
+			return;
+		}
+
+		self.m_outOfOrderCount += (I64(seq) <= self.m_lastSeq[thread]) ? 1 : 0;
+		self.m_lastSeq[thread] = seq;
+		++self.m_received[thread];
+
+		if(self.m_sleepTime > 0.0)
+		{
+			HighRezTimer::sleep(self.m_sleepTime);
+		}
+	}
+};
+
+class LogProducers
+{
+public:
+	Logger* m_logger = nullptr;
+	U32 m_messagesPerThread = 0;
+	Atomic<U32> m_threadIdx = {0};
+
+	void run(U32 threadCount)
+	{
+		Array<Thread*, LogReceiver::MAX_THREADS> threads;
+		HeapAllocator<U8> alloc(allocAligned, nullptr);
+		for(U32 i = 0; i < threadCount; ++i)
+		{
+			threads[i] = alloc.newInstance<Thread>("LogProducer");
+			threads[i]->start(this, produce);
+		}
+
+		for(U32 i = 0; i < threadCount; ++i)
+		{
+			const Error err = threads[i]->join();
+			(void)err;
+			alloc.deleteInstance(threads[i]);
+		}
+	}
+
+private:
+	static Error produce(ThreadCallbackInfo& info)
+	{
+		LogProducers& self = *static_cast<LogProducers*>(info.m_userData);
+		const U32 threadIdx = self.m_threadIdx.fetchAdd(1);
+		for(U32 i = 0; i < self.m_messagesPerThread; ++i)
+		{
+			self.m_logger->writeFormated(ANKI_FILE, __LINE__, ANKI_FUNC, "TEST", LoggerMessageType::NORMAL,
+										 Thread::getCurrentThreadId(), "%u %u", threadIdx, i);
+		}
+
+		return Error::NONE;
+	}
+};
+
+} // end anonymous namespace
+
+ANKI_TEST(Util, AsyncLogger)
+{
+	// Many threads. Every message should either be received in order or be counted as dropped
+	{
+		Logger logger;
+		logger.removeMessageHandler(&logger, Logger::defaultSystemMessageHandler);
+		LogReceiver receiver;
+		logger.addMessageHandler(&receiver, LogReceiver::callback);
+		logger.setAsync(true);
+		ANKI_TEST_EXPECT_EQ(logger.isAsync(), true);
+
+		LogProducers producers;
+		producers.m_logger = &logger;
+		producers.m_messagesPerThread = 20000;
+		producers.run(4);
+
+		logger.flush();
+		ANKI_TEST_EXPECT_EQ(receiver.m_outOfOrderCount, 0);
+		ANKI_TEST_EXPECT_EQ(receiver.getTotalReceived() + logger.getDroppedMessageCount(), 4 * 20000);
+
+		// Messages that don't fit the ring buffer records go the slow way and keep the order
+		const U32 before = receiver.m_received[0];
+		char bigMsg[2048];
+		memset(bigMsg, ' ', sizeof(bigMsg));
+		bigMsg[sizeof(bigMsg) - 1] = '\0';
+		memcpy(bigMsg, "0 99999", 7);
+		logger.writeFormated(ANKI_FILE, __LINE__, ANKI_FUNC, "TEST", LoggerMessageType::NORMAL,
+							 Thread::getCurrentThreadId(), "%s", bigMsg);
+		ANKI_TEST_EXPECT_EQ(receiver.m_received[0], before + 1);
+
+		logger.setAsync(false);
+		logger.removeMessageHandler(&receiver, LogReceiver::callback);
+	}
+
+	// Slow handler, some messages should be dropped
+	{
+		Logger logger;
+		logger.removeMessageHandler(&logger, Logger::defaultSystemMessageHandler);
+		LogReceiver receiver;
+		receiver.m_sleepTime = 1.0 / 10000.0;
+		logger.addMessageHandler(&receiver, LogReceiver::callback);
+		logger.setAsync(true);
+
+		LogProducers producers;
+		producers.m_logger = &logger;
+		producers.m_messagesPerThread = 2000;
+		producers.run(1);
+
+		logger.setAsync(false);
+		ANKI_TEST_EXPECT_GT(logger.getDroppedMessageCount(), 0);
+		ANKI_TEST_EXPECT_EQ(receiver.getTotalReceived() + logger.getDroppedMessageCount(), 2000);
+		ANKI_TEST_EXPECT_EQ(receiver.m_outOfOrderCount, 0);
+
+		logger.removeMessageHandler(&receiver, LogReceiver::callback);
+	}
+}
+
+ANKI_TEST(Util, AsyncLoggerBench)
+{
+	const U32 MESSAGE_COUNT = 100000;
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Write the logs to a temp directory that will be removed at the end
+	StringAuto dir(alloc);
+	ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(dir));
+	dir.append("/AnKiLoggerBench");
+	if(!directoryExists(dir.toCString()))
+	{
+		ANKI_TEST_EXPECT_NO_ERR(createDirectory(dir.toCString()));
+	}
+
+	StringAuto filename(alloc);
+	filename.sprintf("%s/logger_bench.txt", dir.cstr());
+
+	auto bench = [&](Bool async) -> Second {
+		File file;
+		ANKI_TEST_EXPECT_NO_ERR(file.open(filename.toCString(), FileOpenFlag::WRITE));
+		Logger logger;
+		logger.removeMessageHandler(&logger, Logger::defaultSystemMessageHandler);
+		logger.addFileMessageHandler(&file);
+		logger.setAsync(async);
+
+		const Second begin = HighRezTimer::getCurrentTime();
+		for(U32 i = 0; i < MESSAGE_COUNT; ++i)
+		{
+			logger.writeFormated(ANKI_FILE, __LINE__, ANKI_FUNC, "TEST", LoggerMessageType::NORMAL,
+								 Thread::getCurrentThreadId(), "Message %u with some payload %f", i, F64(i) * 0.5);
+		}
+		const Second time = HighRezTimer::getCurrentTime() - begin;
+
+		logger.setAsync(false);
+		return time;
+	};
+
+	const Second syncTime = bench(false);
+	const Second asyncTime = bench(true);
+	ANKI_TEST_EXPECT_NO_ERR(removeDirectory(dir.toCString(), alloc));
+	ANKI_TEST_LOGI("Per call latency of %u messages. Sync %fns, async %fns", MESSAGE_COUNT,
+				   syncTime / MESSAGE_COUNT * 1000000000.0, asyncTime / MESSAGE_COUNT * 1000000000.0);
+}
+
+} // end namespace anki
@@ -7,6 +7,9 @@
 #include <Tests/Util/Foo.h>
 #include <AnKi/Util/Memory.h>
 #include <AnKi/Util/ThreadPool.h>
+#include <AnKi/Util/DynamicArray.h>
+#include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/System.h>
 #include <type_traits>
 #include <cstring>
 
@@ -218,3 +221,164 @@ ANKI_TEST(Util, ChainMemoryPool)
 		ANKI_TEST_EXPECT_EQ(pool.getChunksCount(), 0);
 	}
 }
+
+ANKI_TEST(Util, ThreadLocalStackMemoryPool)
+{
+	// Alignment and big allocations
+	{
+		ThreadLocalStackMemoryPool pool;
+		pool.init(allocAligned, nullptr, 1_KB, 2.0f, 0, 256);
+
+		void* a = pool.allocate(1, 1);
+		void* b = pool.allocate(10, 64);
+		ANKI_TEST_EXPECT_NEQ(a, nullptr);
+		ANKI_TEST_EXPECT_EQ(isAligned(64, b), true);
+
+		void* big = pool.allocate(500, 32);
+		ANKI_TEST_EXPECT_NEQ(big, nullptr);
+		ANKI_TEST_EXPECT_EQ(isAligned(32, big), true);
+		memset(big, 0xFF, 500);
+
+		pool.reset();
+		void* c = pool.allocate(1, 1);
+		ANKI_TEST_EXPECT_NEQ(c, nullptr);
+	}
+
+	// Allocator with containers
+	{
+		ThreadLocalStackAllocator<U8> alloc(allocAligned, nullptr, 16_KB);
+		DynamicArrayAuto<U32> arr(alloc);
+		for(U32 i = 0; i < 1000; ++i)
+		{
+			arr.emplaceBack(i);
+		}
+
+		U32 wrong = 0;
+		for(U32 i = 0; i < 1000; ++i)
+		{
+			wrong += arr[i] != i;
+		}
+		ANKI_TEST_EXPECT_EQ(wrong, 0);
+	}
+
+	// Parallel
+	{
+		ThreadLocalStackMemoryPool pool;
+		const U32 THREAD_COUNT = 16;
+		const U32 ALLOC_SIZE = 25;
+		ThreadPool threadPool(THREAD_COUNT);
+
+		class AllocateTask : public ThreadPoolTask
+		{
+		public:
+			ThreadLocalStackMemoryPool* m_pool = nullptr;
+			Array<void*, 0xFF> m_allocations;
+
+			Error operator()(U32 taskId, PtrSize threadsCount)
+			{
+				for(U32 i = 0; i < m_allocations.getSize(); ++i)
+				{
+					void* ptr = m_pool->allocate(ALLOC_SIZE, 1);
+					memset(ptr, U8(taskId ^ i), ALLOC_SIZE);
+					m_allocations[i] = ptr;
+				}
+
+				return Error::NONE;
+			}
+		};
+
+		pool.init(allocAligned, nullptr, 4_KB, 1.0f, 0, 1_KB);
+		Array<AllocateTask, THREAD_COUNT> tasks;
+
+		for(U32 frame = 0; frame < 3; ++frame)
+		{
+			pool.reset();
+
+			for(U32 i = 0; i < THREAD_COUNT; ++i)
+			{
+				tasks[i].m_pool = &pool;
+				threadPool.assignNewTask(i, &tasks[i]);
+			}
+
+			ANKI_TEST_EXPECT_NO_ERR(threadPool.waitForAllThreadsToFinish());
+
+			U32 wrong = 0;
+			for(U32 i = 0; i < THREAD_COUNT; ++i)
+			{
+				for(U32 j = 0; j < tasks[i].m_allocations.getSize(); ++j)
+				{
+					const U8* ptr = static_cast<const U8*>(tasks[i].m_allocations[j]);
+					for(U32 k = 0; k < ALLOC_SIZE; ++k)
+					{
+						wrong += ptr[k] != U8(i ^ j);
+					}
+				}
+			}
+			ANKI_TEST_EXPECT_EQ(wrong, 0);
+		}
+	}
+}
+
+ANKI_TEST(Util, ThreadLocalStackMemoryPoolBench)
+{
+	const U32 THREAD_COUNT = max(4u, getCpuCoresCount());
+	const U32 ALLOCATIONS_PER_THREAD = 200000;
+	const U32 FRAMES = 5;
+
+	// Mimics what hive tasks do with the frame allocator: Many small arrays
+	auto bench = [&](auto& pool) -> Second {
+		using TPool = std::remove_reference_t<decltype(pool)>;
+
+		class Task : public ThreadPoolTask
+		{
+		public:
+			TPool* m_pool = nullptr;
+			U32 m_sum = 0;
+
+			Error operator()(U32 taskId, PtrSize threadsCount)
+			{
+				for(U32 i = 0; i < ALLOCATIONS_PER_THREAD; ++i)
+				{
+					const U32 size = 8 + (i % 8) * 8;
+					U8* ptr = static_cast<U8*>(m_pool->allocate(size, 8));
+					ptr[0] = U8(i);
+					m_sum += ptr[0];
+				}
+
+				return Error::NONE;
+			}
+		};
+
+		ThreadPool threadPool(THREAD_COUNT);
+		DynamicArrayAuto<Task> tasks(HeapAllocator<U8>(allocAligned, nullptr));
+		tasks.create(THREAD_COUNT);
+
+		Second time = 0.0;
+		for(U32 frame = 0; frame < FRAMES; ++frame)
+		{
+			pool.reset();
+
+			const Second begin = HighRezTimer::getCurrentTime();
+			for(U32 i = 0; i < THREAD_COUNT; ++i)
+			{
+				tasks[i].m_pool = &pool;
+				threadPool.assignNewTask(i, &tasks[i]);
+			}
+			ANKI_TEST_EXPECT_NO_ERR(threadPool.waitForAllThreadsToFinish());
+			time += HighRezTimer::getCurrentTime() - begin;
+		}
+
+		return time / FRAMES;
+	};
+
+	StackMemoryPool stackPool;
+	stackPool.init(allocAligned, nullptr, 10_MB, 2.0f);
+	const Second stackTime = bench(stackPool);
+
+	ThreadLocalStackMemoryPool threadLocalPool;
+	threadLocalPool.init(allocAligned, nullptr, 10_MB, 2.0f);
+	const Second threadLocalTime = bench(threadLocalPool);
+
+	ANKI_TEST_LOGI("%u threads doing %u allocations each. StackMemoryPool %fms, ThreadLocalStackMemoryPool %fms",
+				   THREAD_COUNT, ALLOCATIONS_PER_THREAD, stackTime * 1000.0, threadLocalTime * 1000.0);
+}
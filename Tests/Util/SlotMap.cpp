@@ -0,0 +1,194 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Util/SlotMap.h>
+#include <AnKi/Util/List.h>
+#include <AnKi/Util/HighRezTimer.h>
+
+namespace anki
+{
+namespace
+{
+
+class SlotMapValue : public IntrusiveListEnabled<SlotMapValue>
+{
+public:
+	U32 m_x = 0;
+	F32 m_y = 0.0f;
+
+	SlotMapValue() = default;
+
+	SlotMapValue(U32 x)
+		: m_x(x)
+		, m_y(F32(x))
+	{
+	}
+};
+
+} // end anonymous namespace
+} // end namespace anki
+
+ANKI_TEST(Util, SlotMap)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Simple
+	{
+		SlotMap<U32> map;
+
+		const SlotMapHandle a = map.emplace(alloc, 10);
+		const SlotMapHandle b = map.emplace(alloc, 11);
+		const SlotMapHandle c = map.emplace(alloc, 12);
+		ANKI_TEST_EXPECT_EQ(map.getSize(), 3);
+		ANKI_TEST_EXPECT_EQ(map.get(a), 10);
+		ANKI_TEST_EXPECT_EQ(map.get(b), 11);
+		ANKI_TEST_EXPECT_EQ(map.get(c), 12);
+
+		// Erase from the middle. The handle of the moved value should still work
+		map.erase(alloc, a);
+		ANKI_TEST_EXPECT_EQ(map.getSize(), 2);
+		ANKI_TEST_EXPECT_EQ(map.isValid(a), false);
+		ANKI_TEST_EXPECT_EQ(map.tryGet(a), nullptr);
+		ANKI_TEST_EXPECT_EQ(map.get(b), 11);
+		ANKI_TEST_EXPECT_EQ(map.get(c), 12);
+
+		// The slot gets reused with a different generation
+		const SlotMapHandle d = map.emplace(alloc, 13);
+		ANKI_TEST_EXPECT_EQ(d.getSlot(), a.getSlot());
+		ANKI_TEST_EXPECT_NEQ(d.getGeneration(), a.getGeneration());
+		ANKI_TEST_EXPECT_EQ(map.isValid(a), false);
+		ANKI_TEST_EXPECT_EQ(map.get(d), 13);
+
+		U32 sum = 0;
+		for(U32 v : map)
+		{
+			sum += v;
+		}
+		ANKI_TEST_EXPECT_EQ(sum, 11 + 12 + 13);
+
+		for(U32 i = 0; i < map.getSize(); ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(map.getHandle(i), (map[i] == 11) ? b : ((map[i] == 12) ? c : d));
+		}
+
+		map.destroy(alloc);
+	}
+
+	// Random inserts and erases
+	{
+		SlotMap<U32> map;
+		DynamicArrayAuto<SlotMapHandle> handles(alloc);
+		DynamicArrayAuto<U32> values(alloc);
+
+		for(U32 i = 0; i < 10000; ++i)
+		{
+			if(handles.getSize() > 0 && (getRandom() % 3) == 0)
+			{
+				const U32 idx = U32(getRandom() % handles.getSize());
+				map.erase(alloc, handles[idx]);
+				ANKI_TEST_EXPECT_EQ(map.isValid(handles[idx]), false);
+
+				handles[idx] = handles.getBack();
+				values[idx] = values.getBack();
+				handles.resize(handles.getSize() - 1);
+				values.resize(values.getSize() - 1);
+			}
+			else
+			{
+				handles.emplaceBack(map.emplace(alloc, i));
+				values.emplaceBack(i);
+			}
+		}
+
+		ANKI_TEST_EXPECT_EQ(map.getSize(), handles.getSize());
+		for(U32 i = 0; i < handles.getSize(); ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(map.get(handles[i]), values[i]);
+		}
+
+		map.destroy(alloc);
+	}
+}
+
+ANKI_TEST(Util, SlotMapBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	HighRezTimer timer;
+
+	const U32 COUNT = 1024 * 1024;
+
+	// Shuffle the insertion order a bit to simulate objects that are created at random times
+	DynamicArrayAuto<U32> order(alloc);
+	order.create(COUNT);
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		order[i] = i;
+	}
+	for(U32 i = COUNT - 1; i > 0; --i)
+	{
+		std::swap(order[i], order[U32(getRandom() % (i + 1))]);
+	}
+
+	SlotMap<SlotMapValue> slotMap;
+	List<SlotMapValue> list;
+	IntrusiveList<SlotMapValue> intrusiveList;
+	DynamicArrayAuto<SlotMapValue*> intrusiveNodes(alloc);
+	intrusiveNodes.create(COUNT);
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		slotMap.emplace(alloc, i);
+		list.emplaceBack(alloc, i);
+		intrusiveNodes[i] = alloc.newInstance<SlotMapValue>(i);
+	}
+
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		intrusiveList.pushBack(intrusiveNodes[order[i]]);
+	}
+
+	// Iterate
+	{
+		F64 sum = 0.0; // To avoid compiler opts
+
+		timer.start();
+		for(const SlotMapValue& v : slotMap)
+		{
+			sum += v.m_y;
+		}
+		timer.stop();
+		const Second slotMapTime = timer.getElapsedTime();
+
+		timer.start();
+		for(const SlotMapValue& v : list)
+		{
+			sum += v.m_y;
+		}
+		timer.stop();
+		const Second listTime = timer.getElapsedTime();
+
+		timer.start();
+		for(const SlotMapValue& v : intrusiveList)
+		{
+			sum += v.m_y;
+		}
+		timer.stop();
+		const Second intrusiveListTime = timer.getElapsedTime();
+
+		ANKI_TEST_LOGI("Iteration bench: List %f IntrusiveList %f SlotMap %f (%f)", listTime, intrusiveListTime,
+					   slotMapTime, sum);
+	}
+
+	slotMap.destroy(alloc);
+	list.destroy(alloc);
+	while(!intrusiveList.isEmpty())
+	{
+		intrusiveList.popFront();
+	}
+	for(SlotMapValue* v : intrusiveNodes)
+	{
+		alloc.deleteInstance(v);
+	}
+}
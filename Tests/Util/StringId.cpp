@@ -0,0 +1,48 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <Tests/Framework/Framework.h>
+#include <AnKi/Util/StringId.h>
+#include <AnKi/Util/HashMap.h>
+
+ANKI_TEST(Util, StringId)
+{
+	// Compile time
+	{
+		constexpr StringId a("r_width");
+		static_assert(a == ANKI_STRING_ID("r_width"), "Wrong");
+		static_assert(a != ANKI_STRING_ID("r_height"), "Wrong");
+		static_assert(ANKI_STRING_ID("").isValid(), "Wrong");
+		static_assert(!StringId().isValid(), "Wrong");
+	}
+
+	// Runtime matches compile time
+	{
+		StringAuto str(HeapAllocator<U8>(allocAligned, nullptr));
+		str.sprintf("%s_%s", "r", "width");
+		ANKI_TEST_EXPECT_EQ(StringId(str.toCString()), ANKI_STRING_ID("r_width"));
+		ANKI_TEST_EXPECT_EQ(StringId(CString()), ANKI_STRING_ID(""));
+	}
+
+	// Registry
+	{
+		const StringId id = StringIdRegistry::registerString("StringIdTestName");
+		ANKI_TEST_EXPECT_EQ(id, ANKI_STRING_ID("StringIdTestName"));
+		ANKI_TEST_EXPECT_EQ(StringIdRegistry::registerString("StringIdTestName"), id);
+		ANKI_TEST_EXPECT_EQ(StringIdRegistry::find(id), "StringIdTestName");
+		ANKI_TEST_EXPECT_EQ(StringIdRegistry::find(ANKI_STRING_ID("StringIdNotRegistered")).isEmpty(), true);
+	}
+
+	// As a HashMap key
+	{
+		HeapAllocator<U8> alloc(allocAligned, nullptr);
+		HashMap<StringId, U32> map;
+		map.emplace(alloc, ANKI_STRING_ID("a"), 1);
+		map.emplace(alloc, ANKI_STRING_ID("b"), 2);
+		ANKI_TEST_EXPECT_EQ(*map.find(StringId(CString("b"))), 2);
+		ANKI_TEST_EXPECT_EQ(map.find(ANKI_STRING_ID("c")), map.getEnd());
+		map.destroy(alloc);
+	}
+}
@@ -58,11 +58,11 @@ static void taskToWait(void* arg, U32 threadId, ThreadHive& hive, ThreadHiveSema
 	ANKI_TEST_EXPECT_GEQ(prev, 10);
 }
 
-ANKI_TEST(Util, ThreadHive)
+static void testThreadHive(Bool workStealing)
 {
 	const U32 threadCount = 32;
 	HeapAllocator<U8> alloc(allocAligned, nullptr);
-	ThreadHive hive(threadCount, alloc);
+	ThreadHive hive(threadCount, alloc, false, workStealing);
 
 	// Simple test
 	if(1)
@@ -169,6 +169,12 @@ ANKI_TEST(Util, ThreadHive)
 	}
 }
 
+ANKI_TEST(Util, ThreadHive)
+{
+	testThreadHive(false);
+	testThreadHive(true);
+}
+
 class FibTask
 {
 public:
@@ -245,4 +251,107 @@ ANKI_TEST(Util, ThreadHiveBench)
 	ANKI_TEST_EXPECT_EQ(sum.getNonAtomically(), serialFib);
 }
 
+
+class ThroughputTask
+{
+public:
+	Atomic<U32>* m_counter;
+	U32 m_depth;
+};
+
+static void throughputTaskCallback(void* arg, U32, ThreadHive& hive, ThreadHiveSemaphore* sem)
+{
+	ThroughputTask& task = *static_cast<ThroughputTask*>(arg);
+	task.m_counter->fetchAdd(1);
+
+	// Fan out like the recursive scene and visibility tasks do
+	if(task.m_depth > 0)
+	{
+		constexpr U32 FAN_OUT = 4;
+		ThroughputTask* children = static_cast<ThroughputTask*>(
+			hive.allocateScratchMemory(sizeof(ThroughputTask) * FAN_OUT, alignof(ThroughputTask)));
+		Array<ThreadHiveTask, FAN_OUT> tasks;
+		for(U32 i = 0; i < FAN_OUT; ++i)
+		{
+			children[i].m_counter = task.m_counter;
+			children[i].m_depth = task.m_depth - 1;
+			tasks[i].m_callback = throughputTaskCallback;
+			tasks[i].m_argument = &children[i];
+		}
+
+		hive.submitTasks(&tasks[0], FAN_OUT);
+	}
+}
+
+static F64 measureThreadHiveThroughput(Bool workStealing, U32& taskCount)
+{
+	const U32 threadCount = getCpuCoresCount();
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(threadCount, alloc, false, workStealing);
+
+	constexpr U32 ITERATIONS = 10;
+	constexpr U32 ROOT_TASKS = 256;
+	constexpr U32 DEPTH = 4; // 341 tasks per root
+	constexpr U32 DEP_TASKS = 1024;
+
+	Atomic<U32> counter = {0};
+	Array<ThroughputTask, ROOT_TASKS> roots;
+	Array<ThreadHiveTask, ROOT_TASKS> rootTasks;
+	DynamicArrayAuto<ThreadHiveTask> depTasks(alloc);
+	depTasks.create(DEP_TASKS);
+
+	const Second begin = HighRezTimer::getCurrentTime();
+	for(U32 it = 0; it < ITERATIONS; ++it)
+	{
+		// Independent trees of tasks
+		for(U32 i = 0; i < ROOT_TASKS; ++i)
+		{
+			roots[i].m_counter = &counter;
+			roots[i].m_depth = DEPTH;
+			rootTasks[i].m_callback = throughputTaskCallback;
+			rootTasks[i].m_argument = &roots[i];
+			rootTasks[i].m_signalSemaphore = nullptr;
+			rootTasks[i].m_waitSemaphore = nullptr;
+		}
+
+		hive.submitTasks(&rootTasks[0], ROOT_TASKS);
+
+		// Tasks that depend on a single one
+		ThreadHiveSemaphore* sem = hive.newSemaphore(1);
+		ThroughputTask leaf = {&counter, 0};
+		ThreadHiveTask firstTask;
+		firstTask.m_callback = throughputTaskCallback;
+		firstTask.m_argument = &leaf;
+		firstTask.m_signalSemaphore = sem;
+		hive.submitTasks(&firstTask, 1);
+
+		for(ThreadHiveTask& task : depTasks)
+		{
+			task.m_callback = throughputTaskCallback;
+			task.m_argument = &leaf;
+			task.m_waitSemaphore = sem;
+			task.m_signalSemaphore = nullptr;
+		}
+		hive.submitTasks(&depTasks[0], DEP_TASKS);
+
+		hive.waitAllTasks();
+	}
+	const Second end = HighRezTimer::getCurrentTime();
+
+	taskCount = counter.getNonAtomically();
+	ANKI_TEST_EXPECT_EQ(taskCount, ITERATIONS * (ROOT_TASKS * 341 + 1 + DEP_TASKS));
+	return end - begin;
+}
+
+ANKI_TEST(Util, ThreadHiveThroughputBench)
+{
+	U32 taskCount;
+	const F64 legacyTime = measureThreadHiveThroughput(false, taskCount);
+	const F64 stealingTime = measureThreadHiveThroughput(true, taskCount);
+
+	ANKI_TEST_LOGI("%u tasks. Locked list: %fms (%f Mtasks/s). Work-stealing: %fms (%f Mtasks/s)", taskCount,
+				   legacyTime * 1000.0, F64(taskCount) / legacyTime / 1000000.0, stealingTime * 1000.0,
+				   F64(taskCount) / stealingTime / 1000000.0);
+}
+
 } // end namespace anki
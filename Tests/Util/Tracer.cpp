@@ -7,13 +7,58 @@
 #include <AnKi/Util/Tracer.h>
 #include <AnKi/Core/CoreTracer.h>
 #include <AnKi/Util/HighRezTimer.h>
+#include <AnKi/Util/MemoryMappedFile.h>
+#include <AnKi/Util/Filesystem.h>
+
+namespace anki
+{
+
+namespace
+{
+
+/// A directory under the temp directory that holds the output of a test. It's removed with everything it contains
+/// when it goes out of scope.
+class TestOutputDirectory
+{
+public:
+	StringAuto m_path;
+
+	TestOutputDirectory(HeapAllocator<U8> alloc, CString name)
+		: m_path(alloc)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(getTempDirectory(m_path));
+		m_path.append("/");
+		m_path.append(name);
+		if(!directoryExists(m_path.toCString()))
+		{
+			ANKI_TEST_EXPECT_NO_ERR(createDirectory(m_path.toCString()));
+		}
+	}
+
+	~TestOutputDirectory()
+	{
+		ANKI_TEST_EXPECT_NO_ERR(removeDirectory(m_path.toCString(), m_path.getAllocator()));
+	}
+
+	StringAuto getFilepath(CString filename) const
+	{
+		StringAuto out(m_path.getAllocator());
+		out.sprintf("%s/%s", m_path.cstr(), filename.cstr());
+		return out;
+	}
+};
+
+} // end anonymous namespace
+
+} // end namespace anki
 
 #if ANKI_ENABLE_TRACE
 ANKI_TEST(Util, Tracer)
 {
 	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	TestOutputDirectory dir(alloc, "AnKiTracerTest");
 	CoreTracer tracer;
-	ANKI_TEST_EXPECT_NO_ERR(tracer.init(alloc, "./"));
+	ANKI_TEST_EXPECT_NO_ERR(tracer.init(alloc, dir.m_path.toCString()));
 	TracerSingleton::get().setEnabled(true);
 
 	// 1st frame
@@ -54,3 +99,319 @@ ANKI_TEST(Util, Tracer)
 	tracer.flushFrame(4);
 }
 #endif
+
+namespace anki
+{
+
+namespace
+{
+
+class TraceBinaryCollector : public TraceBinaryVisitor
+{
+public:
+	HeapAllocator<U8> m_alloc = {allocAligned, nullptr};
+	DynamicArrayAuto<StringAuto> m_names = {m_alloc};
+	DynamicArrayAuto<TracerEvent> m_events = {m_alloc};
+	DynamicArrayAuto<ThreadId> m_eventTids = {m_alloc};
+	DynamicArrayAuto<U32> m_counterNameIds = {m_alloc};
+	U64 m_counterSum = 0;
+	U32 m_counterCount = 0;
+
+	void visitName(U32 nameId, CString name) override
+	{
+		ANKI_TEST_EXPECT_EQ(nameId, m_names.getSize());
+		m_names.emplaceBack(m_alloc, name);
+	}
+
+	void visitEvent(ThreadId tid, U64 frame, U32 nameId, U64 startNs, U64 durationNs) override
+	{
+		TracerEvent& event = *m_events.emplaceBack();
+		event.m_name = m_names[nameId].toCString();
+		event.m_start = Second(startNs) / 1000000000.0;
+		event.m_duration = Second(durationNs) / 1000000000.0;
+		m_eventTids.emplaceBack(tid);
+	}
+
+	void visitCounter(ThreadId tid, U64 frame, U32 nameId, U64 value) override
+	{
+		m_counterNameIds.emplaceBack(nameId);
+		m_counterSum += value;
+		++m_counterCount;
+	}
+};
+
+} // end anonymous namespace
+
+ANKI_TEST(Util, TraceBinary)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	TestOutputDirectory dir(alloc, "AnKiTraceBinaryTest");
+	const StringAuto fname = dir.getFilepath("test.ankitrace");
+
+	Array<TracerEvent, 3> events;
+	events[0].m_name = "EVENT_A";
+	events[0].m_start = 10.0;
+	events[0].m_duration = 0.5;
+	events[1].m_name = "EVENT_B";
+	events[1].m_start = 10.25;
+	events[1].m_duration = 0.001;
+	events[2].m_name = "EVENT_A";
+	events[2].m_start = 11.0;
+	events[2].m_duration = 0.0;
+
+	Array<TracerCounter, 2> counters;
+	counters[0].m_name = "COUNTER";
+	counters[0].m_value = 100;
+	counters[1].m_name = "COUNTER";
+	counters[1].m_value = MAX_U64 / 2;
+
+	{
+		TraceBinaryWriter writer;
+		ANKI_TEST_EXPECT_NO_ERR(writer.open(alloc, fname.toCString()));
+		ANKI_TEST_EXPECT_NO_ERR(writer.writeEvents(123, 0, events));
+		ANKI_TEST_EXPECT_NO_ERR(writer.writeCounters(123, 0, counters));
+		ANKI_TEST_EXPECT_NO_ERR(writer.writeEvents(456, 1, ConstWeakArray<TracerEvent>(&events[2], 1)));
+	}
+
+	MemoryMappedFile file;
+	ANKI_TEST_EXPECT_NO_ERR(file.map(fname.toCString()));
+	TraceBinaryCollector collector;
+	ANKI_TEST_EXPECT_NO_ERR(parseTraceBinary(file.getData(), collector));
+
+	// Names are written once
+	ANKI_TEST_EXPECT_EQ(collector.m_names.getSize(), 3);
+
+	ANKI_TEST_EXPECT_EQ(collector.m_events.getSize(), 4);
+	for(U32 i = 0; i < 4; ++i)
+	{
+		const TracerEvent& in = events[(i < 3) ? i : 2];
+		const TracerEvent& out = collector.m_events[i];
+		ANKI_TEST_EXPECT_EQ(in.m_name, out.m_name);
+		ANKI_TEST_EXPECT_NEAR(in.m_start, out.m_start, 1.0e-8);
+		ANKI_TEST_EXPECT_NEAR(in.m_duration, out.m_duration, 1.0e-8);
+		ANKI_TEST_EXPECT_EQ(collector.m_eventTids[i], (i < 3) ? 123 : 456);
+	}
+
+	ANKI_TEST_EXPECT_EQ(collector.m_counterCount, 2);
+	ANKI_TEST_EXPECT_EQ(collector.m_counterSum, 100 + MAX_U64 / 2);
+	for(U32 nameId : collector.m_counterNameIds)
+	{
+		ANKI_TEST_EXPECT_EQ(collector.m_names[nameId], "COUNTER");
+	}
+
+	// Truncated files should fail
+	TraceBinaryCollector collector2;
+	ANKI_TEST_EXPECT_ERR(
+		parseTraceBinary(ConstWeakArray<U8, PtrSize>(file.getData().getBegin(), file.getData().getSize() - 1),
+						 collector2),
+		Error::USER_DATA);
+}
+
+ANKI_TEST(Util, TraceBinaryNameCollision)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	TestOutputDirectory dir(alloc, "AnKiTraceBinaryNameCollision");
+	const StringAuto fname = dir.getFilepath("collision.ankitrace");
+
+	// Fake a collision by giving different names the same StringId
+	Array<TracerCounter, 3> counters;
+	counters[0].m_name = "COUNTER_A";
+	counters[0].m_nameId = StringId::fromHash(123);
+	counters[0].m_value = 1;
+	counters[1].m_name = "COUNTER_B";
+	counters[1].m_nameId = StringId::fromHash(123);
+	counters[1].m_value = 2;
+	counters[2].m_name = "COUNTER_B";
+	counters[2].m_nameId = StringId::fromHash(123);
+	counters[2].m_value = 3;
+
+	{
+		TraceBinaryWriter writer;
+		ANKI_TEST_EXPECT_NO_ERR(writer.open(alloc, fname.toCString()));
+		ANKI_TEST_EXPECT_NO_ERR(writer.writeCounters(123, 0, counters));
+	}
+
+	MemoryMappedFile file;
+	ANKI_TEST_EXPECT_NO_ERR(file.map(fname.toCString()));
+	TraceBinaryCollector collector;
+	ANKI_TEST_EXPECT_NO_ERR(parseTraceBinary(file.getData(), collector));
+
+	ANKI_TEST_EXPECT_EQ(collector.m_names.getSize(), 2);
+	ANKI_TEST_EXPECT_EQ(collector.m_counterNameIds.getSize(), 3);
+	ANKI_TEST_EXPECT_EQ(collector.m_names[collector.m_counterNameIds[0]], "COUNTER_A");
+	ANKI_TEST_EXPECT_EQ(collector.m_names[collector.m_counterNameIds[1]], "COUNTER_B");
+	ANKI_TEST_EXPECT_EQ(collector.m_names[collector.m_counterNameIds[2]], "COUNTER_B");
+}
+
+ANKI_TEST(Util, TraceBinaryBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	const U32 EVENT_COUNT = 1000000;
+	const Array<const char*, 4> names = {"SceneUpdate", "RenderGBuffer", "PhysicsStep", "ResourceLoad"};
+	TestOutputDirectory dir(alloc, "AnKiTraceBinaryBench");
+
+	DynamicArrayAuto<TracerEvent> events(alloc);
+	events.create(EVENT_COUNT);
+	for(U32 i = 0; i < EVENT_COUNT; ++i)
+	{
+		events[i].m_name = names[i % names.getSize()];
+		events[i].m_start = 100.0 + F64(i) * 0.00001;
+		events[i].m_duration = 0.000005;
+	}
+
+	// The old way
+	Second jsonTime;
+	PtrSize jsonSize;
+	{
+		File file;
+		ANKI_TEST_EXPECT_NO_ERR(file.open(dir.getFilepath("bench_trace.json").toCString(), FileOpenFlag::WRITE));
+		const Second begin = HighRezTimer::getCurrentTime();
+		for(const TracerEvent& event : events)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(file.writeText("{\"name\": \"%s\", \"cat\": \"PERF\", \"ph\": \"X\", "
+												   "\"pid\": 1, \"tid\": %llu, \"ts\": %lld, \"dur\": %lld},\n",
+												   event.m_name.cstr(), 1234ull, I64(event.m_start * 1000000.0),
+												   I64(event.m_duration * 1000000.0)));
+		}
+		jsonTime = HighRezTimer::getCurrentTime() - begin;
+		jsonSize = file.tell();
+	}
+
+	// Binary
+	Second binaryTime;
+	PtrSize binarySize;
+	{
+		TraceBinaryWriter writer;
+		ANKI_TEST_EXPECT_NO_ERR(writer.open(alloc, dir.getFilepath("bench_trace.ankitrace").toCString()));
+		const Second begin = HighRezTimer::getCurrentTime();
+		ANKI_TEST_EXPECT_NO_ERR(writer.writeEvents(1234, 0, events));
+		ANKI_TEST_EXPECT_NO_ERR(writer.flush());
+		binaryTime = HighRezTimer::getCurrentTime() - begin;
+
+		File file;
+		ANKI_TEST_EXPECT_NO_ERR(
+			file.open(dir.getFilepath("bench_trace.ankitrace").toCString(), FileOpenFlag::READ | FileOpenFlag::BINARY));
+		binarySize = file.getSize();
+	}
+
+	ANKI_TEST_LOGI("%u events. JSON %fms %zuB, binary %fms %zuB", EVENT_COUNT, jsonTime * 1000.0, jsonSize,
+				   binaryTime * 1000.0, binarySize);
+}
+
+ANKI_TEST(Util, TracerRingMode)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	Tracer tracer(alloc);
+	tracer.setRingMode(3);
+	tracer.setEnabled(true);
+
+	class Collector
+	{
+	public:
+		U32 m_eventCount = 0;
+		U64 m_minFrame = MAX_U64;
+		U64 m_maxFrame = 0;
+		Second m_lastStart = 0.0;
+
+		static void callback(void* ud, ThreadId tid, U64 frame, ConstWeakArray<TracerEvent> events,
+							 ConstWeakArray<TracerCounter> counters)
+		{
+			Collector& self = *static_cast<Collector*>(ud);
+			self.m_eventCount += events.getSize();
+			self.m_minFrame = min(self.m_minFrame, frame);
+			self.m_maxFrame = max(self.m_maxFrame, frame);
+			for(const TracerEvent& event : events)
+			{
+				self.m_lastStart = max(self.m_lastStart, event.m_start);
+			}
+		}
+	};
+
+	// Only the last 3 frames should survive
+	for(U64 frame = 0; frame < 10; ++frame)
+	{
+		tracer.newFrame(frame);
+		tracer.addCustomEvent("EVENT", F64(frame + 1), 0.1);
+		tracer.addCustomEvent("EVENT", F64(frame + 1) + 0.5, 0.1);
+	}
+
+	{
+		Collector collector;
+		tracer.flush(Collector::callback, &collector);
+		ANKI_TEST_EXPECT_EQ(collector.m_eventCount, 3 * 2);
+		ANKI_TEST_EXPECT_EQ(collector.m_minFrame, 7);
+		ANKI_TEST_EXPECT_EQ(collector.m_maxFrame, 9);
+	}
+
+	// A frame with too many events overwrites its oldest ones
+	tracer.newFrame(10);
+	const U32 bigEventCount = 10000;
+	for(U32 i = 0; i < bigEventCount; ++i)
+	{
+		tracer.addCustomEvent("EVENT", 1.0 + F64(i), 0.1);
+	}
+
+	{
+		Collector collector;
+		tracer.flush(Collector::callback, &collector);
+		ANKI_TEST_EXPECT_GT(collector.m_eventCount, 0);
+		ANKI_TEST_EXPECT_LT(collector.m_eventCount, bigEventCount);
+		ANKI_TEST_EXPECT_EQ(collector.m_lastStart, F64(bigEventCount));
+	}
+
+	// Dump requests
+	ANKI_TEST_EXPECT_EQ(tracer.consumeDumpRequest(), false);
+	tracer.requestDump();
+	ANKI_TEST_EXPECT_EQ(tracer.consumeDumpRequest(), true);
+	ANKI_TEST_EXPECT_EQ(tracer.consumeDumpRequest(), false);
+}
+
+ANKI_TEST(Util, TracerScopedEventBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	TracerSingleton::init(alloc);
+	Tracer& tracer = TracerSingleton::get();
+
+	const U32 FRAME_COUNT = 100;
+	const U32 EVENTS_PER_FRAME = 10000;
+
+	auto flushCallback = [](void*, ThreadId, U64, ConstWeakArray<TracerEvent>, ConstWeakArray<TracerCounter>) {};
+
+	auto bench = [&]() -> Second {
+		Second time = 0.0;
+		for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			const Second begin = HighRezTimer::getCurrentTime();
+			for(U32 i = 0; i < EVENTS_PER_FRAME; ++i)
+			{
+				TracerScopedEvent event("EVENT");
+			}
+			time += HighRezTimer::getCurrentTime() - begin;
+
+			// End of frame work is not measured
+			if(tracer.getRingFrameCount() == 0)
+			{
+				tracer.flush(flushCallback, nullptr);
+			}
+			tracer.newFrame(frame + 1);
+		}
+
+		return time / F64(FRAME_COUNT * EVENTS_PER_FRAME);
+	};
+
+	tracer.setEnabled(false);
+	const Second disabledTime = bench();
+
+	tracer.setEnabled(true);
+	const Second fullTime = bench();
+
+	tracer.setRingMode(8);
+	const Second ringTime = bench();
+
+	ANKI_TEST_LOGI("TracerScopedEvent cost. Disabled %fns, full %fns, ring %fns", disabledTime * 1000000000.0,
+				   fullTime * 1000000000.0, ringTime * 1000000000.0);
+
+	TracerSingleton::destroy();
+}
+
+} // end namespace anki
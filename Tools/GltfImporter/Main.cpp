@@ -12,6 +12,8 @@ Options:
 -rpath <string>        : Replace all absolute paths of assets with that path
 -texrpath <string>     : Same as rpath but for textures
 -optimize-meshes <0|1> : Optimize meshes. Default is 1
+-compress-meshes <0|1> : Quantize and compress the meshes. Default is 1
+-mesh-stats <0|1>      : Print the size and the decode throughput of every mesh. Default is 0
 -j <thread_count>      : Number of threads. Defaults to system's max
 -lod-count <1|2|3>     : The number of geometry LODs to generate. Default: 1
 -lod-factor <float>    : The decimate factor for each LOD. Default 0.25
@@ -27,6 +29,8 @@ public:
 	StringAuto m_rpath = {m_alloc};
 	StringAuto m_texRpath = {m_alloc};
 	Bool m_optimizeMeshes = true;
+	Bool m_compressMeshes = true;
+	Bool m_printMeshStats = false;
 	U32 m_threadCount = MAX_U32;
 	U32 m_lodCount = 1;
 	F32 m_lodFactor = 0.25f;
@@ -106,6 +110,36 @@ static Error parseCommandLineArgs(int argc, char** argv, CmdLineArgs& info)
 				return Error::USER_DATA;
 			}
 		}
+		else if(strcmp(argv[i], "-compress-meshes") == 0)
+		{
+			++i;
+
+			if(i < argc)
+			{
+				I compress = 1;
+				ANKI_CHECK(CString(argv[i]).toNumber(compress));
+				info.m_compressMeshes = compress != 0;
+			}
+			else
+			{
+				return Error::USER_DATA;
+			}
+		}
+		else if(strcmp(argv[i], "-mesh-stats") == 0)
+		{
+			++i;
+
+			if(i < argc)
+			{
+				I stats = 0;
+				ANKI_CHECK(CString(argv[i]).toNumber(stats));
+				info.m_printMeshStats = stats != 0;
+			}
+			else
+			{
+				return Error::USER_DATA;
+			}
+		}
 		else if(strcmp(argv[i], "-j") == 0)
 		{
 			++i;
@@ -206,6 +240,8 @@ int main(int argc, char** argv)
 	initInfo.m_rpath = cmdArgs.m_rpath;
 	initInfo.m_texrpath = cmdArgs.m_texRpath;
 	initInfo.m_optimizeMeshes = cmdArgs.m_optimizeMeshes;
+	initInfo.m_compressMeshes = cmdArgs.m_compressMeshes;
+	initInfo.m_printMeshStats = cmdArgs.m_printMeshStats;
 	initInfo.m_lodFactor = cmdArgs.m_lodFactor;
 	initInfo.m_lodCount = cmdArgs.m_lodCount;
 	initInfo.m_lightIntensityScale = cmdArgs.m_lightIntensityScale;
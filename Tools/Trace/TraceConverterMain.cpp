@@ -0,0 +1,230 @@
+// Copyright (C) 2009-2021, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <AnKi/Core/TraceBinary.h>
+#include <AnKi/Util/MemoryMappedFile.h>
+#include <algorithm>
+
+using namespace anki;
+
+static const char* USAGE = R"(Convert a binary trace to Chrome JSON (it can be opened by chrome://tracing and Perfetto)
+Usage: %s in_file out_json_file [out_csv_file]
+The CSV file will contain the counters. One row per frame.
+)";
+
+static void getSpreadsheetColumnName(U32 column, Array<char, 3>& arr)
+{
+	U32 major = column / 26;
+	U32 minor = column % 26;
+
+	if(major)
+	{
+		arr[0] = char('A' + (major - 1));
+		arr[1] = char('A' + minor);
+	}
+	else
+	{
+		arr[0] = char('A' + minor);
+		arr[1] = '\0';
+	}
+
+	arr[2] = '\0';
+}
+
+namespace
+{
+
+class Counter
+{
+public:
+	U64 m_frame;
+	U32 m_nameId;
+	U64 m_value;
+};
+
+/// Writes the events to the JSON file as they come and gathers the counters.
+class Converter : public TraceBinaryVisitor
+{
+public:
+	HeapAllocator<U8> m_alloc = {allocAligned, nullptr};
+	File m_jsonFile;
+	DynamicArrayAuto<StringAuto> m_names = {m_alloc};
+	DynamicArrayAuto<Counter> m_counters = {m_alloc};
+	Error m_err = Error::NONE;
+
+	void visitName(U32 nameId, CString name) override
+	{
+		while(m_names.getSize() <= nameId)
+		{
+			m_names.emplaceBack(m_alloc);
+		}
+
+		m_names[nameId] = name;
+	}
+
+	void visitEvent(ThreadId tid, U64 frame, U32 nameId, U64 startNs, U64 durationNs) override
+	{
+		if(m_err)
+		{
+			return;
+		}
+
+		const CString name = getName(nameId);
+
+		// Put the GPU time in its own track
+		if(name == "GPU_TIME")
+		{
+			tid = 1;
+		}
+
+		m_err = m_jsonFile.writeText("{\"name\": \"%s\", \"cat\": \"PERF\", \"ph\": \"X\", \"pid\": 1, \"tid\": %llu, "
+									 "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"frame\": %llu}},\n",
+									 name.cstr(), tid, F64(startNs) / 1000.0, F64(durationNs) / 1000.0, frame);
+	}
+
+	void visitCounter(ThreadId tid, U64 frame, U32 nameId, U64 value) override
+	{
+		Counter& counter = *m_counters.emplaceBack();
+		counter.m_frame = frame;
+		counter.m_nameId = nameId;
+		counter.m_value = value;
+	}
+
+	CString getName(U32 nameId) const
+	{
+		return (nameId < m_names.getSize() && !m_names[nameId].isEmpty()) ? m_names[nameId].toCString() : "N/A";
+	}
+
+	Error writeCsv(CString filename);
+};
+
+} // end anonymous namespace
+
+Error Converter::writeCsv(CString filename)
+{
+	File file;
+	ANKI_CHECK(file.open(filename, FileOpenFlag::WRITE));
+
+	if(m_counters.getSize() == 0)
+	{
+		return Error::NONE;
+	}
+
+	// Every counter name is a column. Sort the columns by name
+	DynamicArrayAuto<U32> columnNameIds(m_alloc);
+	DynamicArrayAuto<U32> nameIdToColumn(m_alloc);
+	nameIdToColumn.create(m_names.getSize(), MAX_U32);
+	for(const Counter& counter : m_counters)
+	{
+		if(counter.m_nameId < nameIdToColumn.getSize() && nameIdToColumn[counter.m_nameId] == MAX_U32)
+		{
+			nameIdToColumn[counter.m_nameId] = 0;
+			columnNameIds.emplaceBack(counter.m_nameId);
+		}
+	}
+
+	std::sort(columnNameIds.getBegin(), columnNameIds.getEnd(),
+			  [this](U32 a, U32 b) { return m_names[a] < m_names[b]; });
+	for(U32 i = 0; i < columnNameIds.getSize(); ++i)
+	{
+		nameIdToColumn[columnNameIds[i]] = i;
+	}
+
+	// Every frame is a row. The counters of the same frame from all threads are summed
+	std::sort(m_counters.getBegin(), m_counters.getEnd(),
+			  [](const Counter& a, const Counter& b) { return a.m_frame < b.m_frame; });
+
+	ANKI_CHECK(file.writeText("Frame"));
+	for(U32 nameId : columnNameIds)
+	{
+		ANKI_CHECK(file.writeText(",%s", m_names[nameId].cstr()));
+	}
+	ANKI_CHECK(file.writeText("\n"));
+
+	DynamicArrayAuto<U64> row(m_alloc);
+	row.create(columnNameIds.getSize());
+	U32 rowCount = 0;
+	for(U32 i = 0; i < m_counters.getSize();)
+	{
+		const U64 frame = m_counters[i].m_frame;
+		for(U64& value : row)
+		{
+			value = 0;
+		}
+
+		for(; i < m_counters.getSize() && m_counters[i].m_frame == frame; ++i)
+		{
+			if(m_counters[i].m_nameId < nameIdToColumn.getSize())
+			{
+				row[nameIdToColumn[m_counters[i].m_nameId]] += m_counters[i].m_value;
+			}
+		}
+
+		ANKI_CHECK(file.writeText("%llu", frame));
+		for(U64 value : row)
+		{
+			ANKI_CHECK(file.writeText(",%llu", value));
+		}
+		ANKI_CHECK(file.writeText("\n"));
+		++rowCount;
+	}
+
+	// Write some statistics
+	Array<const char*, 2> funcs = {"SUM", "AVERAGE"};
+	for(const char* func : funcs)
+	{
+		ANKI_CHECK(file.writeText(func));
+		for(U32 i = 0; i < columnNameIds.getSize(); ++i)
+		{
+			Array<char, 3> columnName;
+			getSpreadsheetColumnName(i + 1, columnName);
+			ANKI_CHECK(file.writeText(",=%s(%s2:%s%u)", func, &columnName[0], &columnName[0], rowCount + 1));
+		}
+
+		ANKI_CHECK(file.writeText("\n"));
+	}
+
+	return Error::NONE;
+}
+
+static Error convert(CString inFname, CString jsonFname, CString csvFname)
+{
+	MemoryMappedFile inFile;
+	ANKI_CHECK(inFile.map(inFname));
+
+	Converter converter;
+	ANKI_CHECK(converter.m_jsonFile.open(jsonFname, FileOpenFlag::WRITE));
+	ANKI_CHECK(converter.m_jsonFile.writeText("[\n"));
+
+	ANKI_CHECK(parseTraceBinary(inFile.getData(), converter));
+	ANKI_CHECK(converter.m_err);
+
+	ANKI_CHECK(converter.m_jsonFile.writeText("{}\n]\n"));
+
+	if(!csvFname.isEmpty())
+	{
+		ANKI_CHECK(converter.writeCsv(csvFname));
+	}
+
+	return Error::NONE;
+}
+
+int main(int argc, char** argv)
+{
+	if(argc != 3 && argc != 4)
+	{
+		ANKI_LOGE(USAGE, argv[0]);
+		return 1;
+	}
+
+	const Error err = convert(argv[1], argv[2], (argc == 4) ? argv[3] : "");
+	if(err)
+	{
+		ANKI_LOGE("Can't convert due to an error. Bye");
+		return 1;
+	}
+
+	return 0;
+}
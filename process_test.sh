@@ -0,0 +1,9 @@
+#!/bin/bash
+x=1
+while [ $x -le 10 ]
+do
+	echo "Stdout message no $x"
+	echo "Stderr message no $x" 1>&2
+	sleep 1
+	x=$(( $x + 1 ))
+done